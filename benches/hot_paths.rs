@@ -0,0 +1,452 @@
+// benches/hot_paths.rs
+//! Микробенчмарки горячих путей на синтетических кадрах
+//!
+//! Запуск: `cargo bench --bench hot_paths`. Группы без DPDK (классификатор,
+//! арена дескрипторов, декодеры, стакан, кодировщики ордеров, SPSC кольцо)
+//! работают всегда. Группа `native` разбирает burst настоящих mbuf через
+//! `dpdk_parse_burst`; EAL для нее запускается без hugepages и PCI, и если
+//! инициализация не удалась (нет прав или библиотек), группа пропускается.
+use std::hint::black_box;
+use std::net::Ipv4Addr;
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+
+use hfeec::book::order_book::{BookConfig, OrderBook};
+use hfeec::book::orders::Side;
+use hfeec::dpdk::config::{DpdkConfig, MAX_BURST_SIZE};
+use hfeec::dpdk::ffi::{self, RteMbuf, RteMempool};
+use hfeec::dpdk::init::{init_eal, EalPlan};
+use hfeec::dpdk::mempool::{create_pool, MbufPoolPlan, PoolRole};
+use hfeec::packet::classify::{
+    partition_burst, FlowMatch, HeaderClassifier, HeaderLanes, IPPROTO_UDP,
+};
+use hfeec::packet::pool::PacketArena;
+use hfeec::pipeline::ring::SpscRing;
+use hfeec::protocols::fix::{FixFieldWidths, FixOrder, FixSessionIds, FixTemplate, FixTimestamp};
+use hfeec::protocols::igmp::checksum;
+use hfeec::protocols::itch::{self, AddOrder, ItchHandler, OrderDelete};
+use hfeec::protocols::ouch::{OuchOrder, OuchOrderParams, OuchTemplate, TIF_IOC};
+use hfeec::telemetry::worker::BurstStats;
+
+/// Размер burst в бенчмарках, как `burst_size` конфигурации по умолчанию
+const BURST: usize = 32;
+/// Сообщений ITCH в одном пакете MoldUDP64
+const MOLD_MESSAGES: usize = 16;
+
+const FEED_IP: Ipv4Addr = Ipv4Addr::new(233, 54, 12, 1);
+const FEED_PORT: u16 = 26400;
+
+/// Строит Ethernet/IPv4/UDP кадр с заданным payload
+fn udp_frame(dst_ip: Ipv4Addr, dst_port: u16, payload: &[u8]) -> Vec<u8> {
+    let udp_len = 8 + payload.len();
+    let ip_len = 20 + udp_len;
+    let mut frame = vec![0u8; 14 + ip_len];
+
+    frame[0..6].copy_from_slice(&[0x01, 0x00, 0x5e, 0x36, 0x0c, 0x01]);
+    frame[6..12].copy_from_slice(&[0x02, 0x00, 0x00, 0x00, 0x00, 0x01]);
+    frame[12..14].copy_from_slice(&0x0800u16.to_be_bytes());
+
+    let ip = &mut frame[14..34];
+    ip[0] = 0x45;
+    ip[2..4].copy_from_slice(&(ip_len as u16).to_be_bytes());
+    ip[8] = 16;
+    ip[9] = IPPROTO_UDP;
+    ip[12..16].copy_from_slice(&Ipv4Addr::new(10, 0, 0, 1).octets());
+    ip[16..20].copy_from_slice(&dst_ip.octets());
+    let sum = checksum(ip);
+    ip[10..12].copy_from_slice(&sum.to_be_bytes());
+
+    let udp = &mut frame[34..42];
+    udp[0..2].copy_from_slice(&31000u16.to_be_bytes());
+    udp[2..4].copy_from_slice(&dst_port.to_be_bytes());
+    udp[4..6].copy_from_slice(&(udp_len as u16).to_be_bytes());
+
+    frame[42..].copy_from_slice(payload);
+    frame
+}
+
+/// Пакет MoldUDP64 с чередующимися ITCH Add Order и Order Delete
+fn mold_packet(sequence: u64, messages: usize) -> Vec<u8> {
+    let mut packet = Vec::with_capacity(20 + messages * (2 + AddOrder::LEN));
+    packet.extend_from_slice(b"BENCH00001");
+    packet.extend_from_slice(&sequence.to_be_bytes());
+    packet.extend_from_slice(&(messages as u16).to_be_bytes());
+
+    for i in 0..messages {
+        let order_ref = sequence + (i / 2) as u64;
+        let mut msg = if i % 2 == 0 {
+            vec![0u8; AddOrder::LEN]
+        } else {
+            vec![0u8; OrderDelete::LEN]
+        };
+        msg[11..19].copy_from_slice(&order_ref.to_be_bytes());
+
+        if i % 2 == 0 {
+            msg[0] = AddOrder::TYPE;
+            msg[19] = if i % 4 == 0 { b'B' } else { b'S' };
+            msg[20..24].copy_from_slice(&100u32.to_be_bytes());
+            msg[24..32].copy_from_slice(b"AAPL    ");
+            msg[32..36].copy_from_slice(&(1_500_000u32 + i as u32).to_be_bytes());
+        } else {
+            msg[0] = OrderDelete::TYPE;
+        }
+
+        packet.extend_from_slice(&(msg.len() as u16).to_be_bytes());
+        packet.extend_from_slice(&msg);
+    }
+    packet
+}
+
+/// Обработчик ITCH, который только касается полей сообщений
+#[derive(Default)]
+struct TouchHandler {
+    acc: u64,
+}
+
+impl ItchHandler for TouchHandler {
+    #[inline(always)]
+    fn on_add_order(&mut self, msg: AddOrder<'_>) {
+        self.acc = self
+            .acc
+            .wrapping_add(msg.order_ref() ^ msg.price() as u64 ^ msg.shares() as u64);
+    }
+
+    #[inline(always)]
+    fn on_order_delete(&mut self, msg: OrderDelete<'_>) {
+        self.acc = self.acc.wrapping_add(msg.order_ref());
+    }
+}
+
+fn bench_classify(c: &mut Criterion) {
+    let mut lanes = HeaderLanes::new();
+    for i in 0..BURST {
+        lanes.ether_type[i] = 0x0800;
+        lanes.l2_len[i] = 14;
+        lanes.ip_proto[i] = IPPROTO_UDP as u32;
+        lanes.ihl[i] = 5;
+        lanes.dst_ip[i] = u32::from(FEED_IP);
+        // Каждый четвертый пакет не проходит фильтр
+        lanes.dst_port[i] = if i % 4 == 3 { 9999 } else { FEED_PORT as u32 };
+    }
+
+    let classifier = HeaderClassifier::new(&[FlowMatch::udp(FEED_IP, FEED_PORT)]);
+
+    let mut group = c.benchmark_group("classify");
+    group.throughput(Throughput::Elements(BURST as u64));
+
+    group.bench_function("classify", |b| {
+        b.iter(|| classifier.classify(black_box(&lanes), BURST))
+    });
+    group.bench_function("classify_scalar", |b| {
+        b.iter(|| classifier.classify_scalar(black_box(&lanes), BURST))
+    });
+
+    let mask = classifier.classify(&lanes, BURST);
+    let source: [usize; MAX_BURST_SIZE] = std::array::from_fn(|i| i);
+    let mut dropped = [0usize; MAX_BURST_SIZE];
+    group.bench_function("partition_burst", |b| {
+        b.iter(|| {
+            let mut pkts = source;
+            partition_burst(&mut pkts, BURST, black_box(mask), &mut dropped)
+        })
+    });
+
+    group.finish();
+}
+
+fn bench_arena(c: &mut Criterion) {
+    let mut arena = PacketArena::new(MAX_BURST_SIZE, Some(0));
+    let frame = udp_frame(FEED_IP, FEED_PORT, &mold_packet(1, MOLD_MESSAGES));
+
+    let mut group = c.benchmark_group("arena");
+    group.throughput(Throughput::Elements(BURST as u64));
+
+    // Заполнение дескрипторов и проход обработчика по burst, как в RX цикле
+    group.bench_function("fill_and_scan", |b| {
+        b.iter(|| {
+            for i in 0..BURST {
+                let desc = arena.slot_mut(i);
+                desc.data_ptr = frame[42..].as_ptr();
+                desc.data_len = frame.len() - 42;
+                desc.dest_port = FEED_PORT;
+                desc.queue_id = 0;
+                desc.status = 0;
+            }
+            arena
+                .as_slice(BURST)
+                .iter()
+                .map(|p| p.get_data().len())
+                .sum::<usize>()
+        })
+    });
+
+    group.finish();
+}
+
+fn bench_decode(c: &mut Criterion) {
+    let packet = mold_packet(1, MOLD_MESSAGES);
+
+    let mut group = c.benchmark_group("decode");
+    group.throughput(Throughput::Elements(MOLD_MESSAGES as u64));
+
+    group.bench_function("itch_mold_packet", |b| {
+        let mut handler = TouchHandler::default();
+        b.iter(|| {
+            let mut last = 0;
+            let next = itch::decode_mold_packet(black_box(&packet), &mut handler, |seq| last = seq);
+            (next, last)
+        });
+        black_box(handler.acc);
+    });
+
+    group.finish();
+}
+
+fn bench_book(c: &mut Criterion) {
+    const ORDERS: usize = 1024;
+    let config = BookConfig::centered(1_500_000, 100, 2048, ORDERS * 2);
+    let mut book = OrderBook::new(config, None);
+
+    // Заявки вокруг середины окна, чтобы менялись лучшие уровни
+    let prices: Vec<(Side, i64)> = (0..ORDERS)
+        .map(|i| {
+            let offset = ((i * 7919) % 64) as i64 * 100;
+            if i % 2 == 0 {
+                (Side::Bid, 1_500_000 - 100 - offset)
+            } else {
+                (Side::Ask, 1_500_000 + offset)
+            }
+        })
+        .collect();
+
+    let mut group = c.benchmark_group("book");
+    group.throughput(Throughput::Elements(ORDERS as u64 * 2));
+
+    group.bench_function("add_delete", |b| {
+        b.iter(|| {
+            for (i, &(side, price)) in prices.iter().enumerate() {
+                let _ = book.add(i as u64 + 1, side, price, 100);
+            }
+            let top = book.top();
+            for i in 0..ORDERS {
+                let _ = book.delete(i as u64 + 1);
+            }
+            top
+        })
+    });
+
+    group.finish();
+}
+
+fn bench_encode(c: &mut Criterion) {
+    let ids = FixSessionIds {
+        begin_string: "FIX.4.4".to_string(),
+        sender_comp_id: "HFEEC".to_string(),
+        target_comp_id: "EXCH".to_string(),
+    };
+    let fix =
+        FixTemplate::new_order_single(&ids, "ESZ6", Some("ACC1"), b'0', FixFieldWidths::default())
+            .expect("FIX template");
+    let time = FixTimestamp::from_unix_millis(1_790_000_000_000);
+
+    let ouch = OuchTemplate::enter_order(&OuchOrderParams {
+        stock: "AAPL".to_string(),
+        firm: "HFEC".to_string(),
+        time_in_force: TIF_IOC,
+        display: b'Y',
+        capacity: b'P',
+        token_prefix: "B".to_string(),
+    })
+    .expect("OUCH template");
+
+    let mut out = [0u8; 512];
+    let mut group = c.benchmark_group("encode");
+    group.throughput(Throughput::Elements(1));
+
+    group.bench_function("fix_new_order_single", |b| {
+        let mut seq = 1u64;
+        b.iter(|| {
+            seq += 1;
+            let order = FixOrder {
+                cl_ord_id: seq,
+                orig_cl_ord_id: 0,
+                side: Side::Bid,
+                qty: 10,
+                price: 45_250_000,
+            };
+            fix.encode(&mut out, seq, black_box(&time), black_box(&order))
+        })
+    });
+
+    group.bench_function("ouch_enter_order", |b| {
+        let mut token = 1u64;
+        b.iter(|| {
+            token += 1;
+            let order = OuchOrder {
+                token,
+                side: Side::Ask,
+                shares: 100,
+                price: 1_500_100,
+            };
+            ouch.encode(&mut out, black_box(&order))
+        })
+    });
+
+    group.finish();
+}
+
+fn bench_ring(c: &mut Criterion) {
+    let (mut producer, mut consumer) = SpscRing::<u64>::new(1024);
+
+    let mut group = c.benchmark_group("ring");
+    group.throughput(Throughput::Elements(BURST as u64));
+
+    // Одна пачка через кольцо в одном потоке: стоимость операций без
+    // межъядерного трафика (его показывает null_pmd с конвейером)
+    group.bench_function("spsc_burst", |b| {
+        b.iter(|| {
+            for i in 0..BURST as u64 {
+                let _ = producer.push(black_box(i));
+            }
+            producer.publish();
+
+            let mut sum = 0;
+            while let Some(v) = consumer.pop() {
+                sum += v;
+            }
+            consumer.release();
+            sum
+        })
+    });
+
+    group.finish();
+}
+
+/// Запускает EAL без hugepages и PCI и создает пул mbuf для синтетических кадров
+fn native_pool() -> Option<*mut RteMempool> {
+    let mut dpdk_config = DpdkConfig::default()
+        .without_numa()
+        .with_eal_arg("--no-huge")
+        .with_eal_arg("--no-pci")
+        .with_eal_arg("--log-level=lib.eal:error");
+    dpdk_config.use_huge_pages = false;
+
+    let plan = EalPlan {
+        main_lcore: 0,
+        worker_lcores: Vec::new(),
+        socket_mem: Vec::new(),
+        extra_args: dpdk_config.eal_args.clone(),
+    };
+    if let Err(e) = init_eal(&plan, &dpdk_config) {
+        eprintln!("Skipping native benches: {}", e);
+        return None;
+    }
+
+    let pool_plan = MbufPoolPlan {
+        name: "bench_pool".to_string(),
+        role: PoolRole::Shared,
+        socket_id: -1,
+        num_mbufs: 1023,
+        cache_size: 0,
+        data_room_size: dpdk_config.data_room_size,
+    };
+    match create_pool(&pool_plan) {
+        Ok(pool) => Some(pool),
+        Err(e) => {
+            eprintln!("Skipping native benches: {}", e);
+            None
+        }
+    }
+}
+
+fn bench_native(c: &mut Criterion) {
+    let Some(pool) = native_pool() else {
+        return;
+    };
+
+    let frames: Vec<Vec<u8>> = (0..BURST)
+        .map(|i| {
+            udp_frame(
+                FEED_IP,
+                FEED_PORT,
+                &mold_packet(1 + (i * MOLD_MESSAGES) as u64, MOLD_MESSAGES),
+            )
+        })
+        .collect();
+
+    let mut pkts = [std::ptr::null_mut::<RteMbuf>(); MAX_BURST_SIZE];
+    for (slot, frame) in pkts.iter_mut().zip(&frames) {
+        *slot = unsafe { ffi::dpdk_tx_frame(pool, frame.as_ptr(), frame.len() as u16) };
+        if slot.is_null() {
+            eprintln!("Skipping native benches: mbuf allocation failed");
+            return;
+        }
+    }
+
+    let mut arena = PacketArena::new(MAX_BURST_SIZE, Some(0));
+    let mut lanes = Box::new(HeaderLanes::new());
+    let mut stats = BurstStats::default();
+
+    let mut group = c.benchmark_group("native");
+    group.throughput(Throughput::Elements(BURST as u64));
+
+    // Разбор не владеет mbuf, поэтому один и тот же burst разбирается повторно
+    group.bench_function("dpdk_parse_burst", |b| {
+        b.iter(|| {
+            stats.clear();
+            unsafe {
+                ffi::dpdk_parse_burst(
+                    pkts.as_mut_ptr(),
+                    BURST as u16,
+                    0,
+                    arena.as_mut_ptr(),
+                    std::ptr::null(),
+                    &mut stats,
+                )
+            }
+        })
+    });
+
+    group.bench_function("dpdk_gather_headers", |b| {
+        b.iter(|| unsafe { ffi::dpdk_gather_headers(pkts.as_mut_ptr(), BURST as u16, &mut *lanes) })
+    });
+
+    // Полный путь до обработчика: разбор и декодирование всех сообщений
+    group.throughput(Throughput::Elements((BURST * MOLD_MESSAGES) as u64));
+    group.bench_function("parse_and_decode_itch", |b| {
+        let mut handler = TouchHandler::default();
+        b.iter(|| {
+            stats.clear();
+            let nb_ok = unsafe {
+                ffi::dpdk_parse_burst(
+                    pkts.as_mut_ptr(),
+                    BURST as u16,
+                    0,
+                    arena.as_mut_ptr(),
+                    std::ptr::null(),
+                    &mut stats,
+                )
+            };
+            for packet in arena.as_slice(nb_ok as usize) {
+                let _ = itch::decode_mold_packet(packet.get_data(), &mut handler, |_| {});
+            }
+        });
+        black_box(handler.acc);
+    });
+
+    group.finish();
+
+    unsafe { ffi::rte_pktmbuf_free_bulk(pkts.as_mut_ptr(), BURST as u32) };
+}
+
+criterion_group!(
+    benches,
+    bench_classify,
+    bench_arena,
+    bench_decode,
+    bench_book,
+    bench_encode,
+    bench_ring,
+    bench_native
+);
+criterion_main!(benches);
@@ -0,0 +1,384 @@
+// benches/null_pmd.rs
+//! Сквозной бенчмарк RX worker на виртуальных устройствах DPDK
+//!
+//! Запуск: `cargo bench --bench null_pmd`. Поднимает `NumaManager` с
+//! настоящими worker поверх vdev и измеряет Mpps на ядро по счетчикам
+//! worker и распределение задержки до обработчика.
+//!
+//! Переменные окружения:
+//! - `HFEEC_BENCH_VDEV` - устройство EAL, по умолчанию `net_ring0`: кольцо
+//!   замыкает TX очередь `i` на RX очередь `i`, генератор шлет в него пакеты
+//!   с TSC отправки в payload. `net_null0` дает поток пустых кадров (только
+//!   Mpps, все пакеты уходят в ошибки разбора), `net_pcap0,rx_pcap=feed.pcap`
+//!   воспроизводит запись фида;
+//! - `HFEEC_BENCH_QUEUES` - RX/TX очереди (и генераторы), по умолчанию 1;
+//! - `HFEEC_BENCH_RATE_PPS` - суммарная частота генератора, 0 - без ограничения;
+//! - `HFEEC_BENCH_SECONDS` - длительность замера;
+//! - `HFEEC_BENCH_PAYLOAD` - размер UDP payload генератора;
+//! - `HFEEC_BENCH_GENERATE` - 0/1, генератор (по умолчанию только для net_ring);
+//! - `HFEEC_BENCH_REPLAY` - файл pcap/pcapng, который RX очереди порта 0
+//!   читают вместо устройства (по умолчанию тогда `net_null0`), замер идет
+//!   до конца записи, `HFEEC_BENCH_SECONDS` ограничивает его сверху;
+//! - `HFEEC_BENCH_REPLAY_SPEED` - `max` (по умолчанию), `recorded` или `Nx`.
+use std::env;
+use std::net::Ipv4Addr;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, Instant};
+
+use hfeec::capture::replay::ReplaySpeed;
+use hfeec::dpdk::config::DpdkConfig;
+use hfeec::dpdk::hugepages::check_hugepages_available;
+use hfeec::numa::manager::NumaManager;
+use hfeec::packet::handler::{BurstHandler, PacketBurst};
+use hfeec::packet::timestamp::{tsc, tsc_hz, RxTimestampMode};
+use hfeec::telemetry::latency::{LatencyHistogram, LatencySnapshot};
+use hfeec::telemetry::worker::WorkerSnapshot;
+use hfeec::tx::session::{TxProtocol, TxSession, TxSessionConfig};
+
+/// Признак пакета генератора в начале payload
+const BENCH_MAGIC: u32 = 0x4846_4543;
+/// Заголовок payload генератора: magic, номер пакета, TSC отправки
+const STAMP_LEN: usize = 20;
+/// Пакетов в одной отправке генератора
+const TX_BATCH: usize = 16;
+const MAX_PAYLOAD: usize = 1400;
+
+const BENCH_PORT: u16 = 26400;
+
+/// Параметры запуска из окружения
+struct BenchParams {
+    vdev: String,
+    queues: u16,
+    rate_pps: u64,
+    seconds: u64,
+    payload: usize,
+    generate: bool,
+    replay: Option<String>,
+    replay_speed: ReplaySpeed,
+}
+
+impl BenchParams {
+    fn from_env() -> Self {
+        fn var<T: std::str::FromStr>(name: &str, default: T) -> T {
+            env::var(name)
+                .ok()
+                .and_then(|v| v.parse().ok())
+                .unwrap_or(default)
+        }
+
+        let replay = env::var("HFEEC_BENCH_REPLAY").ok();
+        let replay_speed = env::var("HFEEC_BENCH_REPLAY_SPEED")
+            .ok()
+            .and_then(|v| ReplaySpeed::parse(&v).ok())
+            .unwrap_or(ReplaySpeed::Max);
+        let default_vdev = if replay.is_some() {
+            "net_null0"
+        } else {
+            "net_ring0"
+        };
+        let vdev = env::var("HFEEC_BENCH_VDEV").unwrap_or_else(|_| default_vdev.to_string());
+        let generate = var("HFEEC_BENCH_GENERATE", vdev.starts_with("net_ring") as u8) != 0;
+        // Запись воспроизводится до конца, если длительность не задана явно
+        let default_seconds = if replay.is_some() { u64::MAX } else { 10 };
+
+        Self {
+            generate,
+            queues: var("HFEEC_BENCH_QUEUES", 1u16).max(1),
+            rate_pps: var("HFEEC_BENCH_RATE_PPS", 1_000_000u64),
+            seconds: var("HFEEC_BENCH_SECONDS", default_seconds).max(1),
+            payload: var("HFEEC_BENCH_PAYLOAD", 64usize).clamp(STAMP_LEN, MAX_PAYLOAD),
+            vdev,
+            replay,
+            replay_speed,
+        }
+    }
+}
+
+/// Обработчик бенчмарка: задержка от отправки генератором до обработчика
+///
+/// Гистограмма на каждую RX очередь; очередь обслуживает один worker,
+/// поэтому у каждой гистограммы единственный писатель.
+#[derive(Clone)]
+struct BenchHandler {
+    latency: Arc<Vec<LatencyHistogram>>,
+}
+
+impl BurstHandler for BenchHandler {
+    #[inline]
+    fn on_burst(&mut self, queue_id: u16, burst: &mut PacketBurst<'_>) {
+        let now = tsc();
+        let Some(histogram) = self.latency.get(queue_id as usize) else {
+            return;
+        };
+
+        for packet in burst.packets() {
+            let data = packet.get_data();
+            if data.len() < STAMP_LEN
+                || u32::from_le_bytes([data[0], data[1], data[2], data[3]]) != BENCH_MAGIC
+            {
+                continue;
+            }
+            let mut sent = [0u8; 8];
+            sent.copy_from_slice(&data[12..20]);
+            histogram.record(now.saturating_sub(u64::from_le_bytes(sent)));
+        }
+    }
+}
+
+/// Генератор одной TX очереди с равномерным темпом
+fn run_generator(
+    mut session: TxSession,
+    rate_pps: u64,
+    payload_len: usize,
+    running: Arc<AtomicBool>,
+) -> TxSession {
+    let hz = tsc_hz();
+    // Интервал между пачками в тактах; 0 - отправлять без пауз
+    let interval = if rate_pps == 0 {
+        0
+    } else {
+        hz * TX_BATCH as u64 / rate_pps.max(1)
+    };
+
+    let mut buffers = vec![[0u8; MAX_PAYLOAD]; TX_BATCH];
+    for buf in &mut buffers {
+        buf[0..4].copy_from_slice(&BENCH_MAGIC.to_le_bytes());
+    }
+
+    let mut seq = 0u64;
+    let mut deadline = tsc();
+
+    while running.load(Ordering::Relaxed) {
+        if interval != 0 {
+            while tsc() < deadline {
+                std::hint::spin_loop();
+            }
+            deadline += interval;
+        }
+
+        let now = tsc();
+        for buf in &mut buffers {
+            buf[4..12].copy_from_slice(&seq.to_le_bytes());
+            buf[12..20].copy_from_slice(&now.to_le_bytes());
+            seq += 1;
+        }
+
+        let payloads: [&[u8]; TX_BATCH] = std::array::from_fn(|i| &buffers[i][..payload_len]);
+        session.send(&payloads);
+    }
+
+    session.flush();
+    session
+}
+
+fn print_latency(label: &str, snapshot: &LatencySnapshot, hz: u64) {
+    if snapshot.count == 0 {
+        return;
+    }
+    let ns = snapshot.to_ns(hz);
+    println!(
+        "  {:<24} n={:<10} mean={:>8.0} p50={:>7} p99={:>7} p99.9={:>7} max={:>9} ns",
+        label,
+        ns.count,
+        snapshot.mean() * 1e9 / hz as f64,
+        ns.p50,
+        ns.p99,
+        ns.p999,
+        ns.max
+    );
+}
+
+fn snapshots(manager: &NumaManager) -> Vec<WorkerSnapshot> {
+    manager
+        .worker_telemetry()
+        .iter()
+        .map(|t| t.snapshot())
+        .filter(|s| s.role == "rx")
+        .collect()
+}
+
+fn main() {
+    let params = BenchParams::from_env();
+    println!(
+        "null_pmd bench: vdev {}, {} queues, {} pps, {} s, payload {} B, generator {}",
+        params.vdev,
+        params.queues,
+        params.rate_pps,
+        params.seconds,
+        params.payload,
+        if params.generate { "on" } else { "off" }
+    );
+    if let Some(path) = &params.replay {
+        println!("  replay {} at {:?} speed", path, params.replay_speed);
+    }
+
+    let mut manager = match NumaManager::new() {
+        Ok(manager) => manager,
+        Err(e) => {
+            eprintln!("Failed to initialize NUMA manager: {}", e);
+            return;
+        }
+    };
+    if let Err(e) = manager.init_nodes() {
+        eprintln!("Failed to initialize NUMA nodes: {}", e);
+        return;
+    }
+
+    let mut dpdk_config = DpdkConfig::default()
+        .without_numa()
+        .with_vdev(&params.vdev)
+        .with_eal_arg("--no-pci")
+        .with_rx_timestamps(RxTimestampMode::Tsc);
+    dpdk_config.num_rx_queues = params.queues;
+    dpdk_config.num_tx_queues = params.queues;
+    // У виртуальных устройств нет RSS и offload контрольных сумм
+    dpdk_config.use_rss = false;
+    dpdk_config.use_hw_checksum = false;
+    if !check_hugepages_available() {
+        dpdk_config.use_huge_pages = false;
+        dpdk_config = dpdk_config.with_eal_arg("--no-huge");
+    }
+    if let Some(path) = &params.replay {
+        dpdk_config = dpdk_config.with_replay(path, params.replay_speed);
+    }
+
+    if let Err(e) = manager.init_eal(&dpdk_config) {
+        eprintln!("Failed to initialize DPDK EAL: {}", e);
+        return;
+    }
+    if let Err(e) = manager.distribute_interfaces(&dpdk_config) {
+        eprintln!("Failed to distribute interfaces: {}", e);
+        return;
+    }
+    if let Err(e) = manager.init_dpdk(&dpdk_config) {
+        eprintln!("Failed to initialize DPDK: {}", e);
+        return;
+    }
+
+    let latency: Arc<Vec<LatencyHistogram>> = Arc::new(
+        (0..params.queues)
+            .map(|_| LatencyHistogram::new())
+            .collect(),
+    );
+    let handler = BenchHandler {
+        latency: latency.clone(),
+    };
+    if let Err(e) = manager.start_packet_processing(handler, &dpdk_config) {
+        eprintln!("Failed to start packet processing: {}", e);
+        return;
+    }
+
+    let running = Arc::new(AtomicBool::new(true));
+    let mut generators = Vec::new();
+    if params.generate {
+        let per_queue_rate = params.rate_pps / params.queues as u64;
+        for queue_id in 0..params.queues {
+            let session_config = TxSessionConfig {
+                port_id: 0,
+                queue_id,
+                dst_mac: [0xff; 6],
+                src_ip: Ipv4Addr::new(10, 0, 0, 1),
+                dst_ip: Ipv4Addr::new(10, 0, 0, 2),
+                src_port: 31000 + queue_id,
+                dst_port: BENCH_PORT,
+                protocol: TxProtocol::Udp,
+            };
+            let session = match manager.create_tx_session(&session_config, &dpdk_config) {
+                Ok(session) => session,
+                Err(e) => {
+                    eprintln!("Failed to create TX session for queue {}: {}", queue_id, e);
+                    break;
+                }
+            };
+
+            let running = running.clone();
+            let payload = params.payload;
+            generators.push(thread::spawn(move || {
+                run_generator(session, per_queue_rate, payload, running)
+            }));
+        }
+    }
+
+    // Разогрев: кеши, TLB и первые выделения mbuf не попадают в замер
+    thread::sleep(Duration::from_millis(500));
+    let hz = tsc_hz();
+    let start = Instant::now();
+    let baseline = snapshots(&manager);
+
+    for second in 1..=params.seconds {
+        // Конец записи проверяется чаще раза в секунду, чтобы не занижать Mpps
+        for _ in 0..10 {
+            if manager.replay_finished() {
+                break;
+            }
+            thread::sleep(Duration::from_millis(100));
+        }
+        let total: u64 = snapshots(&manager).iter().map(|s| s.rx_packets).sum();
+        let base: u64 = baseline.iter().map(|s| s.rx_packets).sum();
+        println!(
+            "[{:>3}s] {:.3} Mpps",
+            second,
+            (total - base) as f64 / start.elapsed().as_secs_f64() / 1e6
+        );
+        if manager.replay_finished() {
+            break;
+        }
+    }
+
+    let elapsed = start.elapsed().as_secs_f64();
+    let end = snapshots(&manager);
+
+    running.store(false, Ordering::Relaxed);
+    let sessions: Vec<TxSession> = generators
+        .into_iter()
+        .filter_map(|generator| generator.join().ok())
+        .collect();
+
+    println!("Results over {:.1} s:", elapsed);
+    for snapshot in &end {
+        let before = baseline
+            .iter()
+            .find(|s| s.port_id == snapshot.port_id && s.queue_id == snapshot.queue_id);
+        let (packets, bytes) = match before {
+            Some(b) => (
+                snapshot.rx_packets - b.rx_packets,
+                snapshot.rx_bytes - b.rx_bytes,
+            ),
+            None => (snapshot.rx_packets, snapshot.rx_bytes),
+        };
+        println!(
+            "  core {:>3} port {} queue {}: {:.3} Mpps, {:.2} Gbit/s, mean burst {:.1}, idle {:.1}%, parse errors {}",
+            snapshot.core_id,
+            snapshot.port_id,
+            snapshot.queue_id,
+            packets as f64 / elapsed / 1e6,
+            bytes as f64 * 8.0 / elapsed / 1e9,
+            snapshot.mean_burst_size(),
+            snapshot.idle_ratio() * 100.0,
+            snapshot.total_parse_errors()
+        );
+        print_latency("rx -> handler done", &snapshot.latency, hz);
+        if let Some(histogram) = latency.get(snapshot.queue_id as usize) {
+            print_latency("tx -> handler", &histogram.snapshot(), hz);
+        }
+    }
+
+    for session in &sessions {
+        let stats = session.stats();
+        println!(
+            "  generator queue {}: sent {}, dropped {}, alloc failures {}",
+            session.queue_id(),
+            stats.sent,
+            stats.dropped,
+            stats.alloc_failures
+        );
+    }
+
+    if params.replay.is_some() {
+        manager.print_telemetry();
+    }
+
+    manager.stop_packet_processing();
+}
@@ -10,9 +10,13 @@ fn main() {
     let is_release = profile == "release";
     let enable_pgo = env::var("ENABLE_PGO").unwrap_or_else(|_| "0".to_string()) == "1";
     let pgo_mode = env::var("PGO_MODE").unwrap_or_else(|_| "none".to_string());
+    let pgo_dir = env::var("PGO_DIR").unwrap_or_else(|_| "./pgo-data".to_string());
+    let enable_bolt = env::var("ENABLE_BOLT").unwrap_or_else(|_| "0".to_string()) == "1";
 
     println!("cargo:rerun-if-env-changed=ENABLE_PGO");
     println!("cargo:rerun-if-env-changed=PGO_MODE");
+    println!("cargo:rerun-if-env-changed=PGO_DIR");
+    println!("cargo:rerun-if-env-changed=ENABLE_BOLT");
 
     // Get DPDK paths and flags using pkg-config or fallback to defaults
     let dpdk_include_path = Command::new("pkg-config")
@@ -47,6 +51,11 @@ fn main() {
         }
     }
 
+    // Declare the cfg feature flags set below so rustc does not warn about them
+    println!(
+        "cargo:rustc-check-cfg=cfg(feature, values(\"hugepages\", \"numa\", \"sse4_2\", \"avx\", \"avx2\", \"avx512\", \"aes_ni\", \"rdrand\", \"rdseed\"))"
+    );
+
     // Check if HugePages are available and enable feature flag if so
     let has_hugepages = check_hugepages_available();
     if has_hugepages {
@@ -70,6 +79,13 @@ fn main() {
     let mut compiler = cc::Build::new();
     compiler.file("src/native/dpdk.c");
 
+    // PGO uses LLVM instrumentation so that the C file and the Rust crate
+    // share one profile: rustc only understands LLVM .profdata, not GCC .gcda
+    let use_llvm_pgo = is_release && enable_pgo;
+    if use_llvm_pgo {
+        compiler.compiler("clang");
+    }
+
     // Include DPDK headers
     compiler.include("/usr/include/dpdk");
     compiler.include("/usr/include/x86_64-linux-gnu/dpdk");
@@ -93,29 +109,34 @@ fn main() {
 
         // Aggressive optimization flags
         compiler.flag("-O3"); // Maximum optimization level
-        compiler.flag("-flto"); // Link-time optimization
+        if !use_llvm_pgo {
+            // Clang LTO objects cannot be linked by the GCC driver rustc uses
+            compiler.flag("-flto"); // Link-time optimization
+        }
         compiler.flag("-ffast-math"); // Faster but less precise floating-point
         compiler.flag("-ftree-vectorize"); // Explicitly enable vectorization
         compiler.flag("-funroll-loops"); // Unroll loops for better performance
 
         // Cache optimization
-        compiler.flag("-fprefetch-loop-arrays"); // Prefetch data in loops
+        if !use_llvm_pgo {
+            compiler.flag("-fprefetch-loop-arrays"); // Prefetch data in loops (GCC only)
+        }
 
-        // Add Profile-Guided Optimization if enabled
+        // Add Profile-Guided Optimization if enabled (see scripts/pgo.sh)
         if enable_pgo {
             match pgo_mode.as_str() {
                 "generate" => {
-                    // Generate profile information during test runs
-                    compiler.flag("-fprofile-generate");
-                    println!("PGO: Generating profile data. Run your tests now and then rebuild with PGO_MODE=use");
+                    // Raw profiles land next to the ones written by -Cprofile-generate
+                    compiler.flag(&format!("-fprofile-generate={}", pgo_dir));
+                    println!("PGO: Generating profile data. Run `hfeec train` now and then rebuild with PGO_MODE=use");
                 }
                 "use" => {
-                    // Use previously generated profile information
-                    let profile_dir =
-                        env::var("PGO_DIR").unwrap_or_else(|_| "./pgo-data".to_string());
-                    compiler.flag(&format!("-fprofile-use={}", profile_dir));
-                    compiler.flag("-fprofile-correction");
-                    println!("PGO: Using profile data from {}", profile_dir);
+                    // Use the merged profile of the training run
+                    let profdata = format!("{}/merged.profdata", pgo_dir);
+                    compiler.flag(&format!("-fprofile-use={}", profdata));
+                    compiler.flag("-Wno-profile-instr-unprofiled");
+                    println!("cargo:rerun-if-changed={}", profdata);
+                    println!("PGO: Using profile data from {}", profdata);
                 }
                 _ => {
                     println!(
@@ -124,6 +145,8 @@ fn main() {
                     );
                 }
             }
+
+            check_rust_pgo_flags(&pgo_mode);
         }
     }
 
@@ -143,11 +166,39 @@ fn main() {
         println!("cargo:rustc-link-arg=-flto"); // Link-time optimization
     }
 
+    // BOLT rewrites the final binary and needs its relocations preserved
+    if enable_bolt {
+        println!("cargo:rustc-link-arg=-Wl,--emit-relocs");
+    }
+
     // Trigger rebuild if native source or build script changes
     println!("cargo:rerun-if-changed=src/native/dpdk.c");
     println!("cargo:rerun-if-changed=build.rs");
 }
 
+/// Warn when only the C file is instrumented or optimized with the profile
+///
+/// A build script cannot add codegen flags to its own crate, so the Rust
+/// side has to come from RUSTFLAGS (-Cprofile-generate / -Cprofile-use).
+fn check_rust_pgo_flags(pgo_mode: &str) {
+    println!("cargo:rerun-if-env-changed=RUSTFLAGS");
+    println!("cargo:rerun-if-env-changed=CARGO_ENCODED_RUSTFLAGS");
+
+    let rustflags = env::var("CARGO_ENCODED_RUSTFLAGS").unwrap_or_default();
+    let expected = match pgo_mode {
+        "generate" => "profile-generate",
+        "use" => "profile-use",
+        _ => return,
+    };
+
+    if !rustflags.split('\x1f').any(|flag| flag.contains(expected)) {
+        println!(
+            "cargo:warning=PGO_MODE={} applies only to src/native/dpdk.c; set RUSTFLAGS=-C{}=... or use scripts/pgo.sh",
+            pgo_mode, expected
+        );
+    }
+}
+
 /// Check if HugePages are available on the system
 fn check_hugepages_available() -> bool {
     Path::new("/sys/kernel/mm/hugepages").exists()
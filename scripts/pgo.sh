@@ -0,0 +1,77 @@
+#!/bin/sh
+# scripts/pgo.sh - Profile-guided (and optionally BOLT) build of HFEEC
+#
+# Builds an instrumented binary, runs the built-in training workload
+# (`hfeec train`), merges the profile and rebuilds both the Rust crate and
+# src/native/dpdk.c with it. With --bolt the PGO binary is then instrumented
+# by llvm-bolt, trained again and re-laid out.
+#
+# Usage: scripts/pgo.sh [--bolt] [-- <hfeec train args>]
+#   e.g. scripts/pgo.sh --bolt -- --pcap /data/itch-open.pcap --seconds 60
+#
+# The workload needs the same privileges as production (hugepages, vdevs).
+# clang must use the same LLVM major version as rustc (`rustc -vV`), otherwise
+# the merged profile is rejected by one of them.
+#
+# Environment: PGO_DIR (default ./pgo-data), LLVM_PROFDATA, LLVM_BOLT.
+set -eu
+
+BOLT=0
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --bolt) BOLT=1; shift ;;
+        --) shift; break ;;
+        *) echo "Unknown option: $1" >&2; exit 1 ;;
+    esac
+done
+
+PGO_DIR=$(realpath -m "${PGO_DIR:-./pgo-data}")
+HOST=$(rustc -vV | sed -n 's/^host: //p')
+SYSROOT_BIN="$(rustc --print sysroot)/lib/rustlib/$HOST/bin"
+
+# llvm-profdata from `rustup component add llvm-tools-preview` matches rustc
+if [ -z "${LLVM_PROFDATA:-}" ]; then
+    if [ -x "$SYSROOT_BIN/llvm-profdata" ]; then
+        LLVM_PROFDATA="$SYSROOT_BIN/llvm-profdata"
+    else
+        LLVM_PROFDATA=llvm-profdata
+    fi
+fi
+LLVM_BOLT=${LLVM_BOLT:-llvm-bolt}
+
+export PGO_DIR ENABLE_PGO=1
+
+echo "== PGO: instrumented build"
+rm -rf "$PGO_DIR"
+mkdir -p "$PGO_DIR"
+PGO_MODE=generate RUSTFLAGS="-Cprofile-generate=$PGO_DIR" \
+    cargo build --release --target-dir target/pgo-generate
+
+echo "== PGO: training run"
+target/pgo-generate/release/hfeec train "$@"
+
+"$LLVM_PROFDATA" merge -o "$PGO_DIR/merged.profdata" "$PGO_DIR"/*.profraw
+
+echo "== PGO: optimized build"
+ENABLE_BOLT=$BOLT PGO_MODE=use \
+    RUSTFLAGS="-Cprofile-use=$PGO_DIR/merged.profdata -Cllvm-args=-pgo-warn-missing-function" \
+    cargo build --release
+
+BIN=target/release/hfeec
+if [ "$BOLT" = 1 ]; then
+    echo "== BOLT: instrumented binary"
+    "$LLVM_BOLT" "$BIN" -instrument -instrumentation-file="$PGO_DIR/bolt.fdata" \
+        -o "$BIN.bolt-inst"
+
+    echo "== BOLT: training run"
+    "$BIN.bolt-inst" train "$@"
+
+    echo "== BOLT: layout"
+    "$LLVM_BOLT" "$BIN" -o "$BIN.bolt" -data="$PGO_DIR/bolt.fdata" \
+        -reorder-blocks=ext-tsp -reorder-functions=hfsort+ -split-functions \
+        -split-all-cold -icf=1 -dyno-stats
+    rm -f "$BIN.bolt-inst"
+    BIN="$BIN.bolt"
+fi
+
+echo "== Done: $BIN"
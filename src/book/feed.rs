@@ -0,0 +1,423 @@
+// src/book/feed.rs
+use crate::book::order_book::{BookConfig, OrderBook};
+use crate::book::orders::Side;
+use crate::numa::ffi::NumaAllocator;
+use crate::packet::handler::{BurstHandler, PacketBurst};
+use crate::protocols::itch::{self, ItchHandler};
+use crate::protocols::mdp3::{self, Mdp3Handler};
+use crate::protocols::wire::DecodeError;
+
+/// Количество ключей инструментов: stock locate ITCH - u16
+const MAX_INSTRUMENTS: usize = u16::MAX as usize + 1;
+
+/// Получатель уведомлений об изменении стаканов
+///
+/// Вызывается один раз на burst после применения всех его сообщений,
+/// с ключами стаканов, изменившихся за burst.
+pub trait BookListener: Send + 'static {
+    fn on_books_updated(&mut self, books: &BookSet, changed: &[u16]);
+}
+
+struct BookSlot {
+    book: Option<Box<OrderBook>>,
+    /// Ключ уже добавлен в список изменившихся за текущий burst
+    queued: bool,
+}
+
+/// Стаканы инструментов, принадлежащих одному worker
+///
+/// Ключ инструмента - stock locate ITCH или ключ, назначенный
+/// security id MDP3 через `map_security_id`. Стаканы создаются в
+/// `allocate` из потока worker, поэтому их память лежит на его узле NUMA;
+/// до этого набор хранит только конфигурации, и его копия (`Clone`)
+/// для каждого worker не содержит стаканов.
+pub struct BookSet {
+    specs: Vec<(u16, BookConfig)>,
+    security_ids: Vec<(i32, u16)>,
+    slots: Vec<BookSlot>,
+    changed: Vec<u16>,
+    numa_node: Option<usize>,
+    allocated: bool,
+    /// Сообщения для инструментов без стакана
+    pub unknown_instrument: u64,
+    /// Ошибки применения обновлений (неизвестная заявка, пул исчерпан)
+    pub book_errors: u64,
+}
+
+impl Clone for BookSet {
+    fn clone(&self) -> Self {
+        let mut books = BookSet::new(self.numa_node);
+        books.specs = self.specs.clone();
+        books.security_ids = self.security_ids.clone();
+        books
+    }
+}
+
+impl BookSet {
+    /// Создает пустой набор; `numa_node` None - узел текущего потока в `allocate`
+    pub fn new(numa_node: Option<usize>) -> Self {
+        Self {
+            specs: Vec::new(),
+            security_ids: Vec::new(),
+            slots: Vec::new(),
+            changed: Vec::new(),
+            numa_node,
+            allocated: false,
+            unknown_instrument: 0,
+            book_errors: 0,
+        }
+    }
+
+    /// Регистрирует инструмент с ключом `key`
+    pub fn with_instrument(mut self, key: u16, config: BookConfig) -> Self {
+        self.specs.retain(|&(k, _)| k != key);
+        self.specs.push((key, config));
+        self
+    }
+
+    /// Сопоставляет security id MDP3 ключу инструмента
+    pub fn map_security_id(mut self, security_id: i32, key: u16) -> Self {
+        self.security_ids.retain(|&(id, _)| id != security_id);
+        self.security_ids.push((security_id, key));
+        self.security_ids.sort_unstable();
+        self
+    }
+
+    /// Выделяет стаканы всех инструментов; вызывать из потока-владельца
+    pub fn allocate(&mut self) {
+        if self.allocated {
+            return;
+        }
+
+        let numa_node = self.numa_node.or_else(NumaAllocator::current_node);
+
+        self.slots = (0..MAX_INSTRUMENTS)
+            .map(|_| BookSlot {
+                book: None,
+                queued: false,
+            })
+            .collect();
+
+        for &(key, config) in &self.specs {
+            self.slots[key as usize].book = Some(Box::new(OrderBook::new(config, numa_node)));
+        }
+
+        self.changed = Vec::with_capacity(self.specs.len());
+        self.numa_node = numa_node;
+        self.allocated = true;
+    }
+
+    pub fn is_allocated(&self) -> bool {
+        self.allocated
+    }
+
+    /// Стакан инструмента
+    #[inline(always)]
+    pub fn book(&self, key: u16) -> Option<&OrderBook> {
+        self.slots
+            .get(key as usize)
+            .and_then(|slot| slot.book.as_deref())
+    }
+
+    /// Ключ инструмента по security id MDP3
+    #[inline(always)]
+    pub fn key_for_security(&self, security_id: i32) -> Option<u16> {
+        self.security_ids
+            .binary_search_by_key(&security_id, |&(id, _)| id)
+            .ok()
+            .map(|i| self.security_ids[i].1)
+    }
+
+    /// Применяет обновление к стакану `key` и учитывает его в списке изменений
+    #[inline(always)]
+    fn apply<R>(&mut self, key: u16, update: impl FnOnce(&mut OrderBook) -> R) -> Option<R> {
+        let slot = match self.slots.get_mut(key as usize) {
+            Some(slot) => slot,
+            None => {
+                self.unknown_instrument += 1;
+                return None;
+            }
+        };
+
+        let book = match slot.book.as_deref_mut() {
+            Some(book) => book,
+            None => {
+                self.unknown_instrument += 1;
+                return None;
+            }
+        };
+
+        let result = update(book);
+        if !slot.queued && book.take_changed() {
+            slot.queued = true;
+            self.changed.push(key);
+        }
+        Some(result)
+    }
+
+    #[inline(always)]
+    fn apply_result<E>(&mut self, key: u16, update: impl FnOnce(&mut OrderBook) -> Result<(), E>) {
+        if let Some(Err(_)) = self.apply(key, update) {
+            self.book_errors += 1;
+        }
+    }
+
+    /// Уведомляет получателя об изменениях за burst и сбрасывает список
+    #[inline(always)]
+    pub fn notify<L: BookListener>(&mut self, listener: &mut L) {
+        if self.changed.is_empty() {
+            return;
+        }
+
+        listener.on_books_updated(self, &self.changed);
+
+        for &key in &self.changed {
+            let slot = &mut self.slots[key as usize];
+            slot.queued = false;
+            if let Some(book) = slot.book.as_deref_mut() {
+                book.take_changed();
+            }
+        }
+        self.changed.clear();
+    }
+}
+
+impl ItchHandler for BookSet {
+    #[inline(always)]
+    fn on_add_order(&mut self, msg: itch::AddOrder<'_>) {
+        self.apply_result(msg.stock_locate(), |book| {
+            book.add(
+                msg.order_ref(),
+                Side::from_itch(msg.side()),
+                msg.price() as i64,
+                msg.shares(),
+            )
+        });
+    }
+
+    #[inline(always)]
+    fn on_add_order_mpid(&mut self, msg: itch::AddOrderMpid<'_>) {
+        self.apply_result(msg.stock_locate(), |book| {
+            book.add(
+                msg.order_ref(),
+                Side::from_itch(msg.side()),
+                msg.price() as i64,
+                msg.shares(),
+            )
+        });
+    }
+
+    #[inline(always)]
+    fn on_order_executed(&mut self, msg: itch::OrderExecuted<'_>) {
+        self.apply_result(msg.stock_locate(), |book| {
+            book.reduce(msg.order_ref(), msg.executed_shares())
+        });
+    }
+
+    #[inline(always)]
+    fn on_order_executed_with_price(&mut self, msg: itch::OrderExecutedWithPrice<'_>) {
+        self.apply_result(msg.stock_locate(), |book| {
+            book.reduce(msg.order_ref(), msg.executed_shares())
+        });
+    }
+
+    #[inline(always)]
+    fn on_order_cancel(&mut self, msg: itch::OrderCancel<'_>) {
+        self.apply_result(msg.stock_locate(), |book| {
+            book.reduce(msg.order_ref(), msg.cancelled_shares())
+        });
+    }
+
+    #[inline(always)]
+    fn on_order_delete(&mut self, msg: itch::OrderDelete<'_>) {
+        self.apply_result(msg.stock_locate(), |book| book.delete(msg.order_ref()));
+    }
+
+    #[inline(always)]
+    fn on_order_replace(&mut self, msg: itch::OrderReplace<'_>) {
+        self.apply_result(msg.stock_locate(), |book| {
+            book.replace(
+                msg.original_order_ref(),
+                msg.new_order_ref(),
+                msg.price() as i64,
+                msg.shares(),
+            )
+        });
+    }
+}
+
+/// Сторона записи MDP3 по MDEntryType; implied и прочие типы пропускаются
+#[inline(always)]
+fn mdp3_side(entry_type: u8) -> Option<Side> {
+    match entry_type {
+        b'0' => Some(Side::Bid),
+        b'1' => Some(Side::Ask),
+        _ => None,
+    }
+}
+
+impl Mdp3Handler for BookSet {
+    #[inline(always)]
+    fn on_book(&mut self, msg: &mdp3::IncrementalRefreshBook<'_>) {
+        for entry in msg.entries.iter() {
+            let side = match mdp3_side(entry.entry_type()) {
+                Some(side) => side,
+                None => continue,
+            };
+            let key = match self.key_for_security(entry.security_id()) {
+                Some(key) => key,
+                None => {
+                    self.unknown_instrument += 1;
+                    continue;
+                }
+            };
+
+            let (price, size, orders) = (entry.price(), entry.size(), entry.number_of_orders());
+            // MDUpdateAction: 0 New, 1 Change, 2 Delete, 3 DeleteThru, 4 DeleteFrom, 5 Overlay
+            self.apply(key, |book| match entry.update_action() {
+                2 => book.set_level(side, price, 0, 0),
+                3 => book.remove_best_levels(side, usize::MAX),
+                4 => book.remove_best_levels(side, entry.price_level() as usize),
+                _ => book.set_level(side, price, size.max(0) as u64, orders.max(0) as u32),
+            });
+        }
+    }
+
+    #[inline(always)]
+    fn on_order_book(&mut self, msg: &mdp3::IncrementalRefreshOrderBook<'_>) {
+        for entry in msg.entries.iter() {
+            let side = match mdp3_side(entry.entry_type()) {
+                Some(side) => side,
+                None => continue,
+            };
+            let key = match self.key_for_security(entry.security_id()) {
+                Some(key) => key,
+                None => {
+                    self.unknown_instrument += 1;
+                    continue;
+                }
+            };
+
+            let (id, price, qty) = (
+                entry.order_id(),
+                entry.price(),
+                entry.display_qty().max(0) as u32,
+            );
+            self.apply_result(key, |book| match entry.update_action() {
+                0 => book.add(id, side, price, qty),
+                2 => book.delete(id),
+                _ => book.delete(id).and_then(|_| book.add(id, side, price, qty)),
+            });
+        }
+    }
+}
+
+/// Обработчик burst: ITCH поверх MoldUDP64 в стаканы worker
+///
+/// Все сообщения burst применяются к стаканам, после чего получатель
+/// уведомляется один раз. Стаканы выделяются при первом burst в потоке
+/// worker (на его узле NUMA).
+#[derive(Clone)]
+pub struct ItchBookHandler<L> {
+    pub books: BookSet,
+    pub listener: L,
+    /// Ожидаемый порядковый номер MoldUDP64, 0 - еще не известен
+    pub expected_sequence: u64,
+    /// Пропущено сообщений по разрывам последовательности
+    pub gap_messages: u64,
+    pub decode_errors: u64,
+    pub last_error: Option<DecodeError>,
+}
+
+impl<L: BookListener> ItchBookHandler<L> {
+    pub fn new(books: BookSet, listener: L) -> Self {
+        Self {
+            books,
+            listener,
+            expected_sequence: 0,
+            gap_messages: 0,
+            decode_errors: 0,
+            last_error: None,
+        }
+    }
+}
+
+impl<L: BookListener> BurstHandler for ItchBookHandler<L> {
+    #[inline(always)]
+    fn on_burst(&mut self, _queue_id: u16, burst: &mut PacketBurst<'_>) {
+        if !self.books.is_allocated() {
+            self.books.allocate();
+        }
+
+        for packet in burst.packets() {
+            let expected = &mut self.expected_sequence;
+            let gaps = &mut self.gap_messages;
+
+            let result = itch::decode_mold_packet(packet.get_data(), &mut self.books, |sequence| {
+                if *expected != 0 && sequence > *expected {
+                    *gaps += sequence - *expected;
+                }
+                *expected = sequence + 1;
+            });
+
+            if let Err(e) = result {
+                self.decode_errors += 1;
+                self.last_error = Some(e);
+            }
+        }
+
+        self.books.notify(&mut self.listener);
+    }
+}
+
+/// Обработчик burst: пакеты CME MDP 3.0 в стаканы worker
+#[derive(Clone)]
+pub struct Mdp3BookHandler<L> {
+    pub books: BookSet,
+    pub listener: L,
+    /// Ожидаемый MsgSeqNum пакета, 0 - еще не известен
+    pub expected_sequence: u32,
+    /// Пропущено пакетов по разрывам последовательности
+    pub gap_packets: u64,
+    pub decode_errors: u64,
+    pub last_error: Option<DecodeError>,
+}
+
+impl<L: BookListener> Mdp3BookHandler<L> {
+    pub fn new(books: BookSet, listener: L) -> Self {
+        Self {
+            books,
+            listener,
+            expected_sequence: 0,
+            gap_packets: 0,
+            decode_errors: 0,
+            last_error: None,
+        }
+    }
+}
+
+impl<L: BookListener> BurstHandler for Mdp3BookHandler<L> {
+    #[inline(always)]
+    fn on_burst(&mut self, _queue_id: u16, burst: &mut PacketBurst<'_>) {
+        if !self.books.is_allocated() {
+            self.books.allocate();
+        }
+
+        for packet in burst.packets() {
+            match mdp3::decode_packet(packet.get_data(), &mut self.books) {
+                Ok(sequence) => {
+                    if self.expected_sequence != 0 && sequence > self.expected_sequence {
+                        self.gap_packets += (sequence - self.expected_sequence) as u64;
+                    }
+                    self.expected_sequence = sequence.wrapping_add(1);
+                }
+                Err(e) => {
+                    self.decode_errors += 1;
+                    self.last_error = Some(e);
+                }
+            }
+        }
+
+        self.books.notify(&mut self.listener);
+    }
+}
@@ -0,0 +1,3 @@
+pub mod feed;
+pub mod order_book;
+pub mod orders;
@@ -0,0 +1,478 @@
+// src/book/order_book.rs
+use crate::book::orders::{Order, OrderTable, Side, NIL};
+use crate::numa::array::NodeArray;
+
+/// Параметры стакана одного инструмента
+#[derive(Debug, Clone, Copy)]
+pub struct BookConfig {
+    /// Цена нижнего уровня окна в единицах фида
+    pub base_price: i64,
+    /// Шаг цены в единицах фида
+    pub tick_size: i64,
+    /// Количество уровней в окне на каждую сторону
+    pub levels: usize,
+    /// Максимальное количество одновременно живых заявок (L3)
+    pub max_orders: usize,
+}
+
+impl BookConfig {
+    /// Окно `levels` шагов цены вокруг `mid_price`
+    pub fn centered(mid_price: i64, tick_size: i64, levels: usize, max_orders: usize) -> Self {
+        let tick_size = tick_size.max(1);
+        Self {
+            base_price: mid_price - tick_size * (levels / 2) as i64,
+            tick_size,
+            levels,
+            max_orders,
+        }
+    }
+}
+
+/// Агрегированный ценовой уровень
+///
+/// `head`/`tail` - очередь заявок уровня (L3), в режиме L2 не используются.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct Level {
+    pub qty: u64,
+    pub orders: u32,
+    head: u32,
+    tail: u32,
+}
+
+impl Level {
+    const EMPTY: Level = Level {
+        qty: 0,
+        orders: 0,
+        head: NIL,
+        tail: NIL,
+    };
+}
+
+/// Ошибка применения обновления к стакану
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum BookError {
+    /// Заявка с таким id не найдена
+    UnknownOrder,
+    /// Заявка с таким id уже в стакане
+    DuplicateOrder,
+    /// Пул заявок исчерпан
+    PoolExhausted,
+}
+
+/// Счетчики стакана
+#[derive(Debug, Default, Clone, Copy)]
+pub struct BookStats {
+    pub updates: u64,
+    /// Обновления с ценой вне окна уровней (заявка учитывается только в таблице)
+    pub out_of_range: u64,
+    pub errors: u64,
+}
+
+/// Лучшие цены стакана
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct TopOfBook {
+    pub bid_price: i64,
+    pub bid_qty: u64,
+    pub ask_price: i64,
+    pub ask_qty: u64,
+}
+
+/// Стакан одного инструмента на плоских массивах
+///
+/// Уровни каждой стороны - массив, индексируемый номером шага цены от
+/// `base_price`, поэтому обновление уровня - одно обращение по индексу без
+/// поиска. Лучшие цены хранятся индексами и при опустошении лучшего уровня
+/// ищутся линейным проходом по соседним (обычно близким) уровням.
+/// Заявки (L3) хранятся в `OrderTable`; весь стакан выделяется при
+/// создании в памяти узла NUMA worker-владельца.
+pub struct OrderBook {
+    config: BookConfig,
+    bids: NodeArray<Level>,
+    asks: NodeArray<Level>,
+    /// Индекс лучшего уровня покупки или NIL
+    best_bid: u32,
+    /// Индекс лучшего уровня продажи или NIL
+    best_ask: u32,
+    orders: OrderTable,
+    stats: BookStats,
+    /// Стакан изменился с последнего `take_changed`
+    changed: bool,
+}
+
+impl OrderBook {
+    pub fn new(config: BookConfig, numa_node: Option<usize>) -> Self {
+        let levels = config.levels.clamp(1, NIL as usize - 1);
+        let config = BookConfig {
+            levels,
+            tick_size: config.tick_size.max(1),
+            ..config
+        };
+
+        Self {
+            config,
+            bids: NodeArray::new(levels, Level::EMPTY, numa_node),
+            asks: NodeArray::new(levels, Level::EMPTY, numa_node),
+            best_bid: NIL,
+            best_ask: NIL,
+            orders: OrderTable::new(config.max_orders, numa_node),
+            stats: BookStats::default(),
+            changed: false,
+        }
+    }
+
+    pub fn config(&self) -> &BookConfig {
+        &self.config
+    }
+
+    pub fn stats(&self) -> &BookStats {
+        &self.stats
+    }
+
+    /// Количество заявок в стакане
+    pub fn order_count(&self) -> usize {
+        self.orders.len()
+    }
+
+    /// Индекс уровня для цены или NIL, если цена вне окна
+    #[inline(always)]
+    fn level_index(&self, price: i64) -> u32 {
+        let offset = price - self.config.base_price;
+        if offset < 0 || offset % self.config.tick_size != 0 {
+            return NIL;
+        }
+        let index = offset / self.config.tick_size;
+        if index >= self.config.levels as i64 {
+            NIL
+        } else {
+            index as u32
+        }
+    }
+
+    #[inline(always)]
+    fn level_price(&self, index: u32) -> i64 {
+        self.config.base_price + index as i64 * self.config.tick_size
+    }
+
+    #[inline(always)]
+    fn side_levels(&mut self, side: Side) -> &mut NodeArray<Level> {
+        match side {
+            Side::Bid => &mut self.bids,
+            Side::Ask => &mut self.asks,
+        }
+    }
+
+    /// Пересчитывает лучшую цену после изменения уровня `index`
+    #[inline(always)]
+    fn update_best(&mut self, side: Side, index: u32) {
+        let filled = self.side_levels(side)[index as usize].qty > 0;
+
+        match side {
+            Side::Bid => {
+                if filled {
+                    if self.best_bid == NIL || index > self.best_bid {
+                        self.best_bid = index;
+                    }
+                } else if index == self.best_bid {
+                    self.best_bid = (0..index)
+                        .rev()
+                        .find(|&i| self.bids[i as usize].qty > 0)
+                        .unwrap_or(NIL);
+                }
+            }
+            Side::Ask => {
+                if filled {
+                    if self.best_ask == NIL || index < self.best_ask {
+                        self.best_ask = index;
+                    }
+                } else if index == self.best_ask {
+                    self.best_ask = (index + 1..self.config.levels as u32)
+                        .find(|&i| self.asks[i as usize].qty > 0)
+                        .unwrap_or(NIL);
+                }
+            }
+        }
+    }
+
+    /// Добавляет заявку в конец очереди ее уровня (L3)
+    #[inline(always)]
+    pub fn add(&mut self, id: u64, side: Side, price: i64, qty: u32) -> Result<(), BookError> {
+        self.stats.updates += 1;
+        let level = self.level_index(price);
+
+        let slot = match self.orders.insert(Order {
+            id,
+            price,
+            qty,
+            level,
+            prev: NIL,
+            next: NIL,
+            side,
+        }) {
+            Some(slot) => slot,
+            None => {
+                self.stats.errors += 1;
+                return Err(if self.orders.find(id).is_some() {
+                    BookError::DuplicateOrder
+                } else {
+                    BookError::PoolExhausted
+                });
+            }
+        };
+
+        if level == NIL {
+            self.stats.out_of_range += 1;
+            return Ok(());
+        }
+
+        let tail = {
+            let lvl = &mut self.side_levels(side)[level as usize];
+            let tail = lvl.tail;
+            lvl.qty += qty as u64;
+            lvl.orders += 1;
+            lvl.tail = slot;
+            if tail == NIL {
+                lvl.head = slot;
+            }
+            tail
+        };
+
+        if tail != NIL {
+            self.orders.get_mut(tail).next = slot;
+            self.orders.get_mut(slot).prev = tail;
+        }
+
+        self.update_best(side, level);
+        self.changed = true;
+        Ok(())
+    }
+
+    /// Уменьшает объем заявки (исполнение или частичная отмена);
+    /// заявка с нулевым остатком удаляется
+    #[inline(always)]
+    pub fn reduce(&mut self, id: u64, qty: u32) -> Result<(), BookError> {
+        self.stats.updates += 1;
+        let slot = match self.orders.find(id) {
+            Some(slot) => slot,
+            None => {
+                self.stats.errors += 1;
+                return Err(BookError::UnknownOrder);
+            }
+        };
+
+        let order = *self.orders.get(slot);
+        let qty = qty.min(order.qty);
+
+        if qty == order.qty {
+            self.unlink(slot);
+            self.orders.remove(slot);
+        } else {
+            self.orders.get_mut(slot).qty -= qty;
+            if order.level != NIL {
+                self.side_levels(order.side)[order.level as usize].qty -= qty as u64;
+            }
+        }
+
+        if order.level != NIL {
+            self.update_best(order.side, order.level);
+            self.changed = true;
+        }
+        Ok(())
+    }
+
+    /// Удаляет заявку
+    #[inline(always)]
+    pub fn delete(&mut self, id: u64) -> Result<(), BookError> {
+        self.stats.updates += 1;
+        let slot = match self.orders.find(id) {
+            Some(slot) => slot,
+            None => {
+                self.stats.errors += 1;
+                return Err(BookError::UnknownOrder);
+            }
+        };
+
+        let order = *self.orders.get(slot);
+        self.unlink(slot);
+        self.orders.remove(slot);
+
+        if order.level != NIL {
+            self.update_best(order.side, order.level);
+            self.changed = true;
+        }
+        Ok(())
+    }
+
+    /// Заменяет заявку новой (новый id, цена и объем, сторона сохраняется);
+    /// новая заявка теряет приоритет
+    #[inline(always)]
+    pub fn replace(
+        &mut self,
+        old_id: u64,
+        new_id: u64,
+        price: i64,
+        qty: u32,
+    ) -> Result<(), BookError> {
+        let side = match self.orders.find(old_id) {
+            Some(slot) => self.orders.get(slot).side,
+            None => {
+                self.stats.updates += 1;
+                self.stats.errors += 1;
+                return Err(BookError::UnknownOrder);
+            }
+        };
+
+        self.delete(old_id)?;
+        self.add(new_id, side, price, qty)
+    }
+
+    /// Исключает заявку из очереди ее уровня и вычитает ее объем
+    #[inline(always)]
+    fn unlink(&mut self, slot: u32) {
+        let order = *self.orders.get(slot);
+        if order.level == NIL {
+            return;
+        }
+
+        if order.prev != NIL {
+            self.orders.get_mut(order.prev).next = order.next;
+        }
+        if order.next != NIL {
+            self.orders.get_mut(order.next).prev = order.prev;
+        }
+
+        let lvl = &mut self.side_levels(order.side)[order.level as usize];
+        if lvl.head == slot {
+            lvl.head = order.next;
+        }
+        if lvl.tail == slot {
+            lvl.tail = order.prev;
+        }
+        lvl.qty -= order.qty as u64;
+        lvl.orders -= 1;
+    }
+
+    /// Устанавливает агрегированный уровень целиком (L2, например MDP3 MBP)
+    #[inline(always)]
+    pub fn set_level(&mut self, side: Side, price: i64, qty: u64, orders: u32) {
+        self.stats.updates += 1;
+        let index = self.level_index(price);
+        if index == NIL {
+            self.stats.out_of_range += 1;
+            return;
+        }
+
+        let lvl = &mut self.side_levels(side)[index as usize];
+        lvl.qty = qty;
+        lvl.orders = orders;
+
+        self.update_best(side, index);
+        self.changed = true;
+    }
+
+    /// Очищает `count` лучших уровней стороны (L2, MDP3 DeleteFrom / DeleteThru)
+    pub fn remove_best_levels(&mut self, side: Side, count: usize) {
+        for _ in 0..count {
+            let best = match side {
+                Side::Bid => self.best_bid,
+                Side::Ask => self.best_ask,
+            };
+            if best == NIL {
+                break;
+            }
+
+            let lvl = &mut self.side_levels(side)[best as usize];
+            lvl.qty = 0;
+            lvl.orders = 0;
+            self.update_best(side, best);
+            self.changed = true;
+        }
+    }
+
+    /// Лучшая цена покупки и объем
+    #[inline(always)]
+    pub fn best_bid(&self) -> Option<(i64, u64)> {
+        (self.best_bid != NIL).then(|| {
+            (
+                self.level_price(self.best_bid),
+                self.bids[self.best_bid as usize].qty,
+            )
+        })
+    }
+
+    /// Лучшая цена продажи и объем
+    #[inline(always)]
+    pub fn best_ask(&self) -> Option<(i64, u64)> {
+        (self.best_ask != NIL).then(|| {
+            (
+                self.level_price(self.best_ask),
+                self.asks[self.best_ask as usize].qty,
+            )
+        })
+    }
+
+    /// Лучшие цены обеих сторон; пустая сторона возвращается с нулевым объемом
+    #[inline(always)]
+    pub fn top(&self) -> TopOfBook {
+        let (bid_price, bid_qty) = self.best_bid().unwrap_or((0, 0));
+        let (ask_price, ask_qty) = self.best_ask().unwrap_or((0, 0));
+        TopOfBook {
+            bid_price,
+            bid_qty,
+            ask_price,
+            ask_qty,
+        }
+    }
+
+    /// Непустые уровни стороны от лучшего к худшему: (цена, объем, заявок)
+    pub fn depth(&self, side: Side) -> impl Iterator<Item = (i64, u64, u32)> + '_ {
+        let (levels, best, step): (&NodeArray<Level>, u32, i64) = match side {
+            Side::Bid => (&self.bids, self.best_bid, -1),
+            Side::Ask => (&self.asks, self.best_ask, 1),
+        };
+
+        let count = if best == NIL {
+            0
+        } else if step < 0 {
+            best as usize + 1
+        } else {
+            self.config.levels - best as usize
+        };
+
+        (0..count)
+            .map(move |i| (best as i64 + step * i as i64) as u32)
+            .filter(move |&index| levels[index as usize].qty > 0)
+            .map(move |index| {
+                let lvl = &levels[index as usize];
+                (self.level_price(index), lvl.qty, lvl.orders)
+            })
+    }
+
+    /// Заявки уровня в порядке приоритета (L3)
+    pub fn level_orders(&self, side: Side, price: i64) -> impl Iterator<Item = &Order> + '_ {
+        let index = self.level_index(price);
+        let mut slot = if index == NIL {
+            NIL
+        } else {
+            match side {
+                Side::Bid => self.bids[index as usize].head,
+                Side::Ask => self.asks[index as usize].head,
+            }
+        };
+
+        std::iter::from_fn(move || {
+            if slot == NIL {
+                return None;
+            }
+            let order = self.orders.get(slot);
+            slot = order.next;
+            Some(order)
+        })
+    }
+
+    /// Возвращает и сбрасывает признак изменения стакана
+    #[inline(always)]
+    pub fn take_changed(&mut self) -> bool {
+        std::mem::replace(&mut self.changed, false)
+    }
+}
@@ -0,0 +1,204 @@
+// src/book/orders.rs
+use crate::numa::array::NodeArray;
+
+/// Индекс отсутствующей заявки / пустой ссылки
+pub const NIL: u32 = u32::MAX;
+
+/// Сторона заявки
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(u8)]
+pub enum Side {
+    Bid = 0,
+    Ask = 1,
+}
+
+impl Side {
+    /// Сторона по коду ITCH (b'B' - покупка, b'S' - продажа)
+    #[inline(always)]
+    pub fn from_itch(code: u8) -> Side {
+        if code == b'B' {
+            Side::Bid
+        } else {
+            Side::Ask
+        }
+    }
+}
+
+/// Заявка в пуле
+///
+/// `prev`/`next` связывают заявки одного ценового уровня в порядке
+/// поступления (очередь приоритета); в свободной заявке `next` указывает
+/// на следующую свободную.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct Order {
+    pub id: u64,
+    pub price: i64,
+    pub qty: u32,
+    /// Индекс ценового уровня или NIL, если цена вне окна стакана
+    pub level: u32,
+    pub prev: u32,
+    pub next: u32,
+    pub side: Side,
+}
+
+impl Order {
+    const EMPTY: Order = Order {
+        id: 0,
+        price: 0,
+        qty: 0,
+        level: NIL,
+        prev: NIL,
+        next: NIL,
+        side: Side::Bid,
+    };
+}
+
+/// Таблица заявок: пул фиксированного размера и хеш-индекс по id
+///
+/// Индекс - открытая адресация с линейным пробированием и удалением со
+/// сдвигом назад (без надгробий), ячейки хранят номер слота пула. Вся
+/// память выделяется при создании; при исчерпании пула `insert`
+/// возвращает None вместо роста.
+pub struct OrderTable {
+    pool: NodeArray<Order>,
+    index: NodeArray<u32>,
+    mask: usize,
+    free_head: u32,
+    live: usize,
+}
+
+impl OrderTable {
+    /// Создает таблицу на `capacity` заявок; индекс вдвое больше пула
+    pub fn new(capacity: usize, numa_node: Option<usize>) -> Self {
+        let capacity = capacity.clamp(1, NIL as usize - 1);
+        let index_size = (capacity * 2).next_power_of_two();
+
+        let mut pool = NodeArray::new(capacity, Order::EMPTY, numa_node);
+        for (i, order) in pool.iter_mut().enumerate() {
+            order.next = if i + 1 < capacity {
+                (i + 1) as u32
+            } else {
+                NIL
+            };
+        }
+
+        Self {
+            pool,
+            index: NodeArray::new(index_size, NIL, numa_node),
+            mask: index_size - 1,
+            free_head: 0,
+            live: 0,
+        }
+    }
+
+    /// Количество заявок в таблице
+    #[inline(always)]
+    pub fn len(&self) -> usize {
+        self.live
+    }
+
+    #[inline(always)]
+    pub fn is_empty(&self) -> bool {
+        self.live == 0
+    }
+
+    /// Емкость пула
+    #[inline(always)]
+    pub fn capacity(&self) -> usize {
+        self.pool.len()
+    }
+
+    #[inline(always)]
+    fn home(&self, id: u64) -> usize {
+        (id.wrapping_mul(0x9E37_79B9_7F4A_7C15) >> 32) as usize & self.mask
+    }
+
+    /// Находит слот заявки по id
+    #[inline(always)]
+    pub fn find(&self, id: u64) -> Option<u32> {
+        let mut pos = self.home(id);
+        loop {
+            let slot = self.index[pos];
+            if slot == NIL {
+                return None;
+            }
+            if self.pool[slot as usize].id == id {
+                return Some(slot);
+            }
+            pos = (pos + 1) & self.mask;
+        }
+    }
+
+    /// Добавляет заявку; None - id уже есть или пул исчерпан
+    #[inline(always)]
+    pub fn insert(&mut self, order: Order) -> Option<u32> {
+        if self.free_head == NIL {
+            return None;
+        }
+
+        let mut pos = self.home(order.id);
+        loop {
+            let slot = self.index[pos];
+            if slot == NIL {
+                break;
+            }
+            if self.pool[slot as usize].id == order.id {
+                return None;
+            }
+            pos = (pos + 1) & self.mask;
+        }
+
+        let slot = self.free_head;
+        self.free_head = self.pool[slot as usize].next;
+        self.pool[slot as usize] = order;
+        self.index[pos] = slot;
+        self.live += 1;
+        Some(slot)
+    }
+
+    /// Удаляет заявку из индекса и возвращает слот в пул
+    #[inline(always)]
+    pub fn remove(&mut self, slot: u32) {
+        let id = self.pool[slot as usize].id;
+        let mut pos = self.home(id);
+        while self.index[pos] != slot {
+            debug_assert!(self.index[pos] != NIL);
+            pos = (pos + 1) & self.mask;
+        }
+
+        // Сдвигаем назад следующие элементы цепочки, чтобы не оставлять дыр
+        let mut hole = pos;
+        let mut next = (hole + 1) & self.mask;
+        loop {
+            let moved = self.index[next];
+            if moved == NIL {
+                break;
+            }
+            let home = self.home(self.pool[moved as usize].id);
+            // Элемент можно перенести в дыру, если его home не лежит в (hole, next]
+            if (next.wrapping_sub(home) & self.mask) >= (next.wrapping_sub(hole) & self.mask) {
+                self.index[hole] = moved;
+                hole = next;
+            }
+            next = (next + 1) & self.mask;
+        }
+        self.index[hole] = NIL;
+
+        self.pool[slot as usize].next = self.free_head;
+        self.pool[slot as usize].level = NIL;
+        self.free_head = slot;
+        self.live -= 1;
+    }
+
+    /// Заявка в слоте
+    #[inline(always)]
+    pub fn get(&self, slot: u32) -> &Order {
+        &self.pool[slot as usize]
+    }
+
+    #[inline(always)]
+    pub fn get_mut(&mut self, slot: u32) -> &mut Order {
+        &mut self.pool[slot as usize]
+    }
+}
@@ -0,0 +1,195 @@
+// src/capture/file.rs
+use std::alloc::{alloc_zeroed, dealloc, Layout};
+use std::fs::{File, OpenOptions};
+use std::io::Write;
+use std::os::unix::fs::OpenOptionsExt;
+use std::os::unix::io::AsRawFd;
+
+/// Выравнивание адреса, смещения и длины записи для O_DIRECT
+pub const DIRECT_IO_ALIGN: usize = 4096;
+
+/// Минимальный размер буфера: блок pcapng с пакетом максимальной длины
+/// и хвост предыдущей записи
+const MIN_BUFFER_SIZE: usize = 256 * 1024;
+
+/// Файл, записываемый крупными выровненными блоками
+///
+/// Данные накапливаются в буфере, выровненном по `DIRECT_IO_ALIGN`, и
+/// уходят в файл целыми блоками. С O_DIRECT запись идет мимо page cache:
+/// поток захвата не вытесняет память и не порождает writeback в
+/// произвольные моменты. Неполный последний блок дописывается в `finish`
+/// после снятия O_DIRECT с дескриптора.
+pub struct DirectFile {
+    file: File,
+    buf: *mut u8,
+    cap: usize,
+    len: usize,
+    direct: bool,
+    written: u64,
+}
+
+unsafe impl Send for DirectFile {}
+
+impl DirectFile {
+    /// Создает (перезаписывает) файл
+    ///
+    /// Если файловая система не поддерживает O_DIRECT (tmpfs, часть
+    /// сетевых ФС), файл открывается для обычной буферизованной записи.
+    pub fn create(path: &str, buffer_size: usize, direct_io: bool) -> Result<Self, String> {
+        let open = |flags: i32| {
+            OpenOptions::new()
+                .write(true)
+                .create(true)
+                .truncate(true)
+                .custom_flags(flags)
+                .open(path)
+        };
+
+        let (file, direct) = if direct_io {
+            match open(libc::O_DIRECT) {
+                Ok(file) => (file, true),
+                Err(e) => {
+                    eprintln!(
+                        "Warning: O_DIRECT is not available for {}: {}, using buffered writes",
+                        path, e
+                    );
+                    (
+                        open(0).map_err(|e| format!("Failed to create {}: {}", path, e))?,
+                        false,
+                    )
+                }
+            }
+        } else {
+            (
+                open(0).map_err(|e| format!("Failed to create {}: {}", path, e))?,
+                false,
+            )
+        };
+
+        let cap = (buffer_size.max(MIN_BUFFER_SIZE) + DIRECT_IO_ALIGN - 1) & !(DIRECT_IO_ALIGN - 1);
+        let layout = Layout::from_size_align(cap, DIRECT_IO_ALIGN)
+            .map_err(|e| format!("Invalid capture buffer size {}: {}", cap, e))?;
+        let buf = unsafe { alloc_zeroed(layout) };
+        if buf.is_null() {
+            return Err(format!("Failed to allocate {} byte capture buffer", cap));
+        }
+
+        Ok(Self {
+            file,
+            buf,
+            cap,
+            len: 0,
+            direct,
+            written: 0,
+        })
+    }
+
+    /// Открыт ли файл с O_DIRECT
+    pub fn is_direct(&self) -> bool {
+        self.direct
+    }
+
+    /// Байт, переданных в файл и ожидающих в буфере
+    pub fn position(&self) -> u64 {
+        self.written + self.len as u64
+    }
+
+    /// Возвращает `n` свободных байт в конце буфера; при нехватке места
+    /// сначала записывает накопленные целые блоки
+    ///
+    /// Зарезервированное место становится частью файла после `commit`.
+    #[inline]
+    pub fn reserve(&mut self, n: usize) -> Result<&mut [u8], String> {
+        if self.len + n > self.cap {
+            self.flush_blocks()?;
+            if self.len + n > self.cap {
+                return Err(format!(
+                    "Capture record of {} bytes does not fit {} byte buffer",
+                    n, self.cap
+                ));
+            }
+        }
+
+        Ok(unsafe { std::slice::from_raw_parts_mut(self.buf.add(self.len), n) })
+    }
+
+    /// Добавляет к файлу `n` байт, заполненных после `reserve`
+    #[inline]
+    pub fn commit(&mut self, n: usize) {
+        debug_assert!(self.len + n <= self.cap);
+        self.len += n;
+    }
+
+    /// Копирует `data` в буфер
+    pub fn write_all(&mut self, data: &[u8]) -> Result<(), String> {
+        self.reserve(data.len())?.copy_from_slice(data);
+        self.commit(data.len());
+        Ok(())
+    }
+
+    /// Записывает целые блоки буфера, хвост переносит в начало
+    fn flush_blocks(&mut self) -> Result<(), String> {
+        let aligned = self.len & !(DIRECT_IO_ALIGN - 1);
+        if aligned == 0 {
+            return Ok(());
+        }
+
+        let data = unsafe { std::slice::from_raw_parts(self.buf, aligned) };
+        self.file
+            .write_all(data)
+            .map_err(|e| format!("Capture write failed: {}", e))?;
+        self.written += aligned as u64;
+
+        let tail = self.len - aligned;
+        unsafe { std::ptr::copy(self.buf.add(aligned), self.buf, tail) };
+        self.len = tail;
+        Ok(())
+    }
+
+    /// Дописывает остаток буфера и сбрасывает данные на устройство
+    ///
+    /// Возвращает итоговый размер файла.
+    pub fn finish(&mut self) -> Result<u64, String> {
+        self.flush_blocks()?;
+
+        if self.len > 0 {
+            if self.direct {
+                // Длина хвоста не кратна блоку: O_DIRECT ее не примет
+                let fd = self.file.as_raw_fd();
+                unsafe {
+                    let flags = libc::fcntl(fd, libc::F_GETFL);
+                    if flags < 0 || libc::fcntl(fd, libc::F_SETFL, flags & !libc::O_DIRECT) < 0 {
+                        return Err(format!(
+                            "Failed to clear O_DIRECT: {}",
+                            std::io::Error::last_os_error()
+                        ));
+                    }
+                }
+                self.direct = false;
+            }
+
+            let data = unsafe { std::slice::from_raw_parts(self.buf, self.len) };
+            self.file
+                .write_all(data)
+                .map_err(|e| format!("Capture write failed: {}", e))?;
+            self.written += self.len as u64;
+            self.len = 0;
+        }
+
+        self.file
+            .sync_data()
+            .map_err(|e| format!("Capture fsync failed: {}", e))?;
+        Ok(self.written)
+    }
+}
+
+impl Drop for DirectFile {
+    fn drop(&mut self) {
+        unsafe {
+            dealloc(
+                self.buf,
+                Layout::from_size_align_unchecked(self.cap, DIRECT_IO_ALIGN),
+            )
+        };
+    }
+}
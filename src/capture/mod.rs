@@ -0,0 +1,5 @@
+pub mod file;
+pub mod pcapng;
+pub mod reader;
+pub mod replay;
+pub mod tap;
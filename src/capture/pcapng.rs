@@ -0,0 +1,232 @@
+// src/capture/pcapng.rs
+use crate::capture::file::DirectFile;
+
+const SHB_TYPE: u32 = 0x0A0D_0D0A;
+const IDB_TYPE: u32 = 0x0000_0001;
+const ISB_TYPE: u32 = 0x0000_0005;
+const EPB_TYPE: u32 = 0x0000_0006;
+const BYTE_ORDER_MAGIC: u32 = 0x1A2B_3C4D;
+
+/// LINKTYPE_ETHERNET
+pub const LINKTYPE_ETHERNET: u16 = 1;
+
+const OPT_ENDOFOPT: u16 = 0;
+const SHB_USERAPPL: u16 = 4;
+const IF_NAME: u16 = 2;
+const IF_TSRESOL: u16 = 9;
+const EPB_QUEUE: u16 = 6;
+const ISB_STARTTIME: u16 = 2;
+const ISB_ENDTIME: u16 = 3;
+const ISB_IFRECV: u16 = 4;
+const ISB_IFDROP: u16 = 5;
+
+/// Заголовок EPB до данных пакета и хвост: опция epb_queue, конец опций,
+/// повтор длины блока
+const EPB_HEADER_LEN: usize = 28;
+const EPB_TRAILER_LEN: usize = 16;
+
+#[inline(always)]
+fn pad4(n: usize) -> usize {
+    (n + 3) & !3
+}
+
+/// Построитель блока со списком опций
+struct Block {
+    data: Vec<u8>,
+}
+
+impl Block {
+    fn new(block_type: u32) -> Self {
+        let mut data = Vec::with_capacity(128);
+        data.extend_from_slice(&block_type.to_le_bytes());
+        data.extend_from_slice(&0u32.to_le_bytes());
+        Self { data }
+    }
+
+    fn u16(mut self, value: u16) -> Self {
+        self.data.extend_from_slice(&value.to_le_bytes());
+        self
+    }
+
+    fn u32(mut self, value: u32) -> Self {
+        self.data.extend_from_slice(&value.to_le_bytes());
+        self
+    }
+
+    fn u64(mut self, value: u64) -> Self {
+        self.data.extend_from_slice(&value.to_le_bytes());
+        self
+    }
+
+    fn option(mut self, code: u16, value: &[u8]) -> Self {
+        self.data.extend_from_slice(&code.to_le_bytes());
+        self.data
+            .extend_from_slice(&(value.len() as u16).to_le_bytes());
+        self.data.extend_from_slice(value);
+        self.data.resize(pad4(self.data.len()), 0);
+        self
+    }
+
+    /// Время в формате pcapng: старшие, затем младшие 32 бита
+    fn timestamp_option(self, code: u16, ts_ns: u64) -> Self {
+        let mut value = [0u8; 8];
+        value[..4].copy_from_slice(&((ts_ns >> 32) as u32).to_le_bytes());
+        value[4..].copy_from_slice(&(ts_ns as u32).to_le_bytes());
+        self.option(code, &value)
+    }
+
+    fn finish(self) -> Vec<u8> {
+        let mut data = self.option(OPT_ENDOFOPT, &[]).data;
+        let total_len = (data.len() + 4) as u32;
+        data[4..8].copy_from_slice(&total_len.to_le_bytes());
+        data.extend_from_slice(&total_len.to_le_bytes());
+        data
+    }
+}
+
+/// Запись pcapng: одна секция, по интерфейсу (IDB) на порт DPDK
+///
+/// Время пакетов - наносекунды UNIX (`if_tsresol` = 9), `epb_queue` -
+/// номер RX очереди. Числа записываются в little-endian, читатели
+/// определяют порядок байтов по magic заголовка секции.
+pub struct PcapngWriter {
+    out: DirectFile,
+    /// port_id каждого интерфейса, индекс - номер интерфейса в секции
+    interfaces: Vec<u16>,
+    snap_len: u32,
+}
+
+impl PcapngWriter {
+    /// Записывает заголовок секции
+    pub fn new(mut out: DirectFile, application: &str, snap_len: u32) -> Result<Self, String> {
+        let shb = Block::new(SHB_TYPE)
+            .u32(BYTE_ORDER_MAGIC)
+            .u16(1)
+            .u16(0)
+            // Длина секции неизвестна
+            .u64(u64::MAX)
+            .option(SHB_USERAPPL, application.as_bytes())
+            .finish();
+        out.write_all(&shb)?;
+
+        Ok(Self {
+            out,
+            interfaces: Vec::new(),
+            snap_len,
+        })
+    }
+
+    /// Добавляет интерфейс порта, возвращает его номер в секции
+    pub fn add_interface(&mut self, port_id: u16) -> Result<u32, String> {
+        if let Some(if_id) = self.interface_id(port_id) {
+            return Ok(if_id);
+        }
+
+        let idb = Block::new(IDB_TYPE)
+            .u16(LINKTYPE_ETHERNET)
+            .u16(0)
+            // 0 - без ограничения длины
+            .u32(self.snap_len)
+            .option(IF_NAME, format!("dpdk{}", port_id).as_bytes())
+            .option(IF_TSRESOL, &[9])
+            .finish();
+        self.out.write_all(&idb)?;
+
+        self.interfaces.push(port_id);
+        Ok(self.interfaces.len() as u32 - 1)
+    }
+
+    /// Номер интерфейса порта
+    #[inline]
+    pub fn interface_id(&self, port_id: u16) -> Option<u32> {
+        self.interfaces
+            .iter()
+            .position(|&p| p == port_id)
+            .map(|i| i as u32)
+    }
+
+    /// port_id интерфейсов секции
+    pub fn interfaces(&self) -> &[u16] {
+        &self.interfaces
+    }
+
+    /// Длина записываемой части пакета длиной `orig_len`
+    #[inline]
+    pub fn captured_len(&self, orig_len: u32) -> u32 {
+        if self.snap_len == 0 {
+            orig_len
+        } else {
+            orig_len.min(self.snap_len)
+        }
+    }
+
+    /// Записывает Enhanced Packet Block
+    ///
+    /// Данные копирует `fill` прямо в буфер записи: он получает срез
+    /// длиной `captured_len(orig_len)`. Возвращает размер блока.
+    #[inline]
+    pub fn write_packet<F>(
+        &mut self,
+        if_id: u32,
+        ts_ns: u64,
+        queue_id: u16,
+        orig_len: u32,
+        fill: F,
+    ) -> Result<usize, String>
+    where
+        F: FnOnce(&mut [u8]),
+    {
+        let cap_len = self.captured_len(orig_len) as usize;
+        let data_end = EPB_HEADER_LEN + pad4(cap_len);
+        let total_len = data_end + EPB_TRAILER_LEN;
+        let block = self.out.reserve(total_len)?;
+
+        let mut put = |offset: usize, value: u32| {
+            block[offset..offset + 4].copy_from_slice(&value.to_le_bytes());
+        };
+        put(0, EPB_TYPE);
+        put(4, total_len as u32);
+        put(8, if_id);
+        put(12, (ts_ns >> 32) as u32);
+        put(16, ts_ns as u32);
+        put(20, cap_len as u32);
+        put(24, orig_len);
+        put(data_end, EPB_QUEUE as u32 | (4 << 16));
+        put(data_end + 4, queue_id as u32);
+        put(data_end + 8, OPT_ENDOFOPT as u32);
+        put(data_end + 12, total_len as u32);
+
+        let data = &mut block[EPB_HEADER_LEN..data_end];
+        data[cap_len..].fill(0);
+        fill(&mut data[..cap_len]);
+
+        self.out.commit(total_len);
+        Ok(total_len)
+    }
+
+    /// Записывает статистику интерфейса (Interface Statistics Block)
+    pub fn write_interface_stats(
+        &mut self,
+        if_id: u32,
+        start_ns: u64,
+        end_ns: u64,
+        received: u64,
+        dropped: u64,
+    ) -> Result<(), String> {
+        let isb = Block::new(ISB_TYPE)
+            .u32(if_id)
+            .u32((end_ns >> 32) as u32)
+            .u32(end_ns as u32)
+            .timestamp_option(ISB_STARTTIME, start_ns)
+            .timestamp_option(ISB_ENDTIME, end_ns)
+            .option(ISB_IFRECV, &received.to_le_bytes())
+            .option(ISB_IFDROP, &dropped.to_le_bytes())
+            .finish();
+        self.out.write_all(&isb)
+    }
+
+    /// Дописывает файл, возвращает его размер
+    pub fn finish(mut self) -> Result<u64, String> {
+        self.out.finish()
+    }
+}
@@ -0,0 +1,372 @@
+// src/capture/reader.rs
+const PCAP_MAGIC_US: u32 = 0xA1B2_C3D4;
+const PCAP_MAGIC_NS: u32 = 0xA1B2_3C4D;
+const PCAP_HEADER_LEN: usize = 24;
+const PCAP_RECORD_LEN: usize = 16;
+
+const SHB_TYPE: u32 = 0x0A0D_0D0A;
+const IDB_TYPE: u32 = 0x0000_0001;
+const PB_TYPE: u32 = 0x0000_0002;
+const SPB_TYPE: u32 = 0x0000_0003;
+const EPB_TYPE: u32 = 0x0000_0006;
+const BYTE_ORDER_MAGIC: u32 = 0x1A2B_3C4D;
+
+const LINKTYPE_ETHERNET: u32 = 1;
+const IF_TSRESOL: u16 = 9;
+const IF_TSOFFSET: u16 = 14;
+const EPB_QUEUE: u16 = 6;
+
+/// Пакет из файла записи
+#[derive(Debug, Clone, Copy)]
+pub struct RecordedPacket<'a> {
+    /// Время UNIX в наносекундах
+    pub ts_ns: u64,
+    /// Записанная часть кадра Ethernet
+    pub data: &'a [u8],
+    /// Длина кадра на линии
+    pub orig_len: u32,
+    /// RX очередь из опции `epb_queue`, если она записана
+    pub queue: Option<u32>,
+}
+
+/// Разрешение времени интерфейса pcapng (`if_tsresol`)
+#[derive(Debug, Clone, Copy)]
+enum TsResolution {
+    /// 10^-n секунды
+    Decimal(u32),
+    /// 2^-n секунды
+    Binary(u32),
+}
+
+impl TsResolution {
+    #[inline]
+    fn to_ns(self, units: u64) -> u64 {
+        match self {
+            TsResolution::Decimal(n) if n <= 9 => units.saturating_mul(10u64.pow(9 - n)),
+            TsResolution::Decimal(n) => units / 10u64.pow((n - 9).min(19)),
+            TsResolution::Binary(n) => ((units as u128 * 1_000_000_000) >> n.min(127)) as u64,
+        }
+    }
+}
+
+#[derive(Debug, Clone, Copy)]
+struct Interface {
+    ethernet: bool,
+    resolution: TsResolution,
+    offset_ns: i64,
+}
+
+#[derive(Debug)]
+enum Format {
+    Pcap { nanos: bool, ethernet: bool },
+    Pcapng { interfaces: Vec<Interface> },
+}
+
+/// Последовательное чтение пакетов из образа файла pcap или pcapng
+///
+/// Поддерживаются оба порядка байтов, для pcapng - несколько секций,
+/// блоки EPB, SPB и устаревший PB. Пакеты интерфейсов с типом канала,
+/// отличным от Ethernet, пропускаются. Обрезанная запись в конце файла
+/// (файл дописывается или запись прервана) считается концом файла.
+#[derive(Debug)]
+pub struct RecordReader<'a> {
+    data: &'a [u8],
+    offset: usize,
+    swapped: bool,
+    format: Format,
+    /// Время последнего пакета: у SPB собственного времени нет
+    last_ts_ns: u64,
+}
+
+impl<'a> RecordReader<'a> {
+    /// Определяет формат по заголовку файла
+    pub fn new(data: &'a [u8]) -> Result<Self, String> {
+        if data.len() < 12 {
+            return Err("File is too short for a pcap header".to_string());
+        }
+
+        let magic = u32::from_le_bytes([data[0], data[1], data[2], data[3]]);
+
+        if magic == SHB_TYPE {
+            let mut reader = Self {
+                data,
+                offset: 0,
+                swapped: false,
+                format: Format::Pcapng {
+                    interfaces: Vec::new(),
+                },
+                last_ts_ns: 0,
+            };
+            // Порядок байтов секции задает magic, заголовок читается в next_packet
+            reader.read_section_order(0)?;
+            return Ok(reader);
+        }
+
+        let (swapped, nanos) = match magic {
+            PCAP_MAGIC_US => (false, false),
+            PCAP_MAGIC_NS => (false, true),
+            m if m.swap_bytes() == PCAP_MAGIC_US => (true, false),
+            m if m.swap_bytes() == PCAP_MAGIC_NS => (true, true),
+            m => return Err(format!("Unknown capture file magic 0x{:08x}", m)),
+        };
+        if data.len() < PCAP_HEADER_LEN {
+            return Err("File is too short for a pcap header".to_string());
+        }
+
+        let mut linktype = u32::from_le_bytes([data[20], data[21], data[22], data[23]]);
+        if swapped {
+            linktype = linktype.swap_bytes();
+        }
+        // Старшие биты поля network заняты FCS и флагами
+        let linktype = linktype & 0x0FFF_FFFF;
+        if linktype != LINKTYPE_ETHERNET {
+            return Err(format!("Unsupported pcap link type {}", linktype));
+        }
+
+        Ok(Self {
+            data,
+            offset: PCAP_HEADER_LEN,
+            swapped,
+            format: Format::Pcap {
+                nanos,
+                ethernet: true,
+            },
+            last_ts_ns: 0,
+        })
+    }
+
+    /// Смещение следующей записи в файле
+    pub fn position(&self) -> usize {
+        self.offset
+    }
+
+    #[inline(always)]
+    fn u16_at(&self, offset: usize) -> u16 {
+        let v = u16::from_le_bytes([self.data[offset], self.data[offset + 1]]);
+        if self.swapped {
+            v.swap_bytes()
+        } else {
+            v
+        }
+    }
+
+    #[inline(always)]
+    fn u32_at(&self, offset: usize) -> u32 {
+        let mut b = [0u8; 4];
+        b.copy_from_slice(&self.data[offset..offset + 4]);
+        let v = u32::from_le_bytes(b);
+        if self.swapped {
+            v.swap_bytes()
+        } else {
+            v
+        }
+    }
+
+    #[inline(always)]
+    fn u64_at(&self, offset: usize) -> u64 {
+        let mut b = [0u8; 8];
+        b.copy_from_slice(&self.data[offset..offset + 8]);
+        let v = u64::from_le_bytes(b);
+        if self.swapped {
+            v.swap_bytes()
+        } else {
+            v
+        }
+    }
+
+    /// Читает порядок байтов секции, начинающейся в `offset`
+    fn read_section_order(&mut self, offset: usize) -> Result<(), String> {
+        if self.data.len() < offset + 12 {
+            return Err("Truncated pcapng section header".to_string());
+        }
+        let b = &self.data[offset + 8..offset + 12];
+        let magic = u32::from_le_bytes([b[0], b[1], b[2], b[3]]);
+        self.swapped = match magic {
+            BYTE_ORDER_MAGIC => false,
+            m if m.swap_bytes() == BYTE_ORDER_MAGIC => true,
+            m => return Err(format!("Bad pcapng byte order magic 0x{:08x}", m)),
+        };
+        Ok(())
+    }
+
+    /// Следующий пакет; None - конец файла
+    #[inline]
+    pub fn next_packet(&mut self) -> Option<RecordedPacket<'a>> {
+        match self.format {
+            Format::Pcap { nanos, ethernet } => self.next_pcap(nanos, ethernet),
+            Format::Pcapng { .. } => self.next_pcapng(),
+        }
+    }
+
+    fn next_pcap(&mut self, nanos: bool, ethernet: bool) -> Option<RecordedPacket<'a>> {
+        let offset = self.offset;
+        if !ethernet || self.data.len() < offset + PCAP_RECORD_LEN {
+            return None;
+        }
+
+        let sec = self.u32_at(offset) as u64;
+        let frac = self.u32_at(offset + 4) as u64;
+        let cap_len = self.u32_at(offset + 8) as usize;
+        let orig_len = self.u32_at(offset + 12);
+        let start = offset + PCAP_RECORD_LEN;
+        if self.data.len() < start + cap_len {
+            return None;
+        }
+
+        self.offset = start + cap_len;
+        let ts_ns = sec * 1_000_000_000 + if nanos { frac } else { frac * 1_000 };
+        self.last_ts_ns = ts_ns;
+
+        Some(RecordedPacket {
+            ts_ns,
+            data: &self.data[start..start + cap_len],
+            orig_len,
+            queue: None,
+        })
+    }
+
+    fn next_pcapng(&mut self) -> Option<RecordedPacket<'a>> {
+        loop {
+            let offset = self.offset;
+            if self.data.len() < offset + 12 {
+                return None;
+            }
+
+            if u32::from_le_bytes([
+                self.data[offset],
+                self.data[offset + 1],
+                self.data[offset + 2],
+                self.data[offset + 3],
+            ]) == SHB_TYPE
+            {
+                self.read_section_order(offset).ok()?;
+                if let Format::Pcapng { interfaces } = &mut self.format {
+                    interfaces.clear();
+                }
+            }
+
+            let block_type = self.u32_at(offset);
+            let block_len = self.u32_at(offset + 4) as usize;
+            if block_len < 12 || block_len % 4 != 0 || self.data.len() < offset + block_len {
+                return None;
+            }
+            self.offset = offset + block_len;
+            let body_end = offset + block_len - 4;
+
+            match block_type {
+                IDB_TYPE if block_len >= 20 => {
+                    let interface = self.read_interface(offset, body_end);
+                    if let Format::Pcapng { interfaces } = &mut self.format {
+                        interfaces.push(interface);
+                    }
+                }
+                EPB_TYPE | PB_TYPE if block_len >= 32 => {
+                    let if_id = if block_type == EPB_TYPE {
+                        self.u32_at(offset + 8)
+                    } else {
+                        self.u16_at(offset + 8) as u32
+                    };
+                    let ts =
+                        ((self.u32_at(offset + 12) as u64) << 32) | self.u32_at(offset + 16) as u64;
+                    let cap_len = self.u32_at(offset + 20) as usize;
+                    let orig_len = self.u32_at(offset + 24);
+                    let start = offset + 28;
+                    if start + cap_len > body_end {
+                        return None;
+                    }
+
+                    let Some(interface) = self.interface(if_id) else {
+                        continue;
+                    };
+                    if !interface.ethernet {
+                        continue;
+                    }
+
+                    let queue = if block_type == EPB_TYPE {
+                        self.find_option(start + pad4(cap_len), body_end, EPB_QUEUE)
+                            .filter(|&(_, len)| len == 4)
+                            .map(|(value, _)| self.u32_at(value))
+                    } else {
+                        None
+                    };
+
+                    let ts_ns = (interface.resolution.to_ns(ts) as i64)
+                        .saturating_add(interface.offset_ns) as u64;
+                    self.last_ts_ns = ts_ns;
+
+                    return Some(RecordedPacket {
+                        ts_ns,
+                        data: &self.data[start..start + cap_len],
+                        orig_len,
+                        queue,
+                    });
+                }
+                SPB_TYPE if block_len >= 16 => {
+                    if !self.interface(0).map_or(false, |i| i.ethernet) {
+                        continue;
+                    }
+                    let orig_len = self.u32_at(offset + 8);
+                    let start = offset + 12;
+                    let cap_len = (orig_len as usize).min(body_end - start);
+
+                    return Some(RecordedPacket {
+                        ts_ns: self.last_ts_ns,
+                        data: &self.data[start..start + cap_len],
+                        orig_len,
+                        queue: None,
+                    });
+                }
+                _ => {}
+            }
+        }
+    }
+
+    fn interface(&self, if_id: u32) -> Option<Interface> {
+        match &self.format {
+            Format::Pcapng { interfaces } => interfaces.get(if_id as usize).copied(),
+            Format::Pcap { .. } => None,
+        }
+    }
+
+    fn read_interface(&self, offset: usize, body_end: usize) -> Interface {
+        let linktype = self.u16_at(offset + 8) as u32;
+        let resolution = match self.find_option(offset + 16, body_end, IF_TSRESOL) {
+            Some((value, 1)) if self.data[value] & 0x80 != 0 => {
+                TsResolution::Binary((self.data[value] & 0x7F) as u32)
+            }
+            Some((value, 1)) => TsResolution::Decimal(self.data[value] as u32),
+            _ => TsResolution::Decimal(6),
+        };
+        let offset_ns = match self.find_option(offset + 16, body_end, IF_TSOFFSET) {
+            Some((value, 8)) => (self.u64_at(value) as i64).saturating_mul(1_000_000_000),
+            _ => 0,
+        };
+
+        Interface {
+            ethernet: linktype == LINKTYPE_ETHERNET,
+            resolution,
+            offset_ns,
+        }
+    }
+
+    /// Ищет опцию `code` в списке опций [start, end): (смещение значения, длина)
+    fn find_option(&self, mut offset: usize, end: usize, code: u16) -> Option<(usize, usize)> {
+        while offset + 4 <= end {
+            let opt_code = self.u16_at(offset);
+            let opt_len = self.u16_at(offset + 2) as usize;
+            if opt_code == 0 || offset + 4 + opt_len > end {
+                return None;
+            }
+            if opt_code == code {
+                return Some((offset + 4, opt_len));
+            }
+            offset += 4 + pad4(opt_len);
+        }
+        None
+    }
+}
+
+#[inline(always)]
+fn pad4(n: usize) -> usize {
+    (n + 3) & !3
+}
@@ -0,0 +1,372 @@
+// src/capture/replay.rs
+use std::fs::File;
+use std::os::unix::io::AsRawFd;
+use std::sync::{
+    atomic::{AtomicU64, AtomicUsize, Ordering},
+    Arc, Mutex,
+};
+
+use crate::capture::reader::{RecordReader, RecordedPacket};
+use crate::dpdk::config::MAX_BURST_SIZE;
+use crate::dpdk::ffi::{self, RteMbuf, RteMempool};
+use crate::packet::timestamp::{tsc, tsc_hz};
+use crate::telemetry::worker::Counter;
+
+/// Темп воспроизведения записи
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ReplaySpeed {
+    /// С интервалами между пакетами, как при записи
+    Recorded,
+    /// Без пауз: каждый опрос получает полный burst
+    Max,
+    /// Интервалы записи, сжатые в N раз
+    Accelerated(f64),
+}
+
+impl ReplaySpeed {
+    /// Разбирает `recorded`, `max` или множитель `N`/`Nx`
+    pub fn parse(value: &str) -> Result<Self, String> {
+        match value {
+            "recorded" => Ok(ReplaySpeed::Recorded),
+            "max" => Ok(ReplaySpeed::Max),
+            _ => {
+                let factor: f64 = value
+                    .trim_end_matches('x')
+                    .parse()
+                    .map_err(|_| format!("Invalid replay speed: {}", value))?;
+                if !(factor > 0.0) {
+                    return Err(format!("Replay speed must be positive: {}", value));
+                }
+                Ok(ReplaySpeed::Accelerated(factor))
+            }
+        }
+    }
+}
+
+/// Источник RX из файла записи вместо порта
+#[derive(Debug, Clone)]
+pub struct ReplayConfig {
+    /// Файл pcap/pcapng; None - воспроизведение выключено
+    pub path: Option<String>,
+    pub speed: ReplaySpeed,
+    /// Порт, RX очереди которого читают запись вместо `rte_eth_rx_burst`
+    pub port_id: u16,
+}
+
+impl Default for ReplayConfig {
+    fn default() -> Self {
+        Self {
+            path: None,
+            speed: ReplaySpeed::Recorded,
+            port_id: 0,
+        }
+    }
+}
+
+impl ReplayConfig {
+    /// Включено ли воспроизведение
+    pub fn is_enabled(&self) -> bool {
+        self.path.is_some()
+    }
+}
+
+/// Счетчики источника воспроизведения одной RX очереди
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct ReplayCounters {
+    /// Пакетов передано worker
+    pub replayed: Counter,
+    pub bytes: Counter,
+    /// Опросов, в которых пул не выдал mbuf; пакеты burst повторяются
+    /// в следующем опросе
+    pub alloc_failures: Counter,
+}
+
+/// Файл записи, отображенный в память и общий для всех RX очередей
+///
+/// Пакет воспроизводится в очереди `epb_queue % num_rx_queues` (номер
+/// очереди, записанный захватом из src/capture/tap.rs); пакеты без этой
+/// опции, в т.ч. все пакеты pcap, приходят в очередь 0. Все очереди
+/// отсчитывают время от одного момента старта, поэтому взаимный темп
+/// потоков сохраняется.
+pub struct ReplayFile {
+    path: String,
+    map: *const u8,
+    len: usize,
+    speed: ReplaySpeed,
+    port_id: u16,
+    num_queues: u16,
+    /// Время первого пакета файла
+    first_ts_ns: u64,
+    /// Тактов TSC на наносекунду записи с учетом ускорения
+    ticks_per_ns: f64,
+    /// TSC первого опроса любой очереди, 0 - воспроизведение не начато
+    start_tsc: AtomicU64,
+    /// Источники, еще не дошедшие до конца файла
+    active: AtomicUsize,
+    counters: Mutex<Vec<Arc<ReplayCounters>>>,
+}
+
+unsafe impl Send for ReplayFile {}
+unsafe impl Sync for ReplayFile {}
+
+impl ReplayFile {
+    /// Отображает файл в память и проверяет формат
+    pub fn open(config: &ReplayConfig, num_queues: u16) -> Result<Arc<Self>, String> {
+        let path = config
+            .path
+            .clone()
+            .ok_or_else(|| "Replay path is not set".to_string())?;
+        let file = File::open(&path).map_err(|e| format!("Failed to open {}: {}", path, e))?;
+        let len = file
+            .metadata()
+            .map_err(|e| format!("Failed to stat {}: {}", path, e))?
+            .len() as usize;
+        if len == 0 {
+            return Err(format!("Replay file {} is empty", path));
+        }
+
+        let map = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if map == libc::MAP_FAILED {
+            return Err(format!(
+                "Failed to map {}: {}",
+                path,
+                std::io::Error::last_os_error()
+            ));
+        }
+        // Каждая очередь читает файл от начала до конца
+        unsafe { libc::madvise(map, len, libc::MADV_SEQUENTIAL) };
+
+        let hz = tsc_hz() as f64;
+        let ticks_per_ns = match config.speed {
+            ReplaySpeed::Recorded => hz / 1e9,
+            ReplaySpeed::Accelerated(factor) => hz / 1e9 / factor,
+            ReplaySpeed::Max => 0.0,
+        };
+
+        let mut replay = Self {
+            path,
+            map: map as *const u8,
+            len,
+            speed: config.speed,
+            port_id: config.port_id,
+            num_queues: num_queues.max(1),
+            first_ts_ns: 0,
+            ticks_per_ns,
+            start_tsc: AtomicU64::new(0),
+            active: AtomicUsize::new(0),
+            counters: Mutex::new(Vec::new()),
+        };
+
+        let mut reader = RecordReader::new(replay.data())?;
+        let first = reader
+            .next_packet()
+            .ok_or_else(|| format!("Replay file {} has no Ethernet packets", replay.path))?;
+        replay.first_ts_ns = first.ts_ns;
+
+        println!(
+            "Replaying {} ({} MB) on port {} at {:?} speed",
+            replay.path,
+            len >> 20,
+            replay.port_id,
+            replay.speed
+        );
+        Ok(Arc::new(replay))
+    }
+
+    fn data(&self) -> &[u8] {
+        unsafe { std::slice::from_raw_parts(self.map, self.len) }
+    }
+
+    /// Порт, RX очереди которого воспроизводят запись
+    pub fn port_id(&self) -> u16 {
+        self.port_id
+    }
+
+    /// Создает источник для RX очереди; mbuf выделяются из `pool`
+    pub fn source(self: &Arc<Self>, queue_id: u16, pool: *mut RteMempool) -> ReplaySource {
+        // Образ файла живет, пока источник держит Arc на ReplayFile
+        let data: &'static [u8] = unsafe { std::slice::from_raw_parts(self.map, self.len) };
+        let reader = RecordReader::new(data).expect("replay file format checked in open");
+        let counters = Arc::new(ReplayCounters::default());
+
+        self.counters
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .push(counters.clone());
+        self.active.fetch_add(1, Ordering::SeqCst);
+
+        ReplaySource {
+            reader,
+            next: None,
+            pending_data: [std::ptr::null(); MAX_BURST_SIZE],
+            pending_lens: [0; MAX_BURST_SIZE],
+            nb_pending: 0,
+            done: false,
+            queue_id,
+            pool,
+            counters,
+            file: self.clone(),
+        }
+    }
+
+    /// Все источники дошли до конца файла
+    pub fn is_finished(&self) -> bool {
+        self.start_tsc.load(Ordering::Relaxed) != 0 && self.active.load(Ordering::SeqCst) == 0
+    }
+
+    /// Суммарные счетчики: (пакеты, байты, ошибки выделения mbuf)
+    pub fn totals(&self) -> (u64, u64, u64) {
+        let counters = self.counters.lock().unwrap_or_else(|e| e.into_inner());
+        counters.iter().fold((0, 0, 0), |acc, c| {
+            (
+                acc.0 + c.replayed.get(),
+                acc.1 + c.bytes.get(),
+                acc.2 + c.alloc_failures.get(),
+            )
+        })
+    }
+
+    /// TSC начала воспроизведения; первый вызов фиксирует его
+    #[inline]
+    fn start_tsc(&self, now: u64) -> u64 {
+        let start = self.start_tsc.load(Ordering::Relaxed);
+        if start != 0 {
+            return start;
+        }
+        match self
+            .start_tsc
+            .compare_exchange(0, now, Ordering::Relaxed, Ordering::Relaxed)
+        {
+            Ok(_) => now,
+            Err(start) => start,
+        }
+    }
+
+    /// Момент выдачи пакета в тактах TSC от начала воспроизведения
+    #[inline(always)]
+    fn release_offset(&self, ts_ns: u64) -> u64 {
+        (ts_ns.saturating_sub(self.first_ts_ns) as f64 * self.ticks_per_ns) as u64
+    }
+}
+
+impl Drop for ReplayFile {
+    fn drop(&mut self) {
+        unsafe { libc::munmap(self.map as *mut libc::c_void, self.len) };
+    }
+}
+
+/// Источник RX одной очереди: замена `rte_eth_rx_burst` в RX worker
+///
+/// Выдает mbuf из пула порта с копией записанных кадров, так что разбор,
+/// классификатор, обработчики и освобождение mbuf идут по тому же пути,
+/// что и с NIC. Порядок пакетов очереди совпадает с записью.
+pub struct ReplaySource {
+    /// Читает образ `file`; объявлен раньше, чтобы уничтожаться первым
+    reader: RecordReader<'static>,
+    /// Пакет очереди, время которого еще не наступило
+    next: Option<RecordedPacket<'static>>,
+    /// Пакеты burst, для которых не удалось выделить mbuf
+    pending_data: [*const u8; MAX_BURST_SIZE],
+    pending_lens: [u32; MAX_BURST_SIZE],
+    nb_pending: usize,
+    done: bool,
+    queue_id: u16,
+    pool: *mut RteMempool,
+    counters: Arc<ReplayCounters>,
+    file: Arc<ReplayFile>,
+}
+
+unsafe impl Send for ReplaySource {}
+
+impl ReplaySource {
+    /// Заполняет `pkts` пакетами, время которых наступило
+    ///
+    /// Возвращает количество пакетов, как `rte_eth_rx_burst`; после конца
+    /// файла всегда 0.
+    #[inline]
+    pub fn rx_burst(&mut self, pkts: &mut [*mut RteMbuf]) -> u16 {
+        if self.done {
+            return 0;
+        }
+
+        let now = tsc();
+        let start = self.file.start_tsc(now);
+        let paced = self.file.speed != ReplaySpeed::Max;
+        let want = pkts.len().min(MAX_BURST_SIZE);
+
+        while self.nb_pending < want {
+            let Some(packet) = self.next.take().or_else(|| self.next_for_queue()) else {
+                break;
+            };
+            if paced && start + self.file.release_offset(packet.ts_ns) > now {
+                self.next = Some(packet);
+                break;
+            }
+            self.pending_data[self.nb_pending] = packet.data.as_ptr();
+            self.pending_lens[self.nb_pending] = packet.data.len() as u32;
+            self.nb_pending += 1;
+        }
+
+        if self.nb_pending == 0 {
+            if self.next.is_none() {
+                self.done = true;
+                self.file.active.fetch_sub(1, Ordering::SeqCst);
+            }
+            return 0;
+        }
+
+        let nb = unsafe {
+            ffi::dpdk_replay_burst(
+                self.pool,
+                self.file.port_id,
+                pkts.as_mut_ptr(),
+                self.pending_data.as_ptr(),
+                self.pending_lens.as_ptr(),
+                self.nb_pending as u16,
+            )
+        };
+        if nb == 0 {
+            self.counters.alloc_failures.inc();
+            return 0;
+        }
+
+        let bytes: u64 = self.pending_lens[..self.nb_pending]
+            .iter()
+            .map(|&len| len as u64)
+            .sum();
+        self.counters.replayed.add(nb as u64);
+        self.counters.bytes.add(bytes);
+        self.nb_pending = 0;
+        nb
+    }
+
+    /// Следующий пакет файла, относящийся к очереди источника
+    #[inline]
+    fn next_for_queue(&mut self) -> Option<RecordedPacket<'static>> {
+        let num_queues = self.file.num_queues as u32;
+        while let Some(packet) = self.reader.next_packet() {
+            if packet.queue.unwrap_or(0) % num_queues == self.queue_id as u32 {
+                return Some(packet);
+            }
+        }
+        None
+    }
+}
+
+impl Drop for ReplaySource {
+    fn drop(&mut self) {
+        if !self.done {
+            self.file.active.fetch_sub(1, Ordering::SeqCst);
+        }
+    }
+}
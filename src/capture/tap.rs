@@ -0,0 +1,468 @@
+// src/capture/tap.rs
+use core_affinity::CoreId;
+use std::sync::{
+    atomic::{AtomicBool, Ordering},
+    Arc, Mutex,
+};
+use std::thread::{self, JoinHandle};
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+use crate::capture::file::DirectFile;
+use crate::capture::pcapng::PcapngWriter;
+use crate::dpdk::config::MAX_BURST_SIZE;
+use crate::dpdk::ffi::{self, RteMbuf};
+use crate::packet::timestamp::{tsc, tsc_hz, RxClock};
+use crate::pipeline::ring::{Consumer, Producer, SpscRing};
+use crate::telemetry::port::PortStats;
+use crate::telemetry::worker::Counter;
+
+/// Пауза потока записи, когда все кольца пусты
+const IDLE_SLEEP: Duration = Duration::from_micros(50);
+
+/// Конфигурация захвата входящих пакетов в pcapng
+#[derive(Debug, Clone)]
+pub struct CaptureConfig {
+    /// Файл записи; None - захват выключен
+    pub path: Option<String>,
+    /// Записей в кольце каждого RX worker. Пакеты в кольце держат mbuf,
+    /// поэтому размер учитывается при расчете пулов
+    pub ring_size: usize,
+    /// Сколько байт пакета записывать, 0 - целиком
+    pub snap_len: u32,
+    /// Ядро потока записи; None - без привязки. Не должно совпадать с ядрами
+    /// RX worker
+    pub core: Option<usize>,
+    /// Размер выровненного буфера записи
+    pub buffer_size: usize,
+    /// Писать с O_DIRECT мимо page cache
+    pub direct_io: bool,
+}
+
+impl Default for CaptureConfig {
+    fn default() -> Self {
+        Self {
+            path: None,
+            ring_size: 4096,
+            snap_len: 0,
+            core: None,
+            buffer_size: 4 << 20,
+            direct_io: true,
+        }
+    }
+}
+
+impl CaptureConfig {
+    /// Включен ли захват
+    pub fn is_enabled(&self) -> bool {
+        self.path.is_some()
+    }
+}
+
+/// Пакет, переданный потоку записи
+///
+/// Раскладка должна совпадать с `struct dpdk_capture_record` в
+/// src/native/dpdk.c. Запись владеет одной ссылкой на mbuf.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct CaptureRecord {
+    pub mbuf: *mut RteMbuf,
+    /// Время прихода в тактах TSC (аппаратная метка, если включена)
+    pub rx_tsc: u64,
+    pub port_id: u16,
+    pub queue_id: u16,
+    pub pkt_len: u32,
+}
+
+unsafe impl Send for CaptureRecord {}
+
+impl CaptureRecord {
+    const EMPTY: Self = Self {
+        mbuf: std::ptr::null_mut(),
+        rx_tsc: 0,
+        port_id: 0,
+        queue_id: 0,
+        pkt_len: 0,
+    };
+}
+
+/// Счетчики точки захвата одного RX worker
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct TapCounters {
+    /// Пакетов передано потоку записи
+    pub captured: Counter,
+    /// Пакетов не записано: кольцо было заполнено
+    pub dropped: Counter,
+}
+
+/// Точка захвата в RX worker
+///
+/// Вызывается сразу после `rte_eth_rx_burst`, до фильтрации: в запись
+/// попадает весь входящий трафик очереди. Пакеты не копируются - worker
+/// только увеличивает счетчик ссылок mbuf, и буфер возвращается в пул,
+/// когда его освободят и worker, и поток записи. Если кольцо заполнено,
+/// остаток burst не записывается и учитывается в `dropped`: RX никогда не
+/// ждет поток записи.
+pub struct CaptureTap {
+    ring: Producer<CaptureRecord>,
+    records: Box<[CaptureRecord; MAX_BURST_SIZE]>,
+    counters: Arc<TapCounters>,
+}
+
+impl CaptureTap {
+    /// Создает точку захвата и кольцо к потоку записи
+    pub fn new(ring_size: usize) -> (Self, CaptureSource) {
+        let (producer, consumer) = SpscRing::new(ring_size.max(MAX_BURST_SIZE));
+        let counters = Arc::new(TapCounters::default());
+
+        let tap = Self {
+            ring: producer,
+            records: Box::new([CaptureRecord::EMPTY; MAX_BURST_SIZE]),
+            counters: counters.clone(),
+        };
+        let source = CaptureSource {
+            ring: consumer,
+            counters,
+        };
+        (tap, source)
+    }
+
+    /// Передает burst потоку записи
+    ///
+    /// `clock` - часы RX очереди, None - один TSC на burst.
+    #[inline]
+    pub fn capture(
+        &mut self,
+        port_id: u16,
+        queue_id: u16,
+        pkts: &mut [*mut RteMbuf],
+        clock: Option<&RxClock>,
+    ) {
+        let nb_pkts = pkts.len().min(MAX_BURST_SIZE);
+        let nb_room = self.ring.free_space().min(nb_pkts);
+        if nb_room < nb_pkts {
+            self.counters.dropped.add((nb_pkts - nb_room) as u64);
+        }
+        if nb_room == 0 {
+            return;
+        }
+
+        unsafe {
+            ffi::dpdk_capture_burst(
+                pkts.as_mut_ptr(),
+                nb_room as u16,
+                port_id,
+                queue_id,
+                clock.map_or(std::ptr::null(), |clock| clock as *const _),
+                self.records.as_mut_ptr(),
+            )
+        };
+
+        for &record in &self.records[..nb_room] {
+            // Место проверено free_space, push не может вернуть ошибку
+            let _ = self.ring.push(record);
+        }
+        self.ring.publish();
+        self.counters.captured.add(nb_room as u64);
+    }
+}
+
+/// Сторона кольца точки захвата у потока записи
+///
+/// При уничтожении освобождает mbuf, оставшиеся в кольце.
+pub struct CaptureSource {
+    ring: Consumer<CaptureRecord>,
+    counters: Arc<TapCounters>,
+}
+
+impl CaptureSource {
+    /// Счетчики точки захвата
+    pub fn counters(&self) -> &Arc<TapCounters> {
+        &self.counters
+    }
+}
+
+impl Drop for CaptureSource {
+    fn drop(&mut self) {
+        while let Some(record) = self.ring.pop() {
+            unsafe { ffi::rte_pktmbuf_free(record.mbuf) };
+        }
+        self.ring.release();
+    }
+}
+
+/// Счетчики потока записи
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct CaptureCounters {
+    /// Пакетов записано в файл
+    pub written: Counter,
+    /// Байт передано в файл, включая заголовки блоков pcapng
+    pub bytes: Counter,
+    /// Пакетов, потерянных из-за ошибок записи
+    pub write_errors: Counter,
+}
+
+/// Перевод тактов TSC во время UNIX
+///
+/// Привязка к системным часам обновляется раз в секунду, чтобы дрейф TSC
+/// относительно NTP не накапливался за время записи.
+struct WallClock {
+    hz: u64,
+    base_tsc: u64,
+    base_ns: u64,
+}
+
+impl WallClock {
+    fn new() -> Self {
+        let mut clock = Self {
+            hz: tsc_hz().max(1),
+            base_tsc: 0,
+            base_ns: 0,
+        };
+        clock.anchor();
+        clock
+    }
+
+    fn anchor(&mut self) {
+        self.base_tsc = tsc();
+        self.base_ns = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .map_or(0, |d| d.as_nanos() as u64);
+    }
+
+    fn refresh(&mut self) {
+        if tsc().wrapping_sub(self.base_tsc) > self.hz {
+            self.anchor();
+        }
+    }
+
+    #[inline]
+    fn to_unix_ns(&self, tsc: u64) -> u64 {
+        let delta = tsc.wrapping_sub(self.base_tsc) as i64 as i128;
+        let ns = self.base_ns as i128 + delta * 1_000_000_000 / self.hz as i128;
+        ns.max(0) as u64
+    }
+
+    fn now_ns(&self) -> u64 {
+        self.to_unix_ns(tsc())
+    }
+}
+
+/// Поток записи захваченных пакетов
+pub struct CaptureThread {
+    running: Arc<AtomicBool>,
+    thread: Option<JoinHandle<()>>,
+    /// Кольца, подключенные после запуска; поток забирает их между проходами
+    pending: Arc<Mutex<Vec<CaptureSource>>>,
+    pub counters: Arc<CaptureCounters>,
+    /// Счетчики точек захвата всех RX worker
+    pub taps: Vec<Arc<TapCounters>>,
+}
+
+impl CaptureThread {
+    /// Открывает файл и запускает поток записи
+    ///
+    /// Интерфейсы `ports` записываются в начало файла; интерфейс порта,
+    /// которого нет в списке, добавляется перед его первым пакетом.
+    pub fn spawn(config: &CaptureConfig, ports: &[u16]) -> Result<Self, String> {
+        let path = config
+            .path
+            .as_deref()
+            .ok_or_else(|| "Capture path is not set".to_string())?;
+
+        let file = DirectFile::create(path, config.buffer_size, config.direct_io)?;
+        let direct = file.is_direct();
+        let mut writer = PcapngWriter::new(file, "hfeec", config.snap_len)?;
+        for &port_id in ports {
+            writer.add_interface(port_id)?;
+        }
+
+        println!(
+            "Capturing {} ports to {} ({})",
+            ports.len(),
+            path,
+            if direct { "O_DIRECT" } else { "buffered" }
+        );
+
+        let running = Arc::new(AtomicBool::new(true));
+        let counters = Arc::new(CaptureCounters::default());
+        let pending = Arc::new(Mutex::new(Vec::new()));
+        let thread_pending = pending.clone();
+        let flag = running.clone();
+        let thread_counters = counters.clone();
+        let core = config.core;
+        let path = path.to_string();
+
+        let thread = thread::spawn(move || {
+            if let Some(id) = core {
+                core_affinity::set_for_current(CoreId { id });
+            }
+
+            let mut run = CaptureRun {
+                writer,
+                sources: Vec::new(),
+                clock: WallClock::new(),
+                counters: thread_counters,
+            };
+            let start_ns = run.clock.now_ns();
+
+            while flag.load(Ordering::Relaxed) {
+                run.attach(&thread_pending);
+                if run.drain() == 0 {
+                    thread::sleep(IDLE_SLEEP);
+                }
+                run.clock.refresh();
+            }
+
+            // RX worker к этому моменту остановлены: дописываем остаток колец
+            run.attach(&thread_pending);
+            while run.drain() > 0 {}
+
+            if let Err(e) = run.finish(start_ns) {
+                eprintln!("Failed to finish capture file {}: {}", path, e);
+            }
+        });
+
+        Ok(Self {
+            running,
+            thread: Some(thread),
+            pending,
+            counters,
+            taps: Vec::new(),
+        })
+    }
+
+    /// Подключает кольца точек захвата RX worker
+    pub fn attach(&mut self, sources: Vec<CaptureSource>) {
+        self.taps
+            .extend(sources.iter().map(|source| source.counters.clone()));
+        self.pending
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .extend(sources);
+    }
+
+    /// Всего пакетов передано потоку записи
+    pub fn captured(&self) -> u64 {
+        self.taps.iter().map(|t| t.captured.get()).sum()
+    }
+
+    /// Всего пакетов не записано из-за переполнения колец
+    pub fn dropped(&self) -> u64 {
+        self.taps.iter().map(|t| t.dropped.get()).sum()
+    }
+
+    /// Останавливает поток: он дописывает кольца, статистику портов и
+    /// закрывает файл. Вызывать после остановки RX worker.
+    pub fn stop(&mut self) {
+        self.running.store(false, Ordering::Relaxed);
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+impl Drop for CaptureThread {
+    fn drop(&mut self) {
+        self.stop();
+    }
+}
+
+/// Состояние потока записи
+struct CaptureRun {
+    writer: PcapngWriter,
+    sources: Vec<CaptureSource>,
+    clock: WallClock,
+    counters: Arc<CaptureCounters>,
+}
+
+impl CaptureRun {
+    /// Забирает подключенные кольца, не ожидая блокировки
+    fn attach(&mut self, pending: &Mutex<Vec<CaptureSource>>) {
+        if let Ok(mut pending) = pending.try_lock() {
+            self.sources.append(&mut pending);
+        }
+    }
+
+    /// Записывает до одного burst из каждого кольца, возвращает число пакетов
+    fn drain(&mut self) -> usize {
+        let mut mbufs = [std::ptr::null_mut::<RteMbuf>(); MAX_BURST_SIZE];
+        let mut total = 0;
+        let mut written = 0u64;
+        let mut bytes = 0u64;
+        let mut errors = 0u64;
+
+        for source in &mut self.sources {
+            let mut nb = 0;
+            while nb < MAX_BURST_SIZE {
+                let Some(record) = source.ring.pop() else {
+                    break;
+                };
+                mbufs[nb] = record.mbuf;
+                nb += 1;
+
+                let ts_ns = self.clock.to_unix_ns(record.rx_tsc);
+                let writer = &mut self.writer;
+                let result = writer.add_interface(record.port_id).and_then(|if_id| {
+                    writer.write_packet(
+                        if_id,
+                        ts_ns,
+                        record.queue_id,
+                        record.pkt_len,
+                        |dst| unsafe {
+                            ffi::dpdk_capture_copy(record.mbuf, dst.as_mut_ptr(), dst.len() as u32);
+                        },
+                    )
+                });
+                match result {
+                    Ok(len) => {
+                        written += 1;
+                        bytes += len as u64;
+                    }
+                    Err(e) => {
+                        if self.counters.write_errors.get() + errors == 0 {
+                            eprintln!("Capture: {}", e);
+                        }
+                        errors += 1;
+                    }
+                }
+            }
+
+            if nb > 0 {
+                unsafe { ffi::rte_pktmbuf_free_bulk(mbufs.as_mut_ptr(), nb as u32) };
+                source.ring.release();
+                total += nb;
+            }
+        }
+
+        self.counters.written.add(written);
+        self.counters.bytes.add(bytes);
+        self.counters.write_errors.add(errors);
+        total
+    }
+
+    /// Записывает статистику портов и закрывает файл
+    fn finish(self, start_ns: u64) -> Result<(), String> {
+        let CaptureRun {
+            mut writer, clock, ..
+        } = self;
+        let end_ns = clock.now_ns();
+
+        for (if_id, port_id) in writer.interfaces().to_vec().into_iter().enumerate() {
+            if let Ok(stats) = PortStats::read(port_id) {
+                writer.write_interface_stats(
+                    if_id as u32,
+                    start_ns,
+                    end_ns,
+                    stats.ipackets + stats.imissed + stats.rx_nombuf,
+                    stats.imissed + stats.rx_nombuf,
+                )?;
+            }
+        }
+
+        let size = writer.finish()?;
+        println!("Capture file closed: {} bytes", size);
+        Ok(())
+    }
+}
@@ -0,0 +1,501 @@
+// src/control/igmp.rs
+use core_affinity::CoreId;
+use std::net::Ipv4Addr;
+use std::sync::{
+    atomic::{AtomicBool, Ordering},
+    Arc,
+};
+use std::thread::{self, JoinHandle};
+use std::time::Duration;
+
+use crate::dpdk::config::MAX_BURST_SIZE;
+use crate::dpdk::ffi::{self, RteEtherAddr, RteMbuf, RteMempool};
+use crate::packet::timestamp::{tsc, tsc_hz};
+use crate::protocols::igmp::{
+    self, GroupRecord, IgmpHost, IgmpVersion, MembershipQuery, RecordType, MAX_FRAME_LEN,
+};
+use crate::telemetry::worker::Counter;
+
+/// Повторы отправки служебного пакета при заполненной TX очереди
+const TX_RETRIES: u32 = 4;
+/// Период опроса служебной RX очереди
+const POLL_INTERVAL: Duration = Duration::from_millis(10);
+
+/// Мультикаст-группа фида на порту
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct MulticastGroup {
+    pub port_id: u16,
+    pub group: Ipv4Addr,
+    /// Источники SSM (IGMPv3 INCLUDE); пустой список - любой источник
+    pub sources: Vec<Ipv4Addr>,
+}
+
+/// Конфигурация подписки на мультикаст-группы в обход ядра
+#[derive(Debug, Clone)]
+pub struct MulticastConfig {
+    pub groups: Vec<MulticastGroup>,
+    /// IP адрес, от имени которого порт отправляет IGMP: (port_id, адрес)
+    pub interfaces: Vec<(u16, Ipv4Addr)>,
+    pub version: IgmpVersion,
+    /// Сколько раз повторяются незапрошенные join/leave (Robustness Variable)
+    pub robustness: u32,
+    /// Интервал между повторами незапрошенных сообщений
+    pub unsolicited_interval_ms: u64,
+    /// Период обновления подписки без запросов (на случай, если запросы
+    /// маршрутизатора не доходят до служебной очереди)
+    pub refresh_interval_ms: u64,
+    /// Ядро потока агента; по умолчанию ядро 0 - главное lcore EAL, которое
+    /// не выдается RX worker и стадиям. None - без привязки
+    pub core: Option<usize>,
+}
+
+impl Default for MulticastConfig {
+    fn default() -> Self {
+        Self {
+            groups: Vec::new(),
+            interfaces: Vec::new(),
+            version: IgmpVersion::V3,
+            robustness: 2,
+            unsolicited_interval_ms: 1_000,
+            refresh_interval_ms: 60_000,
+            core: Some(0),
+        }
+    }
+}
+
+impl MulticastConfig {
+    /// Проверяет, заданы ли группы: только тогда порту нужны служебные очереди
+    pub fn is_enabled(&self) -> bool {
+        !self.groups.is_empty()
+    }
+
+    /// Группы порта
+    pub fn groups_for(&self, port_id: u16) -> impl Iterator<Item = &MulticastGroup> {
+        self.groups.iter().filter(move |g| g.port_id == port_id)
+    }
+
+    /// IP адрес порта для IGMP
+    pub fn interface_ip(&self, port_id: u16) -> Option<Ipv4Addr> {
+        self.interfaces
+            .iter()
+            .find(|&&(p, _)| p == port_id)
+            .map(|&(_, ip)| ip)
+    }
+}
+
+/// Программирует аппаратный фильтр мультикаст MAC адресов порта
+///
+/// Кроме MAC групп порта, в список входит адрес 224.0.0.1, на который
+/// маршрутизатор отправляет общие запросы. Позволяет работать без
+/// promiscuous режима: NIC принимает только свой unicast и эти группы.
+pub fn program_mac_filters(port_id: u16, config: &MulticastConfig) -> Result<usize, String> {
+    let mut macs: Vec<[u8; 6]> = vec![igmp::multicast_mac(igmp::ALL_HOSTS)];
+    for group in config.groups_for(port_id) {
+        let mac = igmp::multicast_mac(group.group);
+        if !macs.contains(&mac) {
+            macs.push(mac);
+        }
+    }
+
+    let mut addrs: Vec<RteEtherAddr> = macs
+        .iter()
+        .map(|&addr_bytes| RteEtherAddr { addr_bytes })
+        .collect();
+
+    let ret = unsafe {
+        ffi::rte_eth_dev_set_mc_addr_list(port_id, addrs.as_mut_ptr(), addrs.len() as u32)
+    };
+    if ret != 0 {
+        return Err(format!(
+            "Failed to set multicast MAC filter on port {}: error code {}",
+            port_id, ret
+        ));
+    }
+
+    Ok(addrs.len())
+}
+
+/// Счетчики IGMP агента
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct IgmpCounters {
+    pub queries: Counter,
+    pub reports_sent: Counter,
+    pub leaves_sent: Counter,
+    pub tx_failures: Counter,
+    pub malformed: Counter,
+}
+
+/// Поток IGMP агента
+pub struct IgmpThread {
+    running: Arc<AtomicBool>,
+    thread: Option<JoinHandle<()>>,
+    pub counters: Arc<IgmpCounters>,
+}
+
+impl IgmpThread {
+    /// Останавливает агент; перед выходом поток отправляет leave по всем группам
+    pub fn stop(&mut self) {
+        self.running.store(false, Ordering::Relaxed);
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+impl Drop for IgmpThread {
+    fn drop(&mut self) {
+        self.stop();
+    }
+}
+
+/// Состояние подписки на группу
+#[derive(Debug)]
+struct GroupState {
+    group: Ipv4Addr,
+    sources: Vec<Ipv4Addr>,
+    /// Осталось повторов незапрошенного join
+    unsolicited_left: u32,
+    next_unsolicited: u64,
+    /// Момент ответа на запрос, 0 - ответ не запланирован
+    response_due: u64,
+    next_refresh: u64,
+}
+
+/// Порт, на котором агент ведет подписки
+struct IgmpPort {
+    port_id: u16,
+    rx_queue: u16,
+    tx_queue: u16,
+    mbuf_pool: *mut RteMempool,
+    host: IgmpHost,
+    groups: Vec<GroupState>,
+    /// Отчеты, собранные за шаг агента: уходят одним doorbell
+    pending: [*mut RteMbuf; MAX_BURST_SIZE],
+    pending_len: usize,
+}
+
+/// Порт для `IgmpAgent::new`: служебные очереди и пул mbuf
+pub struct IgmpPortConfig {
+    pub port_id: u16,
+    pub rx_queue: u16,
+    pub tx_queue: u16,
+    pub mbuf_pool: *mut RteMempool,
+}
+
+/// IGMP хост в обход ядра
+///
+/// Отправляет join при старте (с повторами, RFC 3376 Robustness Variable),
+/// отвечает на запросы маршрутизатора со случайной задержкой в пределах Max
+/// Resp Time, периодически обновляет подписку и отправляет leave при
+/// остановке. Работает в собственном потоке вне изолированных ядер и
+/// пользуется служебными RX/TX очередями порта: запросы направляются в
+/// служебную RX очередь правилом rte_flow, отчеты уходят через служебную
+/// TX очередь и не конкурируют с ордерами.
+pub struct IgmpAgent {
+    ports: Vec<IgmpPort>,
+    version: IgmpVersion,
+    robustness: u32,
+    unsolicited_cycles: u64,
+    refresh_cycles: u64,
+    hz: u64,
+    rng: u64,
+    core: Option<usize>,
+    counters: Arc<IgmpCounters>,
+}
+
+unsafe impl Send for IgmpAgent {}
+
+impl IgmpAgent {
+    pub fn new(config: &MulticastConfig, ports: &[IgmpPortConfig]) -> Result<Self, String> {
+        let hz = tsc_hz();
+        let now = tsc();
+        let mut agent_ports = Vec::with_capacity(ports.len());
+
+        for port in ports {
+            if config.groups_for(port.port_id).next().is_none() {
+                continue;
+            }
+            if port.mbuf_pool.is_null() {
+                return Err(format!("Port {} has no mbuf pool", port.port_id));
+            }
+
+            let src_ip = config
+                .interface_ip(port.port_id)
+                .ok_or_else(|| format!("No IGMP interface address for port {}", port.port_id))?;
+
+            let mut src_mac = RteEtherAddr { addr_bytes: [0; 6] };
+            let ret = unsafe { ffi::rte_eth_macaddr_get(port.port_id, &mut src_mac) };
+            if ret < 0 {
+                return Err(format!(
+                    "Failed to get MAC address of port {}: error code {}",
+                    port.port_id, ret
+                ));
+            }
+
+            let groups = config
+                .groups_for(port.port_id)
+                .map(|g| GroupState {
+                    group: g.group,
+                    sources: g.sources.clone(),
+                    unsolicited_left: config.robustness.max(1),
+                    next_unsolicited: now,
+                    response_due: 0,
+                    next_refresh: 0,
+                })
+                .collect();
+
+            agent_ports.push(IgmpPort {
+                port_id: port.port_id,
+                rx_queue: port.rx_queue,
+                tx_queue: port.tx_queue,
+                mbuf_pool: port.mbuf_pool,
+                host: IgmpHost {
+                    src_mac: src_mac.addr_bytes,
+                    src_ip,
+                },
+                groups,
+                pending: [std::ptr::null_mut(); MAX_BURST_SIZE],
+                pending_len: 0,
+            });
+        }
+
+        Ok(Self {
+            ports: agent_ports,
+            version: config.version,
+            robustness: config.robustness.max(1),
+            unsolicited_cycles: config.unsolicited_interval_ms * hz / 1000,
+            refresh_cycles: config.refresh_interval_ms * hz / 1000,
+            hz,
+            rng: now | 1,
+            core: config.core,
+            counters: Arc::new(IgmpCounters::default()),
+        })
+    }
+
+    /// Счетчики агента для чтения из других потоков
+    pub fn counters(&self) -> Arc<IgmpCounters> {
+        self.counters.clone()
+    }
+
+    /// Один шаг агента: разбор запросов и отправка запланированных отчетов
+    pub fn poll(&mut self, now: u64) {
+        for p in 0..self.ports.len() {
+            self.poll_queries(p, now);
+            self.send_due(p, now);
+            self.flush(p);
+        }
+    }
+
+    /// Отправляет leave по всем группам
+    pub fn leave_all(&mut self) {
+        for p in 0..self.ports.len() {
+            for g in 0..self.ports[p].groups.len() {
+                for _ in 0..self.robustness {
+                    if self.send_record(p, g, true, false) {
+                        self.counters.leaves_sent.inc();
+                    }
+                }
+            }
+            self.flush(p);
+        }
+    }
+
+    /// Запускает агент в отдельном потоке на управляющем ядре (`core`),
+    /// чтобы он не вытеснял RX worker с изолированных ядер
+    pub fn spawn(mut self) -> IgmpThread {
+        let running = Arc::new(AtomicBool::new(true));
+        let counters = self.counters.clone();
+        let flag = running.clone();
+
+        let thread = thread::spawn(move || {
+            if let Some(id) = self.core {
+                core_affinity::set_for_current(CoreId { id });
+            }
+
+            while flag.load(Ordering::Relaxed) {
+                self.poll(tsc());
+                thread::sleep(POLL_INTERVAL);
+            }
+            self.leave_all();
+        });
+
+        IgmpThread {
+            running,
+            thread: Some(thread),
+            counters,
+        }
+    }
+
+    fn poll_queries(&mut self, p: usize, now: u64) {
+        let mut pkts = [std::ptr::null_mut::<RteMbuf>(); MAX_BURST_SIZE];
+        let (port_id, rx_queue) = (self.ports[p].port_id, self.ports[p].rx_queue);
+
+        let nb_rx = unsafe {
+            ffi::rte_eth_rx_burst(port_id, rx_queue, pkts.as_mut_ptr(), MAX_BURST_SIZE as u16)
+        } as usize;
+
+        for &pkt in &pkts[..nb_rx] {
+            let frame = unsafe {
+                let data = ffi::rte_pktmbuf_mtod(pkt, std::ptr::null()) as *const u8;
+                std::slice::from_raw_parts(data, ffi::rte_pktmbuf_data_len(pkt) as usize)
+            };
+
+            match igmp::parse_query(frame) {
+                Ok(Some(query)) => {
+                    self.counters.queries.inc();
+                    self.schedule_response(p, &query, now);
+                }
+                Ok(None) => {}
+                Err(_) => self.counters.malformed.inc(),
+            }
+        }
+
+        if nb_rx > 0 {
+            unsafe { ffi::rte_pktmbuf_free_bulk(pkts.as_mut_ptr(), nb_rx as u32) };
+        }
+    }
+
+    /// Планирует ответ на запрос со случайной задержкой (RFC 3376, 5.2)
+    fn schedule_response(&mut self, p: usize, query: &MembershipQuery, now: u64) {
+        let max_cycles = (query.max_resp_ms as u64 * self.hz / 1000).max(1);
+
+        for g in 0..self.ports[p].groups.len() {
+            if query
+                .group
+                .map_or(false, |q| q != self.ports[p].groups[g].group)
+            {
+                continue;
+            }
+
+            let due = now + self.next_random() % max_cycles;
+            let state = &mut self.ports[p].groups[g];
+            // Уже запланированный более ранний ответ сохраняется
+            if state.response_due == 0 || due < state.response_due {
+                state.response_due = due;
+            }
+        }
+    }
+
+    fn send_due(&mut self, p: usize, now: u64) {
+        for g in 0..self.ports[p].groups.len() {
+            let state = &self.ports[p].groups[g];
+
+            if state.unsolicited_left > 0 && now >= state.next_unsolicited {
+                if self.send_record(p, g, false, true) {
+                    self.counters.reports_sent.inc();
+                }
+                let state = &mut self.ports[p].groups[g];
+                state.unsolicited_left -= 1;
+                state.next_unsolicited = now + self.unsolicited_cycles;
+                state.next_refresh = now + self.refresh_cycles;
+                continue;
+            }
+
+            let answer = state.response_due != 0 && now >= state.response_due;
+            let refresh = now >= state.next_refresh;
+            if answer || refresh {
+                if self.send_record(p, g, false, false) {
+                    self.counters.reports_sent.inc();
+                }
+                let state = &mut self.ports[p].groups[g];
+                state.response_due = 0;
+                state.next_refresh = now + self.refresh_cycles;
+            }
+        }
+    }
+
+    /// Строит сообщение о группе `g` порта `p` и ставит его в очередь
+    /// отправки (`flush`)
+    ///
+    /// `change` - сообщение об изменении состояния (join), иначе текущее
+    /// состояние (ответ на запрос / обновление).
+    fn send_record(&mut self, p: usize, g: usize, leave: bool, change: bool) -> bool {
+        let port = &self.ports[p];
+        let state = &port.groups[g];
+        let ssm = !state.sources.is_empty();
+
+        let record_type = match (ssm, leave, change) {
+            (false, true, _) => RecordType::ChangeToInclude,
+            (false, false, true) => RecordType::ChangeToExclude,
+            (false, false, false) => RecordType::ModeIsExclude,
+            (true, true, _) => RecordType::BlockOldSources,
+            (true, false, true) => RecordType::AllowNewSources,
+            (true, false, false) => RecordType::ModeIsInclude,
+        };
+
+        // IGMPv2 не знает источников: join/leave всей группы
+        let sources: &[Ipv4Addr] = match self.version {
+            IgmpVersion::V2 => &[],
+            IgmpVersion::V3 => &state.sources,
+        };
+        let record_type = match (self.version, leave) {
+            (IgmpVersion::V2, true) => RecordType::ChangeToInclude,
+            (IgmpVersion::V2, false) => RecordType::ModeIsExclude,
+            (IgmpVersion::V3, _) => record_type,
+        };
+
+        let record = GroupRecord {
+            record_type,
+            group: state.group,
+            sources,
+        };
+
+        let mut frame = [0u8; MAX_FRAME_LEN];
+        let Some(len) = igmp::build_frame(&mut frame, &port.host, self.version, &[record]) else {
+            self.counters.tx_failures.inc();
+            return false;
+        };
+
+        let pkt = unsafe { ffi::dpdk_tx_frame(port.mbuf_pool, frame.as_ptr(), len as u16) };
+        if pkt.is_null() {
+            self.counters.tx_failures.inc();
+            return false;
+        }
+
+        if self.ports[p].pending_len == MAX_BURST_SIZE {
+            self.flush(p);
+        }
+        let port = &mut self.ports[p];
+        port.pending[port.pending_len] = pkt;
+        port.pending_len += 1;
+        true
+    }
+
+    /// Отправляет накопленные отчеты порта `p` одним rte_eth_tx_burst
+    ///
+    /// Отчеты - bulk трафик: join по всем группам при старте и ответы на
+    /// общий запрос уходят пачкой, а не отдельным doorbell на каждую группу.
+    fn flush(&mut self, p: usize) {
+        let port = &mut self.ports[p];
+        if port.pending_len == 0 {
+            return;
+        }
+
+        let nb_pkts = port.pending_len;
+        let nb_tx = unsafe {
+            ffi::dpdk_tx_send_burst(
+                port.port_id,
+                port.tx_queue,
+                port.pending.as_mut_ptr(),
+                nb_pkts as u16,
+                TX_RETRIES,
+            )
+        } as usize;
+        if nb_tx < nb_pkts {
+            let unsent = &mut port.pending[nb_tx..nb_pkts];
+            unsafe { ffi::rte_pktmbuf_free_bulk(unsent.as_mut_ptr(), unsent.len() as u32) };
+            self.counters.tx_failures.add((nb_pkts - nb_tx) as u64);
+        }
+        port.pending_len = 0;
+    }
+
+    #[inline]
+    fn next_random(&mut self) -> u64 {
+        // xorshift64: равномерной задержки ответа достаточно
+        self.rng ^= self.rng << 13;
+        self.rng ^= self.rng >> 7;
+        self.rng ^= self.rng << 17;
+        self.rng
+    }
+}
@@ -0,0 +1,2 @@
+pub mod igmp;
+pub mod reconfig;
@@ -0,0 +1,277 @@
+// src/control/reconfig.rs
+use std::any::Any;
+use std::ptr::null_mut;
+use std::sync::atomic::{AtomicPtr, AtomicU64, Ordering};
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, Instant};
+
+/// Сколько управляющая сторона ждет подтверждения от worker
+///
+/// Worker забирает запросы только между кругами опроса, поэтому `Idler`
+/// ограничивает `timeout_ms` стратегии `Interrupt` половиной этого срока
+/// (`MAX_INTERRUPT_TIMEOUT_MS`).
+pub const RECONFIG_TIMEOUT: Duration = Duration::from_secs(2);
+
+/// Максимальное число RX линий одного worker, которые можно приостановить
+pub const MAX_CONTROL_LINES: usize = 64;
+
+/// Общее состояние управления одного worker
+///
+/// Управляющий поток меняет состояние и увеличивает `requested`; worker
+/// сравнивает его со своей копией один раз за круг опроса (Relaxed чтение
+/// почти никогда не меняющейся линии кэша), применяет изменения между
+/// burst и публикует номер в `applied`. Остальные worker при этом не
+/// затрагиваются.
+struct WorkerControl {
+    requested: AtomicU64,
+    applied: AtomicU64,
+    /// Приостановленные линии worker (бит - индекс линии)
+    paused_lines: AtomicU64,
+    /// Количество примененных замен обработчика
+    swaps: AtomicU64,
+}
+
+/// Ячейка замены обработчика в стиле RCU
+///
+/// Новый обработчик публикуется указателем; worker забирает его между
+/// burst, меняет местами со своим и возвращает старый в `retired`, откуда
+/// его уничтожает управляющая сторона, а не горячий поток.
+struct HandlerSlot<H> {
+    next: AtomicPtr<H>,
+    retired: AtomicPtr<H>,
+}
+
+impl<H> HandlerSlot<H> {
+    fn take_retired(&self) -> Option<Box<H>> {
+        let retired = self.retired.swap(null_mut(), Ordering::Acquire);
+        (!retired.is_null()).then(|| unsafe { Box::from_raw(retired) })
+    }
+}
+
+impl<H> Drop for HandlerSlot<H> {
+    fn drop(&mut self) {
+        for slot in [&self.next, &self.retired] {
+            let handler = slot.swap(null_mut(), Ordering::Acquire);
+            if !handler.is_null() {
+                drop(unsafe { Box::from_raw(handler) });
+            }
+        }
+    }
+}
+
+/// Создает канал управления worker с обработчиком типа `H`
+pub fn channel<H: Send + 'static>() -> (ControlHandle, ControlReceiver<H>) {
+    let control = Arc::new(WorkerControl {
+        requested: AtomicU64::new(0),
+        applied: AtomicU64::new(0),
+        paused_lines: AtomicU64::new(0),
+        swaps: AtomicU64::new(0),
+    });
+    let slot = Arc::new(HandlerSlot::<H> {
+        next: AtomicPtr::new(null_mut()),
+        retired: AtomicPtr::new(null_mut()),
+    });
+
+    let handle = ControlHandle {
+        control: control.clone(),
+        slot: slot.clone(),
+    };
+    let receiver = ControlReceiver {
+        control,
+        slot,
+        seen: 0,
+        paused_lines: 0,
+    };
+    (handle, receiver)
+}
+
+/// Управляющая сторона канала, хранится в `Worker`
+#[derive(Clone)]
+pub struct ControlHandle {
+    control: Arc<WorkerControl>,
+    /// `Arc<HandlerSlot<H>>` с типом обработчика worker
+    slot: Arc<dyn Any + Send + Sync>,
+}
+
+impl std::fmt::Debug for ControlHandle {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ControlHandle")
+            .field("applied", &self.applied())
+            .field("paused_lines", &self.paused_lines())
+            .field("swaps", &self.swaps())
+            .finish()
+    }
+}
+
+impl ControlHandle {
+    /// Заменяет обработчик worker и ждет, пока worker начнет его использовать
+    ///
+    /// Старый обработчик уничтожается в вызывающем потоке. Тип `H` должен
+    /// совпадать с типом, с которым worker был запущен. При ошибке замена
+    /// отозвана и не будет применена позже.
+    pub fn swap<H: Send + 'static>(&self, handler: H) -> Result<(), String> {
+        let slot = self
+            .slot
+            .clone()
+            .downcast::<HandlerSlot<H>>()
+            .map_err(|_| {
+                format!(
+                    "Worker handler is not of type {}",
+                    std::any::type_name::<H>()
+                )
+            })?;
+
+        let next = Box::into_raw(Box::new(handler));
+        let pending = slot.next.swap(next, Ordering::AcqRel);
+        if !pending.is_null() {
+            // Предыдущая замена не была подтверждена и не применена
+            drop(unsafe { Box::from_raw(pending) });
+        }
+
+        let target = self.publish();
+        let mut result = self.wait_applied(target);
+        if result.is_err() {
+            match slot
+                .next
+                .compare_exchange(next, null_mut(), Ordering::AcqRel, Ordering::Acquire)
+            {
+                // Worker еще не забрал обработчик: замена отозвана
+                Ok(_) => drop(unsafe { Box::from_raw(next) }),
+                // Worker уже забрал обработчик и ставит его без условий;
+                // старый попадет в `retired` и уничтожится следующей заменой
+                Err(_) => result = Ok(()),
+            }
+        }
+        drop(slot.take_retired());
+        result
+    }
+
+    /// Прекращает опрос линии `line` worker
+    pub fn pause_line(&self, line: usize) -> Result<(), String> {
+        if line >= MAX_CONTROL_LINES {
+            return Err(format!("Line index {} out of range", line));
+        }
+        self.control
+            .paused_lines
+            .fetch_or(1 << line, Ordering::Relaxed);
+        self.request()
+    }
+
+    /// Возобновляет опрос линии `line` worker
+    pub fn resume_line(&self, line: usize) -> Result<(), String> {
+        if line >= MAX_CONTROL_LINES {
+            return Err(format!("Line index {} out of range", line));
+        }
+        self.control
+            .paused_lines
+            .fetch_and(!(1 << line), Ordering::Relaxed);
+        self.request()
+    }
+
+    /// Публикует изменения и ждет их применения worker
+    ///
+    /// Маска линий после ошибки остается опубликованной и применяется
+    /// worker на следующем круге опроса.
+    fn request(&self) -> Result<(), String> {
+        let target = self.publish();
+        self.wait_applied(target)
+    }
+
+    /// Публикует изменения; возвращает номер запроса
+    fn publish(&self) -> u64 {
+        self.control.requested.fetch_add(1, Ordering::Release) + 1
+    }
+
+    /// Ждет, пока worker применит запрос `target`
+    fn wait_applied(&self, target: u64) -> Result<(), String> {
+        let deadline = Instant::now() + RECONFIG_TIMEOUT;
+
+        let mut spins = 0u32;
+        while self.control.applied.load(Ordering::Acquire) < target {
+            if Instant::now() >= deadline {
+                return Err(format!(
+                    "Worker did not apply reconfiguration within {:?}",
+                    RECONFIG_TIMEOUT
+                ));
+            }
+            if spins < 1024 {
+                spins += 1;
+                std::hint::spin_loop();
+            } else {
+                thread::sleep(Duration::from_micros(50));
+            }
+        }
+        Ok(())
+    }
+
+    /// Номер последнего примененного worker запроса
+    pub fn applied(&self) -> u64 {
+        self.control.applied.load(Ordering::Acquire)
+    }
+
+    /// Маска приостановленных линий
+    pub fn paused_lines(&self) -> u64 {
+        self.control.paused_lines.load(Ordering::Relaxed)
+    }
+
+    /// Количество примененных замен обработчика
+    pub fn swaps(&self) -> u64 {
+        self.control.swaps.load(Ordering::Relaxed)
+    }
+}
+
+/// Сторона worker канала управления
+pub struct ControlReceiver<H> {
+    control: Arc<WorkerControl>,
+    slot: Arc<HandlerSlot<H>>,
+    /// Последний примененный запрос
+    seen: u64,
+    /// Локальная копия маски приостановленных линий
+    paused_lines: u64,
+}
+
+impl<H> ControlReceiver<H> {
+    /// Применяет запросы управления, если они есть; вызывается worker
+    /// между burst
+    #[inline(always)]
+    pub fn poll(&mut self, handler: &mut H) {
+        if self.control.requested.load(Ordering::Relaxed) != self.seen {
+            self.apply(handler);
+        }
+    }
+
+    #[cold]
+    #[inline(never)]
+    fn apply(&mut self, handler: &mut H) {
+        let requested = self.control.requested.load(Ordering::Acquire);
+
+        let next = self.slot.next.swap(null_mut(), Ordering::Acquire);
+        if !next.is_null() {
+            // Старый обработчик остается в той же ячейке памяти и уходит
+            // управляющей стороне: в горячем потоке нет выделений и деструкторов
+            unsafe { std::mem::swap(handler, &mut *next) };
+            let unclaimed = self.slot.retired.swap(next, Ordering::AcqRel);
+            if !unclaimed.is_null() {
+                drop(unsafe { Box::from_raw(unclaimed) });
+            }
+            self.control.swaps.fetch_add(1, Ordering::Relaxed);
+        }
+
+        self.paused_lines = self.control.paused_lines.load(Ordering::Relaxed);
+        self.seen = requested;
+        self.control.applied.store(requested, Ordering::Release);
+    }
+
+    /// Приостановлен ли опрос линии `line`
+    #[inline(always)]
+    pub fn is_paused(&self, line: usize) -> bool {
+        line < MAX_CONTROL_LINES && self.paused_lines & (1 << line) != 0
+    }
+
+    /// Маска приостановленных линий, бит `line` - линия `line`
+    #[inline(always)]
+    pub fn paused_lines(&self) -> u64 {
+        self.paused_lines
+    }
+}
@@ -1 +1,2 @@
+pub mod placement;
 pub mod topology;
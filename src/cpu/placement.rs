@@ -0,0 +1,377 @@
+use std::collections::HashMap;
+use std::fmt;
+
+use core_affinity::CoreId;
+
+use crate::cpu::topology::CpuTopology;
+use crate::numa::topology::NumaTopology;
+use crate::telemetry::worker::STAGE_PORT_ID;
+
+/// A unit of work that needs a dedicated core: an RX queue worker or a
+/// pipeline stage serving it
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct PlacementRequest {
+    pub port_id: u16,
+    pub queue_id: u16,
+    /// Requests with the same group (e.g. stages of one pipeline) are kept
+    /// within one L3 domain so that hand-offs stay in the shared cache
+    pub group: Option<usize>,
+    /// Human-readable role used in the plan explanation
+    pub role: &'static str,
+}
+
+impl PlacementRequest {
+    /// Request for an RX queue worker
+    pub fn rx_queue(port_id: u16, queue_id: u16) -> Self {
+        Self {
+            port_id,
+            queue_id,
+            group: None,
+            role: "rx",
+        }
+    }
+
+    /// Request for a pipeline stage core; `index` identifies the stage
+    /// instance within its role
+    pub fn stage(role: &'static str, index: u16, group: usize) -> Self {
+        Self {
+            port_id: STAGE_PORT_ID,
+            queue_id: index,
+            group: Some(group),
+            role,
+        }
+    }
+
+    /// Short description used in the plan explanation
+    pub fn label(&self) -> String {
+        if self.port_id == STAGE_PORT_ID {
+            format!("{} {}", self.role, self.queue_id)
+        } else {
+            format!(
+                "port {} queue {} ({})",
+                self.port_id, self.queue_id, self.role
+            )
+        }
+    }
+
+    /// Same request, kept in the given placement group
+    pub fn in_group(mut self, group: usize) -> Self {
+        self.group = Some(group);
+        self
+    }
+}
+
+/// Why a core was chosen for a request
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PlacementReason {
+    /// Dedicated core isolated from the kernel scheduler
+    Isolated,
+    /// Dedicated core, not isolated from the scheduler
+    Dedicated,
+    /// Dedicated core in the same L3 domain as the rest of its group
+    GroupL3,
+    /// No free core left: the core is shared with other requests
+    Oversubscribed,
+}
+
+/// Core assigned to one request
+#[derive(Debug, Clone)]
+pub struct Placement {
+    pub request: PlacementRequest,
+    pub core: CoreId,
+    pub l3_domain: Option<usize>,
+    pub reason: PlacementReason,
+}
+
+/// Result of planning for one NUMA node
+#[derive(Debug, Clone)]
+pub struct PlacementPlan {
+    pub node_id: usize,
+    pub placements: Vec<Placement>,
+    /// Candidate cores that remained unused
+    pub spare_cores: Vec<usize>,
+}
+
+impl PlacementPlan {
+    /// Returns the core assigned to the given request
+    pub fn core_for(&self, port_id: u16, queue_id: u16, role: &str) -> Option<CoreId> {
+        self.placements
+            .iter()
+            .find(|p| {
+                p.request.port_id == port_id
+                    && p.request.queue_id == queue_id
+                    && p.request.role == role
+            })
+            .map(|p| p.core)
+    }
+
+    /// Checks if at least one core runs more than one request
+    pub fn is_oversubscribed(&self) -> bool {
+        self.placements
+            .iter()
+            .any(|p| p.reason == PlacementReason::Oversubscribed)
+    }
+}
+
+impl fmt::Display for PlacementPlan {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        writeln!(f, "Placement plan for NUMA node {}:", self.node_id)?;
+
+        for p in &self.placements {
+            let l3 = p
+                .l3_domain
+                .map_or_else(|| "?".to_string(), |d| d.to_string());
+            let reason = match p.reason {
+                PlacementReason::Isolated => "isolated core".to_string(),
+                PlacementReason::Dedicated => "dedicated core".to_string(),
+                PlacementReason::GroupL3 => format!(
+                    "dedicated core, shares L3 with group {}",
+                    p.request.group.unwrap_or_default()
+                ),
+                PlacementReason::Oversubscribed => {
+                    let shared: Vec<String> = self
+                        .placements
+                        .iter()
+                        .filter(|o| o.core.id == p.core.id && o.request != p.request)
+                        .map(|o| o.request.label())
+                        .collect();
+                    format!("OVERSUBSCRIBED, shared with {}", shared.join(", "))
+                }
+            };
+
+            writeln!(
+                f,
+                "  {} -> core {} (L3 {}): {}",
+                p.request.label(),
+                p.core.id,
+                l3,
+                reason
+            )?;
+        }
+
+        if !self.spare_cores.is_empty() {
+            writeln!(f, "  spare cores: {:?}", self.spare_cores)?;
+        }
+
+        Ok(())
+    }
+}
+
+/// Assigns cores to workers using CPU and NUMA topology
+///
+/// Each request gets its own physical core while one is available: only
+/// primary logical cores are candidates, so the HT sibling of a worker core
+/// stays idle. Isolated cores are preferred, groups are packed into one L3
+/// domain, and independent requests are spread across L3 domains so they
+/// do not compete for the same cache.
+pub struct PlacementPlanner<'a> {
+    cpu_topology: &'a CpuTopology,
+    numa_topology: &'a NumaTopology,
+}
+
+impl<'a> PlacementPlanner<'a> {
+    pub fn new(cpu_topology: &'a CpuTopology, numa_topology: &'a NumaTopology) -> Self {
+        Self {
+            cpu_topology,
+            numa_topology,
+        }
+    }
+
+    /// Plans placement of `requests` on the candidate cores of a NUMA node
+    pub fn plan(
+        &self,
+        node_id: usize,
+        candidates: &[CoreId],
+        requests: &[PlacementRequest],
+    ) -> PlacementPlan {
+        let node_cores = self.numa_topology.node_cores.get(&node_id);
+
+        // Only primary logical cores of this node; the sibling of each stays idle
+        let mut free: Vec<usize> = candidates
+            .iter()
+            .map(|core| core.id)
+            .filter(|&id| self.cpu_topology.is_primary_logical_core(id))
+            .filter(|id| node_cores.map_or(true, |cores| cores.contains(id)))
+            .collect();
+
+        // Isolated cores first, then by id for a stable plan
+        free.sort_by_key(|&id| (!self.cpu_topology.is_isolated_core(id), id));
+        free.dedup();
+
+        // Cores that may be shared once the free ones run out
+        let eligible = free.clone();
+        let unfiltered: Vec<usize> = candidates.iter().map(|core| core.id).collect();
+        let mut warned_fallback = false;
+
+        let mut placements: Vec<Placement> = Vec::with_capacity(requests.len());
+        let mut load: HashMap<usize, usize> = HashMap::new();
+        let mut group_domain: HashMap<usize, Option<usize>> = HashMap::new();
+
+        // Groups are placed first, so they can claim a whole L3 domain
+        let mut ordered: Vec<&PlacementRequest> = requests.iter().collect();
+        ordered.sort_by_key(|r| r.group.is_none());
+
+        let group_sizes = ordered.iter().fold(HashMap::new(), |mut sizes, r| {
+            if let Some(g) = r.group {
+                *sizes.entry(g).or_insert(0usize) += 1;
+            }
+            sizes
+        });
+
+        for request in ordered {
+            let domain_of = |id: usize| self.cpu_topology.get_core_l3_domain(id);
+
+            let chosen = match request.group {
+                Some(group) => {
+                    let domain = *group_domain
+                        .entry(group)
+                        .or_insert_with(|| self.pick_domain(&free, group_sizes[&group]));
+                    self.take_core(&mut free, domain).map(|(id, in_domain)| {
+                        let reason = if in_domain {
+                            PlacementReason::GroupL3
+                        } else {
+                            self.dedicated_reason(id)
+                        };
+                        (id, reason)
+                    })
+                }
+                None => {
+                    // Spread independent workers over the least loaded L3 domain
+                    let domain = self.pick_domain_least_loaded(&free, &load);
+                    self.take_core(&mut free, domain)
+                        .map(|(id, _)| (id, self.dedicated_reason(id)))
+                }
+            };
+
+            let (core, reason) = match chosen {
+                Some(choice) => choice,
+                None => {
+                    // Out of cores: share the least loaded one, preferring the group's domain
+                    let preferred = request
+                        .group
+                        .and_then(|g| group_domain.get(&g).copied().flatten());
+                    let pool = if eligible.is_empty() {
+                        // No primary core of this node among the candidates:
+                        // sharing a sibling or foreign core is the only option
+                        if !warned_fallback {
+                            eprintln!(
+                                "Placement on node {}: no eligible primary cores, \
+                                 falling back to unfiltered candidates",
+                                node_id
+                            );
+                            warned_fallback = true;
+                        }
+                        &unfiltered
+                    } else {
+                        &eligible
+                    };
+                    let core = pool.iter().copied().min_by_key(|&id| {
+                        (
+                            preferred.map_or(false, |d| domain_of(id) != Some(d)),
+                            load.get(&id).copied().unwrap_or(0),
+                            id,
+                        )
+                    });
+
+                    match core {
+                        Some(id) => (id, PlacementReason::Oversubscribed),
+                        None => continue,
+                    }
+                }
+            };
+
+            *load.entry(core).or_insert(0) += 1;
+            placements.push(Placement {
+                request: *request,
+                core: CoreId { id: core },
+                l3_domain: domain_of(core),
+                reason,
+            });
+        }
+
+        // Reasons of already placed requests change once a core gets shared
+        for i in 0..placements.len() {
+            if load[&placements[i].core.id] > 1 {
+                placements[i].reason = PlacementReason::Oversubscribed;
+            }
+        }
+
+        free.sort_unstable();
+
+        PlacementPlan {
+            node_id,
+            placements,
+            spare_cores: free,
+        }
+    }
+
+    /// Removes a free core from `domain` (or any free core if the domain is
+    /// exhausted); the flag tells whether the core is in the requested domain
+    fn take_core(&self, free: &mut Vec<usize>, domain: Option<usize>) -> Option<(usize, bool)> {
+        match free
+            .iter()
+            .position(|&id| self.cpu_topology.get_core_l3_domain(id) == domain)
+        {
+            Some(pos) => Some((free.remove(pos), true)),
+            None if !free.is_empty() => Some((free.remove(0), false)),
+            None => None,
+        }
+    }
+
+    fn dedicated_reason(&self, core_id: usize) -> PlacementReason {
+        if self.cpu_topology.is_isolated_core(core_id) {
+            PlacementReason::Isolated
+        } else {
+            PlacementReason::Dedicated
+        }
+    }
+
+    /// L3 domain for a group of `size` requests: the smallest domain that
+    /// fits the whole group (larger ones stay available), otherwise the one
+    /// with the most free cores
+    fn pick_domain(&self, free: &[usize], size: usize) -> Option<usize> {
+        let counts = self.domain_counts(free);
+
+        counts
+            .iter()
+            .max_by_key(|&(&domain, &n)| {
+                let fit = if n >= size {
+                    -(n as i64)
+                } else {
+                    n as i64 - i64::MAX
+                };
+                (fit, std::cmp::Reverse(domain))
+            })
+            .and_then(|(&domain, _)| domain)
+    }
+
+    /// L3 domain with the fewest assigned requests among those with free cores
+    fn pick_domain_least_loaded(
+        &self,
+        free: &[usize],
+        load: &HashMap<usize, usize>,
+    ) -> Option<usize> {
+        let counts = self.domain_counts(free);
+
+        counts
+            .keys()
+            .copied()
+            .min_by_key(|&domain| {
+                let used = load
+                    .keys()
+                    .filter(|&&id| self.cpu_topology.get_core_l3_domain(id) == domain)
+                    .count();
+                (used, std::cmp::Reverse(counts[&domain]), domain)
+            })
+            .flatten()
+    }
+
+    fn domain_counts(&self, free: &[usize]) -> HashMap<Option<usize>, usize> {
+        free.iter().fold(HashMap::new(), |mut counts, &id| {
+            *counts
+                .entry(self.cpu_topology.get_core_l3_domain(id))
+                .or_insert(0) += 1;
+            counts
+        })
+    }
+}
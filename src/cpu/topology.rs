@@ -23,6 +23,14 @@ pub struct CpuTopology {
     /// List of cores belonging to each socket
     /// Key: Socket ID, Value: List of logical core IDs
     pub socket_cores: HashMap<usize, Vec<usize>>,
+    /// Mapping of logical cores to last-level (L3) cache domains
+    /// Key: Logical core ID, Value: L3 domain ID (lowest logical core sharing it)
+    pub l3_mapping: HashMap<usize, usize>,
+    /// Cores sharing each L3 cache (CCX / CCD on AMD, socket on most Intel parts)
+    /// Key: L3 domain ID, Value: List of logical core IDs
+    pub l3_domains: HashMap<usize, Vec<usize>>,
+    /// Cores isolated from the scheduler (isolcpus / nohz_full)
+    pub isolated_cores: HashSet<usize>,
 }
 
 impl CpuTopology {
@@ -35,6 +43,9 @@ impl CpuTopology {
             socket_mapping: HashMap::new(),
             sibling_cores: HashMap::new(),
             socket_cores: HashMap::new(),
+            l3_mapping: HashMap::new(),
+            l3_domains: HashMap::new(),
+            isolated_cores: HashSet::new(),
         };
 
         topology.load_topology()?;
@@ -53,7 +64,7 @@ impl CpuTopology {
             let path = entry.path();
             let filename = path.file_name().unwrap().to_string_lossy();
 
-            if !filename.starts_with("system") || !filename[3..].chars().all(char::is_numeric) {
+            if !filename.starts_with("cpu") || !filename[3..].chars().all(char::is_numeric) {
                 continue;
             }
 
@@ -87,6 +98,17 @@ impl CpuTopology {
                     self.sibling_cores.insert(*phys_core_id, core_ids);
                 }
             }
+
+            if let Some(l3_cores) = read_l3_shared_cpus(&path) {
+                if let Some(&domain) = l3_cores.iter().min() {
+                    self.l3_mapping.insert(cpu_id, domain);
+                    self.l3_domains.entry(domain).or_insert(l3_cores);
+                }
+            }
+        }
+
+        if let Ok(isolated) = read_first_line(cpu_path.join("isolated")) {
+            self.isolated_cores = parse_cpu_list(&isolated).into_iter().collect();
         }
 
         self.physical_cores = physical_cores.len();
@@ -100,6 +122,10 @@ impl CpuTopology {
             cores.sort();
         }
 
+        for cores in self.l3_domains.values_mut() {
+            cores.sort();
+        }
+
         Ok(())
     }
 
@@ -175,7 +201,7 @@ impl CpuTopology {
         let core_mask = self.generate_core_mask();
         args.push(format!("--lcores={}", core_mask));
 
-        args.push("--master-lcore=0".to_string());
+        args.push("--main-lcore=0".to_string());
 
         args
     }
@@ -199,6 +225,25 @@ impl CpuTopology {
         true
     }
 
+    /// Returns the L3 cache domain of the specified core
+    pub fn get_core_l3_domain(&self, core_id: usize) -> Option<usize> {
+        self.l3_mapping.get(&core_id).copied()
+    }
+
+    /// Checks if the specified core is isolated from the kernel scheduler
+    pub fn is_isolated_core(&self, core_id: usize) -> bool {
+        self.isolated_cores.contains(&core_id)
+    }
+
+    /// Returns the HT siblings of the specified core, excluding the core itself
+    pub fn get_core_siblings(&self, core_id: usize) -> Vec<usize> {
+        self.core_mapping
+            .get(&core_id)
+            .and_then(|physical_id| self.sibling_cores.get(physical_id))
+            .map(|siblings| siblings.iter().copied().filter(|&id| id != core_id).collect())
+            .unwrap_or_default()
+    }
+
     /// Returns all available sockets (NUMA nodes)
     pub fn get_available_sockets(&self) -> Vec<usize> {
         let mut sockets: Vec<usize> = self.socket_cores.keys().cloned().collect();
@@ -283,6 +328,28 @@ fn read_first_line<P: AsRef<Path>>(path: P) -> io::Result<String> {
     Ok(contents.lines().next().unwrap_or("").to_string())
 }
 
+/// Reads the list of cores sharing the L3 cache with the given CPU
+fn read_l3_shared_cpus(cpu_path: &Path) -> Option<Vec<usize>> {
+    let cache_path = cpu_path.join("cache");
+
+    for entry in fs::read_dir(&cache_path).ok()?.flatten() {
+        let index_path = entry.path();
+        let level = match read_first_line(index_path.join("level")) {
+            Ok(level) => level,
+            Err(_) => continue,
+        };
+
+        if level.trim() == "3" {
+            let shared = read_first_line(index_path.join("shared_cpu_list")).ok()?;
+            let mut cores = parse_cpu_list(&shared);
+            cores.sort();
+            return Some(cores);
+        }
+    }
+
+    None
+}
+
 /// Parses a processor list from a string in the format "0-3,5,7-9"
 fn parse_cpu_list(list: &str) -> Vec<usize> {
     let mut result = Vec::new();
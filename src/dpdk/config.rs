@@ -1,14 +1,34 @@
+use std::net::Ipv4Addr;
 use std::os::raw::{c_uint, c_ushort};
 
+use crate::capture::replay::{ReplayConfig, ReplaySpeed};
+use crate::capture::tap::CaptureConfig;
+use crate::control::igmp::{MulticastConfig, MulticastGroup};
+use crate::dpdk::flow::{FlowAction, FlowRule};
+use crate::dpdk::mempool::PoolLayout;
+use crate::numa::arena::{ArenaConfig, ArenaPageSize};
+use crate::numa::idle::IdleStrategy;
+use crate::packet::classify::FlowMatch;
+use crate::packet::timestamp::RxTimestampMode;
+use crate::protocols::igmp::IgmpVersion;
+use crate::tx::session::{TxBatching, TxPolicy};
+
+/// Максимальный размер burst, должен совпадать с DPDK_MAX_BURST в src/native/dpdk.c
+pub const MAX_BURST_SIZE: usize = 64;
+
 /// Конфигурация DPDK с поддержкой NUMA
 #[repr(C)]
 pub struct DpdkConfig {
     pub port_id: c_ushort,
     pub num_rx_queues: c_ushort,
     pub num_tx_queues: c_ushort,
+    /// Promiscuous режим; при подписке на группы через `multicast` его можно
+    /// выключить - NIC фильтрует мультикаст по MAC адресам групп
     pub promiscuous: bool,
     pub rx_ring_size: c_uint,
     pub tx_ring_size: c_uint,
+    /// Минимальный размер пула mbuf; фактический рассчитывается из
+    /// количества очередей, глубины колец и кешей (см. dpdk::mempool)
     pub num_mbufs: c_uint,
     pub mbuf_cache_size: c_uint,
     pub burst_size: c_uint,
@@ -24,6 +44,7 @@ pub struct DpdkConfig {
     pub use_jumbo_frames: bool,
     pub max_rx_pkt_len: u32,
     pub use_hw_checksum: bool,
+    /// Устанавливать аппаратные правила rte_flow из `flow_rules`
     pub use_flow_director: bool,
     pub use_tso: bool,
     pub use_lro: bool,
@@ -31,6 +52,42 @@ pub struct DpdkConfig {
     pub max_tso_segment_size: u16,
     pub use_gro: bool,
     pub max_gro_size: u16,
+    /// Правила программной фильтрации RX; пустой список - принимать всё
+    pub rx_filters: Vec<FlowMatch>,
+    /// Политика повторной отправки для TX сессий
+    pub tx_policy: TxPolicy,
+    /// Объединение bulk трафика TX сессий в doorbell и освобождение колец
+    pub tx_batching: TxBatching,
+    /// Включать RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE, если драйвер его поддерживает
+    pub tx_fast_free: bool,
+    /// Стратегия ожидания RX worker по умолчанию
+    pub idle_strategy: IdleStrategy,
+    /// Переопределения стратегии ожидания: (port_id, queue_id, стратегия)
+    pub queue_idle_strategies: Vec<(u16, u16, IdleStrategy)>,
+    /// Источник времени прихода пакетов для измерения задержек
+    pub rx_timestamps: RxTimestampMode,
+    /// Раскладка пулов mbuf: общий на порт или на каждую RX очередь
+    pub mbuf_pool_layout: PoolLayout,
+    /// Сколько burst на очередь может одновременно удерживаться
+    /// обработчиком или TX backlog; учитывается при расчете размера пулов
+    pub mbuf_in_flight_bursts: u32,
+    /// Размещать память EAL (и пулы mbuf) на 1 ГБ страницах
+    pub use_1g_hugepages: bool,
+    /// Аппаратные правила направления и отбрасывания потоков
+    pub flow_rules: Vec<FlowRule>,
+    /// Отбрасывать в NIC трафик, не подходящий ни под одно правило направления
+    pub flow_default_drop: bool,
+    /// Подписка на мультикаст-группы фидов (IGMP в обход ядра)
+    pub multicast: MulticastConfig,
+    /// Дополнительные аргументы EAL: виртуальные устройства (`--vdev`),
+    /// `--no-huge`, `--no-pci` и т.п. для стендов и бенчмарков
+    pub eal_args: Vec<String>,
+    /// Запись всего входящего трафика в pcapng
+    pub capture: CaptureConfig,
+    /// Воспроизведение записи вместо приема с порта
+    pub replay: ReplayConfig,
+    /// Арены узлов NUMA для выделений worker и стадий
+    pub arena: ArenaConfig,
 }
 
 impl Default for DpdkConfig {
@@ -68,6 +125,23 @@ impl Default for DpdkConfig {
             max_tso_segment_size: 1460, // Типичный размер MSS (MTU - заголовки TCP/IP)
             use_gro: false,
             max_gro_size: 65535,
+            rx_filters: Vec::new(),
+            tx_policy: TxPolicy::default(),
+            tx_batching: TxBatching::default(),
+            tx_fast_free: true,
+            idle_strategy: IdleStrategy::Spin,
+            queue_idle_strategies: Vec::new(),
+            rx_timestamps: RxTimestampMode::Off,
+            mbuf_pool_layout: PoolLayout::Shared,
+            mbuf_in_flight_bursts: 4,
+            use_1g_hugepages: false,
+            flow_rules: Vec::new(),
+            flow_default_drop: false,
+            multicast: MulticastConfig::default(),
+            eal_args: Vec::new(),
+            capture: CaptureConfig::default(),
+            replay: ReplayConfig::default(),
+            arena: ArenaConfig::default(),
         }
     }
 }
@@ -126,6 +200,207 @@ impl DpdkConfig {
         }
         self
     }
+
+    /// Задает поля RSS хеша для трафика, не направленного правилами rte_flow
+    pub fn with_rss_hash(mut self, rss_hf: u64) -> Self {
+        self.rss_hf = rss_hf;
+        self
+    }
+
+    /// Добавляет правило RX фильтра: пакеты, не подходящие ни под одно
+    /// правило, отбрасываются классификатором до разбора
+    pub fn with_rx_filter(mut self, rule: FlowMatch) -> Self {
+        self.rx_filters.push(rule);
+        self
+    }
+
+    /// Направляет поток в указанную RX очередь аппаратным правилом rte_flow
+    pub fn with_flow_steering(mut self, port_id: Option<u16>, rule: FlowMatch, queue_id: u16) -> Self {
+        self.use_flow_director = true;
+        self.flow_rules.push(FlowRule {
+            port_id,
+            matcher: rule,
+            action: FlowAction::Queue(queue_id),
+        });
+        self
+    }
+
+    /// Отбрасывает поток в NIC аппаратным правилом rte_flow
+    pub fn with_flow_drop(mut self, port_id: Option<u16>, rule: FlowMatch) -> Self {
+        self.use_flow_director = true;
+        self.flow_rules.push(FlowRule {
+            port_id,
+            matcher: rule,
+            action: FlowAction::Drop,
+        });
+        self
+    }
+
+    /// Отбрасывает в NIC весь трафик, не направленный правилами в очереди
+    pub fn with_default_flow_drop(mut self) -> Self {
+        self.use_flow_director = true;
+        self.flow_default_drop = true;
+        self
+    }
+
+    /// Задает стратегию ожидания для всех RX очередей
+    pub fn with_idle_strategy(mut self, strategy: IdleStrategy) -> Self {
+        self.idle_strategy = strategy;
+        self
+    }
+
+    /// Задает стратегию ожидания для конкретной очереди (например, холодной)
+    pub fn with_queue_idle_strategy(
+        mut self,
+        port_id: u16,
+        queue_id: u16,
+        strategy: IdleStrategy,
+    ) -> Self {
+        self.queue_idle_strategies
+            .retain(|&(p, q, _)| p != port_id || q != queue_id);
+        self.queue_idle_strategies.push((port_id, queue_id, strategy));
+        self
+    }
+
+    /// Включает метки времени прихода пакетов и гистограммы задержек worker
+    pub fn with_rx_timestamps(mut self, mode: RxTimestampMode) -> Self {
+        self.rx_timestamps = mode;
+        self
+    }
+
+    /// Задает раскладку пулов mbuf
+    pub fn with_pool_layout(mut self, layout: PoolLayout) -> Self {
+        self.mbuf_pool_layout = layout;
+        self
+    }
+
+    /// Размещает память EAL на 1 ГБ страницах (нужен смонтированный hugetlbfs
+    /// с pagesize=1G, либо явный huge_dir)
+    pub fn with_1g_hugepages(mut self) -> Self {
+        self.use_1g_hugepages = true;
+        self
+    }
+
+    /// Включает или выключает promiscuous режим портов
+    pub fn with_promiscuous(mut self, enabled: bool) -> Self {
+        self.promiscuous = enabled;
+        self
+    }
+
+    /// Подписывает порт на мультикаст-группу (любой источник)
+    pub fn with_multicast_group(mut self, port_id: u16, group: Ipv4Addr) -> Self {
+        self.multicast.groups.push(MulticastGroup {
+            port_id,
+            group,
+            sources: Vec::new(),
+        });
+        self
+    }
+
+    /// Подписывает порт на группу от конкретного источника (SSM, IGMPv3);
+    /// повторный вызов для той же группы добавляет источник
+    pub fn with_ssm_group(mut self, port_id: u16, group: Ipv4Addr, source: Ipv4Addr) -> Self {
+        match self
+            .multicast
+            .groups
+            .iter_mut()
+            .find(|g| g.port_id == port_id && g.group == group && !g.sources.is_empty())
+        {
+            Some(existing) => {
+                if !existing.sources.contains(&source) {
+                    existing.sources.push(source);
+                }
+            }
+            None => self.multicast.groups.push(MulticastGroup {
+                port_id,
+                group,
+                sources: vec![source],
+            }),
+        }
+        self
+    }
+
+    /// Задает IP адрес, от имени которого порт отправляет IGMP сообщения
+    pub fn with_igmp_interface(mut self, port_id: u16, ip: Ipv4Addr) -> Self {
+        self.multicast.interfaces.retain(|&(p, _)| p != port_id);
+        self.multicast.interfaces.push((port_id, ip));
+        self
+    }
+
+    /// Задает версию IGMP (v2 для сетей без SSM)
+    pub fn with_igmp_version(mut self, version: IgmpVersion) -> Self {
+        self.multicast.version = version;
+        self
+    }
+
+    /// Добавляет виртуальное устройство EAL, например `net_ring0`,
+    /// `net_null0` или `net_pcap0,rx_pcap=feed.pcap`
+    pub fn with_vdev(mut self, spec: &str) -> Self {
+        self.eal_args.push(format!("--vdev={}", spec));
+        self
+    }
+
+    /// Добавляет произвольный аргумент EAL
+    pub fn with_eal_arg(mut self, arg: &str) -> Self {
+        self.eal_args.push(arg.to_string());
+        self
+    }
+
+    /// Включает запись входящего трафика всех RX очередей в файл pcapng
+    pub fn with_capture(mut self, path: &str) -> Self {
+        self.capture.path = Some(path.to_string());
+        self
+    }
+
+    /// Подает в RX очереди порта 0 запись pcap/pcapng вместо трафика NIC
+    ///
+    /// Без сетевой карты порт можно создать виртуальным устройством
+    /// `net_null0`: его RX не опрашивается, а TX отбрасывает ордера.
+    pub fn with_replay(mut self, path: &str, speed: ReplaySpeed) -> Self {
+        self.replay.path = Some(path.to_string());
+        self.replay.speed = speed;
+        self
+    }
+
+    /// Задает объединение bulk пакетов TX сессий: doorbell после
+    /// `doorbell_batch` пакетов или через `max_delay_us` мкс
+    pub fn with_tx_batching(mut self, doorbell_batch: usize, max_delay_us: u64) -> Self {
+        self.tx_batching.doorbell_batch = doorbell_batch.clamp(1, MAX_BURST_SIZE);
+        self.tx_batching.max_delay_us = max_delay_us;
+        self
+    }
+
+    /// Создает на каждом узле NUMA арену `size_mb` МБ на huge pages
+    ///
+    /// Арена используется, если бинарник объявил `NodeAwareAllocator`
+    /// глобальным аллокатором (см. `NumaManager::init_node_arenas`).
+    /// Hugepage пул узла должен вмещать `socket_mem` EAL и арену вместе.
+    pub fn with_node_arenas(mut self, size_mb: usize, page_size: ArenaPageSize) -> Self {
+        self.arena.size_mb = size_mb;
+        self.arena.page_size = page_size;
+        self
+    }
+
+    /// Количество служебных пар RX/TX очередей порта сверх рабочих
+    ///
+    /// Служебная очередь имеет индекс `num_rx_queues` (`num_tx_queues` для
+    /// TX), не входит в RETA и не обслуживается RX worker.
+    pub fn control_queues(&self) -> u16 {
+        self.multicast.is_enabled() as u16
+    }
+
+    /// Возвращает стратегию ожидания для очереди
+    pub fn idle_strategy_for(&self, port_id: u16, queue_id: u16) -> IdleStrategy {
+        self.queue_idle_strategies
+            .iter()
+            .find(|&&(p, q, _)| p == port_id && q == queue_id)
+            .map_or(self.idle_strategy, |&(_, _, strategy)| strategy)
+    }
+
+    /// Проверяет, нужны ли порту RX прерывания хотя бы для одной очереди
+    pub fn port_needs_rx_interrupts(&self, port_id: u16) -> bool {
+        (0..self.num_rx_queues).any(|q| self.idle_strategy_for(port_id, q).needs_rx_interrupts())
+    }
 }
 
 /// Создает конфигурацию DPDK с параметрами по умолчанию
@@ -1,6 +1,15 @@
 use std::ffi::c_void;
 use std::os::raw::{c_char, c_int, c_uint, c_ushort};
 
+use crate::capture::tap::CaptureRecord;
+use crate::dpdk::flow::FlowSpec;
+use crate::packet::classify::HeaderLanes;
+use crate::packet::data::PacketData;
+use crate::packet::timestamp::RxClock;
+use crate::telemetry::worker::BurstStats;
+use crate::tx::session::HeaderTemplate;
+use crate::tx::tcp::TcpSegment;
+
 #[repr(C)]
 pub struct RteMbuf {
     _private: [u8; 0],
@@ -12,10 +21,13 @@ pub struct RteMempool {
 }
 
 #[repr(C)]
-pub struct RteEthRssConf {
-    pub rss_key: *mut u8,
-    pub rss_key_len: u8,
-    pub rss_hf: u64,
+pub struct RteFlow {
+    _private: [u8; 0],
+}
+
+#[repr(C)]
+pub struct RteEtherAddr {
+    pub addr_bytes: [u8; 6],
 }
 
 // RSS константы
@@ -23,72 +35,100 @@ pub const ETH_RSS_IP: u64 = 0x1;
 pub const ETH_RSS_TCP: u64 = 0x2;
 pub const ETH_RSS_UDP: u64 = 0x4;
 pub const ETH_RSS_SCTP: u64 = 0x8;
-pub const ETH_MQ_RX_RSS: u32 = 1;
 pub const ETH_RSS_NONFRAG_IPV4_TCP: u64 = 0x40;
 pub const ETH_RSS_NONFRAG_IPV4_UDP: u64 = 0x80;
 pub const ETH_RSS_L4_DST_ONLY: u64 = 0x200;
 pub const ETH_RSS_L4_SRC_ONLY: u64 = 0x100;
 
-// Константы для RX offload флагов
-pub const DEV_RX_OFFLOAD_CHECKSUM: u64 = 0x00000001;
-pub const DEV_RX_OFFLOAD_TCP_LRO: u64 = 0x00000010;
-pub const DEV_RX_OFFLOAD_SCATTER: u64 = 0x00000100;
-pub const DEV_RX_OFFLOAD_TCP_GRO: u64 = 0x00000040;
-
-// Константы для TX offload флагов
-pub const DEV_TX_OFFLOAD_MBUF_FAST_FREE: u64 = 0x00000001;
-pub const DEV_TX_OFFLOAD_IPV4_CKSUM: u64 = 0x00000002;
-pub const DEV_TX_OFFLOAD_UDP_CKSUM: u64 = 0x00000004;
-pub const DEV_TX_OFFLOAD_TCP_CKSUM: u64 = 0x00000008;
-pub const DEV_TX_OFFLOAD_SCTP_CKSUM: u64 = 0x00000010;
-pub const DEV_TX_OFFLOAD_TCP_TSO: u64 = 0x00000020;
-pub const DEV_TX_OFFLOAD_UDP_TSO: u64 = 0x00000040;
-pub const DEV_TX_OFFLOAD_MULTI_SEGS: u64 = 0x00000080;
-
 // Флаги пакетов (метки для mbuf)
 pub const RTE_MBUF_F_TX_TCP_SEG: u64 = 1 << 9;
 pub const RTE_MBUF_F_TX_UDP_SEG: u64 = 1 << 10;
 
+/// Настройки порта для `dpdk_eth_dev_configure`
+///
+/// `struct rte_eth_conf` собирается на стороне C: ее раскладка (резервные
+/// поля, битовые поля `intr_conf`) зависит от версии DPDK, поэтому Rust
+/// передает только плоский набор флагов.
 #[repr(C)]
-pub struct RteEthConf {
-    pub rxmode: RteEthRxMode,
-    pub txmode: RteEthTxMode,
-    pub lpbk_mode: u32,
-    pub rx_adv_conf: RteEthRxAdvConf,
-    pub tx_adv_conf: RteEthTxAdvConf,
-    pub dcb_capability_en: u32,
-    pub fdir_conf: RteEthFdirConf,
-    pub intr_conf: RteEthIntrConf,
+#[derive(Debug)]
+pub struct EthSettings {
+    pub rss_hf: u64,
+    pub rss_key: *const u8,
+    pub rss_key_len: u8,
+    pub rss: u8,
+    pub scatter: u8,
+    pub hw_checksum: u8,
+    pub tx_fast_free: u8,
+    pub tcp_tso: u8,
+    pub udp_tso: u8,
+    pub lro: u8,
+    pub rx_timestamp: u8,
+    pub rxq_intr: u8,
+    /// MTU порта, 0 - значение драйвера по умолчанию
+    pub mtu: u32,
 }
 
-#[repr(C)]
-pub struct RteEthRxMode {
-    pub mq_mode: u32,
-    pub max_rx_pkt_len: u32,
-    pub split_hdr_size: u16,
-    pub offloads: u64,
+impl Default for EthSettings {
+    fn default() -> Self {
+        Self {
+            rss_hf: 0,
+            rss_key: std::ptr::null(),
+            rss_key_len: 0,
+            rss: 0,
+            scatter: 0,
+            hw_checksum: 0,
+            tx_fast_free: 0,
+            tcp_tso: 0,
+            udp_tso: 0,
+            lro: 0,
+            rx_timestamp: 0,
+            rxq_intr: 0,
+            mtu: 0,
+        }
+    }
 }
 
-#[repr(C)]
-pub struct RteEthTxMode {
-    pub mq_mode: u32,
-    pub pvid: u16,
-    pub offloads: u64,
-}
+/// Количество счетчиков очередей в `rte_eth_stats` (RTE_ETHDEV_QUEUE_STAT_CNTRS)
+pub const RTE_ETHDEV_QUEUE_STAT_CNTRS: usize = 16;
 
+/// Базовая статистика порта, `struct rte_eth_stats`
 #[repr(C)]
-pub struct RteEthRxAdvConf {
-    pub rss_conf: RteEthRssConf,
+#[derive(Debug, Clone, Copy)]
+pub struct RteEthStats {
+    pub ipackets: u64,
+    pub opackets: u64,
+    pub ibytes: u64,
+    pub obytes: u64,
+    /// Пакеты, отброшенные NIC из-за переполнения RX очереди
+    pub imissed: u64,
+    pub ierrors: u64,
+    pub oerrors: u64,
+    /// Ошибки выделения mbuf при приеме
+    pub rx_nombuf: u64,
+    pub q_ipackets: [u64; RTE_ETHDEV_QUEUE_STAT_CNTRS],
+    pub q_opackets: [u64; RTE_ETHDEV_QUEUE_STAT_CNTRS],
+    pub q_ibytes: [u64; RTE_ETHDEV_QUEUE_STAT_CNTRS],
+    pub q_obytes: [u64; RTE_ETHDEV_QUEUE_STAT_CNTRS],
+    pub q_errors: [u64; RTE_ETHDEV_QUEUE_STAT_CNTRS],
 }
 
-#[repr(C)]
-pub struct RteEthTxAdvConf {}
+/// Длина имени расширенного счетчика (RTE_ETH_XSTATS_NAME_SIZE)
+pub const RTE_ETH_XSTATS_NAME_SIZE: usize = 64;
 
+/// Имя расширенного счетчика, `struct rte_eth_xstat_name`
 #[repr(C)]
-pub struct RteEthFdirConf {}
+#[derive(Clone, Copy)]
+pub struct RteEthXstatName {
+    pub name: [c_char; RTE_ETH_XSTATS_NAME_SIZE],
+}
 
+/// Значение расширенного счетчика, `struct rte_eth_xstat`
 #[repr(C)]
-pub struct RteEthIntrConf {}
+#[derive(Debug, Clone, Copy, Default)]
+pub struct RteEthXstat {
+    pub id: u64,
+    pub value: u64,
+}
 
 #[derive(Debug, Clone, Copy, PartialEq)]
 pub enum DpdkError {
@@ -116,14 +156,9 @@ extern "C" {
         data_room_size: c_ushort,
         socket_id: c_int,
     ) -> *mut RteMempool;
+    pub fn rte_mempool_free(mp: *mut RteMempool);
 
     pub fn rte_eth_dev_is_valid_port(port_id: c_ushort) -> c_int;
-    pub fn rte_eth_dev_configure(
-        port_id: c_ushort,
-        nb_rx_queue: c_ushort,
-        nb_tx_queue: c_ushort,
-        eth_conf: *const c_void,
-    ) -> c_int;
     pub fn rte_eth_rx_queue_setup(
         port_id: c_ushort,
         rx_queue_id: c_ushort,
@@ -141,7 +176,15 @@ extern "C" {
     ) -> c_int;
     pub fn rte_eth_dev_start(port_id: c_ushort) -> c_int;
     pub fn rte_eth_promiscuous_enable(port_id: c_ushort) -> c_int;
+    pub fn rte_eth_promiscuous_disable(port_id: c_ushort) -> c_int;
+    pub fn rte_eth_dev_set_mc_addr_list(
+        port_id: c_ushort,
+        mc_addr_set: *mut RteEtherAddr,
+        nb_mc_addr: c_uint,
+    ) -> c_int;
     pub fn rte_eth_dev_stop(port_id: c_ushort) -> c_int;
+    pub fn rte_eth_dev_rx_queue_start(port_id: c_ushort, rx_queue_id: c_ushort) -> c_int;
+    pub fn rte_eth_dev_rx_queue_stop(port_id: c_ushort, rx_queue_id: c_ushort) -> c_int;
     pub fn rte_eth_dev_close(port_id: c_ushort) -> c_int;
 
     pub fn rte_eth_rx_burst(
@@ -156,11 +199,26 @@ extern "C" {
         tx_pkts: *mut *mut RteMbuf,
         nb_pkts: c_ushort,
     ) -> c_ushort;
+    pub fn rte_eth_tx_done_cleanup(port_id: c_ushort, queue_id: c_ushort, free_cnt: c_uint)
+        -> c_int;
 
     pub fn rte_pktmbuf_free(m: *mut RteMbuf);
+    pub fn rte_pktmbuf_free_bulk(mbufs: *mut *mut RteMbuf, count: c_uint);
     pub fn rte_pktmbuf_mtod(m: *const RteMbuf, t: *const c_void) -> *mut c_void;
     pub fn rte_pktmbuf_data_len(m: *const RteMbuf) -> c_ushort;
     pub fn rte_eth_dev_socket_id(port_id: c_ushort) -> c_int;
+    pub fn rte_eth_macaddr_get(port_id: c_ushort, mac_addr: *mut RteEtherAddr) -> c_int;
+
+    pub fn rte_eth_stats_get(port_id: c_ushort, stats: *mut RteEthStats) -> c_int;
+    pub fn rte_eth_xstats_get_names(
+        port_id: c_ushort,
+        xstats_names: *mut RteEthXstatName,
+        size: c_uint,
+    ) -> c_int;
+    pub fn rte_eth_read_clock(port_id: c_ushort, clock: *mut u64) -> c_int;
+    pub fn rte_get_tsc_hz() -> u64;
+
+    pub fn rte_eth_xstats_get(port_id: c_ushort, xstats: *mut RteEthXstat, n: c_uint) -> c_int;
 
     pub fn dpdk_extract_packet_data(
         pkt: *const RteMbuf,
@@ -173,4 +231,167 @@ extern "C" {
         data_out: *mut *mut u8,
         data_len_out: *mut u32,
     ) -> c_int;
+
+    /// Разбирает весь burst за один вызов, заполняя `descs[0..nb_pkts]`.
+    /// При ненулевом `clock` проставляет время прихода в такты TSC.
+    /// Байты и коды ошибок разбора накапливаются в `stats`.
+    /// Возвращает количество успешно разобранных пакетов.
+    pub fn dpdk_parse_burst(
+        pkts: *mut *mut RteMbuf,
+        nb_pkts: c_ushort,
+        queue_id: c_ushort,
+        descs: *mut PacketData,
+        clock: *const RxClock,
+        stats: *mut BurstStats,
+    ) -> c_ushort;
+
+    /// Полная длина payload пакета (для многосегментного больше `data_len`)
+    pub fn dpdk_packet_payload_len(desc: *const PacketData) -> u32;
+
+    /// Переходит к следующему сегменту mbuf; NULL - сегментов больше нет
+    pub fn dpdk_packet_next_segment(
+        seg: *const RteMbuf,
+        data_out: *mut *const u8,
+        len_out: *mut u32,
+    ) -> *const RteMbuf;
+
+    /// Непрерывный payload: указатель в mbuf или копия в `buf`; NULL - буфер мал
+    pub fn dpdk_packet_linearize(desc: *const PacketData, buf: *mut u8, buf_len: u32) -> *const u8;
+
+    /// Собирает поля заголовков burst в `HeaderLanes` для классификатора
+    pub fn dpdk_gather_headers(
+        pkts: *mut *mut RteMbuf,
+        nb_pkts: c_ushort,
+        lanes: *mut HeaderLanes,
+    ) -> c_ushort;
+
+    /// Передает burst потоку захвата: увеличивает счетчик ссылок mbuf и
+    /// заполняет `records[0..nb_pkts]`; NULL `clock` - один TSC на burst
+    pub fn dpdk_capture_burst(
+        pkts: *mut *mut RteMbuf,
+        nb_pkts: c_ushort,
+        port_id: c_ushort,
+        queue_id: c_ushort,
+        clock: *const RxClock,
+        records: *mut CaptureRecord,
+    );
+
+    /// Копирует первые `len` байт пакета из всех сегментов в `dst`
+    pub fn dpdk_capture_copy(m: *const RteMbuf, dst: *mut u8, len: u32) -> u32;
+
+    /// Выделяет `nb_pkts` mbuf и копирует в них записанные кадры;
+    /// 0 - в пуле не хватило mbuf
+    pub fn dpdk_replay_burst(
+        pool: *mut RteMempool,
+        port_id: c_ushort,
+        pkts: *mut *mut RteMbuf,
+        data: *const *const u8,
+        lens: *const u32,
+        nb_pkts: c_ushort,
+    ) -> c_ushort;
+
+    /// Строит шаблон заголовков TX сессии; IP-адреса в сетевом порядке байтов
+    pub fn dpdk_tx_template_init(
+        tmpl: *mut HeaderTemplate,
+        src_mac: *const u8,
+        dst_mac: *const u8,
+        src_ip: u32,
+        dst_ip: u32,
+        src_port: u16,
+        dst_port: u16,
+        use_tcp: c_int,
+        hw_cksum: c_int,
+    ) -> c_int;
+
+    /// Выделяет mbuf пачкой и собирает пакеты по шаблону
+    pub fn dpdk_tx_build_burst(
+        mbuf_pool: *mut RteMempool,
+        tmpl: *const HeaderTemplate,
+        payloads: *const *const u8,
+        payload_lens: *const u16,
+        nb_pkts: c_ushort,
+        pkts_out: *mut *mut RteMbuf,
+    ) -> c_ushort;
+
+    /// Выделяет mbuf и возвращает адрес payload после области заголовков
+    pub fn dpdk_tx_prepare(
+        mbuf_pool: *mut RteMempool,
+        tmpl: *const HeaderTemplate,
+        mbuf_out: *mut *mut RteMbuf,
+    ) -> *mut u8;
+
+    /// Достраивает заголовки кадра, payload которого записан на месте
+    pub fn dpdk_tx_commit(tmpl: *const HeaderTemplate, mbuf: *mut RteMbuf, payload_len: c_ushort);
+
+    /// Выделяет mbuf пачкой и собирает TCP сегменты по шаблону
+    pub fn dpdk_tx_build_tcp_burst(
+        mbuf_pool: *mut RteMempool,
+        tmpl: *const HeaderTemplate,
+        segs: *const TcpSegment,
+        nb_segs: c_ushort,
+        pkts_out: *mut *mut RteMbuf,
+    ) -> c_ushort;
+
+    /// Отправляет burst с повторами; неотправленные пакеты не освобождаются
+    pub fn dpdk_tx_send_burst(
+        port_id: c_ushort,
+        queue_id: c_ushort,
+        pkts: *mut *mut RteMbuf,
+        nb_pkts: c_ushort,
+        max_retries: c_uint,
+    ) -> c_ushort;
+
+    /// Собирает `rte_eth_conf` из настроек и вызывает `rte_eth_dev_configure`
+    pub fn dpdk_eth_dev_configure(
+        port_id: c_ushort,
+        nb_rx_queue: c_ushort,
+        nb_tx_queue: c_ushort,
+        settings: *const EthSettings,
+    ) -> c_int;
+
+    /// Проверяет поддержку RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE драйвером порта
+    pub fn dpdk_tx_fast_free_supported(port_id: c_ushort) -> c_int;
+
+    /// Проверяет, что RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE вошел в конфигурацию
+    /// порта: 1 - включен, 0 - нет, отрицательный код ошибки DPDK иначе
+    pub fn dpdk_tx_fast_free_enabled(port_id: c_ushort) -> c_int;
+
+    /// Копирует готовый кадр в новый mbuf; NULL при нехватке mbuf
+    pub fn dpdk_tx_frame(
+        mbuf_pool: *mut RteMempool,
+        frame: *const u8,
+        len: c_ushort,
+    ) -> *mut RteMbuf;
+
+    /// Распределяет таблицу RETA по первым nb_queues очередям
+    pub fn dpdk_rss_reta_spread(port_id: c_ushort, nb_queues: c_ushort) -> c_int;
+
+    /// Регистрирует RX прерывание очереди в epoll текущего потока
+    pub fn dpdk_rx_intr_register(port_id: c_ushort, queue_id: c_ushort) -> c_int;
+
+    /// Ждет RX прерывания любой из очередей не дольше timeout_ms
+    pub fn dpdk_rx_intr_wait(
+        port_ids: *const c_ushort,
+        queue_ids: *const c_ushort,
+        nb_queues: c_ushort,
+        timeout_ms: c_int,
+    ) -> c_int;
+
+    /// Проверяет поддержку RX timestamp и регистрирует динамическое поле mbuf.
+    /// Вызывается до `rte_eth_dev_configure`.
+    pub fn dpdk_rx_timestamp_enable(port_id: c_ushort) -> c_int;
+    /// Возвращает 1, если на порту включены аппаратные RX timestamp
+    pub fn dpdk_rx_timestamp_active(port_id: c_ushort) -> c_int;
+    /// Счетчик тактов для платформ без прямого чтения TSC из Rust
+    pub fn dpdk_tsc_cycles() -> u64;
+
+    /// Проверяет и устанавливает правило rte_flow; текст ошибки пишется в `err`
+    pub fn dpdk_flow_create(
+        port_id: c_ushort,
+        spec: *const FlowSpec,
+        err: *mut c_char,
+        err_len: usize,
+    ) -> *mut RteFlow;
+    pub fn dpdk_flow_destroy(port_id: c_ushort, flow: *mut RteFlow) -> c_int;
+    pub fn dpdk_flow_flush(port_id: c_ushort) -> c_int;
 }
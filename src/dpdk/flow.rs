@@ -0,0 +1,263 @@
+// src/dpdk/flow.rs
+use std::ffi::CStr;
+use std::os::raw::c_char;
+
+use crate::dpdk::config::DpdkConfig;
+use crate::dpdk::ffi::{self, RteFlow};
+use crate::packet::classify::{FlowMatch, IPPROTO_TCP, IPPROTO_UDP};
+use crate::protocols::igmp::IPPROTO_IGMP;
+
+/// Приоритет правил направления; меньшее значение проверяется раньше
+const STEER_PRIORITY: u32 = 0;
+/// Приоритет правила "отбросить остальное", ниже всех правил направления
+const DEFAULT_DROP_PRIORITY: u32 = 1;
+
+/// Действие аппаратного правила
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FlowAction {
+    /// Направить поток в RX очередь
+    Queue(u16),
+    /// Отбросить поток в NIC
+    Drop,
+}
+
+/// Аппаратное правило rte_flow для порта
+#[derive(Debug, Clone, Copy)]
+pub struct FlowRule {
+    /// Порт, None - все порты
+    pub port_id: Option<u16>,
+    pub matcher: FlowMatch,
+    pub action: FlowAction,
+}
+
+/// Параметры правила для dpdk_flow_create
+///
+/// Раскладка совпадает с `struct dpdk_flow_spec` в src/native/dpdk.c.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct FlowSpec {
+    pub dst_ip: u32,
+    pub dst_ip_mask: u32,
+    pub dst_port: u16,
+    pub dst_port_mask: u16,
+    pub proto: u8,
+    pub drop: u8,
+    pub queue: u16,
+    pub priority: u32,
+}
+
+impl FlowSpec {
+    /// Строит спецификации правила; совпадение по порту без протокола
+    /// раскрывается в два правила (UDP и TCP)
+    fn from_rule(rule: &FlowRule) -> Vec<FlowSpec> {
+        let (drop, queue) = match rule.action {
+            FlowAction::Queue(q) => (0, q),
+            FlowAction::Drop => (1, 0),
+        };
+
+        let base = FlowSpec {
+            dst_ip: rule.matcher.dst_ip.map_or(0, |ip| u32::from(ip).to_be()),
+            dst_ip_mask: rule.matcher.dst_ip.map_or(0, |_| u32::MAX),
+            dst_port: rule.matcher.dst_port.unwrap_or(0),
+            dst_port_mask: rule.matcher.dst_port.map_or(0, |_| u16::MAX),
+            proto: rule.matcher.proto.unwrap_or(0),
+            drop,
+            queue,
+            priority: STEER_PRIORITY,
+        };
+
+        if base.proto == 0 && base.dst_port_mask != 0 {
+            [IPPROTO_UDP, IPPROTO_TCP]
+                .iter()
+                .map(|&proto| FlowSpec { proto, ..base })
+                .collect()
+        } else {
+            vec![base]
+        }
+    }
+}
+
+/// Идентификатор правила, добавленного на работающем порту
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct FlowRuleId(pub u64);
+
+/// Установленные правила порта; удаляются при уничтожении таблицы
+#[derive(Debug)]
+pub struct FlowTable {
+    port_id: u16,
+    /// Правила rte_flow; правила из конфигурации не имеют идентификатора
+    flows: Vec<(Option<FlowRuleId>, *mut RteFlow)>,
+}
+
+impl FlowTable {
+    pub fn empty(port_id: u16) -> Self {
+        Self {
+            port_id,
+            flows: Vec::new(),
+        }
+    }
+
+    /// Устанавливает одно правило
+    fn create(&mut self, spec: &FlowSpec, id: Option<FlowRuleId>) -> Result<(), String> {
+        let mut err = [0 as c_char; 256];
+        let flow =
+            unsafe { ffi::dpdk_flow_create(self.port_id, spec, err.as_mut_ptr(), err.len()) };
+
+        if flow.is_null() {
+            let message = unsafe { CStr::from_ptr(err.as_ptr()) }.to_string_lossy();
+            return Err(format!(
+                "Failed to install flow rule on port {}: {}",
+                self.port_id, message
+            ));
+        }
+
+        self.flows.push((id, flow));
+        Ok(())
+    }
+
+    /// Добавляет правило на работающем порту
+    ///
+    /// rte_flow меняет классификацию NIC без остановки порта, поэтому RX
+    /// worker продолжают опрос. Правило получает приоритет направления, как
+    /// правила конфигурации. При ошибке уже созданные части правила
+    /// удаляются.
+    pub fn add_rule(
+        &mut self,
+        id: FlowRuleId,
+        rule: &FlowRule,
+        num_rx_queues: u16,
+    ) -> Result<(), String> {
+        if let FlowAction::Queue(q) = rule.action {
+            if q >= num_rx_queues {
+                return Err(format!(
+                    "Flow rule {:?} targets RX queue {} but port {} has {} queues",
+                    rule.matcher, q, self.port_id, num_rx_queues
+                ));
+            }
+        }
+
+        for spec in FlowSpec::from_rule(rule) {
+            if let Err(e) = self.create(&spec, Some(id)) {
+                self.remove_rule(id);
+                return Err(e);
+            }
+        }
+        Ok(())
+    }
+
+    /// Удаляет правило `id`; возвращает false, если его нет на порту
+    pub fn remove_rule(&mut self, id: FlowRuleId) -> bool {
+        let port_id = self.port_id;
+        let before = self.flows.len();
+
+        self.flows.retain(|&(flow_id, flow)| {
+            if flow_id != Some(id) {
+                return true;
+            }
+            unsafe { ffi::dpdk_flow_destroy(port_id, flow) };
+            false
+        });
+
+        self.flows.len() != before
+    }
+
+    /// Количество установленных правил
+    pub fn len(&self) -> usize {
+        self.flows.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.flows.is_empty()
+    }
+
+    /// Удаляет все правила таблицы
+    pub fn clear(&mut self) {
+        for (_, flow) in self.flows.drain(..) {
+            unsafe { ffi::dpdk_flow_destroy(self.port_id, flow) };
+        }
+    }
+}
+
+impl Drop for FlowTable {
+    fn drop(&mut self) {
+        self.clear();
+    }
+}
+
+unsafe impl Send for FlowTable {}
+
+/// Устанавливает правила rte_flow из конфигурации для порта
+///
+/// Вызывается после rte_eth_dev_start. Таблица владеет только своими
+/// правилами: остатки предыдущего запуска сбрасываются один раз при
+/// поднятии порта в `configure_port_for_node`. Правила направления получают
+/// приоритет выше правила "отбросить остальное", поэтому при
+/// `flow_default_drop` в очереди попадает только явно выбранный трафик.
+pub fn install_port_flows(port_id: u16, dpdk_config: &DpdkConfig) -> Result<FlowTable, String> {
+    let mut table = FlowTable::empty(port_id);
+    let igmp_steering = dpdk_config.control_queues() > 0
+        && dpdk_config.multicast.groups_for(port_id).next().is_some();
+
+    if !dpdk_config.use_flow_director && !igmp_steering {
+        return Ok(table);
+    }
+
+    // Запросы IGMP направляются в служебную очередь агента. Если NIC не
+    // поддерживает правило, агент держит подписку периодическими отчетами,
+    // а запросы обрабатываются как обычный трафик RX worker
+    if igmp_steering {
+        let spec = FlowSpec {
+            proto: IPPROTO_IGMP,
+            queue: dpdk_config.num_rx_queues,
+            priority: STEER_PRIORITY,
+            ..FlowSpec::default()
+        };
+        match table.create(&spec, None) {
+            Ok(()) => println!(
+                "  Port {}: flow IGMP -> Queue({})",
+                port_id, dpdk_config.num_rx_queues
+            ),
+            Err(e) => eprintln!("  Port {}: IGMP steering unavailable: {}", port_id, e),
+        }
+    }
+
+    if !dpdk_config.use_flow_director {
+        return Ok(table);
+    }
+
+    for rule in dpdk_config
+        .flow_rules
+        .iter()
+        .filter(|rule| rule.port_id.map_or(true, |p| p == port_id))
+    {
+        if let FlowAction::Queue(q) = rule.action {
+            if q >= dpdk_config.num_rx_queues {
+                return Err(format!(
+                    "Flow rule {:?} targets RX queue {} but port {} has {} queues",
+                    rule.matcher, q, port_id, dpdk_config.num_rx_queues
+                ));
+            }
+        }
+
+        for spec in FlowSpec::from_rule(rule) {
+            table.create(&spec, None)?;
+        }
+
+        println!(
+            "  Port {}: flow {:?} -> {:?}",
+            port_id, rule.matcher, rule.action
+        );
+    }
+
+    if dpdk_config.flow_default_drop {
+        let spec = FlowSpec {
+            drop: 1,
+            priority: DEFAULT_DROP_PRIORITY,
+            ..FlowSpec::default()
+        };
+        table.create(&spec, None)?;
+        println!("  Port {}: default flow -> Drop", port_id);
+    }
+
+    Ok(table)
+}
@@ -96,6 +96,15 @@ pub fn get_hugepages_info() -> io::Result<HugePagesInfo> {
     Ok(info)
 }
 
+/// Свободные hugetlbfs страницы размера `page_size_kb` на узле NUMA
+pub fn node_free_hugepages(node: usize, page_size_kb: u64) -> Option<u64> {
+    let path = format!(
+        "/sys/devices/system/node/node{}/hugepages/hugepages-{}kB/free_hugepages",
+        node, page_size_kb
+    );
+    fs::read_to_string(path).ok()?.trim().parse().ok()
+}
+
 pub fn configure_hugepages(mb_2m_count: u32, mb_1g_count: u32) -> io::Result<()> {
     if mb_2m_count > 0 {
         let output = Command::new("sudo")
@@ -167,6 +176,51 @@ pub fn mount_hugetlbfs(mount_path: &str, page_size: &str) -> io::Result<()> {
     Ok(())
 }
 
+/// Ищет точку монтирования hugetlbfs с указанным размером страницы
+pub fn find_hugetlbfs_mount(page_size_kb: u64) -> Option<String> {
+    let mounts = fs::read_to_string("/proc/mounts").ok()?;
+    let default_kb = get_default_hugepage_size_kb();
+
+    mounts.lines().find_map(|line| {
+        let fields: Vec<&str> = line.split_whitespace().collect();
+        if fields.len() < 4 || fields[2] != "hugetlbfs" {
+            return None;
+        }
+
+        // Без опции pagesize используется системный размер по умолчанию
+        let size_kb = fields[3]
+            .split(',')
+            .find_map(|opt| opt.strip_prefix("pagesize="))
+            .and_then(parse_page_size_kb)
+            .or(default_kb)?;
+
+        (size_kb == page_size_kb).then(|| fields[1].to_string())
+    })
+}
+
+fn parse_page_size_kb(value: &str) -> Option<u64> {
+    let value = value.trim();
+    let (digits, unit) = value.split_at(value.find(|c: char| !c.is_ascii_digit())?);
+    let n: u64 = digits.parse().ok()?;
+
+    match unit.to_ascii_uppercase().as_str() {
+        "K" | "KB" => Some(n),
+        "M" | "MB" => Some(n * 1024),
+        "G" | "GB" => Some(n * 1024 * 1024),
+        _ => None,
+    }
+}
+
+fn get_default_hugepage_size_kb() -> Option<u64> {
+    let meminfo = fs::read_to_string("/proc/meminfo").ok()?;
+
+    meminfo
+        .lines()
+        .find(|line| line.starts_with("Hugepagesize:"))
+        .and_then(|line| line.split_whitespace().nth(1))
+        .and_then(|kb| kb.parse().ok())
+}
+
 pub fn recommend_hugepage_config() -> io::Result<(u32, u32, Vec<String>)> {
     let num_numa_nodes = get_numa_node_count()?;
     let total_memory_mb = get_total_memory_mb()?;
@@ -1,12 +1,16 @@
 // src/dpdk/init.rs
-use std::ffi::{c_void, CString};
+use std::ffi::CString;
 use std::os::raw::{c_char, c_int};
 use std::ptr;
+use std::sync::atomic::{AtomicBool, Ordering};
 
+use crate::control::igmp;
 use crate::dpdk::config::DpdkConfig;
 use crate::dpdk::ffi;
 use crate::dpdk::hugepages;
+use crate::dpdk::mempool;
 use crate::numa::node::NumaNode;
+use crate::packet::timestamp::RxTimestampMode;
 
 /// Структура для представления порта DPDK
 pub struct DpdkPortInfo {
@@ -15,34 +19,108 @@ pub struct DpdkPortInfo {
     pub numa_node: Option<usize>,
 }
 
-/// Инициализирует DPDK EAL для конкретного узла NUMA
-pub fn init_dpdk_for_node(
-    node: &NumaNode,
-    dpdk_config: &DpdkConfig,
-    additional_args: &[String],
-) -> Result<(), String> {
-    if !hugepages::check_hugepages_available() && dpdk_config.use_huge_pages {
-        return Err("Huge pages not available but required by config".to_string());
+/// Признак того, что EAL уже инициализирован в этом процессе
+static EAL_INITIALIZED: AtomicBool = AtomicBool::new(false);
+
+/// Объединенный план запуска EAL для всех узлов NUMA
+///
+/// `rte_eal_init` можно вызвать только один раз за время жизни процесса,
+/// поэтому ядра и hugepage память всех узлов собираются в один набор
+/// аргументов.
+#[derive(Debug, Clone)]
+pub struct EalPlan {
+    /// Управляющее ядро EAL (не используется worker)
+    pub main_lcore: usize,
+    /// Ядра worker всех узлов, по возрастанию
+    pub worker_lcores: Vec<usize>,
+    /// Объем памяти (МБ) по узлам NUMA, индекс - номер узла
+    pub socket_mem: Vec<u32>,
+    /// Дополнительные аргументы EAL
+    pub extra_args: Vec<String>,
+}
+
+impl EalPlan {
+    /// Строит план по списку узлов
+    pub fn from_nodes<'a>(
+        nodes: impl IntoIterator<Item = &'a NumaNode>,
+        dpdk_config: &DpdkConfig,
+    ) -> Self {
+        let mut worker_lcores = Vec::new();
+        let mut socket_mem = Vec::new();
+
+        for node in nodes {
+            worker_lcores.extend(node.local_cpus.iter().map(|core| core.id));
+
+            if socket_mem.len() <= node.node_id {
+                socket_mem.resize(node.node_id + 1, 0);
+            }
+            socket_mem[node.node_id] = node.socket_mem_mb(dpdk_config);
+        }
+
+        let main_lcore = 0;
+        worker_lcores.retain(|&id| id != main_lcore);
+        worker_lcores.sort_unstable();
+        worker_lcores.dedup();
+
+        Self {
+            main_lcore,
+            worker_lcores,
+            socket_mem,
+            extra_args: dpdk_config.eal_args.clone(),
+        }
     }
 
-    let mut eal_args = vec![
-        "hfeec".to_string(), // Имя программы
-    ];
+    /// Формирует аргументы командной строки EAL
+    pub fn to_args(&self, dpdk_config: &DpdkConfig) -> Vec<String> {
+        let mut args = vec![
+            "hfeec".to_string(), // Имя программы
+        ];
+
+        let lcores: Vec<String> = std::iter::once(self.main_lcore)
+            .chain(self.worker_lcores.iter().copied())
+            .map(|id| id.to_string())
+            .collect();
+        args.push(format!("-l{}", lcores.join(",")));
+        args.push(format!("--main-lcore={}", self.main_lcore));
+
+        if dpdk_config.use_huge_pages && !self.socket_mem.is_empty() {
+            let socket_mem: Vec<String> = self.socket_mem.iter().map(|mb| mb.to_string()).collect();
+            args.push(format!("--socket-mem={}", socket_mem.join(",")));
+
+            if let Some(ref dir) = dpdk_config.huge_dir {
+                args.push(format!("--huge-dir={}", dir));
+            } else if dpdk_config.use_1g_hugepages {
+                // Размер страниц EAL выбирается каталогом hugetlbfs, а не пулом
+                match hugepages::find_hugetlbfs_mount(1024 * 1024) {
+                    Some(dir) => args.push(format!("--huge-dir={}", dir)),
+                    None => eprintln!("No 1G hugetlbfs mount found, using default hugepages"),
+                }
+            }
+        }
 
-    let core_mask = node.generate_core_mask();
-    eal_args.push(format!("--lcores={}", core_mask));
+        args.extend(self.extra_args.iter().cloned());
+        args
+    }
+}
 
-    eal_args.push("--master-lcore=0".to_string());
+/// Инициализирует DPDK EAL один раз для всего процесса
+pub fn init_eal(plan: &EalPlan, dpdk_config: &DpdkConfig) -> Result<(), String> {
+    init_eal_with_args(&plan.to_args(dpdk_config), dpdk_config)
+}
 
-    eal_args.extend(node.generate_eal_args(dpdk_config));
+/// Инициализирует EAL готовыми аргументами (например, из сохраненного
+/// плана запуска, см. `crate::plan`)
+pub fn init_eal_with_args(eal_args: &[String], dpdk_config: &DpdkConfig) -> Result<(), String> {
+    if !hugepages::check_hugepages_available() && dpdk_config.use_huge_pages {
+        return Err("Huge pages not available but required by config".to_string());
+    }
 
-    eal_args.extend_from_slice(additional_args);
+    if EAL_INITIALIZED.swap(true, Ordering::SeqCst) {
+        return Err("DPDK EAL already initialized".to_string());
+    }
 
-    println!(
-        "Initializing DPDK for NUMA node {} with arguments:",
-        node.node_id
-    );
-    for arg in &eal_args {
+    println!("Initializing DPDK EAL with arguments:");
+    for arg in eal_args {
         println!("  {}", arg);
     }
 
@@ -57,19 +135,28 @@ pub fn init_dpdk_for_node(
         .collect();
 
     let ret = unsafe { ffi::rte_eal_init(c_args.len() as c_int, c_argv.as_mut_ptr()) };
+
     if ret < 0 {
+        EAL_INITIALIZED.store(false, Ordering::SeqCst);
         return Err(format!("Failed to initialize DPDK EAL: error code {}", ret));
     }
 
     Ok(())
 }
 
+/// Проверяет, инициализирован ли EAL
+pub fn is_eal_initialized() -> bool {
+    EAL_INITIALIZED.load(Ordering::SeqCst)
+}
+
 /// Конфигурирует порт DPDK для конкретного узла NUMA
+///
+/// Возвращает пул mbuf порта для TX сессий.
 pub fn configure_port_for_node(
     node: &NumaNode,
     port_id: u16,
     dpdk_config: &DpdkConfig,
-) -> Result<(), String> {
+) -> Result<*mut ffi::RteMempool, String> {
     let is_valid = unsafe { ffi::rte_eth_dev_is_valid_port(port_id) };
     if is_valid == 0 {
         return Err(format!("Invalid port id: {}", port_id));
@@ -96,38 +183,49 @@ pub fn configure_port_for_node(
 
     println!("Configuring port {} on socket {}", port_id, port_socket_id);
 
-    let mbuf_pool = create_mbuf_pool_for_port(port_id, dpdk_config)?;
-    if mbuf_pool.is_null() {
-        return Err("Failed to create mbuf pool".to_string());
-    }
+    // Каждое ядро узла может брать mbuf из пулов порта, плюс управляющее ядро
+    let lcores = node.local_cpus.len() as u32 + 1;
+    let pools = mempool::create_port_pools(port_id, port_socket_id, dpdk_config, lcores)?;
 
-    let mut eth_conf = default_eth_config();
+    let mut settings = ffi::EthSettings::default();
 
     // Настраиваем Receive Side Scaling (RSS)
     let enable_rss = dpdk_config.use_rss && dpdk_config.num_rx_queues > 1;
     if enable_rss {
-        eth_conf.rxmode.mq_mode = ffi::ETH_MQ_RX_RSS;
-        eth_conf.rx_adv_conf.rss_conf.rss_hf = dpdk_config.rss_hf;
+        settings.rss = 1;
+        settings.rss_hf = dpdk_config.rss_hf;
 
         if let Some(ref key) = dpdk_config.rss_key {
-            eth_conf.rx_adv_conf.rss_conf.rss_key = key.as_ptr() as *mut u8;
-            eth_conf.rx_adv_conf.rss_conf.rss_key_len = key.len() as u8;
+            settings.rss_key = key.as_ptr();
+            settings.rss_key_len = key.len() as u8;
         }
     }
 
     // Настраиваем размер Jumbo фреймов
     if dpdk_config.use_jumbo_frames {
-        eth_conf.rxmode.max_rx_pkt_len = dpdk_config.max_rx_pkt_len;
+        // max_rx_pkt_len включает заголовок Ethernet и VLAN тег (см. with_jumbo_frames)
+        settings.mtu = dpdk_config.max_rx_pkt_len.saturating_sub(18);
         // Для Jumbo фреймов требуется scatter
-        eth_conf.rxmode.offloads |= ffi::DEV_RX_OFFLOAD_SCATTER;
+        settings.scatter = 1;
     }
 
     // Включаем аппаратный подсчет контрольных сумм
     if dpdk_config.use_hw_checksum {
-        eth_conf.rxmode.offloads |= ffi::DEV_RX_OFFLOAD_CHECKSUM;
-        eth_conf.txmode.offloads |= ffi::DEV_TX_OFFLOAD_IPV4_CKSUM
-            | ffi::DEV_TX_OFFLOAD_UDP_CKSUM
-            | ffi::DEV_TX_OFFLOAD_TCP_CKSUM;
+        settings.hw_checksum = 1;
+    }
+
+    // Отправленные mbuf возвращаются в пул без проверки refcnt: каждая TX
+    // очередь принадлежит одной сессии и берет mbuf только из пула порта
+    if dpdk_config.tx_fast_free {
+        let ret = unsafe { ffi::dpdk_tx_fast_free_supported(port_id) };
+        if ret == 0 {
+            settings.tx_fast_free = 1;
+        } else {
+            println!(
+                "TX mbuf fast free unavailable on port {} (error {})",
+                port_id, ret
+            );
+        }
     }
 
     // Настройка TSO
@@ -136,7 +234,7 @@ pub fn configure_port_for_node(
             "Enabling TCP Segmentation Offload (TSO) with MSS: {}",
             dpdk_config.max_tso_segment_size
         );
-        eth_conf.txmode.offloads |= ffi::DEV_TX_OFFLOAD_TCP_TSO | ffi::DEV_TX_OFFLOAD_MULTI_SEGS;
+        settings.tcp_tso = 1;
     }
 
     // Настройка UDP TSO (GSO)
@@ -145,31 +243,53 @@ pub fn configure_port_for_node(
             "Enabling UDP TSO (GSO) with segment size: {}",
             dpdk_config.max_tso_segment_size
         );
-        eth_conf.txmode.offloads |= ffi::DEV_TX_OFFLOAD_UDP_TSO | ffi::DEV_TX_OFFLOAD_MULTI_SEGS;
+        settings.udp_tso = 1;
     }
 
     // Настройка LRO
     if dpdk_config.use_lro {
         println!("Enabling Large Receive Offload (LRO)");
-        eth_conf.rxmode.offloads |= ffi::DEV_RX_OFFLOAD_TCP_LRO;
+        settings.lro = 1;
     }
 
-    // Настройка GRO
+    // GRO выполняется программно, от драйвера нужен только scatter
     if dpdk_config.use_gro {
         println!(
             "Enabling Generic Receive Offload (GRO) with max size: {}",
             dpdk_config.max_gro_size
         );
-        eth_conf.rxmode.offloads |= ffi::DEV_RX_OFFLOAD_TCP_GRO;
-        eth_conf.rxmode.offloads |= ffi::DEV_RX_OFFLOAD_SCATTER;
+        settings.scatter = 1;
+    }
+
+    // Аппаратные метки времени прихода, при отсутствии поддержки - TSC
+    if dpdk_config.rx_timestamps == RxTimestampMode::Hardware {
+        let ret = unsafe { ffi::dpdk_rx_timestamp_enable(port_id) };
+        if ret == 0 {
+            println!("Enabling hardware RX timestamps on port {}", port_id);
+            settings.rx_timestamp = 1;
+        } else {
+            println!(
+                "Hardware RX timestamps unavailable on port {} (error {}), using TSC",
+                port_id, ret
+            );
+        }
+    }
+
+    // RX прерывания нужны очередям со стратегией ожидания Interrupt
+    if dpdk_config.port_needs_rx_interrupts(port_id) {
+        println!("Enabling RX queue interrupts on port {}", port_id);
+        settings.rxq_intr = 1;
     }
 
+    // Служебная пара очередей для IGMP идет после рабочих
+    let ctl_queues = dpdk_config.control_queues();
+
     let ret = unsafe {
-        ffi::rte_eth_dev_configure(
+        ffi::dpdk_eth_dev_configure(
             port_id,
-            dpdk_config.num_rx_queues,
-            dpdk_config.num_tx_queues,
-            &eth_conf as *const ffi::RteEthConf as *const c_void,
+            dpdk_config.num_rx_queues + ctl_queues,
+            dpdk_config.num_tx_queues + ctl_queues,
+            &settings,
         )
     };
 
@@ -180,6 +300,17 @@ pub fn configure_port_for_node(
         ));
     }
 
+    // Сверяем, что fast free действительно принят устройством
+    if settings.tx_fast_free != 0 {
+        match unsafe { ffi::dpdk_tx_fast_free_enabled(port_id) } {
+            1 => println!("TX mbuf fast free enabled on port {}", port_id),
+            ret => eprintln!(
+                "Warning: TX mbuf fast free requested but not active on port {} (result {})",
+                port_id, ret
+            ),
+        }
+    }
+
     // Настройка RX и TX очередей
     for q in 0..dpdk_config.num_rx_queues {
         let queue_socket_id = match dpdk_config.use_numa_on_socket {
@@ -194,7 +325,7 @@ pub fn configure_port_for_node(
                 dpdk_config.rx_ring_size as u16,
                 queue_socket_id,
                 ptr::null(),
-                mbuf_pool,
+                pools.rx[q as usize],
             )
         };
 
@@ -230,6 +361,48 @@ pub fn configure_port_for_node(
         }
     }
 
+    for c in 0..ctl_queues {
+        let queue_socket_id = match dpdk_config.use_numa_on_socket {
+            true => port_socket_id,
+            false => -1,
+        };
+
+        let rx_queue = dpdk_config.num_rx_queues + c;
+        let ret = unsafe {
+            ffi::rte_eth_rx_queue_setup(
+                port_id,
+                rx_queue,
+                dpdk_config.rx_ring_size as u16,
+                queue_socket_id,
+                ptr::null(),
+                pools.tx,
+            )
+        };
+        if ret < 0 {
+            return Err(format!(
+                "Failed to setup control RX queue {}: error code {}",
+                rx_queue, ret
+            ));
+        }
+
+        let tx_queue = dpdk_config.num_tx_queues + c;
+        let ret = unsafe {
+            ffi::rte_eth_tx_queue_setup(
+                port_id,
+                tx_queue,
+                dpdk_config.tx_ring_size as u16,
+                queue_socket_id,
+                ptr::null(),
+            )
+        };
+        if ret < 0 {
+            return Err(format!(
+                "Failed to setup control TX queue {}: error code {}",
+                tx_queue, ret
+            ));
+        }
+    }
+
     let ret = unsafe { ffi::rte_eth_dev_start(port_id) };
     if ret < 0 {
         return Err(format!(
@@ -238,90 +411,45 @@ pub fn configure_port_for_node(
         ));
     }
 
-    if dpdk_config.promiscuous {
-        let ret = unsafe { ffi::rte_eth_promiscuous_enable(port_id) };
+    // Правила rte_flow, оставшиеся от предыдущего запуска процесса; после
+    // этого правила порта создаются и удаляются только через FlowTable
+    unsafe { ffi::dpdk_flow_flush(port_id) };
+
+    // RSS не должен раскладывать данные фида в служебную очередь
+    if ctl_queues > 0 && dpdk_config.use_rss {
+        let ret = unsafe { ffi::dpdk_rss_reta_spread(port_id, dpdk_config.num_rx_queues) };
         if ret < 0 {
             return Err(format!(
-                "Failed to enable promiscuous mode: error code {}",
-                ret
+                "Failed to limit RETA to data queues on port {}: error code {}",
+                port_id, ret
             ));
         }
     }
 
-    Ok(())
-}
+    if dpdk_config.multicast.groups_for(port_id).next().is_some() {
+        let entries = igmp::program_mac_filters(port_id, &dpdk_config.multicast)?;
+        println!("Port {}: {} multicast MAC filter entries", port_id, entries);
+    }
 
-/// Создает memory pool для порта в соответствующей NUMA-узлу памяти
-fn create_mbuf_pool_for_port(
-    port_id: u16,
-    dpdk_config: &DpdkConfig,
-) -> Result<*mut ffi::RteMempool, String> {
-    let port_numa_node = unsafe {
-        let node = ffi::rte_eth_dev_socket_id(port_id);
-        if node >= 0 {
-            Some(node as usize)
-        } else {
-            None
+    if dpdk_config.promiscuous {
+        let ret = unsafe { ffi::rte_eth_promiscuous_enable(port_id) };
+        if ret < 0 {
+            return Err(format!(
+                "Failed to enable promiscuous mode: error code {}",
+                ret
+            ));
         }
-    };
-
-    println!(
-        "Creating memory pool for port {} on NUMA node {:?}",
-        port_id, port_numa_node
-    );
-
-    let pool_name = match port_numa_node {
-        Some(node) => CString::new(format!("mbuf_pool_node{}", node)).unwrap(),
-        None => CString::new("mbuf_pool_default").unwrap(),
-    };
-
-    let socket_id = port_numa_node.map_or(-1, |id| id as c_int);
-
-    let mbuf_pool = unsafe {
-        ffi::rte_pktmbuf_pool_create(
-            pool_name.as_ptr(),
-            dpdk_config.num_mbufs,
-            dpdk_config.mbuf_cache_size,
-            0,
-            dpdk_config.data_room_size,
-            socket_id,
-        )
-    };
-
-    if mbuf_pool.is_null() {
-        Err("Failed to create mbuf pool".to_string())
     } else {
-        Ok(mbuf_pool)
+        let ret = unsafe { ffi::rte_eth_promiscuous_disable(port_id) };
+        if ret < 0 {
+            return Err(format!(
+                "Failed to disable promiscuous mode: error code {}",
+                ret
+            ));
+        }
     }
-}
 
-/// Создает Ethernet конфигурацию по умолчанию
-fn default_eth_config() -> ffi::RteEthConf {
-    ffi::RteEthConf {
-        rxmode: ffi::RteEthRxMode {
-            mq_mode: 0,
-            max_rx_pkt_len: 0,
-            split_hdr_size: 0,
-            offloads: 0,
-        },
-        txmode: ffi::RteEthTxMode {
-            mq_mode: 0,
-            pvid: 0,
-            offloads: 0,
-        },
-        lpbk_mode: 0,
-        rx_adv_conf: ffi::RteEthRxAdvConf {
-            rss_conf: ffi::RteEthRssConf {
-                rss_key: ptr::null_mut(),
-                rss_key_len: 0,
-                rss_hf: 0,
-            },
-        },
-        tx_adv_conf: ffi::RteEthTxAdvConf {},
-        dcb_capability_en: 0,
-        fdir_conf: ffi::RteEthFdirConf {},
-        intr_conf: ffi::RteEthIntrConf {},
-    }
+    Ok(pools.tx)
 }
 
 /// Перечисляет доступные порты DPDK и возвращает информацию о них
@@ -357,7 +485,9 @@ pub fn enumerate_dpdk_ports() -> Vec<DpdkPortInfo> {
 
 /// Завершает работу DPDK и освобождает ресурсы
 pub fn cleanup_dpdk() {
-    unsafe {
-        ffi::rte_eal_cleanup();
+    if EAL_INITIALIZED.load(Ordering::SeqCst) {
+        unsafe {
+            ffi::rte_eal_cleanup();
+        }
     }
 }
@@ -0,0 +1,263 @@
+// src/dpdk/mempool.rs
+use std::ffi::CString;
+use std::os::raw::c_int;
+
+use crate::dpdk::config::DpdkConfig;
+use crate::dpdk::ffi;
+
+/// Максимальный размер per-lcore кеша mempool (RTE_MEMPOOL_CACHE_MAX_SIZE)
+pub const MEMPOOL_CACHE_MAX_SIZE: u32 = 512;
+
+/// Служебные байты на mbuf сверх data room: struct rte_mbuf и заголовок объекта
+const MBUF_OVERHEAD: u64 = 128 + 64;
+
+/// Раскладка пулов mbuf порта
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PoolLayout {
+    /// Один пул на порт для всех RX очередей и TX сессий
+    Shared,
+    /// Отдельный пул на каждую RX очередь и общий TX пул порта:
+    /// всплеск на одной очереди не опустошает пулы соседних
+    PerQueue,
+}
+
+impl Default for PoolLayout {
+    fn default() -> Self {
+        PoolLayout::Shared
+    }
+}
+
+/// Назначение пула
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PoolRole {
+    /// Пул RX очередей и TX сессий порта
+    Shared,
+    /// Пул одной RX очереди
+    Rx(u16),
+    /// Пул TX сессий порта
+    Tx,
+}
+
+/// Параметры одного пула mbuf
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct MbufPoolPlan {
+    pub name: String,
+    pub role: PoolRole,
+    pub socket_id: c_int,
+    pub num_mbufs: u32,
+    pub cache_size: u32,
+    pub data_room_size: u16,
+}
+
+impl MbufPoolPlan {
+    /// Оценка объема памяти пула в байтах
+    pub fn memory_bytes(&self) -> u64 {
+        self.num_mbufs as u64 * (self.data_room_size as u64 + MBUF_OVERHEAD)
+    }
+}
+
+/// Пулы mbuf порта
+#[derive(Debug, Clone)]
+pub struct PortPools {
+    /// Пул для каждой RX очереди (в раскладке Shared все элементы совпадают)
+    pub rx: Vec<*mut ffi::RteMempool>,
+    /// Пул для TX сессий порта
+    pub tx: *mut ffi::RteMempool,
+}
+
+/// Вычисляет количество mbuf, одновременно занятых потребителями пула
+///
+/// Учитываются: mbuf в RX кольцах (`rx_rings` x `rx_ring_size`), в TX
+/// кольцах до завершения отправки (`tx_rings` x `tx_ring_size`), burst,
+/// удерживаемые обработчиком или backlog (`rx_rings` x `burst_size` x
+/// `mbuf_in_flight_bursts`), и per-lcore кеши, которые могут хранить до
+/// 1.5 размера кеша до сброса в общий пул. При включенном захвате
+/// добавляются mbuf, ожидающие записи в кольцах точек захвата
+/// (`rx_rings` x `capture.ring_size`).
+fn required_mbufs(
+    dpdk_config: &DpdkConfig,
+    rx_rings: u32,
+    tx_rings: u32,
+    lcores: u32,
+    cache_size: u32,
+) -> u64 {
+    let rx = rx_rings as u64 * dpdk_config.rx_ring_size as u64;
+    let tx = tx_rings as u64 * dpdk_config.tx_ring_size as u64;
+    let in_flight = rx_rings.max(tx_rings) as u64
+        * dpdk_config.burst_size as u64
+        * dpdk_config.mbuf_in_flight_bursts as u64;
+    let caches = lcores as u64 * (cache_size as u64 * 3 / 2);
+    let captured = if dpdk_config.capture.is_enabled() {
+        rx_rings as u64 * dpdk_config.capture.ring_size as u64
+    } else {
+        0
+    };
+
+    rx + tx + in_flight + caches + captured
+}
+
+/// Округляет до ближайшего 2^n - 1: оптимальный размер кольца mempool
+fn round_pool_size(n: u64) -> u32 {
+    let n = n.max(1).min(u32::MAX as u64);
+    let size = (n + 1).next_power_of_two() - 1;
+    size.min(u32::MAX as u64) as u32
+}
+
+/// Размер кеша: не больше лимита DPDK и не больше n / 1.5
+fn clamp_cache_size(cache_size: u32, num_mbufs: u32) -> u32 {
+    cache_size
+        .min(MEMPOOL_CACHE_MAX_SIZE)
+        .min((num_mbufs as u64 * 2 / 3) as u32)
+}
+
+/// Строит план пулов mbuf для порта
+///
+/// `lcores` - количество ядер, которые берут mbuf из пулов порта и,
+/// следовательно, держат per-lcore кеш. `num_mbufs` из конфигурации
+/// используется как нижняя граница размера каждого пула.
+pub fn plan_port_pools(
+    port_id: u16,
+    socket_id: c_int,
+    dpdk_config: &DpdkConfig,
+    lcores: u32,
+) -> Vec<MbufPoolPlan> {
+    // Служебные очереди (IGMP) берут mbuf из TX пула порта
+    let ctl_queues = dpdk_config.control_queues() as u32;
+    let rx_queues = dpdk_config.num_rx_queues as u32;
+    let tx_queues = dpdk_config.num_tx_queues as u32;
+    let cache_size = dpdk_config.mbuf_cache_size.min(MEMPOOL_CACHE_MAX_SIZE);
+
+    let make = |name: String, role: PoolRole, required: u64| {
+        let num_mbufs = round_pool_size(required.max(dpdk_config.num_mbufs as u64));
+        MbufPoolPlan {
+            name,
+            role,
+            socket_id,
+            num_mbufs,
+            cache_size: clamp_cache_size(cache_size, num_mbufs),
+            data_room_size: dpdk_config.data_room_size,
+        }
+    };
+
+    match dpdk_config.mbuf_pool_layout {
+        PoolLayout::Shared => {
+            let required = required_mbufs(
+                dpdk_config,
+                rx_queues + ctl_queues,
+                tx_queues + ctl_queues,
+                lcores,
+                cache_size,
+            );
+            let socket = match socket_id {
+                id if id >= 0 => format!("s{}", id),
+                _ => "any".to_string(),
+            };
+            vec![make(
+                format!("mbuf_p{}_{}", port_id, socket),
+                PoolRole::Shared,
+                required,
+            )]
+        }
+        PoolLayout::PerQueue => {
+            // RX очередь обслуживает один worker, поэтому ее пул кеширует одно ядро
+            let mut plans: Vec<MbufPoolPlan> = (0..dpdk_config.num_rx_queues)
+                .map(|q| {
+                    let required = required_mbufs(dpdk_config, 1, 0, 1, cache_size);
+                    make(format!("mbuf_p{}_q{}", port_id, q), PoolRole::Rx(q), required)
+                })
+                .collect();
+
+            let required = required_mbufs(
+                dpdk_config,
+                ctl_queues,
+                tx_queues + ctl_queues,
+                lcores,
+                cache_size,
+            );
+            plans.push(make(format!("mbuf_p{}_tx", port_id), PoolRole::Tx, required));
+            plans
+        }
+    }
+}
+
+/// Создает пул mbuf по плану
+pub fn create_pool(plan: &MbufPoolPlan) -> Result<*mut ffi::RteMempool, String> {
+    let name = CString::new(plan.name.as_str())
+        .map_err(|_| format!("Invalid mempool name: {}", plan.name))?;
+
+    println!(
+        "Creating mbuf pool {} on socket {}: {} mbufs, cache {}, ~{} MB",
+        plan.name,
+        plan.socket_id,
+        plan.num_mbufs,
+        plan.cache_size,
+        plan.memory_bytes() >> 20
+    );
+
+    let pool = unsafe {
+        ffi::rte_pktmbuf_pool_create(
+            name.as_ptr(),
+            plan.num_mbufs,
+            plan.cache_size,
+            0,
+            plan.data_room_size,
+            plan.socket_id,
+        )
+    };
+
+    if pool.is_null() {
+        Err(format!(
+            "Failed to create mbuf pool {} ({} mbufs on socket {})",
+            plan.name, plan.num_mbufs, plan.socket_id
+        ))
+    } else {
+        Ok(pool)
+    }
+}
+
+/// Создает все пулы порта и раскладывает их по очередям
+pub fn create_port_pools(
+    port_id: u16,
+    socket_id: c_int,
+    dpdk_config: &DpdkConfig,
+    lcores: u32,
+) -> Result<PortPools, String> {
+    let plans = plan_port_pools(port_id, socket_id, dpdk_config, lcores);
+
+    let total_mb: u64 = plans.iter().map(|plan| plan.memory_bytes()).sum::<u64>() >> 20;
+    println!(
+        "Port {}: {} mbuf pool(s), ~{} MB total",
+        port_id,
+        plans.len(),
+        total_mb
+    );
+
+    let mut rx = vec![std::ptr::null_mut(); dpdk_config.num_rx_queues as usize];
+    let mut tx = std::ptr::null_mut();
+    let mut created = Vec::with_capacity(plans.len());
+
+    for plan in &plans {
+        let pool = match create_pool(plan) {
+            Ok(pool) => pool,
+            Err(e) => {
+                // Пулы, созданные до ошибки, иначе остались бы занятыми до выхода
+                for &pool in &created {
+                    unsafe { ffi::rte_mempool_free(pool) };
+                }
+                return Err(e);
+            }
+        };
+        created.push(pool);
+
+        match plan.role {
+            PoolRole::Shared => {
+                rx.iter_mut().for_each(|slot| *slot = pool);
+                tx = pool;
+            }
+            PoolRole::Rx(q) => rx[q as usize] = pool,
+            PoolRole::Tx => tx = pool,
+        }
+    }
+
+    Ok(PortPools { rx, tx })
+}
@@ -1,4 +1,6 @@
 pub mod config;
 pub mod ffi;
+pub mod flow;
 pub mod hugepages;
 pub mod init;
+pub mod mempool;
@@ -0,0 +1,19 @@
+// src/lib.rs
+//! HFEEC - High Frequency Electronic Exchange Connector
+//!
+//! Модули вынесены в библиотеку, чтобы бинарник и бенчмарки (benches/)
+//! собирались из одного и того же кода горячих путей.
+#![allow(dead_code)]
+pub mod book;
+pub mod capture;
+pub mod control;
+pub mod cpu;
+pub mod dpdk;
+pub mod numa;
+pub mod packet;
+pub mod pipeline;
+pub mod plan;
+pub mod protocols;
+pub mod telemetry;
+pub mod training;
+pub mod tx;
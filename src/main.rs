@@ -1,48 +1,133 @@
-#![allow(dead_code)]
-mod cpu;
-mod dpdk;
-mod numa;
-mod packet;
-mod protocols;
-
-use std::sync::Arc;
 use std::thread;
 use std::time::Duration;
 
-use crate::dpdk::config::default_dpdk_config;
-use crate::numa::manager::NumaManager;
-use crate::packet::data::PacketData;
+use hfeec::dpdk::config::{default_dpdk_config, DpdkConfig};
+use hfeec::numa::arena::{ArenaPageSize, NodeAwareAllocator};
+use hfeec::numa::manager::NumaManager;
+use hfeec::packet::handler::{BurstHandler, PacketBurst};
+use hfeec::plan::{StartupPlan, DEFAULT_PLAN_PATH};
+use hfeec::training::{self, TrainingConfig};
+
+/// Выделения внутри `ArenaScope` идут в арену узла NUMA
+#[global_allocator]
+static ALLOC: NodeAwareAllocator = NodeAwareAllocator;
+
+/// Пример обработчика: периодически выводит образец данных.
+/// Счетчики пакетов ведет worker (см. `NumaManager::print_telemetry`).
+/// В реальном коде здесь была бы обработка пакетов
+#[derive(Clone, Default)]
+struct SampleHandler {
+    packet_count: u64,
+    last_report: u64,
+}
+
+impl BurstHandler for SampleHandler {
+    fn on_burst(&mut self, _queue_id: u16, burst: &mut PacketBurst<'_>) {
+        self.packet_count += burst.len() as u64;
+
+        // Выводим статистику каждые 1 000 000 пакетов
+        if self.packet_count - self.last_report >= 1_000_000 {
+            // Выводим первые несколько байт данных (для отладки)
+            if let Some(packet) = burst.packets().first() {
+                let data = packet.get_data();
+                if data.len() > 16 {
+                    println!("Data sample: {:02X?}", &data[0..16]);
+                }
+            }
+
+            self.last_report = self.packet_count;
+        }
+    }
+}
+
+/// Конфигурация DPDK для `node_count` узлов NUMA
+fn build_dpdk_config(node_count: usize) -> DpdkConfig {
+    default_dpdk_config()
+        // Настраиваем DPDK с учетом количества узлов NUMA
+        .with_numa_allocation(node_count, 1024)
+        // Включаем поддержку Jumbo Frames
+        .with_jumbo_frames(9000)
+        // Арены huge pages узлов для структур горячего пути
+        .with_node_arenas(256, ArenaPageSize::Huge2M)
+}
 
 fn main() {
     println!("Starting HFEEC - High Frequency Electronic Exchange Connector");
 
-    // Создаем менеджер NUMA
-    let mut numa_manager = match NumaManager::new() {
-        Ok(manager) => manager,
-        Err(e) => {
-            eprintln!("Failed to initialize NUMA manager: {}", e);
-            return;
+    // `hfeec train ...` - обучающая нагрузка для PGO/BOLT (см. scripts/pgo.sh)
+    let args: Vec<String> = std::env::args().collect();
+    if args.get(1).map(String::as_str) == Some("train") {
+        let result =
+            TrainingConfig::from_args(&args[2..]).and_then(|config| training::run(&config));
+        if let Err(e) = result {
+            eprintln!("Training workload failed: {}", e);
+            std::process::exit(1);
         }
-    };
-
-    // Инициализируем NUMA-узлы
-    if let Err(e) = numa_manager.init_nodes() {
-        eprintln!("Failed to initialize NUMA nodes: {}", e);
         return;
     }
 
-    // Выводим информацию о топологии
-    numa_manager.print_numa_topology();
+    // `hfeec plan [файл]` - полный запуск с проверкой EAL и портов, после
+    // которого разрешенная конфигурация сохраняется; `hfeec --plan файл` -
+    // запуск по сохраненному плану без обхода sysfs
+    let plan_out = (args.get(1).map(String::as_str) == Some("plan")).then(|| {
+        args.get(2)
+            .cloned()
+            .unwrap_or_else(|| DEFAULT_PLAN_PATH.to_string())
+    });
+    let plan_in = match args.get(1).map(String::as_str) {
+        Some("--plan") => args.get(2).cloned(),
+        _ => None,
+    };
 
-    // Создаем конфигурацию DPDK
-    let mut dpdk_config = default_dpdk_config();
+    let planned = plan_in.and_then(|path| {
+        let result = StartupPlan::load(&path).and_then(|plan| {
+            let dpdk_config = build_dpdk_config(plan.node_count());
+            plan.validate(&dpdk_config)?;
+            Ok((NumaManager::from_plan(&plan), dpdk_config))
+        });
+        match result {
+            Ok(planned) => Some(planned),
+            Err(e) => {
+                eprintln!("Startup plan not used, running discovery: {}", e);
+                None
+            }
+        }
+    });
 
-    // Настраиваем DPDK с учетом количества узлов NUMA
-    let node_count = numa_manager.get_node_count();
-    dpdk_config = dpdk_config.with_numa_allocation(node_count, 1024);
+    let (mut numa_manager, dpdk_config) = match planned {
+        Some(planned) => planned,
+        None => {
+            // Создаем менеджер NUMA
+            let mut numa_manager = match NumaManager::new() {
+                Ok(manager) => manager,
+                Err(e) => {
+                    eprintln!("Failed to initialize NUMA manager: {}", e);
+                    return;
+                }
+            };
 
-    // Включаем поддержку Jumbo Frames
-    dpdk_config = dpdk_config.with_jumbo_frames(9000);
+            // Инициализируем NUMA-узлы (топология выводится здесь же)
+            if let Err(e) = numa_manager.init_nodes() {
+                eprintln!("Failed to initialize NUMA nodes: {}", e);
+                return;
+            }
+
+            let dpdk_config = build_dpdk_config(numa_manager.get_node_count());
+            (numa_manager, dpdk_config)
+        }
+    };
+
+    // Инициализируем DPDK EAL один раз для всех узлов
+    if let Err(e) = numa_manager.init_eal(&dpdk_config) {
+        eprintln!("Failed to initialize DPDK EAL: {}", e);
+        return;
+    }
+
+    // Арены huge pages узлов для структур горячего пути; после EAL, чтобы
+    // они не забрали страницы, рассчитанные на --socket-mem
+    if let Err(e) = numa_manager.init_node_arenas(&dpdk_config.arena) {
+        eprintln!("Warning: NUMA node arenas unavailable: {}", e);
+    }
 
     // Распределяем интерфейсы по узлам NUMA
     if let Err(e) = numa_manager.distribute_interfaces(&dpdk_config) {
@@ -50,34 +135,31 @@ fn main() {
         return;
     }
 
-    // Инициализируем DPDK для всех узлов
+    // Конфигурируем порты DPDK на всех узлах
     if let Err(e) = numa_manager.init_dpdk(&dpdk_config) {
         eprintln!("Failed to initialize DPDK: {}", e);
         return;
     }
 
-    // Создаем обработчик пакетов
-    let packet_handler = Arc::new(|_queue_id: u16, packet: &PacketData| {
-        // В реальном коде здесь была бы обработка пакетов
-        // Для примера просто считаем количество пакетов
-        static mut PACKET_COUNT: u64 = 0;
-        static mut LAST_REPORT: u64 = 0;
-
-        unsafe {
-            PACKET_COUNT += 1;
-
-            // Выводим статистику каждые 1 000 000 пакетов
-            if PACKET_COUNT - LAST_REPORT >= 1_000_000 {
-                // Выводим первые несколько байт данных (для отладки)
-                let data = packet.get_data();
-                if data.len() > 16 {
-                    println!("Data sample: {:02X?}", &data[0..16]);
-                }
-
-                LAST_REPORT = PACKET_COUNT;
+    if let Some(path) = plan_out {
+        match numa_manager.startup_plan(&dpdk_config).save(&path) {
+            Ok(()) => println!("Startup plan written to {}", path),
+            Err(e) => {
+                eprintln!("{}", e);
+                std::process::exit(1);
             }
         }
-    });
+        return;
+    }
+
+    // Подписываемся на мультикаст-группы фидов, если они заданы
+    if let Err(e) = numa_manager.start_igmp(&dpdk_config) {
+        eprintln!("Failed to start IGMP agent: {}", e);
+        return;
+    }
+
+    // Создаем обработчик пакетов
+    let packet_handler = SampleHandler::default();
 
     if let Err(e) = numa_manager.start_packet_processing(packet_handler, &dpdk_config) {
         eprintln!("Failed to start packet processing: {}", e);
@@ -87,7 +169,8 @@ fn main() {
     println!("Packet processing started. Press Ctrl+C to stop.");
 
     loop {
-        thread::sleep(Duration::from_secs(1));
+        thread::sleep(Duration::from_secs(10));
+        numa_manager.print_telemetry();
     }
 
     // numa_manager.stop_packet_processing();
@@ -5,10 +5,197 @@
 #include <rte_tcp.h>
 #include <rte_udp.h>
 #include <rte_ether.h>
+#include <rte_prefetch.h>
+#include <rte_memcpy.h>
+#include <rte_interrupts.h>
+#include <rte_mbuf_dyn.h>
+#include <rte_cycles.h>
+#include <rte_flow.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <arpa/inet.h>
+#include <errno.h>
+
+/* На сколько пакетов вперед выполняется предзагрузка заголовков в burst-цикле */
+#define DPDK_PREFETCH_AHEAD 4
+
+/* Максимальный размер burst, должен совпадать с MAX_BURST_SIZE в src/dpdk/config.rs */
+#define DPDK_MAX_BURST 64
+
+/* Количество слотов кодов ошибок разбора, должно совпадать с PARSE_ERR_SLOTS в src/telemetry/worker.rs */
+#define DPDK_PARSE_ERR_SLOTS 8
+
+/**
+ * Дескриптор разобранного пакета.
+ *
+ * Раскладка полей должна совпадать с `PacketData` в src/packet/data.rs:
+ * Rust передает массив своих структур напрямую в dpdk_parse_burst.
+ * Размер - ровно одна кеш-линия.
+ */
+struct dpdk_packet_desc {
+    const uint8_t *data;
+    size_t data_len;
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint16_t queue_id;
+    int16_t status;
+    const uint8_t *src_ip;
+    const uint8_t *dst_ip;
+    uint32_t src_ip_len;
+    uint32_t dst_ip_len;
+    uint64_t rx_timestamp;
+    struct rte_mbuf *mbuf;
+} __rte_cache_aligned;
+
+/* Код успешного разбора пакета, payload которого продолжается в следующих сегментах mbuf */
+#define DPDK_PARSE_SEGMENTED 1
+
+/* Максимальное число VLAN тегов перед L3 заголовком (QinQ) */
+#define DPDK_MAX_VLAN_TAGS 2
+
+/**
+ * Проверяет, является ли ether_type (в сетевом порядке байтов) VLAN тегом:
+ * 802.1Q, 802.1ad (QinQ) или устаревший 0x9100
+ */
+static inline uint32_t dpdk_is_vlan(uint16_t ether_type_be)
+{
+    return (ether_type_be == rte_cpu_to_be_16(RTE_ETHER_TYPE_VLAN)) |
+           (ether_type_be == rte_cpu_to_be_16(RTE_ETHER_TYPE_QINQ)) |
+           (ether_type_be == rte_cpu_to_be_16(RTE_ETHER_TYPE_QINQ1));
+}
+
+/**
+ * Пропускает до DPDK_MAX_VLAN_TAGS VLAN тегов без ветвлений
+ *
+ * Чтение следующего ether_type выполняется безусловно: для кадра без тегов
+ * это байты IP заголовка, которые отбрасываются условной пересылкой.
+ *
+ * @param eth_hdr Заголовок Ethernet
+ * @param ether_type_out ether_type L3 заголовка в сетевом порядке байтов
+ * @return Длина L2 заголовка вместе с тегами
+ */
+static inline uint32_t dpdk_l2_len(const struct rte_ether_hdr *eth_hdr, uint16_t *ether_type_out)
+{
+    const uint8_t *l2 = (const uint8_t *)eth_hdr;
+    uint16_t ether_type = eth_hdr->ether_type;
+    uint32_t l2_len = sizeof(struct rte_ether_hdr);
+    int tag;
+
+    for (tag = 0; tag < DPDK_MAX_VLAN_TAGS; tag++) {
+        uint32_t tagged = dpdk_is_vlan(ether_type);
+        uint16_t inner = ((const struct rte_vlan_hdr *)(l2 + l2_len))->eth_proto;
+
+        ether_type = tagged ? inner : ether_type;
+        l2_len += tagged * sizeof(struct rte_vlan_hdr);
+    }
+
+    *ether_type_out = ether_type;
+    return l2_len;
+}
+
+/**
+ * Разбирает заголовки одного пакета и заполняет дескриптор
+ *
+ * Коды возврата совпадают с dpdk_extract_packet_data:
+ * -2 не IPv4, -3 не TCP/UDP, -4 некорректная длина или пустой payload,
+ * -5 IPv4 фрагмент. DPDK_PARSE_SEGMENTED - успех, но payload не умещается
+ * в первом сегменте mbuf: data/data_len описывают только его часть в первом
+ * сегменте, остаток доступен через dpdk_packet_next_segment.
+ * При ошибке data/data_len обнулены, остальные поля не определены.
+ *
+ * Тип пакета (ptype), распознанный NIC, позволяет отбросить не-IPv4 трафик
+ * и фрагменты, не читая данные пакета. Для кадра без тегов проверка VLAN
+ * сводится к одному сравнению ether_type.
+ */
+static inline int dpdk_parse_packet(struct rte_mbuf *pkt, struct dpdk_packet_desc *desc)
+{
+    struct rte_ether_hdr *eth_hdr = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
+    uint32_t ptype = pkt->packet_type;
+    uint32_t seg_len = rte_pktmbuf_data_len(pkt);
+    uint32_t l2_len = sizeof(struct rte_ether_hdr);
+    uint16_t ether_type = eth_hdr->ether_type;
+
+    desc->mbuf = pkt;
+    desc->data = NULL;
+    desc->data_len = 0;
+
+    /* ptype 0 - драйвер не распознает типы, решение принимается по заголовкам */
+    if (unlikely((ptype & RTE_PTYPE_L3_MASK) && !RTE_ETH_IS_IPV4_HDR(ptype))) {
+        return -2;
+    }
+    if (unlikely((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_FRAG)) {
+        return -5;
+    }
+
+    if (unlikely(ether_type != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4))) {
+        l2_len = dpdk_l2_len(eth_hdr, &ether_type);
+        if (ether_type != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4)) {
+            return -2;
+        }
+    }
+
+    struct rte_ipv4_hdr *ip_hdr = (struct rte_ipv4_hdr *)((uint8_t *)eth_hdr + l2_len);
+    uint16_t ip_hdr_len = (ip_hdr->version_ihl & 0x0f) * 4;
+    uint8_t *l4_hdr = (uint8_t *)ip_hdr + ip_hdr_len;
+    uint16_t payload_offset;
+
+    if (unlikely(ip_hdr_len < sizeof(struct rte_ipv4_hdr) ||
+                 l2_len + ip_hdr_len + sizeof(struct rte_udp_hdr) > seg_len)) {
+        return -4;
+    }
+
+    /* Фрагменты без распознанного ptype: MF или ненулевое смещение */
+    if (unlikely(ip_hdr->fragment_offset &
+                 rte_cpu_to_be_16(RTE_IPV4_HDR_MF_FLAG | RTE_IPV4_HDR_OFFSET_MASK))) {
+        return -5;
+    }
+
+    if (ip_hdr->next_proto_id == IPPROTO_UDP) {
+        struct rte_udp_hdr *udp_hdr = (struct rte_udp_hdr *)l4_hdr;
+
+        desc->src_port = rte_be_to_cpu_16(udp_hdr->src_port);
+        desc->dst_port = rte_be_to_cpu_16(udp_hdr->dst_port);
+        payload_offset = ip_hdr_len + sizeof(struct rte_udp_hdr);
+    } else if (ip_hdr->next_proto_id == IPPROTO_TCP) {
+        struct rte_tcp_hdr *tcp_hdr = (struct rte_tcp_hdr *)l4_hdr;
+
+        if (unlikely(l2_len + ip_hdr_len + sizeof(struct rte_tcp_hdr) > seg_len)) {
+            return -4;
+        }
+
+        desc->src_port = rte_be_to_cpu_16(tcp_hdr->src_port);
+        desc->dst_port = rte_be_to_cpu_16(tcp_hdr->dst_port);
+        payload_offset = ip_hdr_len + ((tcp_hdr->data_off & 0xf0) >> 4) * 4;
+    } else {
+        return -3;
+    }
+
+    desc->src_ip = (const uint8_t *)&ip_hdr->src_addr;
+    desc->src_ip_len = sizeof(ip_hdr->src_addr);
+    desc->dst_ip = (const uint8_t *)&ip_hdr->dst_addr;
+    desc->dst_ip_len = sizeof(ip_hdr->dst_addr);
+
+    uint32_t ip_total_length = rte_be_to_cpu_16(ip_hdr->total_length);
+    uint32_t payload_start = l2_len + payload_offset;
+
+    /* total_length не может выходить за пределы принятого кадра */
+    if (unlikely(ip_total_length <= payload_offset ||
+                 l2_len + ip_total_length > pkt->pkt_len ||
+                 payload_start > seg_len)) {
+        return -4;
+    }
+
+    desc->data = (const uint8_t *)ip_hdr + payload_offset;
+
+    if (likely(l2_len + ip_total_length <= seg_len)) {
+        desc->data_len = ip_total_length - payload_offset;
+        return 0;
+    }
+
+    /* Scatter: в дескрипторе только часть payload из первого сегмента */
+    desc->data_len = seg_len - payload_start;
+    return DPDK_PARSE_SEGMENTED;
+}
 
 /**
  * Извлекает информацию и данные из пакета DPDK для передачи в Rust
@@ -19,8 +206,9 @@
  * @param src_port_out Указатель на переменную для записи порта источника
  * @param dst_port_out Указатель на переменную для записи порта назначения
  * @param data_out Указатель на переменную для указателя на данные пакета
- * @param data_len_out Указатель на переменную для длины данных
- * @return 0 в случае успеха, ненулевое значение в случае ошибки
+ * @param data_len_out Указатель на переменную для длины данных (в первом сегменте)
+ * @return 0 в случае успеха, DPDK_PARSE_SEGMENTED если payload продолжается
+ *         в следующих сегментах, отрицательное значение в случае ошибки
  */
 int dpdk_extract_packet_data(
     const struct rte_mbuf *pkt,
@@ -37,221 +225,1251 @@ int dpdk_extract_packet_data(
         !src_port_out || !dst_port_out || !data_out || !data_len_out) {
         return -1;
     }
-    
-    *src_port_out = 0;
-    *dst_port_out = 0;
-    *data_out = NULL;
-    *data_len_out = 0;
-    *src_ip_out = NULL;
-    *src_ip_len_out = 0;
-    *dst_ip_out = NULL;
-    *dst_ip_len_out = 0;
-    
-    struct rte_ether_hdr *eth_hdr = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
-    
-    if (rte_be_to_cpu_16(eth_hdr->ether_type) != RTE_ETHER_TYPE_IPV4) {
-        return -2;
+
+    struct dpdk_packet_desc desc = { 0 };
+    int ret = dpdk_parse_packet((struct rte_mbuf *)pkt, &desc);
+
+    *src_port_out = desc.src_port;
+    *dst_port_out = desc.dst_port;
+    *data_out = (uint8_t *)desc.data;
+    *data_len_out = (uint32_t)desc.data_len;
+    *src_ip_out = (uint8_t *)desc.src_ip;
+    *src_ip_len_out = desc.src_ip_len;
+    *dst_ip_out = (uint8_t *)desc.dst_ip;
+    *dst_ip_len_out = desc.dst_ip_len;
+
+    return ret;
+}
+
+/**
+ * Возвращает полную длину payload пакета по дескриптору
+ *
+ * Для многосегментного пакета (status DPDK_PARSE_SEGMENTED) длина больше
+ * desc->data_len; берется из total_length IP заголовка, на который
+ * указывает desc->src_ip.
+ */
+uint32_t dpdk_packet_payload_len(const struct dpdk_packet_desc *desc)
+{
+    if (likely(desc->status != DPDK_PARSE_SEGMENTED)) {
+        return (uint32_t)desc->data_len;
     }
-    
-    struct rte_ipv4_hdr *ip_hdr = (struct rte_ipv4_hdr *)(eth_hdr + 1);
-    
-    *src_ip_out = (uint8_t *)&ip_hdr->src_addr;
-    *src_ip_len_out = sizeof(ip_hdr->src_addr);
-    *dst_ip_out = (uint8_t *)&ip_hdr->dst_addr;
-    *dst_ip_len_out = sizeof(ip_hdr->dst_addr);
-    
-    uint16_t payload_offset = 0;
-    
-    if (ip_hdr->next_proto_id == IPPROTO_TCP) {
-        struct rte_tcp_hdr *tcp_hdr = (struct rte_tcp_hdr *)((uint8_t *)ip_hdr + 
-                                    (ip_hdr->version_ihl & 0x0f) * 4);
-        
-        *src_port_out = rte_be_to_cpu_16(tcp_hdr->src_port);
-        *dst_port_out = rte_be_to_cpu_16(tcp_hdr->dst_port);
-        
-        uint8_t tcp_header_size = ((tcp_hdr->data_off & 0xf0) >> 4) * 4;
-        payload_offset = ((ip_hdr->version_ihl & 0x0f) * 4) + tcp_header_size;
-    } 
-    else if (ip_hdr->next_proto_id == IPPROTO_UDP) {
-        struct rte_udp_hdr *udp_hdr = (struct rte_udp_hdr *)((uint8_t *)ip_hdr + 
-                                    (ip_hdr->version_ihl & 0x0f) * 4);
-        
-        *src_port_out = rte_be_to_cpu_16(udp_hdr->src_port);
-        *dst_port_out = rte_be_to_cpu_16(udp_hdr->dst_port);
-        
-        payload_offset = ((ip_hdr->version_ihl & 0x0f) * 4) + 8;
-    }
-    else {
-        return -3;
+
+    const struct rte_ipv4_hdr *ip_hdr = (const struct rte_ipv4_hdr *)
+        (desc->src_ip - offsetof(struct rte_ipv4_hdr, src_addr));
+
+    return rte_be_to_cpu_16(ip_hdr->total_length) - (uint32_t)(desc->data - (const uint8_t *)ip_hdr);
+}
+
+/**
+ * Переходит к следующему сегменту цепочки mbuf
+ *
+ * @param seg Текущий сегмент
+ * @param data_out Начало данных следующего сегмента
+ * @param len_out Длина данных следующего сегмента
+ * @return Следующий сегмент или NULL, если сегментов больше нет
+ */
+const struct rte_mbuf *dpdk_packet_next_segment(
+    const struct rte_mbuf *seg,
+    const uint8_t **data_out,
+    uint32_t *len_out
+) {
+    const struct rte_mbuf *next = seg->next;
+
+    if (next) {
+        *data_out = rte_pktmbuf_mtod(next, const uint8_t *);
+        *len_out = rte_pktmbuf_data_len(next);
     }
-    
-    uint16_t ip_total_length = rte_be_to_cpu_16(ip_hdr->total_length);
-    uint32_t payload_length = 0;
-    
-    if (ip_total_length > payload_offset) {
-        payload_length = ip_total_length - payload_offset;
+
+    return next;
+}
+
+/**
+ * Возвращает непрерывное представление payload пакета
+ *
+ * Если payload целиком лежит в первом сегменте, возвращается указатель
+ * на него без копирования, иначе payload копируется в buf.
+ *
+ * @param desc Дескриптор разобранного пакета
+ * @param buf Буфер для копии многосегментного payload
+ * @param buf_len Размер буфера
+ * @return Указатель на payload длиной dpdk_packet_payload_len(desc) или NULL,
+ *         если буфер мал
+ */
+const uint8_t *dpdk_packet_linearize(
+    const struct dpdk_packet_desc *desc,
+    uint8_t *buf,
+    uint32_t buf_len
+) {
+    if (likely(desc->status != DPDK_PARSE_SEGMENTED)) {
+        return desc->data;
     }
-    else {
-        return -4;
+
+    uint32_t len = dpdk_packet_payload_len(desc);
+    uint32_t offset = (uint32_t)(desc->data - rte_pktmbuf_mtod(desc->mbuf, const uint8_t *));
+
+    if (len > buf_len) {
+        return NULL;
+    }
+
+    return rte_pktmbuf_read(desc->mbuf, offset, len, buf);
+}
+
+/* Смещение и флаг динамического поля RX timestamp, -1/0 пока поле не зарегистрировано */
+static int dpdk_rx_ts_offset = -1;
+static uint64_t dpdk_rx_ts_flag;
+
+/* Порты, для которых включен RTE_ETH_RX_OFFLOAD_TIMESTAMP */
+static uint8_t dpdk_rx_ts_ports[RTE_MAX_ETHPORTS];
+
+/**
+ * Подготавливает порт к аппаратным RX timestamp
+ *
+ * Проверяет, что драйвер поддерживает RTE_ETH_RX_OFFLOAD_TIMESTAMP, и
+ * регистрирует динамическое поле mbuf. Вызывается до rte_eth_dev_configure,
+ * offload в конфигурацию порта добавляет вызывающий код.
+ *
+ * @param port_id Идентификатор порта
+ * @return 0 в случае успеха, -ENOTSUP если драйвер не поддерживает
+ *         timestamp, другой отрицательный код ошибки DPDK иначе
+ */
+int dpdk_rx_timestamp_enable(uint16_t port_id)
+{
+    struct rte_eth_dev_info dev_info;
+    int ret;
+
+    if (port_id >= RTE_MAX_ETHPORTS) {
+        return -EINVAL;
+    }
+
+    ret = rte_eth_dev_info_get(port_id, &dev_info);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (!(dev_info.rx_offload_capa & RTE_ETH_RX_OFFLOAD_TIMESTAMP)) {
+        return -ENOTSUP;
+    }
+
+    if (dpdk_rx_ts_offset < 0) {
+        ret = rte_mbuf_dyn_rx_timestamp_register(&dpdk_rx_ts_offset, &dpdk_rx_ts_flag);
+        if (ret != 0) {
+            dpdk_rx_ts_offset = -1;
+            return ret;
+        }
+    }
+
+    dpdk_rx_ts_ports[port_id] = 1;
+    return 0;
+}
+
+/**
+ * Проверяет, включены ли аппаратные RX timestamp на порту
+ *
+ * @return 1 если включены, 0 иначе
+ */
+int dpdk_rx_timestamp_active(uint16_t port_id)
+{
+    return port_id < RTE_MAX_ETHPORTS && dpdk_rx_ts_ports[port_id];
+}
+
+/**
+ * Часы RX для проставления timestamp в дескрипторы.
+ *
+ * Раскладка должна совпадать с `RxClock` в src/packet/timestamp.rs.
+ * При hw != 0 timestamp NIC переводится в домен TSC по последней паре
+ * (nic_ref, tsc_ref) и наклону tsc_per_tick, которые обновляет worker.
+ * Пакеты без аппаратной метки получают burst_tsc - время возврата
+ * rte_eth_rx_burst.
+ */
+struct dpdk_rx_clock {
+    uint64_t burst_tsc;
+    uint64_t nic_ref;
+    uint64_t tsc_ref;
+    double tsc_per_tick;
+    int32_t hw;
+    int32_t _reserved;
+};
+
+/**
+ * Возвращает время прихода пакета в тактах TSC
+ */
+static inline uint64_t dpdk_rx_stamp(const struct rte_mbuf *pkt, const struct dpdk_rx_clock *clock)
+{
+    if (clock->hw && (pkt->ol_flags & dpdk_rx_ts_flag)) {
+        rte_mbuf_timestamp_t ts = *RTE_MBUF_DYNFIELD(pkt, dpdk_rx_ts_offset, rte_mbuf_timestamp_t *);
+        int64_t delta = (int64_t)(ts - clock->nic_ref);
+
+        return clock->tsc_ref + (uint64_t)(int64_t)((double)delta * clock->tsc_per_tick);
+    }
+
+    return clock->burst_tsc;
+}
+
+/**
+ * Итоги разбора одного burst для телеметрии worker.
+ *
+ * Раскладка должна совпадать с `BurstStats` в src/telemetry/worker.rs.
+ * errors[n] - количество пакетов с кодом возврата -n из dpdk_parse_packet.
+ */
+struct dpdk_burst_stats {
+    uint64_t bytes;
+    uint16_t nb_errors;
+    uint16_t errors[DPDK_PARSE_ERR_SLOTS];
+};
+
+/**
+ * Разбирает весь burst, полученный из rte_eth_rx_burst, за один вызов
+ *
+ * Успешно разобранные пакеты записываются подряд в descs[0..ret), а массив
+ * pkts переупорядочивается так, что pkts[i] соответствует descs[i];
+ * пакеты с ошибкой разбора оказываются в pkts[ret..nb_pkts). Порядок
+ * успешных пакетов сохраняется (в т.ч. многосегментных, status
+ * DPDK_PARSE_SEGMENTED). Заголовки следующих пакетов предзагружаются в кеш
+ * по ходу цикла.
+ *
+ * @param pkts Массив пакетов из rte_eth_rx_burst
+ * @param nb_pkts Количество пакетов в массиве
+ * @param queue_id Номер RX очереди, записывается в каждый дескриптор
+ * @param descs Массив дескрипторов размером не менее nb_pkts
+ * @param clock Часы RX для rx_timestamp дескрипторов, NULL - не проставлять
+ * @param stats Счетчики байтов и ошибок разбора, накапливаются (не обнуляются)
+ * @return Количество успешно разобранных пакетов
+ */
+uint16_t dpdk_parse_burst(
+    struct rte_mbuf **pkts,
+    uint16_t nb_pkts,
+    uint16_t queue_id,
+    struct dpdk_packet_desc *descs,
+    const struct dpdk_rx_clock *clock,
+    struct dpdk_burst_stats *stats
+) {
+    uint16_t nb_ok = 0;
+    uint16_t i;
+
+    for (i = 0; i < nb_pkts && i < DPDK_PREFETCH_AHEAD; i++) {
+        rte_prefetch0(rte_pktmbuf_mtod(pkts[i], void *));
+    }
+
+    for (i = 0; i < nb_pkts; i++) {
+        if (i + DPDK_PREFETCH_AHEAD < nb_pkts) {
+            rte_prefetch0(rte_pktmbuf_mtod(pkts[i + DPDK_PREFETCH_AHEAD], void *));
+        }
+
+        struct rte_mbuf *pkt = pkts[i];
+        struct dpdk_packet_desc *desc = &descs[nb_ok];
+        int ret = dpdk_parse_packet(pkt, desc);
+
+        desc->queue_id = queue_id;
+        desc->status = (int16_t)ret;
+        stats->bytes += pkt->pkt_len;
+
+        if (likely(ret >= 0)) {
+            desc->rx_timestamp = clock ? dpdk_rx_stamp(pkt, clock) : 0;
+            pkts[i] = pkts[nb_ok];
+            pkts[nb_ok] = pkt;
+            nb_ok++;
+        } else {
+            /* Дескриптор будет перезаписан следующим пакетом, код сохраняется в stats */
+            stats->nb_errors++;
+            stats->errors[(-ret) & (DPDK_PARSE_ERR_SLOTS - 1)]++;
+        }
+    }
+
+    return nb_ok;
+}
+
+/**
+ * Поля заголовков burst в формате "структура массивов" (по одной линии на пакет).
+ *
+ * Раскладка должна совпадать с `HeaderLanes` в src/packet/classify.rs.
+ * Все значения в порядке байтов хоста, расширены до 32 бит, чтобы
+ * классификатор мог сравнивать 8 (AVX2) или 16 (AVX-512) пакетов за раз.
+ * ether_type и l2_len относятся к L3 заголовку после VLAN тегов.
+ */
+struct dpdk_header_lanes {
+    uint32_t ether_type[DPDK_MAX_BURST];
+    uint32_t l2_len[DPDK_MAX_BURST];
+    uint32_t ip_proto[DPDK_MAX_BURST];
+    uint32_t ihl[DPDK_MAX_BURST];
+    uint32_t dst_ip[DPDK_MAX_BURST];
+    uint32_t dst_port[DPDK_MAX_BURST];
+} __rte_cache_aligned;
+
+/**
+ * Собирает поля заголовков burst в dpdk_header_lanes без ветвлений
+ *
+ * Поля L3/L4 читаются безусловно: для не-IPv4 пакетов они содержат мусор
+ * из буфера mbuf, который классификатор отбрасывает по ether_type.
+ * VLAN теги пропускаются условной пересылкой (dpdk_l2_len). У IPv4
+ * фрагментов ip_proto обнуляется, и классификатор их отбрасывает: у
+ * последующих фрагментов нет L4 заголовка.
+ *
+ * @param pkts Массив пакетов из rte_eth_rx_burst
+ * @param nb_pkts Количество пакетов (не более DPDK_MAX_BURST)
+ * @param lanes Структура для записи полей заголовков
+ * @return Количество обработанных пакетов
+ */
+uint16_t dpdk_gather_headers(
+    struct rte_mbuf **pkts,
+    uint16_t nb_pkts,
+    struct dpdk_header_lanes *lanes
+) {
+    uint16_t i;
+
+    if (nb_pkts > DPDK_MAX_BURST) {
+        nb_pkts = DPDK_MAX_BURST;
+    }
+
+    for (i = 0; i < nb_pkts && i < DPDK_PREFETCH_AHEAD; i++) {
+        rte_prefetch0(rte_pktmbuf_mtod(pkts[i], void *));
+    }
+
+    for (i = 0; i < nb_pkts; i++) {
+        if (i + DPDK_PREFETCH_AHEAD < nb_pkts) {
+            rte_prefetch0(rte_pktmbuf_mtod(pkts[i + DPDK_PREFETCH_AHEAD], void *));
+        }
+
+        const struct rte_ether_hdr *eth_hdr =
+            rte_pktmbuf_mtod(pkts[i], const struct rte_ether_hdr *);
+        uint16_t ether_type;
+        uint32_t l2_len = dpdk_l2_len(eth_hdr, &ether_type);
+        const struct rte_ipv4_hdr *ip_hdr =
+            (const struct rte_ipv4_hdr *)((const uint8_t *)eth_hdr + l2_len);
+        uint32_t ihl = ip_hdr->version_ihl & 0x0f;
+        const struct rte_tcp_hdr *tcp_hdr =
+            (const struct rte_tcp_hdr *)((const uint8_t *)ip_hdr + ihl * 4);
+        uint32_t is_frag = (ip_hdr->fragment_offset &
+            rte_cpu_to_be_16(RTE_IPV4_HDR_MF_FLAG | RTE_IPV4_HDR_OFFSET_MASK)) != 0;
+
+        lanes->ether_type[i] = rte_be_to_cpu_16(ether_type);
+        lanes->l2_len[i] = l2_len;
+        lanes->ip_proto[i] = is_frag ? 0 : ip_hdr->next_proto_id;
+        lanes->ihl[i] = ihl;
+        lanes->dst_ip[i] = rte_be_to_cpu_32(ip_hdr->dst_addr);
+        lanes->dst_port[i] = rte_be_to_cpu_16(tcp_hdr->dst_port);
+    }
+
+    return nb_pkts;
+}
+
+/**
+ * Запись пакета для потока захвата.
+ *
+ * Раскладка должна совпадать с `CaptureRecord` в src/capture/tap.rs.
+ */
+struct dpdk_capture_record {
+    struct rte_mbuf *mbuf;
+    uint64_t rx_tsc;
+    uint16_t port_id;
+    uint16_t queue_id;
+    uint32_t pkt_len;
+};
+
+/**
+ * Передает пакеты burst потоку захвата без копирования
+ *
+ * Увеличивает счетчик ссылок всех сегментов каждого mbuf: после
+ * rte_pktmbuf_free в worker данные остаются живыми, пока поток захвата не
+ * освободит свою ссылку. Время прихода берется так же, как в
+ * dpdk_parse_burst (аппаратная метка или burst_tsc).
+ *
+ * @param pkts Массив пакетов из rte_eth_rx_burst
+ * @param nb_pkts Количество пакетов
+ * @param port_id Порт, с которого получен burst
+ * @param queue_id RX очередь, с которой получен burst
+ * @param clock Часы RX, NULL - один rte_rdtsc на весь burst
+ * @param records Массив записей размером не менее nb_pkts
+ */
+void dpdk_capture_burst(
+    struct rte_mbuf **pkts,
+    uint16_t nb_pkts,
+    uint16_t port_id,
+    uint16_t queue_id,
+    const struct dpdk_rx_clock *clock,
+    struct dpdk_capture_record *records
+) {
+    uint64_t now = clock ? clock->burst_tsc : rte_rdtsc();
+    uint16_t i;
+
+    for (i = 0; i < nb_pkts; i++) {
+        struct rte_mbuf *pkt = pkts[i];
+        struct dpdk_capture_record *rec = &records[i];
+
+        rte_pktmbuf_refcnt_update(pkt, 1);
+        rec->mbuf = pkt;
+        rec->rx_tsc = clock ? dpdk_rx_stamp(pkt, clock) : now;
+        rec->port_id = port_id;
+        rec->queue_id = queue_id;
+        rec->pkt_len = pkt->pkt_len;
     }
-    
-    if (payload_length > 0) {
-        uint8_t *payload = (uint8_t *)ip_hdr + payload_offset;
-        
-        *data_out = payload;
-        *data_len_out = payload_length;
-        
+}
+
+/**
+ * Копирует начало пакета (все сегменты) в буфер записи захвата
+ *
+ * @param m Пакет
+ * @param dst Буфер размером не менее len
+ * @param len Сколько байт копировать, не больше pkt_len
+ * @return Количество скопированных байт, 0 - len больше длины пакета
+ */
+uint32_t dpdk_capture_copy(const struct rte_mbuf *m, uint8_t *dst, uint32_t len)
+{
+    const void *src = rte_pktmbuf_read(m, 0, len, dst);
+
+    if (src == NULL) {
         return 0;
     }
-    
-    return -5;
+    if (src != dst) {
+        rte_memcpy(dst, src, len);
+    }
+
+    return len;
 }
 
 /**
- * Создает новый пакет DPDK и заполняет его данными для отправки
- * 
- * @param mbuf_pool Пул памяти для создания пакета
- * @param src_ip IP-адрес источника
- * @param dst_ip IP-адрес назначения
+ * Собирает burst из записанных пакетов для режима воспроизведения
+ *
+ * Выделяет nb_pkts mbuf одним вызовом и копирует в каждый данные пакета;
+ * пакеты длиннее tailroom обрезаются. Поля mbuf заполняются как у пакета
+ * из rte_eth_rx_burst без offload: port, длины, ol_flags = 0.
+ *
+ * @param pool Пул, из которого выделяются mbuf
+ * @param port_id Порт, записываемый в mbuf
+ * @param pkts Массив для записи пакетов
+ * @param data Данные пакетов
+ * @param lens Длины пакетов
+ * @param nb_pkts Количество пакетов
+ * @return nb_pkts или 0, если в пуле не хватило mbuf
+ */
+uint16_t dpdk_replay_burst(
+    struct rte_mempool *pool,
+    uint16_t port_id,
+    struct rte_mbuf **pkts,
+    const uint8_t *const *data,
+    const uint32_t *lens,
+    uint16_t nb_pkts
+) {
+    uint16_t i;
+
+    if (nb_pkts == 0 || rte_pktmbuf_alloc_bulk(pool, pkts, nb_pkts) != 0) {
+        return 0;
+    }
+
+    for (i = 0; i < nb_pkts; i++) {
+        struct rte_mbuf *m = pkts[i];
+        uint32_t room = rte_pktmbuf_tailroom(m);
+        uint32_t len = lens[i] < room ? lens[i] : room;
+
+        rte_memcpy(rte_pktmbuf_mtod(m, void *), data[i], len);
+        m->data_len = (uint16_t)len;
+        m->pkt_len = len;
+        m->port = port_id;
+        m->ol_flags = 0;
+        m->packet_type = 0;
+    }
+
+    return nb_pkts;
+}
+
+/* Максимальный размер заголовков в шаблоне TX (Ethernet + IPv4 + TCP с опциями) */
+#define DPDK_TX_HDR_MAX 96
+
+/**
+ * Заранее сериализованные заголовки Ethernet/IPv4/L4 одной TX сессии.
+ *
+ * Раскладка должна совпадать с `HeaderTemplate` в src/tx/session.rs.
+ * При отправке копируются байты hdr и исправляются только длины
+ * и контрольные суммы.
+ */
+struct dpdk_tx_template {
+    uint8_t hdr[DPDK_TX_HDR_MAX];
+    uint16_t hdr_len;
+    uint8_t l2_len;
+    uint8_t l3_len;
+    uint8_t l4_len;
+    uint8_t ip_proto;
+    uint8_t hw_cksum;
+    uint8_t _reserved;
+    /* Сумма псевдозаголовка без поля длины, см. rte_ipv4_phdr_cksum */
+    uint32_t phdr_sum;
+    uint64_t ol_flags;
+} __rte_cache_aligned;
+
+/* Сворачивает 32-битную сумму в 16-битную без инверсии */
+static inline uint16_t dpdk_cksum_fold(uint32_t sum)
+{
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+/**
+ * Строит шаблон заголовков TX сессии
+ *
+ * @param tmpl Шаблон для заполнения
+ * @param src_mac MAC-адрес источника (обычно адрес порта)
+ * @param dst_mac MAC-адрес назначения (шлюз или хост биржи)
+ * @param src_ip IP-адрес источника в сетевом порядке байтов
+ * @param dst_ip IP-адрес назначения в сетевом порядке байтов
  * @param src_port Порт источника
  * @param dst_port Порт назначения
- * @param data Указатель на данные для отправки
- * @param data_len Длина данных
  * @param use_tcp Использовать TCP (1) или UDP (0)
- * @param use_tso Использовать TCP Segmentation Offload для TCP или UDP TSO для UDP (1) или нет (0)
- * @param mss Максимальный размер сегмента для TSO (0 - значение по умолчанию)
- * @return Указатель на созданный пакет или NULL в случае ошибки
+ * @param hw_cksum Рассчитывать контрольные суммы на NIC (1) или программно (0)
+ * @return 0 в случае успеха, ненулевое значение в случае ошибки
  */
-struct rte_mbuf* dpdk_create_packet(
-    struct rte_mempool *mbuf_pool,
-    const char *src_ip,
-    const char *dst_ip,
+int dpdk_tx_template_init(
+    struct dpdk_tx_template *tmpl,
+    const uint8_t *src_mac,
+    const uint8_t *dst_mac,
+    uint32_t src_ip,
+    uint32_t dst_ip,
     uint16_t src_port,
     uint16_t dst_port,
-    const uint8_t *data,
-    uint32_t data_len,
     int use_tcp,
-    int use_tso,
-    uint16_t mss
+    int hw_cksum
 ) {
-    struct rte_mbuf *mbuf = rte_pktmbuf_alloc(mbuf_pool);
-    if (mbuf == NULL) {
-        return NULL;
-    }
-    
-    uint16_t eth_hdr_size = sizeof(struct rte_ether_hdr);
-    uint16_t ip_hdr_size = sizeof(struct rte_ipv4_hdr);
-    uint16_t l4_hdr_size = use_tcp ? sizeof(struct rte_tcp_hdr) : sizeof(struct rte_udp_hdr);
-    uint16_t total_hdr_size = eth_hdr_size + ip_hdr_size + l4_hdr_size;
-    
-    uint16_t total_size = total_hdr_size + data_len;
-    
-    char *payload = rte_pktmbuf_append(mbuf, total_size);
-    if (payload == NULL) {
-        rte_pktmbuf_free(mbuf);
-        return NULL;
+    if (!tmpl || !src_mac || !dst_mac) {
+        return -1;
     }
-    
-    struct rte_ether_hdr *eth_hdr = (struct rte_ether_hdr *)payload;
-    struct rte_ipv4_hdr *ip_hdr = (struct rte_ipv4_hdr *)(payload + eth_hdr_size);
-    void *l4_hdr = payload + eth_hdr_size + ip_hdr_size;
-    uint8_t *pkt_data = (uint8_t *)(payload + total_hdr_size);
-    
-    memset(&eth_hdr->dst_addr, 0xFF, RTE_ETHER_ADDR_LEN); 
-    memset(&eth_hdr->src_addr, 0xAA, RTE_ETHER_ADDR_LEN); 
+
+    memset(tmpl, 0, sizeof(*tmpl));
+
+    tmpl->l2_len = sizeof(struct rte_ether_hdr);
+    tmpl->l3_len = sizeof(struct rte_ipv4_hdr);
+    tmpl->l4_len = use_tcp ? sizeof(struct rte_tcp_hdr) : sizeof(struct rte_udp_hdr);
+    tmpl->hdr_len = tmpl->l2_len + tmpl->l3_len + tmpl->l4_len;
+    tmpl->ip_proto = use_tcp ? IPPROTO_TCP : IPPROTO_UDP;
+    tmpl->hw_cksum = hw_cksum ? 1 : 0;
+
+    struct rte_ether_hdr *eth_hdr = (struct rte_ether_hdr *)tmpl->hdr;
+    struct rte_ipv4_hdr *ip_hdr = (struct rte_ipv4_hdr *)(tmpl->hdr + tmpl->l2_len);
+    uint8_t *l4_hdr = tmpl->hdr + tmpl->l2_len + tmpl->l3_len;
+
+    memcpy(&eth_hdr->dst_addr, dst_mac, RTE_ETHER_ADDR_LEN);
+    memcpy(&eth_hdr->src_addr, src_mac, RTE_ETHER_ADDR_LEN);
     eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
-    
-    memset(ip_hdr, 0, ip_hdr_size);
-    ip_hdr->version_ihl = 0x45; 
-    ip_hdr->type_of_service = 0;
-    ip_hdr->total_length = rte_cpu_to_be_16(ip_hdr_size + l4_hdr_size + data_len);
-    ip_hdr->packet_id = 0;
-    ip_hdr->fragment_offset = 0;
-    ip_hdr->time_to_live = 64; // TTL
-    ip_hdr->next_proto_id = use_tcp ? IPPROTO_TCP : IPPROTO_UDP;
-    
-    inet_pton(AF_INET, src_ip, &ip_hdr->src_addr);
-    inet_pton(AF_INET, dst_ip, &ip_hdr->dst_addr);
-    
-    if (data != NULL && data_len > 0) {
-        memcpy(pkt_data, data, data_len);
-    }
-
-    // Базовая настройка offload флагов
-    mbuf->ol_flags |= RTE_MBUF_F_TX_IP_CKSUM;  
-    mbuf->l2_len = sizeof(struct rte_ether_hdr);  
-    mbuf->l3_len = sizeof(struct rte_ipv4_hdr);  
-
-    ip_hdr->hdr_checksum = 0;
+
+    ip_hdr->version_ihl = 0x45;
+    ip_hdr->fragment_offset = rte_cpu_to_be_16(RTE_IPV4_HDR_DF_FLAG);
+    ip_hdr->time_to_live = 64;
+    ip_hdr->next_proto_id = tmpl->ip_proto;
+    ip_hdr->src_addr = src_ip;
+    ip_hdr->dst_addr = dst_ip;
 
     if (use_tcp) {
         struct rte_tcp_hdr *tcp_hdr = (struct rte_tcp_hdr *)l4_hdr;
-        memset(tcp_hdr, 0, sizeof(struct rte_tcp_hdr));
-        
+
         tcp_hdr->src_port = rte_cpu_to_be_16(src_port);
         tcp_hdr->dst_port = rte_cpu_to_be_16(dst_port);
-        tcp_hdr->data_off = 0x50;  // Смещение данных 5 * 4 = 20 байт (стандартный заголовок TCP)
-        tcp_hdr->rx_win = rte_cpu_to_be_16(8192); 
-        
-        mbuf->ol_flags |= RTE_MBUF_F_TX_TCP_CKSUM;
-        mbuf->l4_len = sizeof(struct rte_tcp_hdr);
-        tcp_hdr->cksum = rte_ipv4_phdr_cksum(ip_hdr, mbuf->ol_flags);
-        
-        // Если включен TSO и пакет TCP, настраиваем TSO
-        if (use_tso && data_len > 0) {
-            // Используем заданный MSS или значение по умолчанию
-            uint16_t tso_mss = mss > 0 ? mss : 1460;
-            
-            // Проверяем, что размер данных больше MSS, иначе TSO не нужен
-            if (data_len > tso_mss) {
-                mbuf->ol_flags |= RTE_MBUF_F_TX_TCP_SEG;
-                mbuf->tso_segsz = tso_mss;
-                
-                // TCP Payload Length
-                mbuf->pkt_len = eth_hdr_size + ip_hdr_size + l4_hdr_size + data_len;
-                mbuf->data_len = mbuf->pkt_len;
-                
-                // TCP sequence number (для TSO это начальный номер последовательности)
-                tcp_hdr->sent_seq = rte_cpu_to_be_32(0);
-                
-                // Устанавливаем флаг PSH только для последнего сегмента
-                tcp_hdr->tcp_flags = RTE_TCP_ACK_FLAG;  // ACK для всех сегментов
-                
-                printf("TSO enabled for packet, data_len: %u, mss: %u\n", data_len, tso_mss);
-            }
-        }
+        tcp_hdr->data_off = 0x50;
+        tcp_hdr->tcp_flags = RTE_TCP_ACK_FLAG | RTE_TCP_PSH_FLAG;
+        tcp_hdr->rx_win = rte_cpu_to_be_16(0xffff);
     } else {
         struct rte_udp_hdr *udp_hdr = (struct rte_udp_hdr *)l4_hdr;
-        memset(udp_hdr, 0, sizeof(struct rte_udp_hdr));
-        
+
         udp_hdr->src_port = rte_cpu_to_be_16(src_port);
         udp_hdr->dst_port = rte_cpu_to_be_16(dst_port);
-        udp_hdr->dgram_len = rte_cpu_to_be_16(l4_hdr_size + data_len);
-        
-        mbuf->ol_flags |= RTE_MBUF_F_TX_UDP_CKSUM;
-        mbuf->l4_len = sizeof(struct rte_udp_hdr);
-        udp_hdr->dgram_cksum = rte_ipv4_phdr_cksum(ip_hdr, mbuf->ol_flags);
-        
-        // Если включен TSO и пакет UDP, настраиваем UDP TSO (GSO)
-        if (use_tso && data_len > 0) {
-            // Максимальный размер фрагмента UDP (обычно MTU - заголовки IP/UDP)
-            uint16_t tso_mss = mss > 0 ? mss : 1472;  // типичный размер для UDP 1500-28
-            
-            // Проверяем, что размер данных больше максимального размера фрагмента
-            if (data_len > tso_mss) {
-                // Для UDP TSO (иногда называемого UDP Fragmentation Offload - UFO)
-                // нужно установить другие флаги и правильно настроить mbuf
-                mbuf->ol_flags |= RTE_MBUF_F_TX_UDP_SEG;  // флаг для UDP TSO
-                mbuf->tso_segsz = tso_mss;
-                
-                // UDP Payload Length
-                mbuf->pkt_len = eth_hdr_size + ip_hdr_size + l4_hdr_size + data_len;
-                mbuf->data_len = mbuf->pkt_len;
-                
-                printf("UDP TSO enabled for packet, data_len: %u, mss: %u\n", data_len, tso_mss);
-            }
+    }
+
+    if (tmpl->hw_cksum) {
+        tmpl->ol_flags = RTE_MBUF_F_TX_IPV4 | RTE_MBUF_F_TX_IP_CKSUM |
+            (use_tcp ? RTE_MBUF_F_TX_TCP_CKSUM : RTE_MBUF_F_TX_UDP_CKSUM);
+    }
+
+    /* Псевдозаголовок с нулевой длиной: длина добавляется при отправке */
+    struct {
+        uint32_t src_addr;
+        uint32_t dst_addr;
+        uint8_t zero;
+        uint8_t proto;
+        uint16_t len;
+    } psd = { src_ip, dst_ip, 0, tmpl->ip_proto, 0 };
+    uint16_t words[sizeof(psd) / 2];
+    uint32_t sum = 0;
+    size_t w;
+
+    memcpy(words, &psd, sizeof(psd));
+    for (w = 0; w < sizeof(psd) / 2; w++) {
+        sum += words[w];
+    }
+    tmpl->phdr_sum = sum;
+
+    return 0;
+}
+
+/**
+ * Выставляет длины и контрольные суммы кадра, заголовки которого уже
+ * скопированы из шаблона
+ *
+ * l4_len может быть больше tmpl->l4_len, если в сегмент добавлены опции TCP.
+ */
+static inline void dpdk_tx_fixup(
+    const struct dpdk_tx_template *tmpl,
+    struct rte_mbuf *mbuf,
+    uint8_t *frame,
+    uint8_t l4_len,
+    uint16_t payload_len
+) {
+    struct rte_ipv4_hdr *ip_hdr = (struct rte_ipv4_hdr *)(frame + tmpl->l2_len);
+    uint8_t *l4_hdr = frame + tmpl->l2_len + tmpl->l3_len;
+    uint16_t l4_total = l4_len + payload_len;
+
+    ip_hdr->total_length = rte_cpu_to_be_16(tmpl->l3_len + l4_total);
+
+    mbuf->data_len = tmpl->l2_len + tmpl->l3_len + l4_total;
+    mbuf->pkt_len = mbuf->data_len;
+
+    if (tmpl->ip_proto == IPPROTO_UDP) {
+        ((struct rte_udp_hdr *)l4_hdr)->dgram_len = rte_cpu_to_be_16(l4_total);
+    }
+
+    uint16_t l4_cksum;
+    if (likely(tmpl->hw_cksum)) {
+        mbuf->ol_flags = tmpl->ol_flags;
+        mbuf->l2_len = tmpl->l2_len;
+        mbuf->l3_len = tmpl->l3_len;
+        mbuf->l4_len = l4_len;
+        l4_cksum = dpdk_cksum_fold(tmpl->phdr_sum + rte_cpu_to_be_16(l4_total));
+    } else {
+        ip_hdr->hdr_checksum = rte_ipv4_cksum(ip_hdr);
+        l4_cksum = rte_ipv4_udptcp_cksum(ip_hdr, l4_hdr);
+    }
+
+    if (tmpl->ip_proto == IPPROTO_UDP) {
+        ((struct rte_udp_hdr *)l4_hdr)->dgram_cksum = l4_cksum;
+    } else {
+        ((struct rte_tcp_hdr *)l4_hdr)->cksum = l4_cksum;
+    }
+}
+
+/**
+ * Копирует заголовки шаблона в начало кадра и выставляет длины и offload
+ *
+ * payload длиной payload_len уже должен находиться в mbuf сразу после
+ * области заголовков (hdr_len байт от начала данных).
+ */
+static inline void dpdk_tx_finalize(
+    const struct dpdk_tx_template *tmpl,
+    struct rte_mbuf *mbuf,
+    uint8_t *frame,
+    uint16_t payload_len
+) {
+    rte_memcpy(frame, tmpl->hdr, tmpl->hdr_len);
+    dpdk_tx_fixup(tmpl, mbuf, frame, tmpl->l4_len, payload_len);
+}
+
+/**
+ * Собирает burst пакетов по шаблону заголовков
+ *
+ * mbuf выделяются одним вызовом rte_pktmbuf_alloc_bulk. Если пул не может
+ * выдать все nb_pkts mbuf сразу, ничего не выделяется.
+ *
+ * @param mbuf_pool Пул памяти порта
+ * @param tmpl Шаблон заголовков сессии
+ * @param payloads Массив указателей на данные
+ * @param payload_lens Массив длин данных
+ * @param nb_pkts Количество пакетов
+ * @param pkts_out Массив для записи созданных пакетов
+ * @return Количество созданных пакетов (0 или nb_pkts)
+ */
+uint16_t dpdk_tx_build_burst(
+    struct rte_mempool *mbuf_pool,
+    const struct dpdk_tx_template *tmpl,
+    const uint8_t *const *payloads,
+    const uint16_t *payload_lens,
+    uint16_t nb_pkts,
+    struct rte_mbuf **pkts_out
+) {
+    uint16_t i;
+
+    if (nb_pkts == 0 || rte_pktmbuf_alloc_bulk(mbuf_pool, pkts_out, nb_pkts) != 0) {
+        return 0;
+    }
+
+    for (i = 0; i < nb_pkts; i++) {
+        struct rte_mbuf *mbuf = pkts_out[i];
+        uint8_t *frame = rte_pktmbuf_mtod(mbuf, uint8_t *);
+
+        rte_memcpy(frame + tmpl->hdr_len, payloads[i], payload_lens[i]);
+        dpdk_tx_finalize(tmpl, mbuf, frame, payload_lens[i]);
+    }
+
+    return nb_pkts;
+}
+
+/**
+ * Выделяет mbuf и возвращает адрес payload сразу после области заголовков,
+ * чтобы вызывающая сторона записала сообщение прямо в data room
+ *
+ * @param mbuf_pool Пул памяти порта
+ * @param tmpl Шаблон заголовков сессии
+ * @param mbuf_out Выделенный mbuf
+ * @return Адрес payload или NULL, если пул пуст
+ */
+uint8_t *dpdk_tx_prepare(
+    struct rte_mempool *mbuf_pool,
+    const struct dpdk_tx_template *tmpl,
+    struct rte_mbuf **mbuf_out
+) {
+    struct rte_mbuf *mbuf = rte_pktmbuf_alloc(mbuf_pool);
+
+    *mbuf_out = mbuf;
+    if (mbuf == NULL) {
+        return NULL;
+    }
+
+    return rte_pktmbuf_mtod(mbuf, uint8_t *) + tmpl->hdr_len;
+}
+
+/**
+ * Достраивает кадр, payload которого записан после dpdk_tx_prepare
+ *
+ * @param tmpl Шаблон заголовков сессии
+ * @param mbuf mbuf из dpdk_tx_prepare
+ * @param payload_len Длина записанного payload
+ */
+void dpdk_tx_commit(
+    const struct dpdk_tx_template *tmpl,
+    struct rte_mbuf *mbuf,
+    uint16_t payload_len
+) {
+    dpdk_tx_finalize(tmpl, mbuf, rte_pktmbuf_mtod(mbuf, uint8_t *), payload_len);
+}
+
+/* Длина опции MSS в SYN сегменте */
+#define DPDK_TCP_OPT_MSS_LEN 4
+
+/**
+ * Параметры одного TCP сегмента сессии
+ *
+ * Раскладка должна совпадать с `TcpSegment` в src/tx/tcp.rs. Номера
+ * последовательности и окно - в порядке байтов хоста.
+ */
+struct dpdk_tcp_segment {
+    const uint8_t *payload;
+    uint32_t seq;
+    uint32_t ack;
+    uint16_t payload_len;
+    uint16_t window;
+    uint8_t flags;
+    uint8_t _reserved;
+    /* Значение опции MSS, 0 - без опций (опция нужна только в SYN) */
+    uint16_t mss;
+};
+
+/**
+ * Собирает burst TCP сегментов по шаблону заголовков сессии
+ *
+ * В отличие от dpdk_tx_build_burst, в каждом сегменте перед расчетом
+ * контрольной суммы исправляются номера SEQ/ACK, флаги и окно.
+ *
+ * @param mbuf_pool Пул памяти порта
+ * @param tmpl Шаблон заголовков TCP сессии
+ * @param segs Массив сегментов
+ * @param nb_segs Количество сегментов
+ * @param pkts_out Массив для записи созданных пакетов
+ * @return Количество созданных пакетов (0 или nb_segs)
+ */
+uint16_t dpdk_tx_build_tcp_burst(
+    struct rte_mempool *mbuf_pool,
+    const struct dpdk_tx_template *tmpl,
+    const struct dpdk_tcp_segment *segs,
+    uint16_t nb_segs,
+    struct rte_mbuf **pkts_out
+) {
+    uint16_t i;
+
+    if (tmpl->ip_proto != IPPROTO_TCP) {
+        return 0;
+    }
+
+    if (nb_segs == 0 || rte_pktmbuf_alloc_bulk(mbuf_pool, pkts_out, nb_segs) != 0) {
+        return 0;
+    }
+
+    for (i = 0; i < nb_segs; i++) {
+        const struct dpdk_tcp_segment *seg = &segs[i];
+        struct rte_mbuf *mbuf = pkts_out[i];
+        uint8_t *frame = rte_pktmbuf_mtod(mbuf, uint8_t *);
+        struct rte_tcp_hdr *tcp_hdr =
+            (struct rte_tcp_hdr *)(frame + tmpl->l2_len + tmpl->l3_len);
+        uint8_t opt_len = seg->mss ? DPDK_TCP_OPT_MSS_LEN : 0;
+        uint8_t l4_len = tmpl->l4_len + opt_len;
+
+        rte_memcpy(frame, tmpl->hdr, tmpl->hdr_len);
+        if (seg->payload_len) {
+            rte_memcpy(frame + tmpl->hdr_len + opt_len, seg->payload, seg->payload_len);
+        }
+
+        tcp_hdr->sent_seq = rte_cpu_to_be_32(seg->seq);
+        tcp_hdr->recv_ack = rte_cpu_to_be_32(seg->ack);
+        tcp_hdr->tcp_flags = seg->flags;
+        tcp_hdr->rx_win = rte_cpu_to_be_16(seg->window);
+        tcp_hdr->data_off = (uint8_t)((l4_len / 4) << 4);
+
+        if (opt_len) {
+            uint8_t *opt = (uint8_t *)(tcp_hdr + 1);
+            opt[0] = 2; /* MSS */
+            opt[1] = DPDK_TCP_OPT_MSS_LEN;
+            opt[2] = (uint8_t)(seg->mss >> 8);
+            opt[3] = (uint8_t)seg->mss;
         }
+
+        dpdk_tx_fixup(tmpl, mbuf, frame, l4_len, seg->payload_len);
     }
-    
-    return mbuf;
-}
\ No newline at end of file
+
+    return nb_segs;
+}
+
+/**
+ * Отправляет burst в TX очередь с повторными попытками
+ *
+ * Повторяет rte_eth_tx_burst для неотправленного хвоста, пока очередь
+ * не примет все пакеты или не закончатся попытки. Неотправленные пакеты
+ * остаются в pkts[ret..nb_pkts) и не освобождаются: решение о сбросе
+ * или повторной отправке принимает вызывающая сторона.
+ *
+ * @param port_id ID порта
+ * @param queue_id ID TX очереди
+ * @param pkts Массив пакетов
+ * @param nb_pkts Количество пакетов
+ * @param max_retries Количество повторных попыток при заполненной очереди
+ * @return Количество отправленных пакетов
+ */
+uint16_t dpdk_tx_send_burst(
+    uint16_t port_id,
+    uint16_t queue_id,
+    struct rte_mbuf **pkts,
+    uint16_t nb_pkts,
+    uint32_t max_retries
+) {
+    uint16_t nb_tx = rte_eth_tx_burst(port_id, queue_id, pkts, nb_pkts);
+    uint32_t retry = 0;
+
+    while (unlikely(nb_tx < nb_pkts) && retry++ < max_retries) {
+        rte_pause();
+        nb_tx += rte_eth_tx_burst(port_id, queue_id, pkts + nb_tx, nb_pkts - nb_tx);
+    }
+
+    return nb_tx;
+}
+
+/**
+ * Проверяет, что драйвер поддерживает RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE
+ *
+ * Offload допустим, пока все mbuf одной TX очереди берутся из одного пула и
+ * имеют refcnt 1: так устроены TX сессии и служебная очередь порта.
+ *
+ * @param port_id Идентификатор порта
+ * @return 0 в случае поддержки, -ENOTSUP если драйвер не поддерживает
+ *         offload, другой отрицательный код ошибки DPDK иначе
+ */
+int dpdk_tx_fast_free_supported(uint16_t port_id)
+{
+    struct rte_eth_dev_info dev_info;
+    int ret;
+
+    ret = rte_eth_dev_info_get(port_id, &dev_info);
+    if (ret != 0) {
+        return ret;
+    }
+
+    return (dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE) ? 0 : -ENOTSUP;
+}
+
+/**
+ * Проверяет, что RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE вошел в конфигурацию
+ * порта, принятую rte_eth_dev_configure
+ *
+ * @param port_id Идентификатор порта (сконфигурированного)
+ * @return 1 если offload включен, 0 если нет, отрицательный код ошибки
+ *         DPDK иначе
+ */
+int dpdk_tx_fast_free_enabled(uint16_t port_id)
+{
+    struct rte_eth_conf conf;
+    int ret;
+
+    ret = rte_eth_dev_conf_get(port_id, &conf);
+    if (ret != 0) {
+        return ret;
+    }
+
+    return (conf.txmode.offloads & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE) ? 1 : 0;
+}
+
+/**
+ * Собирает mbuf из готового Ethernet кадра (служебный трафик: IGMP и т.п.)
+ *
+ * @param mbuf_pool Пул mbuf порта
+ * @param frame Кадр целиком, начиная с заголовка Ethernet
+ * @param len Длина кадра
+ * @return mbuf с копией кадра или NULL, если пул пуст или кадр не помещается
+ */
+struct rte_mbuf *dpdk_tx_frame(struct rte_mempool *mbuf_pool, const uint8_t *frame, uint16_t len)
+{
+    struct rte_mbuf *pkt = rte_pktmbuf_alloc(mbuf_pool);
+
+    if (pkt == NULL) {
+        return NULL;
+    }
+
+    char *data = rte_pktmbuf_append(pkt, len);
+    if (data == NULL) {
+        rte_pktmbuf_free(pkt);
+        return NULL;
+    }
+
+    rte_memcpy(data, frame, len);
+    return pkt;
+}
+
+/**
+ * Параметры конфигурации порта, зеркало EthSettings в src/dpdk/ffi.rs.
+ *
+ * struct rte_eth_conf собирается здесь, а не в Rust: ее раскладка (резервные
+ * поля, битовые поля intr_conf) меняется между версиями DPDK.
+ */
+struct dpdk_eth_settings {
+    uint64_t rss_hf;
+    const uint8_t *rss_key;
+    uint8_t rss_key_len;
+    uint8_t rss;
+    uint8_t scatter;
+    uint8_t hw_checksum;
+    uint8_t tx_fast_free;
+    uint8_t tcp_tso;
+    uint8_t udp_tso;
+    uint8_t lro;
+    uint8_t rx_timestamp;
+    uint8_t rxq_intr;
+    uint32_t mtu;
+};
+
+/**
+ * Конфигурирует порт по настройкам, собранным в src/dpdk/init.rs
+ *
+ * @param port_id Идентификатор порта
+ * @param nb_rx_queue Количество RX очередей (включая служебные)
+ * @param nb_tx_queue Количество TX очередей (включая служебные)
+ * @param settings Настройки порта; mtu 0 оставляет значение драйвера
+ * @return 0 в случае успеха, отрицательный код ошибки DPDK иначе
+ */
+int dpdk_eth_dev_configure(
+    uint16_t port_id,
+    uint16_t nb_rx_queue,
+    uint16_t nb_tx_queue,
+    const struct dpdk_eth_settings *settings)
+{
+    struct rte_eth_conf conf;
+
+    memset(&conf, 0, sizeof(conf));
+
+    if (settings->rss) {
+        conf.rxmode.mq_mode = RTE_ETH_MQ_RX_RSS;
+        conf.rx_adv_conf.rss_conf.rss_hf = settings->rss_hf;
+        conf.rx_adv_conf.rss_conf.rss_key = (uint8_t *)settings->rss_key;
+        conf.rx_adv_conf.rss_conf.rss_key_len = settings->rss_key_len;
+    }
+
+    conf.rxmode.mtu = settings->mtu;
+    if (settings->scatter) {
+        conf.rxmode.offloads |= RTE_ETH_RX_OFFLOAD_SCATTER;
+    }
+    if (settings->hw_checksum) {
+        conf.rxmode.offloads |= RTE_ETH_RX_OFFLOAD_CHECKSUM;
+        conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_IPV4_CKSUM |
+                                RTE_ETH_TX_OFFLOAD_UDP_CKSUM |
+                                RTE_ETH_TX_OFFLOAD_TCP_CKSUM;
+    }
+    if (settings->lro) {
+        conf.rxmode.offloads |= RTE_ETH_RX_OFFLOAD_TCP_LRO;
+    }
+    if (settings->rx_timestamp) {
+        conf.rxmode.offloads |= RTE_ETH_RX_OFFLOAD_TIMESTAMP;
+    }
+
+    if (settings->tx_fast_free) {
+        conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE;
+    }
+    if (settings->tcp_tso) {
+        conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_TCP_TSO | RTE_ETH_TX_OFFLOAD_MULTI_SEGS;
+    }
+    if (settings->udp_tso) {
+        conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_UDP_TSO | RTE_ETH_TX_OFFLOAD_MULTI_SEGS;
+    }
+
+    conf.intr_conf.rxq = settings->rxq_intr ? 1 : 0;
+
+    return rte_eth_dev_configure(port_id, nb_rx_queue, nb_tx_queue, &conf);
+}
+
+/**
+ * Распределяет RSS таблицу перенаправления по первым nb_queues очередям
+ *
+ * По умолчанию драйвер включает в RETA все сконфигурированные RX очереди;
+ * служебные очереди за пределами nb_queues должны получать только трафик,
+ * направленный в них правилами rte_flow.
+ *
+ * @param port_id Идентификатор порта (запущенного)
+ * @param nb_queues Количество очередей данных
+ * @return 0 в случае успеха, отрицательный код ошибки DPDK иначе
+ */
+int dpdk_rss_reta_spread(uint16_t port_id, uint16_t nb_queues)
+{
+    struct rte_eth_dev_info dev_info;
+    struct rte_eth_rss_reta_entry64 reta[RTE_ETH_RSS_RETA_SIZE_512 / RTE_ETH_RETA_GROUP_SIZE];
+    uint16_t i;
+    int ret;
+
+    if (nb_queues == 0) {
+        return -EINVAL;
+    }
+
+    ret = rte_eth_dev_info_get(port_id, &dev_info);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (dev_info.reta_size == 0 || dev_info.reta_size > RTE_ETH_RSS_RETA_SIZE_512) {
+        return -ENOTSUP;
+    }
+
+    memset(reta, 0, sizeof(reta));
+    for (i = 0; i < dev_info.reta_size; i++) {
+        struct rte_eth_rss_reta_entry64 *group = &reta[i / RTE_ETH_RETA_GROUP_SIZE];
+
+        group->mask |= 1ULL << (i % RTE_ETH_RETA_GROUP_SIZE);
+        group->reta[i % RTE_ETH_RETA_GROUP_SIZE] = i % nb_queues;
+    }
+
+    return rte_eth_dev_rss_reta_update(port_id, reta, dev_info.reta_size);
+}
+
+/**
+ * Регистрирует RX прерывание очереди в epoll текущего потока
+ *
+ * Требует intr_conf.rxq = 1 при конфигурации порта. Вызывается из потока,
+ * который будет ждать прерывания в dpdk_rx_intr_wait.
+ *
+ * @return 0 в случае успеха, отрицательный код ошибки DPDK иначе
+ */
+int dpdk_rx_intr_register(uint16_t port_id, uint16_t queue_id)
+{
+    return rte_eth_dev_rx_intr_ctl_q(port_id, queue_id, RTE_EPOLL_PER_THREAD,
+                                     RTE_INTR_EVENT_ADD, NULL);
+}
+
+/**
+ * Усыпляет поток до RX прерывания любой из очередей или истечения таймаута
+ *
+ * Прерывания включаются только на время ожидания, чтобы в режиме опроса
+ * NIC не генерировал лишних прерываний. Worker, опрашивающий несколько
+ * линий, ждет сразу на всех: пакет любой линии будит поток. Пакет,
+ * пришедший между последним пустым опросом и включением прерывания,
+ * события уже не вызовет, поэтому после включения очереди проверяются
+ * еще раз.
+ *
+ * @param port_ids ID портов очередей
+ * @param queue_ids ID RX очередей
+ * @param nb_queues Количество очередей
+ * @param timeout_ms Максимальное время сна в миллисекундах
+ * @return Количество событий (0 - таймаут, 1 - очередь уже не пуста),
+ *         отрицательное значение при ошибке
+ */
+int dpdk_rx_intr_wait(
+    const uint16_t *port_ids,
+    const uint16_t *queue_ids,
+    uint16_t nb_queues,
+    int timeout_ms)
+{
+    struct rte_epoll_event event;
+    uint16_t armed, i;
+    int ret = 0;
+
+    for (armed = 0; armed < nb_queues; armed++) {
+        if (rte_eth_dev_rx_intr_enable(port_ids[armed], queue_ids[armed]) != 0) {
+            ret = -1;
+            goto out;
+        }
+    }
+
+    /* Драйвер без rx_queue_count вернет -ENOTSUP: тогда просто ждем */
+    for (i = 0; i < nb_queues; i++) {
+        if (rte_eth_rx_queue_count(port_ids[i], queue_ids[i]) > 0) {
+            ret = 1;
+            goto out;
+        }
+    }
+
+    ret = rte_epoll_wait(RTE_EPOLL_PER_THREAD, &event, 1, timeout_ms);
+
+out:
+    for (i = 0; i < armed; i++) {
+        rte_eth_dev_rx_intr_disable(port_ids[i], queue_ids[i]);
+    }
+
+    return ret;
+}
+
+/**
+ * Возвращает текущее значение счетчика тактов
+ *
+ * Используется на платформах, где Rust не может прочитать TSC напрямую.
+ */
+uint64_t dpdk_tsc_cycles(void)
+{
+    return rte_get_tsc_cycles();
+}
+
+/**
+ * Параметры правила rte_flow.
+ *
+ * Раскладка должна совпадать с `FlowSpec` в src/dpdk/flow.rs.
+ * Адрес - в сетевом порядке байтов, порт - в порядке байтов хоста.
+ * Нулевая маска означает "любое значение"; proto = 0 - любой протокол
+ * (совпадение по порту в этом случае невозможно).
+ */
+struct dpdk_flow_spec {
+    uint32_t dst_ip;
+    uint32_t dst_ip_mask;
+    uint16_t dst_port;
+    uint16_t dst_port_mask;
+    uint8_t proto;
+    uint8_t drop;
+    uint16_t queue;
+    uint32_t priority;
+};
+
+/* Копирует сообщение об ошибке rte_flow в буфер вызывающего */
+static void dpdk_flow_error_copy(const struct rte_flow_error *error, char *err, size_t err_len)
+{
+    if (err && err_len > 0) {
+        snprintf(err, err_len, "%s", error->message ? error->message : "unspecified error");
+    }
+}
+
+/**
+ * Устанавливает правило rte_flow: ETH / IPV4 / UDP|TCP -> QUEUE или DROP
+ *
+ * Правило предварительно проверяется через rte_flow_validate, чтобы
+ * драйвер мог отклонить неподдерживаемое сочетание полей без побочных
+ * эффектов.
+ *
+ * @param port_id Идентификатор порта
+ * @param spec Параметры правила
+ * @param err Буфер для текста ошибки драйвера (может быть NULL)
+ * @param err_len Размер буфера
+ * @return Дескриптор правила или NULL в случае ошибки
+ */
+struct rte_flow *dpdk_flow_create(
+    uint16_t port_id,
+    const struct dpdk_flow_spec *spec,
+    char *err,
+    size_t err_len
+) {
+    struct rte_flow_attr attr = { .priority = spec->priority, .ingress = 1 };
+    struct rte_flow_item pattern[4];
+    struct rte_flow_action actions[2];
+    struct rte_flow_action_queue queue = { .index = spec->queue };
+    struct rte_flow_item_ipv4 ip_spec, ip_mask;
+    struct rte_flow_item_udp udp_spec, udp_mask;
+    struct rte_flow_item_tcp tcp_spec, tcp_mask;
+    struct rte_flow_error error;
+    int n = 0;
+
+    memset(pattern, 0, sizeof(pattern));
+    memset(actions, 0, sizeof(actions));
+    memset(&ip_spec, 0, sizeof(ip_spec));
+    memset(&ip_mask, 0, sizeof(ip_mask));
+    memset(&udp_spec, 0, sizeof(udp_spec));
+    memset(&udp_mask, 0, sizeof(udp_mask));
+    memset(&tcp_spec, 0, sizeof(tcp_spec));
+    memset(&tcp_mask, 0, sizeof(tcp_mask));
+    memset(&error, 0, sizeof(error));
+
+    if (spec->dst_port_mask && spec->proto != IPPROTO_UDP && spec->proto != IPPROTO_TCP) {
+        if (err && err_len > 0) {
+            snprintf(err, err_len, "destination port match requires UDP or TCP");
+        }
+        return NULL;
+    }
+
+    pattern[n++].type = RTE_FLOW_ITEM_TYPE_ETH;
+
+    if (spec->dst_ip_mask || spec->proto) {
+        ip_spec.hdr.dst_addr = spec->dst_ip;
+        ip_mask.hdr.dst_addr = spec->dst_ip_mask;
+        ip_spec.hdr.next_proto_id = spec->proto;
+        ip_mask.hdr.next_proto_id = spec->proto ? 0xff : 0;
+
+        pattern[n].type = RTE_FLOW_ITEM_TYPE_IPV4;
+        pattern[n].spec = &ip_spec;
+        pattern[n].mask = &ip_mask;
+        n++;
+    }
+
+    if (spec->proto == IPPROTO_UDP) {
+        udp_spec.hdr.dst_port = rte_cpu_to_be_16(spec->dst_port);
+        udp_mask.hdr.dst_port = rte_cpu_to_be_16(spec->dst_port_mask);
+
+        pattern[n].type = RTE_FLOW_ITEM_TYPE_UDP;
+        pattern[n].spec = &udp_spec;
+        pattern[n].mask = &udp_mask;
+        n++;
+    } else if (spec->proto == IPPROTO_TCP) {
+        tcp_spec.hdr.dst_port = rte_cpu_to_be_16(spec->dst_port);
+        tcp_mask.hdr.dst_port = rte_cpu_to_be_16(spec->dst_port_mask);
+
+        pattern[n].type = RTE_FLOW_ITEM_TYPE_TCP;
+        pattern[n].spec = &tcp_spec;
+        pattern[n].mask = &tcp_mask;
+        n++;
+    }
+
+    pattern[n].type = RTE_FLOW_ITEM_TYPE_END;
+
+    if (spec->drop) {
+        actions[0].type = RTE_FLOW_ACTION_TYPE_DROP;
+    } else {
+        actions[0].type = RTE_FLOW_ACTION_TYPE_QUEUE;
+        actions[0].conf = &queue;
+    }
+    actions[1].type = RTE_FLOW_ACTION_TYPE_END;
+
+    if (rte_flow_validate(port_id, &attr, pattern, actions, &error) != 0) {
+        dpdk_flow_error_copy(&error, err, err_len);
+        return NULL;
+    }
+
+    struct rte_flow *flow = rte_flow_create(port_id, &attr, pattern, actions, &error);
+    if (flow == NULL) {
+        dpdk_flow_error_copy(&error, err, err_len);
+    }
+
+    return flow;
+}
+
+/**
+ * Удаляет правило rte_flow
+ *
+ * @return 0 в случае успеха, отрицательный код ошибки иначе
+ */
+int dpdk_flow_destroy(uint16_t port_id, struct rte_flow *flow)
+{
+    struct rte_flow_error error;
+
+    return rte_flow_destroy(port_id, flow, &error);
+}
+
+/**
+ * Удаляет все правила rte_flow порта
+ *
+ * @return 0 в случае успеха, отрицательный код ошибки иначе
+ */
+int dpdk_flow_flush(uint16_t port_id)
+{
+    struct rte_flow_error error;
+
+    return rte_flow_flush(port_id, &error);
+}
@@ -0,0 +1,532 @@
+// src/numa/arena.rs
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::{Cell, UnsafeCell};
+use std::hint;
+use std::os::raw::{c_int, c_void};
+use std::ptr::{self, null_mut};
+use std::sync::atomic::{AtomicBool, AtomicPtr, AtomicU64, AtomicUsize, Ordering};
+
+use crate::dpdk::hugepages;
+use crate::numa::ffi::{numa_tonode_memory, NumaAllocator};
+
+/// Максимальное число узлов NUMA с собственной ареной
+pub const MAX_ARENA_NODES: usize = 64;
+
+/// Классы размеров: степени двойки от 16 байт до 2 МБ
+const MIN_CLASS_SHIFT: u32 = 4;
+const MAX_CLASS_SHIFT: u32 = 21;
+const NUM_CLASSES: usize = (MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1) as usize;
+
+/// Шаг округления крупных блоков (больше старшего класса)
+const LARGE_CHUNK: usize = 1 << MAX_CLASS_SHIFT;
+
+/// Кодирование размера страницы во флагах mmap (MAP_HUGE_2MB/MAP_HUGE_1GB)
+const MAP_HUGE_SHIFT: c_int = 26;
+
+/// Размер страниц арены
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ArenaPageSize {
+    /// 2 МБ страницы
+    Huge2M,
+    /// 1 ГБ страницы: один TLB вход на всю арену типичного размера
+    Huge1G,
+}
+
+impl ArenaPageSize {
+    /// Размер страницы в байтах
+    pub fn bytes(self) -> usize {
+        match self {
+            ArenaPageSize::Huge2M => 2 << 20,
+            ArenaPageSize::Huge1G => 1 << 30,
+        }
+    }
+
+    fn map_flags(self) -> c_int {
+        let shift = match self {
+            ArenaPageSize::Huge2M => 21,
+            ArenaPageSize::Huge1G => 30,
+        };
+        libc::MAP_HUGETLB | (shift << MAP_HUGE_SHIFT)
+    }
+}
+
+/// Конфигурация арен узлов NUMA
+#[derive(Debug, Clone)]
+pub struct ArenaConfig {
+    /// Размер арены каждого узла в МБ (0 - арены не создаются)
+    pub size_mb: usize,
+    /// Размер страниц арены
+    pub page_size: ArenaPageSize,
+}
+
+impl Default for ArenaConfig {
+    fn default() -> Self {
+        Self {
+            size_mb: 0,
+            page_size: ArenaPageSize::Huge2M,
+        }
+    }
+}
+
+impl ArenaConfig {
+    /// Создаются ли арены узлов
+    pub fn is_enabled(&self) -> bool {
+        self.size_mb > 0
+    }
+}
+
+/// Освобожденный блок класса размера
+struct FreeBlock {
+    next: *mut FreeBlock,
+}
+
+/// Освобожденный крупный блок; переиспользуется только при точном
+/// совпадении размера
+struct LargeBlock {
+    next: *mut LargeBlock,
+    size: usize,
+}
+
+/// Состояние под спин-блокировкой
+struct ArenaState {
+    /// Смещение первого свободного байта от начала арены
+    bump: usize,
+    free: [*mut FreeBlock; NUM_CLASSES],
+    large: *mut LargeBlock,
+}
+
+/// Арена памяти одного узла NUMA на huge pages
+///
+/// Память выделяется одним отображением, привязывается к узлу и заранее
+/// заполняется страницами, поэтому в цикле обработки не бывает page fault и
+/// обращения к ядру. Внутри - bump-выделение и списки свободных блоков по
+/// классам-степеням двойки: блок класса выровнен по своему размеру, так
+/// что мелкие структуры стакана не пересекают границы кэш-линий без нужды,
+/// а вся арена покрывается несколькими TLB входами.
+///
+/// Арены создаются на старте и живут до конца процесса; освобождение по
+/// адресу работает из любого потока, поэтому структуры, созданные worker,
+/// может уничтожить и управляющий поток.
+///
+/// Состояние арены защищено одной спин-блокировкой на узел, кешей потоков
+/// нет: все потоки узла, выделяющие одновременно, выстраиваются в очередь.
+/// Арена рассчитана на выделения при создании worker и обработчиков, а
+/// горячий путь (обработка burst, стадии конвейера) не должен выделять и
+/// освобождать память - иначе соседние ядра узла ждут друг друга.
+pub struct NodeArena {
+    node: usize,
+    base: *mut u8,
+    capacity: usize,
+    page_size: usize,
+    /// Отображение на hugetlbfs страницах (false - прозрачные huge pages)
+    hugetlb: bool,
+    lock: AtomicBool,
+    state: UnsafeCell<ArenaState>,
+    /// Зеркало `state.bump` для телеметрии
+    used: AtomicUsize,
+    live_bytes: AtomicUsize,
+    /// Выделения, ушедшие в системную кучу из-за нехватки места
+    fallbacks: AtomicU64,
+}
+
+// Состояние меняется только под `lock`
+unsafe impl Send for NodeArena {}
+unsafe impl Sync for NodeArena {}
+
+#[allow(clippy::declare_interior_mutable_const)]
+const NO_ARENA: AtomicPtr<NodeArena> = AtomicPtr::new(null_mut());
+
+static ARENAS: [AtomicPtr<NodeArena>; MAX_ARENA_NODES] = [NO_ARENA; MAX_ARENA_NODES];
+
+/// Общий диапазон адресов всех арен: быстрый отказ для памяти System
+static ARENA_LO: AtomicUsize = AtomicUsize::new(usize::MAX);
+static ARENA_HI: AtomicUsize = AtomicUsize::new(0);
+
+thread_local! {
+    /// Арена, в которую `NodeAwareAllocator` направляет выделения потока
+    static CURRENT: Cell<*const NodeArena> = const { Cell::new(ptr::null()) };
+}
+
+impl NodeArena {
+    /// Создает и регистрирует арену узла `node` размером `size` байт
+    ///
+    /// Если на узле не хватает свободных hugetlbfs страниц нужного размера
+    /// или отображение не удалось, используется обычная анонимная память
+    /// с прозрачными huge pages.
+    pub fn create(
+        node: usize,
+        size: usize,
+        page_size: ArenaPageSize,
+    ) -> Result<&'static NodeArena, String> {
+        if node >= MAX_ARENA_NODES {
+            return Err(format!(
+                "NUMA node {} exceeds arena limit {}",
+                node, MAX_ARENA_NODES
+            ));
+        }
+        if Self::get(node).is_some() {
+            return Err(format!("Arena for NUMA node {} already exists", node));
+        }
+
+        let huge_size = page_size.bytes();
+        let capacity = size.max(huge_size).div_ceil(huge_size) * huge_size;
+
+        let pages_needed = (capacity / huge_size) as u64;
+        let pages_free = hugepages::node_free_hugepages(node, huge_size as u64 / 1024);
+        let hugetlb_memory = match pages_free {
+            Some(free) if free < pages_needed => {
+                eprintln!(
+                    "Warning: NUMA node {} has {} free {} kB hugepages, arena needs {}",
+                    node,
+                    free,
+                    huge_size / 1024,
+                    pages_needed
+                );
+                None
+            }
+            _ => Self::map(capacity, page_size.map_flags()),
+        };
+
+        let (base, hugetlb, page_size) = match hugetlb_memory {
+            Some(base) => (base, true, huge_size),
+            None => {
+                let base = Self::map(capacity, 0).ok_or_else(|| {
+                    format!(
+                        "Failed to map {} MB arena for NUMA node {}: {}",
+                        capacity >> 20,
+                        node,
+                        std::io::Error::last_os_error()
+                    )
+                })?;
+                unsafe { libc::madvise(base as *mut c_void, capacity, libc::MADV_HUGEPAGE) };
+                eprintln!(
+                    "Warning: arena for NUMA node {} uses transparent huge pages",
+                    node
+                );
+                (base, false, 4096)
+            }
+        };
+
+        // Привязка до первого касания, затем prefault всех страниц
+        if NumaAllocator::is_available() {
+            unsafe { numa_tonode_memory(base as *mut c_void, capacity, node as c_int) };
+        }
+        for offset in (0..capacity).step_by(page_size) {
+            unsafe { ptr::write_volatile(base.add(offset), 0) };
+        }
+
+        let arena = Box::leak(Box::new(NodeArena {
+            node,
+            base,
+            capacity,
+            page_size,
+            hugetlb,
+            lock: AtomicBool::new(false),
+            state: UnsafeCell::new(ArenaState {
+                bump: 0,
+                free: [null_mut(); NUM_CLASSES],
+                large: null_mut(),
+            }),
+            used: AtomicUsize::new(0),
+            live_bytes: AtomicUsize::new(0),
+            fallbacks: AtomicU64::new(0),
+        }));
+
+        ARENA_LO.fetch_min(base as usize, Ordering::SeqCst);
+        ARENA_HI.fetch_max(base as usize + capacity, Ordering::SeqCst);
+        ARENAS[node].store(arena, Ordering::Release);
+
+        println!(
+            "NUMA node {} arena: {} MB on {} kB pages{}",
+            node,
+            capacity >> 20,
+            page_size / 1024,
+            if hugetlb { "" } else { " (THP)" }
+        );
+
+        Ok(arena)
+    }
+
+    fn map(size: usize, extra_flags: c_int) -> Option<*mut u8> {
+        let memory = unsafe {
+            libc::mmap(
+                null_mut(),
+                size,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_PRIVATE | libc::MAP_ANONYMOUS | extra_flags,
+                -1,
+                0,
+            )
+        };
+        if memory == libc::MAP_FAILED {
+            None
+        } else {
+            Some(memory as *mut u8)
+        }
+    }
+
+    /// Возвращает арену узла `node`, если она создана
+    #[inline]
+    pub fn get(node: usize) -> Option<&'static NodeArena> {
+        let arena = ARENAS.get(node)?.load(Ordering::Acquire);
+        unsafe { arena.as_ref() }
+    }
+
+    /// Возвращает арену, которой принадлежит адрес `ptr`
+    #[inline]
+    pub fn owner_of(ptr: *const u8) -> Option<&'static NodeArena> {
+        let addr = ptr as usize;
+        if addr < ARENA_LO.load(Ordering::Relaxed) || addr >= ARENA_HI.load(Ordering::Relaxed) {
+            return None;
+        }
+        ARENAS
+            .iter()
+            .filter_map(|arena| unsafe { arena.load(Ordering::Acquire).as_ref() })
+            .find(|arena| arena.contains(ptr))
+    }
+
+    /// Принадлежит ли адрес этой арене
+    #[inline]
+    pub fn contains(&self, ptr: *const u8) -> bool {
+        let addr = ptr as usize;
+        addr >= self.base as usize && addr < self.base as usize + self.capacity
+    }
+
+    /// Размер блока арены для `layout`: класс или округленный крупный блок
+    #[inline]
+    fn block_size(layout: &Layout) -> Option<usize> {
+        let size = layout.size().max(layout.align()).max(1 << MIN_CLASS_SHIFT);
+        if layout.align() > LARGE_CHUNK {
+            None
+        } else if size <= 1 << MAX_CLASS_SHIFT {
+            Some(size.next_power_of_two())
+        } else {
+            size.checked_next_multiple_of(LARGE_CHUNK)
+        }
+    }
+
+    #[inline]
+    fn lock(&self) -> &mut ArenaState {
+        while self
+            .lock
+            .compare_exchange_weak(false, true, Ordering::Acquire, Ordering::Relaxed)
+            .is_err()
+        {
+            hint::spin_loop();
+        }
+        unsafe { &mut *self.state.get() }
+    }
+
+    #[inline]
+    fn unlock(&self) {
+        self.lock.store(false, Ordering::Release);
+    }
+
+    /// Выделяет блок под `layout`; null, если арена исчерпана
+    pub fn alloc(&self, layout: Layout) -> *mut u8 {
+        let Some(block) = Self::block_size(&layout) else {
+            return null_mut();
+        };
+
+        let state = self.lock();
+        let memory = if block <= 1 << MAX_CLASS_SHIFT {
+            let class = (block.trailing_zeros() - MIN_CLASS_SHIFT) as usize;
+            let head = state.free[class];
+            if head.is_null() {
+                self.bump(state, block, block)
+            } else {
+                state.free[class] = unsafe { (*head).next };
+                head as *mut u8
+            }
+        } else {
+            let mut link = &mut state.large as *mut *mut LargeBlock;
+            unsafe {
+                while !(*link).is_null() && (**link).size != block {
+                    link = &mut (**link).next;
+                }
+                let found = *link;
+                if found.is_null() {
+                    self.bump(state, block, LARGE_CHUNK)
+                } else {
+                    *link = (*found).next;
+                    found as *mut u8
+                }
+            }
+        };
+        self.unlock();
+
+        if !memory.is_null() {
+            self.live_bytes.fetch_add(block, Ordering::Relaxed);
+        }
+        memory
+    }
+
+    #[inline]
+    fn bump(&self, state: &mut ArenaState, size: usize, align: usize) -> *mut u8 {
+        let start = (self.base as usize + state.bump).next_multiple_of(align);
+        let end = start + size;
+        if end > self.base as usize + self.capacity {
+            return null_mut();
+        }
+        state.bump = end - self.base as usize;
+        self.used.store(state.bump, Ordering::Relaxed);
+        start as *mut u8
+    }
+
+    /// Возвращает блок в арену
+    ///
+    /// # Safety
+    /// `ptr` выделен этой ареной с тем же `layout` (или layout того же класса)
+    pub unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        let Some(block) = Self::block_size(&layout) else {
+            return;
+        };
+
+        let state = self.lock();
+        if block <= 1 << MAX_CLASS_SHIFT {
+            let class = (block.trailing_zeros() - MIN_CLASS_SHIFT) as usize;
+            let freed = ptr as *mut FreeBlock;
+            (*freed).next = state.free[class];
+            state.free[class] = freed;
+        } else {
+            let freed = ptr as *mut LargeBlock;
+            (*freed).next = state.large;
+            (*freed).size = block;
+            state.large = freed;
+        }
+        self.unlock();
+
+        self.live_bytes.fetch_sub(block, Ordering::Relaxed);
+    }
+
+    /// Узел NUMA арены
+    pub fn node(&self) -> usize {
+        self.node
+    }
+
+    /// Размер арены в байтах
+    pub fn capacity(&self) -> usize {
+        self.capacity
+    }
+
+    /// Занятая bump-выделением часть арены в байтах
+    pub fn used(&self) -> usize {
+        self.used.load(Ordering::Relaxed)
+    }
+
+    /// Суммарный размер выделенных и не освобожденных блоков
+    pub fn live_bytes(&self) -> usize {
+        self.live_bytes.load(Ordering::Relaxed)
+    }
+
+    /// Выделения, ушедшие в системную кучу из-за нехватки места
+    pub fn fallbacks(&self) -> u64 {
+        self.fallbacks.load(Ordering::Relaxed)
+    }
+
+    /// Размер страниц арены в байтах
+    pub fn page_size(&self) -> usize {
+        self.page_size
+    }
+
+    /// Отображена ли арена на hugetlbfs страницы
+    pub fn is_hugetlb(&self) -> bool {
+        self.hugetlb
+    }
+}
+
+/// Направляет выделения текущего потока в арену узла до уничтожения
+///
+/// Worker и стадии конвейера входят в арену своего узла на все время
+/// работы; управляющий поток - на время создания обработчиков, чтобы
+/// книги заявок и состояние сессий сразу оказались в памяти узла. Без
+/// арены узла ничего не меняет.
+pub struct ArenaScope {
+    previous: *const NodeArena,
+}
+
+impl ArenaScope {
+    /// Входит в арену узла `node`
+    pub fn enter(node: usize) -> Self {
+        let arena = NodeArena::get(node).map_or(ptr::null(), |arena| arena as *const _);
+        let previous = CURRENT.with(|current| current.replace(arena));
+        Self { previous }
+    }
+}
+
+impl Drop for ArenaScope {
+    fn drop(&mut self) {
+        CURRENT.with(|current| current.set(self.previous));
+    }
+}
+
+/// Глобальный аллокатор, учитывающий арены узлов NUMA
+///
+/// Stable Rust не дает передать аллокатор в `Vec`/`Box`, поэтому арена
+/// подключается как `#[global_allocator]` бинарника: внутри `ArenaScope`
+/// выделения идут в арену узла, вне его и при исчерпании арены - в
+/// `System`. Освобождение определяется адресом блока, так что память
+/// можно отдавать из любого потока.
+pub struct NodeAwareAllocator;
+
+impl NodeAwareAllocator {
+    #[inline(always)]
+    fn current() -> Option<&'static NodeArena> {
+        unsafe { CURRENT.with(|current| current.get()).as_ref() }
+    }
+}
+
+unsafe impl GlobalAlloc for NodeAwareAllocator {
+    #[inline]
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        if let Some(arena) = Self::current() {
+            let memory = arena.alloc(layout);
+            if !memory.is_null() {
+                return memory;
+            }
+            arena.fallbacks.fetch_add(1, Ordering::Relaxed);
+        }
+        System.alloc(layout)
+    }
+
+    #[inline]
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        if let Some(arena) = Self::current() {
+            // Блоки из списков свободных уже использовались
+            let memory = arena.alloc(layout);
+            if !memory.is_null() {
+                ptr::write_bytes(memory, 0, layout.size());
+                return memory;
+            }
+            arena.fallbacks.fetch_add(1, Ordering::Relaxed);
+        }
+        System.alloc_zeroed(layout)
+    }
+
+    #[inline]
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        match NodeArena::owner_of(ptr) {
+            Some(arena) => arena.dealloc(ptr, layout),
+            None => System.dealloc(ptr, layout),
+        }
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        let owner = NodeArena::owner_of(ptr);
+        if owner.is_none() && Self::current().is_none() {
+            return System.realloc(ptr, layout, new_size);
+        }
+
+        let new_layout = Layout::from_size_align_unchecked(new_size, layout.align());
+        if owner.is_some() && NodeArena::block_size(&layout) == NodeArena::block_size(&new_layout) {
+            return ptr;
+        }
+
+        let memory = self.alloc(new_layout);
+        if !memory.is_null() {
+            ptr::copy_nonoverlapping(ptr, memory, layout.size().min(new_size));
+            self.dealloc(ptr, layout);
+        }
+        memory
+    }
+}
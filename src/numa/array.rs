@@ -0,0 +1,116 @@
+// src/numa/array.rs
+use std::alloc::{self, Layout};
+use std::marker::PhantomData;
+use std::ops::{Deref, DerefMut};
+use std::os::raw::c_void;
+use std::ptr::NonNull;
+
+use crate::numa::arena::NodeArena;
+use crate::numa::ffi::NumaAllocator;
+
+/// Массив фиксированной длины в памяти узла NUMA
+///
+/// Как и `PacketArena`, выделяется один раз при создании и заполняется
+/// потоком-владельцем; для структур, растущих на горячем пути (уровни
+/// стакана, пулы заявок), выделение заранее исключает обращения к
+/// аллокатору в цикле обработки.
+pub struct NodeArray<T: Copy> {
+    ptr: NonNull<T>,
+    len: usize,
+    /// NUMA-узел, на котором выделена память (None - обычная куча)
+    numa_node: Option<usize>,
+    _not_sync: PhantomData<*mut T>,
+}
+
+impl<T: Copy> NodeArray<T> {
+    /// Создает массив из `len` копий `fill`, по возможности на узле `numa_node`
+    pub fn new(len: usize, fill: T, numa_node: Option<usize>) -> Self {
+        let len = len.max(1);
+        let layout = Self::layout(len);
+
+        // Арена узла, затем numa_alloc_onnode, затем обычная куча
+        let numa_memory = numa_node
+            .and_then(NodeArena::get)
+            .map(|arena| (arena.alloc(layout) as *mut c_void, arena.node()))
+            .filter(|(memory, _)| !memory.is_null())
+            .or_else(|| {
+                numa_node
+                    .filter(|_| NumaAllocator::is_available())
+                    .map(|node| (NumaAllocator::alloc_on_node(layout.size(), node), node))
+                    .filter(|(memory, _)| !memory.is_null())
+            });
+
+        // Арена выравнивает блок по классу размера, numa_alloc_onnode - по странице
+        let (memory, numa_node) = match numa_memory {
+            Some((memory, node)) => (memory as *mut T, Some(node)),
+            None => (unsafe { alloc::alloc(layout) } as *mut T, None),
+        };
+
+        let ptr = match NonNull::new(memory) {
+            Some(ptr) => ptr,
+            None => alloc::handle_alloc_error(layout),
+        };
+
+        for i in 0..len {
+            unsafe { ptr.as_ptr().add(i).write(fill) };
+        }
+
+        Self {
+            ptr,
+            len,
+            numa_node,
+            _not_sync: PhantomData,
+        }
+    }
+
+    fn layout(len: usize) -> Layout {
+        Layout::array::<T>(len).expect("node array size overflow")
+    }
+
+    /// Заполняет массив значением `value`
+    pub fn fill(&mut self, value: T) {
+        for slot in self.iter_mut() {
+            *slot = value;
+        }
+    }
+
+    /// Возвращает NUMA-узел, на котором выделена память
+    pub fn get_numa_node(&self) -> Option<usize> {
+        self.numa_node
+    }
+}
+
+impl<T: Copy> Deref for NodeArray<T> {
+    type Target = [T];
+
+    #[inline(always)]
+    fn deref(&self) -> &[T] {
+        unsafe { std::slice::from_raw_parts(self.ptr.as_ptr(), self.len) }
+    }
+}
+
+impl<T: Copy> DerefMut for NodeArray<T> {
+    #[inline(always)]
+    fn deref_mut(&mut self) -> &mut [T] {
+        unsafe { std::slice::from_raw_parts_mut(self.ptr.as_ptr(), self.len) }
+    }
+}
+
+impl<T: Copy> Drop for NodeArray<T> {
+    fn drop(&mut self) {
+        let layout = Self::layout(self.len);
+
+        let memory = self.ptr.as_ptr() as *mut u8;
+        if let Some(arena) = NodeArena::owner_of(memory) {
+            unsafe { arena.dealloc(memory, layout) };
+            return;
+        }
+
+        match self.numa_node {
+            Some(_) => NumaAllocator::free(self.ptr.as_ptr() as *mut c_void, layout.size()),
+            None => unsafe { alloc::dealloc(self.ptr.as_ptr() as *mut u8, layout) },
+        }
+    }
+}
+
+unsafe impl<T: Copy + Send> Send for NodeArray<T> {}
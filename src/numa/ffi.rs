@@ -8,11 +8,13 @@ extern "C" {
     pub fn numa_node_to_cpus(node: c_int, mask: *mut c_ulong, size: c_int) -> c_int;
     pub fn numa_alloc_onnode(size: usize, node: c_int) -> *mut c_void;
     pub fn numa_free(start: *mut c_void, size: usize);
+    pub fn numa_tonode_memory(start: *mut c_void, size: usize, node: c_int);
     pub fn numa_run_on_node(node: c_int) -> c_int;
     pub fn numa_bind(nodemask: *const c_ulong);
     pub fn numa_set_localalloc();
     pub fn numa_alloc_local(size: usize) -> *mut c_void;
     pub fn numa_preferred() -> c_int;
+    pub fn numa_node_of_cpu(cpu: c_int) -> c_int;
 }
 
 pub struct NumaAllocator;
@@ -100,6 +102,25 @@ impl NumaAllocator {
         }
     }
 
+    /// Возвращает узел NUMA ядра, на котором выполняется текущий поток
+    pub fn current_node() -> Option<usize> {
+        if !Self::is_available() {
+            return None;
+        }
+
+        let cpu = unsafe { libc::sched_getcpu() };
+        if cpu < 0 {
+            return None;
+        }
+
+        let node = unsafe { numa_node_of_cpu(cpu) };
+        if node >= 0 {
+            Some(node as usize)
+        } else {
+            None
+        }
+    }
+
     /// Возвращает предпочтительный узел NUMA для текущего потока
     pub fn get_preferred_node() -> Option<usize> {
         if Self::is_available() {
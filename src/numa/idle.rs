@@ -0,0 +1,193 @@
+// src/numa/idle.rs
+use crate::control::reconfig::{MAX_CONTROL_LINES, RECONFIG_TIMEOUT};
+use crate::dpdk::ffi;
+use crate::telemetry::worker::PollCounters;
+
+/// Предел сна стратегии `Interrupt`: worker должен успеть забрать запрос
+/// реконфигурации до истечения `RECONFIG_TIMEOUT`
+pub const MAX_INTERRUPT_TIMEOUT_MS: u32 = (RECONFIG_TIMEOUT.as_millis() / 2) as u32;
+
+/// Стратегия ожидания RX worker при пустых опросах очереди
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum IdleStrategy {
+    /// Непрерывный опрос без пауз: минимальная задержка, ядро загружено полностью
+    Spin,
+    /// Опрос с инструкцией pause между пустыми итерациями,
+    /// освобождает ресурсы конвейера для HT-соседа
+    Pause,
+    /// После `spin_polls` пустых опросов число pause между опросами
+    /// удваивается до `max_pauses`; сбрасывается при первом пакете
+    Backoff { spin_polls: u32, max_pauses: u32 },
+    /// После `spin_polls` пустых опросов поток засыпает до RX прерывания
+    /// или `timeout_ms` (не больше `MAX_INTERRUPT_TIMEOUT_MS`); подходит
+    /// для холодных очередей (heartbeat)
+    Interrupt { spin_polls: u32, timeout_ms: u32 },
+}
+
+impl Default for IdleStrategy {
+    fn default() -> Self {
+        IdleStrategy::Spin
+    }
+}
+
+impl IdleStrategy {
+    /// Требует ли стратегия RX прерываний от порта
+    pub fn needs_rx_interrupts(&self) -> bool {
+        matches!(self, IdleStrategy::Interrupt { .. })
+    }
+}
+
+/// Состояние стратегии ожидания очередей одного worker
+pub struct Idler<'a> {
+    strategy: IdleStrategy,
+    /// Все линии worker (порт, очередь)
+    lines: Vec<(u16, u16)>,
+    /// Маска приостановленных линий, см. `set_paused`
+    paused: u64,
+    /// Порты и очереди неприостановленных линий, на RX прерывания которых
+    /// ждет поток
+    port_ids: Vec<u16>,
+    queue_ids: Vec<u16>,
+    empty_streak: u32,
+    pauses: u32,
+    intr_registered: bool,
+    counters: &'a PollCounters,
+}
+
+impl<'a> Idler<'a> {
+    /// Создает состояние ожидания для очередей `lines` (порт, очередь);
+    /// вызывается из потока worker, так как RX прерывания регистрируются в
+    /// epoll текущего потока. Поток засыпает, только если прерывание
+    /// зарегистрировано для каждой линии: иначе трафик линии без прерывания
+    /// ждал бы таймаута.
+    pub fn new(
+        mut strategy: IdleStrategy,
+        lines: &[(u16, u16)],
+        counters: &'a PollCounters,
+    ) -> Self {
+        let mut intr_registered = false;
+
+        if let IdleStrategy::Interrupt { timeout_ms, .. } = &mut strategy {
+            if *timeout_ms > MAX_INTERRUPT_TIMEOUT_MS {
+                eprintln!(
+                    "Interrupt idle timeout {} ms exceeds {} ms, clamped so reconfiguration is not missed",
+                    timeout_ms, MAX_INTERRUPT_TIMEOUT_MS
+                );
+                *timeout_ms = MAX_INTERRUPT_TIMEOUT_MS;
+            }
+        }
+
+        if strategy.needs_rx_interrupts() {
+            intr_registered = !lines.is_empty();
+
+            for &(port_id, queue_id) in lines {
+                let ret = unsafe { ffi::dpdk_rx_intr_register(port_id, queue_id) };
+                if ret != 0 {
+                    eprintln!(
+                        "RX interrupts unavailable for port {}, queue {} (error {}), falling back to backoff",
+                        port_id, queue_id, ret
+                    );
+                    intr_registered = false;
+                    break;
+                }
+            }
+        }
+
+        Self {
+            strategy,
+            lines: lines.to_vec(),
+            paused: 0,
+            port_ids: lines.iter().map(|&(port_id, _)| port_id).collect(),
+            queue_ids: lines.iter().map(|&(_, queue_id)| queue_id).collect(),
+            empty_streak: 0,
+            pauses: 1,
+            intr_registered,
+            counters,
+        }
+    }
+
+    /// Исключает из ожидания прерываний приостановленные линии (маска
+    /// `ControlReceiver::paused_lines`)
+    ///
+    /// Остановленная в NIC очередь не позволяет включить прерывание, а
+    /// приостановленная, но получающая трафик, никогда не бывает пустой:
+    /// с любой из них ожидание возвращалось бы сразу. Вызывается при
+    /// изменении маски; память массивов выделена при создании.
+    pub fn set_paused(&mut self, paused: u64) {
+        self.paused = paused;
+        self.port_ids.clear();
+        self.queue_ids.clear();
+
+        for (line, &(port_id, queue_id)) in self.lines.iter().enumerate() {
+            if line < MAX_CONTROL_LINES && paused & (1 << line) != 0 {
+                continue;
+            }
+            self.port_ids.push(port_id);
+            self.queue_ids.push(queue_id);
+        }
+    }
+
+    /// Маска приостановленных линий, переданная в `set_paused`
+    #[inline(always)]
+    pub fn paused(&self) -> u64 {
+        self.paused
+    }
+
+    /// Вызывается после опроса, вернувшего пакеты
+    #[inline(always)]
+    pub fn on_busy(&mut self) {
+        self.counters.busy_polls.inc();
+        self.empty_streak = 0;
+        self.pauses = 1;
+    }
+
+    /// Вызывается после пустого опроса
+    #[inline(always)]
+    pub fn on_idle(&mut self) {
+        self.counters.empty_polls.inc();
+
+        match self.strategy {
+            IdleStrategy::Spin => {}
+            IdleStrategy::Pause => std::hint::spin_loop(),
+            IdleStrategy::Backoff {
+                spin_polls,
+                max_pauses,
+            } => self.backoff(spin_polls, max_pauses),
+            IdleStrategy::Interrupt {
+                spin_polls,
+                timeout_ms,
+            } => {
+                // Без линий, на которых можно ждать прерывания, - backoff
+                if !self.intr_registered || self.port_ids.is_empty() {
+                    self.backoff(spin_polls, 1024);
+                } else if self.empty_streak >= spin_polls {
+                    unsafe {
+                        ffi::dpdk_rx_intr_wait(
+                            self.port_ids.as_ptr(),
+                            self.queue_ids.as_ptr(),
+                            self.port_ids.len() as u16,
+                            timeout_ms as i32,
+                        )
+                    };
+                    self.empty_streak = 0;
+                } else {
+                    self.empty_streak += 1;
+                    std::hint::spin_loop();
+                }
+            }
+        }
+    }
+
+    #[inline(always)]
+    fn backoff(&mut self, spin_polls: u32, max_pauses: u32) {
+        if self.empty_streak < spin_polls {
+            self.empty_streak += 1;
+            return;
+        }
+
+        for _ in 0..self.pauses {
+            std::hint::spin_loop();
+        }
+        self.pauses = (self.pauses << 1).min(max_pauses.max(1));
+    }
+}
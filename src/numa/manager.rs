@@ -1,12 +1,37 @@
 // src/numa/manager.rs
+use core_affinity::CoreId;
 use std::collections::HashMap;
+use std::sync::Arc;
 
+use crate::capture::replay::ReplayFile;
+use crate::capture::tap::CaptureThread;
+use crate::control::igmp::{IgmpAgent, IgmpPortConfig, IgmpThread};
+use crate::control::reconfig::ControlHandle;
+use crate::cpu::placement::PlacementPlanner;
 use crate::cpu::topology::CpuTopology;
 use crate::dpdk::config::DpdkConfig;
-use crate::dpdk::init::{configure_port_for_node, enumerate_dpdk_ports, init_dpdk_for_node};
+use crate::dpdk::ffi;
+use crate::dpdk::flow::{install_port_flows, FlowRule, FlowRuleId};
+use crate::dpdk::init::{
+    configure_port_for_node, enumerate_dpdk_ports, init_eal, init_eal_with_args,
+    is_eal_initialized, EalPlan,
+};
+use crate::dpdk::mempool::{plan_port_pools, MbufPoolPlan};
+use crate::numa::arena::{ArenaConfig, ArenaScope, NodeArena};
 use crate::numa::ffi::NumaAllocator;
 use crate::numa::node::NumaNode;
 use crate::numa::topology::NumaTopology;
+use crate::packet::handler::BurstHandler;
+use crate::packet::timestamp::tsc_hz;
+use crate::pipeline::arbiter::{ArbitrationConfig, FeedSequence, GapRequest};
+use crate::pipeline::ring::Consumer;
+use crate::pipeline::stage::{Decoder, PipelineConfig, Strategy};
+use crate::plan::{config_hash, system_fingerprint, StartupPlan};
+use crate::telemetry::port::PortStats;
+use crate::telemetry::worker::WorkerTelemetry;
+use crate::tx::queue::{TxQueueClaim, TX_QUEUE_AUTO};
+use crate::tx::session::{TxSession, TxSessionConfig};
+use crate::tx::tcp::{TcpConfig, TcpSession};
 
 /// Управляет созданием и инициализацией изолированных узлов NUMA
 pub struct NumaManager {
@@ -18,6 +43,21 @@ pub struct NumaManager {
     nodes: HashMap<usize, NumaNode>,
     /// Признак, что NUMA доступна
     numa_available: bool,
+    /// Поток IGMP агента, если заданы мультикаст-группы
+    igmp: Option<IgmpThread>,
+    /// Поток записи захваченного трафика; объявлен после `nodes`, чтобы при
+    /// уничтожении менеджера останавливаться после RX worker
+    capture: Option<CaptureThread>,
+    /// Запись, воспроизводимая вместо приема с порта
+    replay: Option<Arc<ReplayFile>>,
+    /// Идентификатор следующего правила, добавляемого на ходу
+    next_flow_rule: u64,
+    /// RX очереди, остановленные в NIC через `stop_rx_queue`
+    stopped_queues: Vec<(u16, u16)>,
+    /// Аргументы EAL из сохраненного плана запуска
+    planned_eal_args: Option<Vec<String>>,
+    /// Пулы mbuf портов из загруженного плана запуска
+    planned_pools: Option<Vec<(u16, MbufPoolPlan)>>,
 }
 
 impl NumaManager {
@@ -38,9 +78,92 @@ impl NumaManager {
             numa_topology,
             nodes: HashMap::new(),
             numa_available,
+            igmp: None,
+            capture: None,
+            replay: None,
+            next_flow_rule: 0,
+            stopped_queues: Vec::new(),
+            planned_eal_args: None,
+            planned_pools: None,
         })
     }
 
+    /// Создает менеджер с узлами по сохраненному плану запуска, без обхода
+    /// sysfs; заменяет пару `new` + `init_nodes`
+    ///
+    /// План должен быть проверен `StartupPlan::validate`.
+    pub fn from_plan(plan: &StartupPlan) -> Self {
+        let numa_available = NumaAllocator::is_available();
+        println!(
+            "Using startup plan: {} NUMA nodes, NUMA support available: {}",
+            plan.node_count(),
+            numa_available
+        );
+
+        let nodes = plan
+            .node_cores
+            .iter()
+            .map(|(node_id, cores)| {
+                let cores = cores.iter().map(|&id| CoreId { id }).collect();
+                (*node_id, NumaNode::with_cores(*node_id, cores))
+            })
+            .collect();
+
+        Self {
+            cpu_topology: plan.cpu_topology.clone(),
+            numa_topology: plan.numa_topology.clone(),
+            nodes,
+            numa_available,
+            igmp: None,
+            capture: None,
+            replay: None,
+            next_flow_rule: 0,
+            stopped_queues: Vec::new(),
+            planned_eal_args: Some(plan.eal_args.clone()),
+            planned_pools: Some(plan.pools.clone()),
+        }
+    }
+
+    /// Собирает план запуска из разрешенной конфигурации
+    ///
+    /// Вызывается после `init_dpdk`: к этому моменту EAL и порты проверены
+    /// на реальной системе, а сокеты портов известны.
+    pub fn startup_plan(&self, dpdk_config: &DpdkConfig) -> StartupPlan {
+        let mut node_ids: Vec<usize> = self.nodes.keys().copied().collect();
+        node_ids.sort_unstable();
+
+        let eal_args = match &self.planned_eal_args {
+            Some(args) => args.clone(),
+            None => EalPlan::from_nodes(node_ids.iter().map(|id| &self.nodes[id]), dpdk_config)
+                .to_args(dpdk_config),
+        };
+
+        let mut pools = Vec::new();
+        for node_id in &node_ids {
+            let node = &self.nodes[node_id];
+            for port in &node.local_ports {
+                pools.extend(
+                    node_port_pools(node, port.port_id, dpdk_config)
+                        .into_iter()
+                        .map(|pool| (port.port_id, pool)),
+                );
+            }
+        }
+
+        StartupPlan {
+            fingerprint: system_fingerprint(),
+            config_hash: config_hash(dpdk_config),
+            cpu_topology: self.cpu_topology.clone(),
+            numa_topology: self.numa_topology.clone(),
+            node_cores: node_ids
+                .iter()
+                .map(|id| (*id, self.nodes[id].local_cpus.iter().map(|c| c.id).collect()))
+                .collect(),
+            eal_args,
+            pools,
+        }
+    }
+
     /// Инициализирует необходимое количество NUMA-узлов
     pub fn init_nodes(&mut self) -> Result<(), String> {
         let node_count = if self.numa_available {
@@ -61,6 +184,29 @@ impl NumaManager {
         Ok(())
     }
 
+    /// Создает арены huge pages на всех узлах NUMA
+    ///
+    /// Вызывается до запуска worker: выделения потоков узла (дескрипторы
+    /// пакетов, книги заявок, кольца, состояние сессий) идут в его арену.
+    /// Вызывается после `init_eal`: страницы арен не входят в `--socket-mem`
+    /// и берутся из оставшегося пула узла, а при его нехватке арена
+    /// переходит на прозрачные huge pages.
+    pub fn init_node_arenas(&mut self, config: &ArenaConfig) -> Result<(), String> {
+        if !config.is_enabled() {
+            return Ok(());
+        }
+
+        let mut node_ids: Vec<usize> = self.nodes.keys().copied().collect();
+        node_ids.sort_unstable();
+
+        for node_id in node_ids {
+            if NodeArena::get(node_id).is_none() {
+                NodeArena::create(node_id, config.size_mb << 20, config.page_size)?;
+            }
+        }
+        Ok(())
+    }
+
     /// Распределяет сетевые интерфейсы по NUMA-узлам
     pub fn distribute_interfaces(&mut self, dpdk_config: &DpdkConfig) -> Result<(), String> {
         let ports = enumerate_dpdk_ports();
@@ -89,21 +235,49 @@ impl NumaManager {
         Ok(())
     }
 
-    /// Инициализирует DPDK для всех NUMA-узлов
-    pub fn init_dpdk(&mut self, dpdk_config: &DpdkConfig) -> Result<(), String> {
-        for (node_id, node) in &mut self.nodes {
-            let mut node_args = vec![];
+    /// Инициализирует DPDK EAL один раз для всех узлов NUMA
+    ///
+    /// Должен вызываться до `distribute_interfaces`: порты DPDK видны только
+    /// после инициализации EAL.
+    pub fn init_eal(&mut self, dpdk_config: &DpdkConfig) -> Result<(), String> {
+        if is_eal_initialized() {
+            return Ok(());
+        }
 
-            if self.numa_available {
-                node_args.push(format!("--socket-id={}", node_id));
-            }
+        if let Some(args) = &self.planned_eal_args {
+            return init_eal_with_args(args, dpdk_config);
+        }
 
-            println!("Initializing DPDK for NUMA node {}", node_id);
+        let mut node_ids: Vec<usize> = self.nodes.keys().copied().collect();
+        node_ids.sort_unstable();
 
-            init_dpdk_for_node(node, dpdk_config, &node_args)?;
+        let plan = EalPlan::from_nodes(node_ids.iter().map(|id| &self.nodes[id]), dpdk_config);
 
-            for port in &node.local_ports {
-                configure_port_for_node(node, port.port_id, dpdk_config)?;
+        println!(
+            "EAL plan: main lcore {}, {} worker lcores on {} NUMA nodes",
+            plan.main_lcore,
+            plan.worker_lcores.len(),
+            node_ids.len()
+        );
+
+        init_eal(&plan, dpdk_config)
+    }
+
+    /// Конфигурирует порты DPDK на всех NUMA-узлах
+    pub fn init_dpdk(&mut self, dpdk_config: &DpdkConfig) -> Result<(), String> {
+        self.init_eal(dpdk_config)?;
+
+        for (node_id, node) in &mut self.nodes {
+            println!("Configuring DPDK ports for NUMA node {}", node_id);
+
+            for i in 0..node.local_ports.len() {
+                let port_id = node.local_ports[i].port_id;
+                if let Some(planned) = &self.planned_pools {
+                    check_planned_pools(planned, node, port_id, dpdk_config)?;
+                }
+                let mbuf_pool = configure_port_for_node(node, port_id, dpdk_config)?;
+                node.local_ports[i].mbuf_pool = mbuf_pool;
+                node.local_ports[i].flows = install_port_flows(port_id, dpdk_config)?;
             }
         }
 
@@ -111,30 +285,640 @@ impl NumaManager {
     }
 
     /// Запускает обработку пакетов на всех узлах NUMA
-    pub fn start_packet_processing(
+    pub fn start_packet_processing<H: BurstHandler + Clone>(
         &mut self,
-        packet_handler: crate::numa::node::PacketHandler,
+        packet_handler: H,
         dpdk_config: &DpdkConfig,
     ) -> Result<(), String> {
         println!("Starting packet processing on all NUMA nodes");
 
+        self.open_replay(dpdk_config)?;
+        let planner = PlacementPlanner::new(&self.cpu_topology, &self.numa_topology);
+
         for (node_id, node) in &mut self.nodes {
             println!("Starting workers on NUMA node {}", node_id);
 
-            node.start_workers(packet_handler.clone(), dpdk_config.burst_size)?;
+            node.start_workers(packet_handler.clone(), dpdk_config, &planner)?;
+        }
+
+        self.start_capture(dpdk_config)
+    }
+
+    /// Запускает конвейерный режим на всех узлах NUMA: RX worker передают
+    /// пакеты ядрам декодирования, те - события ядрам стратегии
+    pub fn start_pipeline<D, S>(
+        &mut self,
+        decoder: D,
+        strategy: S,
+        pipeline: &PipelineConfig,
+        dpdk_config: &DpdkConfig,
+    ) -> Result<(), String>
+    where
+        D: Decoder + Clone,
+        S: Strategy<Event = D::Event> + Clone,
+    {
+        println!("Starting pipeline on all NUMA nodes");
+
+        self.open_replay(dpdk_config)?;
+        let planner = PlacementPlanner::new(&self.cpu_topology, &self.numa_topology);
+
+        for (node_id, node) in &mut self.nodes {
+            if node.local_ports.is_empty() {
+                println!("No ports on NUMA node {}, pipeline not started", node_id);
+                continue;
+            }
+
+            node.start_pipeline(
+                decoder.clone(),
+                strategy.clone(),
+                pipeline,
+                dpdk_config,
+                &planner,
+            )?;
         }
 
+        self.start_capture(dpdk_config)
+    }
+
+    /// Запускает арбитраж линий A/B на узле, которому принадлежат порты линий
+    pub fn start_arbitrated_feed<H, S>(
+        &mut self,
+        arbitration: &ArbitrationConfig,
+        sequence: S,
+        packet_handler: H,
+        dpdk_config: &DpdkConfig,
+    ) -> Result<Consumer<GapRequest>, String>
+    where
+        H: BurstHandler,
+        S: FeedSequence,
+    {
+        self.open_replay(dpdk_config)?;
+        let planner = PlacementPlanner::new(&self.cpu_topology, &self.numa_topology);
+        let port_id = arbitration.line_a.0;
+
+        let node = self
+            .nodes
+            .values_mut()
+            .find(|node| node.local_ports.iter().any(|port| port.port_id == port_id))
+            .ok_or_else(|| format!("Port {} is not registered on any NUMA node", port_id))?;
+
+        let recovery = node.start_arbitrated_feed(
+            arbitration,
+            sequence,
+            packet_handler,
+            dpdk_config,
+            &planner,
+        )?;
+        self.start_capture(dpdk_config)?;
+
+        Ok(recovery)
+    }
+
+    /// Отображает файл воспроизведения и передает его узлам
+    ///
+    /// Файл открывается один раз; RX worker, запущенные на порту
+    /// воспроизведения, читают его вместо `rte_eth_rx_burst`.
+    fn open_replay(&mut self, dpdk_config: &DpdkConfig) -> Result<(), String> {
+        if !dpdk_config.replay.is_enabled() || self.replay.is_some() {
+            return Ok(());
+        }
+
+        let port_id = dpdk_config.replay.port_id;
+        let node = self
+            .nodes
+            .values_mut()
+            .find(|node| node.local_ports.iter().any(|port| port.port_id == port_id))
+            .ok_or_else(|| format!("Replay port {} is not registered", port_id))?;
+
+        let replay = ReplayFile::open(&dpdk_config.replay, dpdk_config.num_rx_queues)?;
+        node.replay = Some(replay.clone());
+        self.replay = Some(replay);
+        Ok(())
+    }
+
+    /// Проверяет, воспроизведена ли запись до конца всеми RX очередями
+    ///
+    /// Без воспроизведения всегда false.
+    pub fn replay_finished(&self) -> bool {
+        self.replay.as_ref().map_or(false, |replay| replay.is_finished())
+    }
+
+    /// Передает потоку записи кольца точек захвата запущенных RX worker
+    ///
+    /// Поток запускается при первом вызове; RX пути, запущенные позже,
+    /// пишут в тот же файл.
+    fn start_capture(&mut self, dpdk_config: &DpdkConfig) -> Result<(), String> {
+        let sources: Vec<_> = self
+            .nodes
+            .values_mut()
+            .flat_map(|node| std::mem::take(&mut node.capture_sources))
+            .collect();
+        if sources.is_empty() {
+            return Ok(());
+        }
+
+        if self.capture.is_none() {
+            let mut ports: Vec<u16> = self
+                .nodes
+                .values()
+                .flat_map(|node| node.local_ports.iter())
+                .map(|port| port.port_id)
+                .collect();
+            ports.sort_unstable();
+            self.capture = Some(CaptureThread::spawn(&dpdk_config.capture, &ports)?);
+        }
+
+        if let Some(capture) = self.capture.as_mut() {
+            capture.attach(sources);
+        }
+        Ok(())
+    }
+
+    /// Подписывает порты на мультикаст-группы из конфигурации
+    ///
+    /// Вызывается после `init_dpdk`: агенту нужны служебные очереди и пулы
+    /// портов. Без групп ничего не делает.
+    pub fn start_igmp(&mut self, dpdk_config: &DpdkConfig) -> Result<(), String> {
+        if dpdk_config.control_queues() == 0 || self.igmp.is_some() {
+            return Ok(());
+        }
+
+        let ports: Vec<IgmpPortConfig> = self
+            .nodes
+            .values()
+            .flat_map(|node| node.local_ports.iter())
+            .map(|port| IgmpPortConfig {
+                port_id: port.port_id,
+                rx_queue: port.num_rx_queues,
+                tx_queue: port.num_tx_queues,
+                mbuf_pool: port.mbuf_pool,
+            })
+            .collect();
+
+        let agent = IgmpAgent::new(&dpdk_config.multicast, &ports)?;
+        println!(
+            "Starting IGMP{:?} agent for {} multicast groups",
+            dpdk_config.multicast.version,
+            dpdk_config.multicast.groups.len()
+        );
+        self.igmp = Some(agent.spawn());
+
         Ok(())
     }
 
+    /// Закрепляет рабочую TX очередь порта за новой сессией
+    ///
+    /// Возвращает пул порта, право на очередь и адресацию с фактическим
+    /// номером очереди (при `TX_QUEUE_AUTO` - первой свободной).
+    fn claim_tx_queue(
+        &self,
+        session_config: &TxSessionConfig,
+    ) -> Result<(*mut ffi::RteMempool, TxQueueClaim, TxSessionConfig), String> {
+        let port = self
+            .nodes
+            .values()
+            .flat_map(|node| node.local_ports.iter())
+            .find(|port| port.port_id == session_config.port_id)
+            .ok_or_else(|| format!("Port {} not registered", session_config.port_id))?;
+
+        let claim = match session_config.queue_id {
+            TX_QUEUE_AUTO => port.tx_queues.claim_free()?,
+            queue_id => port.tx_queues.claim(queue_id)?,
+        };
+
+        let config = TxSessionConfig {
+            queue_id: claim.queue_id(),
+            ..session_config.clone()
+        };
+        Ok((port.mbuf_pool, claim, config))
+    }
+
+    /// Создает TX сессию на сконфигурированном порту
+    ///
+    /// Сессия единолично владеет своей TX очередью до уничтожения: вторая
+    /// сессия на той же очереди получает ошибку (кроме `TxSession::sibling`).
+    pub fn create_tx_session(
+        &self,
+        session_config: &TxSessionConfig,
+        dpdk_config: &DpdkConfig,
+    ) -> Result<TxSession, String> {
+        let (mbuf_pool, claim, config) = self.claim_tx_queue(session_config)?;
+
+        let mut session = TxSession::new(&config, mbuf_pool, dpdk_config)?;
+        session.bind_queue(claim);
+        Ok(session)
+    }
+
+    /// Создает TCP сессию ввода ордеров на сконфигурированном порту
+    ///
+    /// Ответы биржи должны попадать в RX очередь ядра, которое опрашивает
+    /// сессию: обычно правилом `with_flow_steering` по локальному TCP порту.
+    pub fn create_tcp_session(
+        &self,
+        tcp_config: &TcpConfig,
+        dpdk_config: &DpdkConfig,
+    ) -> Result<TcpSession, String> {
+        let (mbuf_pool, claim, session) = self.claim_tx_queue(&tcp_config.session)?;
+        let tcp_config = TcpConfig {
+            session,
+            ..tcp_config.clone()
+        };
+
+        let mut tcp = TcpSession::new(&tcp_config, mbuf_pool, dpdk_config)?;
+        tcp.bind_queue(claim);
+        Ok(tcp)
+    }
+
     /// Останавливает обработку пакетов на всех узлах NUMA
     pub fn stop_packet_processing(&mut self) {
         println!("Stopping packet processing on all NUMA nodes");
 
+        // Leave отправляется до остановки worker, пока порты еще работают
+        if let Some(mut igmp) = self.igmp.take() {
+            igmp.stop();
+        }
+
         for (node_id, node) in &mut self.nodes {
             println!("Stopping workers on NUMA node {}", node_id);
             node.stop_workers();
         }
+
+        // Поток записи освобождает mbuf, переданные worker, поэтому
+        // останавливается последним
+        if let Some(mut capture) = self.capture.take() {
+            capture.stop();
+        }
+
+        // Порты возвращаются к исходной конфигурации очередей
+        for (port_id, queue_id) in self.stopped_queues.drain(..) {
+            unsafe { ffi::rte_eth_dev_rx_queue_start(port_id, queue_id) };
+        }
+    }
+
+    /// Находит канал управления worker, опрашивающего RX очередь: (узел,
+    /// канал, индекс линии в worker)
+    fn line_control(
+        &self,
+        port_id: u16,
+        queue_id: u16,
+    ) -> Result<(usize, ControlHandle, usize), String> {
+        let (node_id, worker, line) = self
+            .nodes
+            .iter()
+            .find_map(|(&node_id, node)| {
+                node.workers.iter().find_map(|worker| {
+                    let line = worker
+                        .lines
+                        .iter()
+                        .position(|&line| line == (port_id, queue_id))?;
+                    Some((node_id, worker, line))
+                })
+            })
+            .ok_or_else(|| format!("No worker polls RX queue {}:{}", port_id, queue_id))?;
+
+        let control = worker
+            .control
+            .clone()
+            .ok_or_else(|| format!("Worker for {}:{} has no control channel", port_id, queue_id))?;
+        Ok((node_id, control, line))
+    }
+
+    /// Заменяет обработчик работающего RX worker очереди `queue_id` порта
+    /// `port_id`
+    ///
+    /// Worker подхватывает обработчик между burst, остальные worker не
+    /// останавливаются, а EAL, порты и подписки на фиды остаются как есть.
+    /// Тип `H` должен совпадать с типом, переданным в
+    /// `start_packet_processing`; старый обработчик уничтожается здесь.
+    /// У арбитрируемого фида `H` - тип обработчика внутри `LineArbiter`:
+    /// заменяется только он, а номера, разрывы и кольцо восстановления
+    /// арбитра сохраняются.
+    pub fn swap_handler<H: BurstHandler>(
+        &mut self,
+        port_id: u16,
+        queue_id: u16,
+        handler: H,
+    ) -> Result<(), String> {
+        let (node_id, control, _) = self.line_control(port_id, queue_id)?;
+
+        let _arena = ArenaScope::enter(node_id);
+        control.swap(handler)?;
+
+        println!("Handler of RX queue {}:{} replaced", port_id, queue_id);
+        Ok(())
+    }
+
+    /// Заменяет стратегию работающей стадии конвейера `index` на узле `node_id`
+    pub fn swap_strategy<S: Strategy>(
+        &mut self,
+        node_id: usize,
+        index: u16,
+        strategy: S,
+    ) -> Result<(), String> {
+        let node = self
+            .nodes
+            .get(&node_id)
+            .ok_or_else(|| format!("NUMA node {} not found", node_id))?;
+        let control = node
+            .workers
+            .iter()
+            .find(|worker| worker.telemetry.role == "strategy" && worker.queue_id == index)
+            .and_then(|worker| worker.control.as_ref())
+            .ok_or_else(|| format!("No strategy stage {} on NUMA node {}", index, node_id))?;
+
+        let _arena = ArenaScope::enter(node_id);
+        control.swap(strategy)?;
+
+        println!("Strategy {} on NUMA node {} replaced", index, node_id);
+        Ok(())
+    }
+
+    /// Добавляет правило rte_flow на работающие порты (все, если
+    /// `rule.port_id` не задан)
+    ///
+    /// При ошибке на одном из портов правило удаляется со всех.
+    pub fn add_flow_rule(&mut self, rule: FlowRule) -> Result<FlowRuleId, String> {
+        let id = FlowRuleId(self.next_flow_rule);
+        self.next_flow_rule += 1;
+
+        let mut installed = 0;
+        let mut result = Ok(());
+        for port in self
+            .nodes
+            .values_mut()
+            .flat_map(|node| node.local_ports.iter_mut())
+            .filter(|port| rule.port_id.map_or(true, |p| p == port.port_id))
+        {
+            if let Err(e) = port.flows.add_rule(id, &rule, port.num_rx_queues) {
+                result = Err(e);
+                break;
+            }
+            println!(
+                "  Port {}: flow {:?} -> {:?} added",
+                port.port_id, rule.matcher, rule.action
+            );
+            installed += 1;
+        }
+
+        if result.is_ok() && installed == 0 {
+            result = Err(format!("Flow rule {:?}: no matching ports", rule.matcher));
+        }
+
+        if let Err(e) = result {
+            for port in self
+                .nodes
+                .values_mut()
+                .flat_map(|node| node.local_ports.iter_mut())
+            {
+                port.flows.remove_rule(id);
+            }
+            return Err(e);
+        }
+
+        Ok(id)
+    }
+
+    /// Удаляет правило, добавленное `add_flow_rule`, со всех портов
+    pub fn remove_flow_rule(&mut self, id: FlowRuleId) -> Result<(), String> {
+        let mut removed = false;
+        for port in self
+            .nodes
+            .values_mut()
+            .flat_map(|node| node.local_ports.iter_mut())
+        {
+            if port.flows.remove_rule(id) {
+                println!("  Port {}: flow rule {} removed", port.port_id, id.0);
+                removed = true;
+            }
+        }
+
+        if removed {
+            Ok(())
+        } else {
+            Err(format!("Flow rule {} not found", id.0))
+        }
+    }
+
+    /// Останавливает одну RX очередь, не трогая остальные очереди порта
+    ///
+    /// Worker прекращает опрос очереди, затем очередь останавливается в NIC.
+    /// Если драйвер не умеет останавливать очереди на работающем порту,
+    /// очередь остается запущенной, но не опрашивается.
+    pub fn stop_rx_queue(&mut self, port_id: u16, queue_id: u16) -> Result<(), String> {
+        let (_, control, line) = self.line_control(port_id, queue_id)?;
+
+        control.pause_line(line)?;
+
+        let ret = unsafe { ffi::rte_eth_dev_rx_queue_stop(port_id, queue_id) };
+        if ret == 0 {
+            if !self.stopped_queues.contains(&(port_id, queue_id)) {
+                self.stopped_queues.push((port_id, queue_id));
+            }
+        } else {
+            eprintln!(
+                "Warning: port {} cannot stop RX queue {} at runtime ({}), queue is only unpolled",
+                port_id, queue_id, ret
+            );
+        }
+
+        println!("RX queue {}:{} stopped", port_id, queue_id);
+        Ok(())
+    }
+
+    /// Запускает RX очередь, остановленную `stop_rx_queue`
+    pub fn start_rx_queue(&mut self, port_id: u16, queue_id: u16) -> Result<(), String> {
+        let (_, control, line) = self.line_control(port_id, queue_id)?;
+
+        if let Some(pos) = self
+            .stopped_queues
+            .iter()
+            .position(|&queue| queue == (port_id, queue_id))
+        {
+            let ret = unsafe { ffi::rte_eth_dev_rx_queue_start(port_id, queue_id) };
+            if ret != 0 {
+                return Err(format!(
+                    "Failed to start RX queue {} on port {}: {}",
+                    queue_id, port_id, ret
+                ));
+            }
+            self.stopped_queues.swap_remove(pos);
+        }
+
+        control.resume_line(line)?;
+
+        println!("RX queue {}:{} started", port_id, queue_id);
+        Ok(())
+    }
+
+    /// Возвращает телеметрию всех запущенных worker
+    ///
+    /// Счетчики только читаются, поэтому вызов можно выполнять из любого
+    /// потока, не мешая RX циклам.
+    pub fn worker_telemetry(&self) -> Vec<Arc<WorkerTelemetry>> {
+        self.nodes
+            .values()
+            .flat_map(|node| node.workers.iter())
+            .map(|worker| worker.telemetry.clone())
+            .collect()
+    }
+
+    /// Читает статистику драйвера для всех зарегистрированных портов
+    pub fn port_stats(&self) -> Vec<PortStats> {
+        self.nodes
+            .values()
+            .flat_map(|node| node.local_ports.iter())
+            .filter_map(|port| match PortStats::read(port.port_id) {
+                Ok(stats) => Some(stats),
+                Err(e) => {
+                    eprintln!("{}", e);
+                    None
+                }
+            })
+            .collect()
+    }
+
+    /// Выводит сводку счетчиков worker и портов
+    pub fn print_telemetry(&self) {
+        for stats in self.port_stats() {
+            println!(
+                "Port {}: rx {} pkts / {} bytes, missed {}, rx_nombuf {}, ierrors {}, tx {} pkts, oerrors {}",
+                stats.port_id,
+                stats.ipackets,
+                stats.ibytes,
+                stats.imissed,
+                stats.rx_nombuf,
+                stats.ierrors,
+                stats.opackets,
+                stats.oerrors
+            );
+        }
+
+        let hz = tsc_hz();
+
+        for telemetry in self.worker_telemetry() {
+            let snapshot = telemetry.snapshot();
+            if snapshot.role != "rx" {
+                println!(
+                    "  Stage {} {} (core {}): in {}, out {}, dropped {}, idle {:.1}%",
+                    snapshot.role,
+                    snapshot.queue_id,
+                    snapshot.core_id,
+                    snapshot.rx_packets,
+                    snapshot.rx_delivered,
+                    snapshot.rx_filtered,
+                    snapshot.idle_ratio() * 100.0
+                );
+                continue;
+            }
+
+            println!(
+                "  Port {} queue {} (core {}): rx {} pkts / {} bytes, delivered {}, filtered {}, parse errors {:?}, mean burst {:.1}, idle {:.1}%",
+                snapshot.port_id,
+                snapshot.queue_id,
+                snapshot.core_id,
+                snapshot.rx_packets,
+                snapshot.rx_bytes,
+                snapshot.rx_delivered,
+                snapshot.rx_filtered,
+                &snapshot.parse_errors[2..6],
+                snapshot.mean_burst_size(),
+                snapshot.idle_ratio() * 100.0
+            );
+
+            if snapshot.latency.count > 0 {
+                let latency = snapshot.latency.to_ns(hz);
+                println!(
+                    "    latency ns: p50 {}, p99 {}, p99.9 {}, max {}",
+                    latency.p50, latency.p99, latency.p999, latency.max
+                );
+            }
+        }
+
+        for link in self
+            .nodes
+            .values()
+            .flat_map(|node| node.pipeline_links.iter())
+        {
+            println!(
+                "  Ring {} -> {} ({} slots): enqueued {}, dropped {}, stalls {}",
+                link.from,
+                link.to,
+                link.capacity,
+                link.stats.enqueued.get(),
+                link.stats.dropped.get(),
+                link.stats.stalls.get()
+            );
+        }
+
+        for feed in self.nodes.values().flat_map(|node| node.arbiters.iter()) {
+            let stats = &feed.stats;
+            println!(
+                "  Feed {}:{} / {}:{}: forwarded {}, duplicates {}, gap fills {}, \
+                 partial overlaps {}, heartbeats {}, unsequenced {}, gaps {} ({} seqs), \
+                 recovery dropped {}",
+                feed.line_a.0,
+                feed.line_a.1,
+                feed.line_b.0,
+                feed.line_b.1,
+                stats.forwarded.get(),
+                stats.duplicates.get(),
+                stats.gap_fills.get(),
+                stats.partial_overlaps.get(),
+                stats.heartbeats.get(),
+                stats.unsequenced.get(),
+                stats.gaps_escalated.get(),
+                stats.gap_sequences.get(),
+                stats.recovery_dropped.get()
+            );
+        }
+
+        if let Some(igmp) = &self.igmp {
+            let c = &igmp.counters;
+            println!(
+                "  IGMP: queries {}, reports {}, leaves {}, tx failures {}, malformed {}",
+                c.queries.get(),
+                c.reports_sent.get(),
+                c.leaves_sent.get(),
+                c.tx_failures.get(),
+                c.malformed.get()
+            );
+        }
+
+        let mut node_ids: Vec<usize> = self.nodes.keys().copied().collect();
+        node_ids.sort_unstable();
+        for arena in node_ids.into_iter().filter_map(NodeArena::get) {
+            println!(
+                "  Arena node {}: used {} / {} MB, live {} bytes, fallbacks {}",
+                arena.node(),
+                arena.used() >> 20,
+                arena.capacity() >> 20,
+                arena.live_bytes(),
+                arena.fallbacks()
+            );
+        }
+
+        if let Some(replay) = &self.replay {
+            let (packets, bytes, alloc_failures) = replay.totals();
+            println!(
+                "  Replay: {} pkts / {} bytes, alloc failures {}, finished {}",
+                packets,
+                bytes,
+                alloc_failures,
+                replay.is_finished()
+            );
+        }
+
+        if let Some(capture) = &self.capture {
+            let c = &capture.counters;
+            println!(
+                "  Capture: captured {}, ring overflow {}, written {} pkts / {} bytes, write errors {}",
+                capture.captured(),
+                capture.dropped(),
+                c.written.get(),
+                c.bytes.get(),
+                c.write_errors.get()
+            );
+        }
     }
 
     /// Выводит информацию о топологии NUMA
@@ -192,3 +976,40 @@ impl Drop for NumaManager {
         self.stop_packet_processing();
     }
 }
+
+/// Пулы mbuf порта `port_id` узла `node`, как их создает
+/// `configure_port_for_node`: ядра узла и управляющее ядро
+fn node_port_pools(node: &NumaNode, port_id: u16, dpdk_config: &DpdkConfig) -> Vec<MbufPoolPlan> {
+    let lcores = node.local_cpus.len() as u32 + 1;
+    let socket_id = unsafe { ffi::rte_eth_dev_socket_id(port_id) }.max(-1);
+    plan_port_pools(port_id, socket_id, dpdk_config, lcores)
+}
+
+/// Сверяет пулы порта, которые будут созданы, с пулами плана запуска
+///
+/// Размер пулов зависит и от числа ядер узла, которое не входит в хеш
+/// конфигурации, поэтому устаревший план обнаруживается здесь, до
+/// создания пулов.
+fn check_planned_pools(
+    planned: &[(u16, MbufPoolPlan)],
+    node: &NumaNode,
+    port_id: u16,
+    dpdk_config: &DpdkConfig,
+) -> Result<(), String> {
+    let expected: Vec<&MbufPoolPlan> = planned
+        .iter()
+        .filter(|(port, _)| *port == port_id)
+        .map(|(_, pool)| pool)
+        .collect();
+    let actual = node_port_pools(node, port_id, dpdk_config);
+
+    if expected.len() != actual.len() || expected.iter().zip(&actual).any(|(e, a)| *e != a) {
+        return Err(format!(
+            "Mbuf pools of port {} differ from the startup plan ({} planned, {} required), run `hfeec plan` again",
+            port_id,
+            expected.len(),
+            actual.len()
+        ));
+    }
+    Ok(())
+}
@@ -1,4 +1,7 @@
+pub mod arena;
+pub mod array;
 pub mod ffi;
+pub mod idle;
 pub mod manager;
 pub mod node;
 pub mod topology;
@@ -6,12 +6,33 @@ use std::sync::{
 };
 use std::thread::{self, JoinHandle};
 
+use crate::capture::replay::{ReplayFile, ReplaySource};
+use crate::capture::tap::{CaptureSource, CaptureTap};
+use crate::control::reconfig::{self, ControlHandle, ControlReceiver};
+use crate::cpu::placement::{PlacementPlan, PlacementPlanner, PlacementRequest};
 use crate::cpu::topology::CpuTopology;
-use crate::dpdk::config::DpdkConfig;
+use crate::dpdk::config::{DpdkConfig, MAX_BURST_SIZE};
+use crate::dpdk::ffi::RteMempool;
+use crate::dpdk::flow::FlowTable;
+use crate::numa::arena::ArenaScope;
 use crate::numa::ffi::NumaAllocator;
+use crate::numa::idle::{IdleStrategy, Idler};
 use crate::numa::topology::NumaTopology;
+use crate::packet::classify::{partition_burst, HeaderClassifier, HeaderLanes};
 use crate::packet::data::PacketData;
-use crate::packet::pool::PacketDataPool;
+use crate::packet::handler::{BurstHandler, PacketBurst};
+use crate::packet::pool::PacketArena;
+use crate::packet::timestamp::{tsc, RxClockSync, RxTimestampMode};
+use crate::pipeline::arbiter::{
+    ArbitrationConfig, FeedArbitration, FeedSequence, GapRequest, LineArbiter,
+};
+use crate::pipeline::ring::{Consumer, Producer, SpscRing};
+use crate::pipeline::stage::{
+    run_decode_stage, run_strategy_stage, Decoder, PipelineConfig, PipelineLink, PipelineRx,
+    Strategy,
+};
+use crate::telemetry::worker::{BurstStats, WorkerTelemetry, STAGE_PORT_ID};
+use crate::tx::queue::TxQueueTable;
 
 /// Информация о DPDK порте
 #[derive(Debug)]
@@ -20,6 +41,12 @@ pub struct DpdkPort {
     pub if_name: String,
     pub num_rx_queues: u16,
     pub num_tx_queues: u16,
+    /// Пул mbuf порта, заполняется после конфигурации
+    pub mbuf_pool: *mut RteMempool,
+    /// Аппаратные правила rte_flow порта
+    pub flows: FlowTable,
+    /// Владельцы рабочих TX очередей порта
+    pub tx_queues: Arc<TxQueueTable>,
 }
 
 /// Рабочий поток
@@ -29,11 +56,15 @@ pub struct Worker {
     pub core_id: CoreId,
     pub port_id: u16,
     pub queue_id: u16,
+    /// Счетчики worker, доступные для чтения из других потоков
+    pub telemetry: Arc<WorkerTelemetry>,
+    /// RX очереди (порт, очередь), которые опрашивает worker
+    pub lines: Vec<(u16, u16)>,
+    /// Канал замены обработчика и приостановки линий (None - стадия без
+    /// поддержки замены)
+    pub control: Option<ControlHandle>,
 }
 
-/// Тип обработчика пакетов
-pub type PacketHandler = Arc<dyn Fn(u16, &PacketData) + Send + Sync + 'static>;
-
 /// Автономный узел NUMA
 pub struct NumaNode {
     /// ID узла NUMA
@@ -44,8 +75,21 @@ pub struct NumaNode {
     pub local_ports: Vec<DpdkPort>,
     /// Рабочие потоки
     pub workers: Vec<Worker>,
+    /// План размещения worker по ядрам, построенный при запуске
+    pub placement: Option<PlacementPlan>,
+    /// Кольца между стадиями конвейера (пусто вне конвейерного режима)
+    pub pipeline_links: Vec<PipelineLink>,
+    /// Арбитраж линий A/B, запущенный на узле
+    pub arbiters: Vec<FeedArbitration>,
+    /// Кольца точек захвата запущенных RX worker, еще не переданные потоку записи
+    pub capture_sources: Vec<CaptureSource>,
+    /// Запись, которую RX worker читают вместо порта `replay.port_id()`
+    pub replay: Option<Arc<ReplayFile>>,
     /// Флаг работы
     pub running: Arc<AtomicBool>,
+    /// Флаг работы стадий конвейера; снимается только после останова RX
+    /// worker, чтобы декодирование вернуло в пул все mbuf из колец
+    pub stages_running: Arc<AtomicBool>,
 }
 
 impl NumaNode {
@@ -64,6 +108,11 @@ impl NumaNode {
             cpu_topology.get_filtered_core_ids()
         };
 
+        Self::with_cores(node_id, local_cpus)
+    }
+
+    /// Создает узел с уже выбранными ядрами (из сохраненного плана запуска)
+    pub fn with_cores(node_id: usize, local_cpus: Vec<CoreId>) -> Self {
         println!(
             "Created NUMA node {} with {} CPU cores",
             node_id,
@@ -75,7 +124,13 @@ impl NumaNode {
             local_cpus,
             local_ports: Vec::new(),
             workers: Vec::new(),
+            placement: None,
+            pipeline_links: Vec::new(),
+            arbiters: Vec::new(),
+            capture_sources: Vec::new(),
+            replay: None,
             running: Arc::new(AtomicBool::new(false)),
+            stages_running: Arc::new(AtomicBool::new(false)),
         }
     }
 
@@ -111,54 +166,80 @@ impl NumaNode {
             if_name: if_name.to_string(),
             num_rx_queues,
             num_tx_queues,
+            mbuf_pool: std::ptr::null_mut(),
+            flows: FlowTable::empty(port_id),
+            tx_queues: TxQueueTable::new(port_id, num_tx_queues),
         });
 
         true
     }
 
     /// Запускает рабочие потоки для обработки пакетов
-    pub fn start_workers(
+    pub fn start_workers<H: BurstHandler + Clone>(
         &mut self,
-        packet_handler: PacketHandler,
-        burst_size: u32,
+        packet_handler: H,
+        dpdk_config: &DpdkConfig,
+        planner: &PlacementPlanner<'_>,
     ) -> Result<(), String> {
         if self.running.load(Ordering::SeqCst) {
             return Err("Workers already running".to_string());
         }
 
-        self.running.store(true, Ordering::SeqCst);
-
-        for port in &self.local_ports {
-            let port_id = port.port_id;
-            let num_rx_queues = port.num_rx_queues;
+        if self.local_cpus.is_empty() {
+            return Err(format!("No cores available for NUMA node {}", self.node_id));
+        }
 
-            println!(
-                "Starting {} worker threads for port {} on NUMA node {}",
-                num_rx_queues, port_id, self.node_id
+        let requests: Vec<PlacementRequest> = self
+            .local_ports
+            .iter()
+            .flat_map(|port| {
+                (0..port.num_rx_queues).map(move |q| PlacementRequest::rx_queue(port.port_id, q))
+            })
+            .collect();
+
+        let plan = planner.plan(self.node_id, &self.local_cpus, &requests);
+        print!("{}", plan);
+
+        if plan.is_oversubscribed() {
+            eprintln!(
+                "Warning: NUMA node {} has {} cores for {} workers, some cores are shared",
+                self.node_id,
+                self.local_cpus.len(),
+                requests.len()
             );
+        }
 
-            if self.local_cpus.is_empty() {
-                return Err(format!("No cores available for NUMA node {}", self.node_id));
-            }
+        self.running.store(true, Ordering::SeqCst);
 
-            for queue_id in 0..num_rx_queues {
-                let core_idx = (queue_id as usize) % self.local_cpus.len();
-                let core_id = self.local_cpus[core_idx];
+        let classifier = HeaderClassifier::new(&dpdk_config.rx_filters);
 
-                println!("  Queue {} -> Core {}", queue_id, core_id.id);
+        for placement in &plan.placements {
+            let port_id = placement.request.port_id;
+            let queue_id = placement.request.queue_id;
 
-                let worker = self.start_worker_thread(
-                    port_id,
-                    queue_id,
-                    core_id,
-                    packet_handler.clone(),
-                    burst_size,
-                );
+            let capture = self.capture_tap(dpdk_config);
+            // Копия обработчика создается в арене узла worker
+            let handler = {
+                let _arena = ArenaScope::enter(self.node_id);
+                packet_handler.clone()
+            };
+            let worker = self.start_worker_thread(
+                port_id,
+                queue_id,
+                placement.core,
+                handler,
+                classifier.clone(),
+                dpdk_config.idle_strategy_for(port_id, queue_id),
+                dpdk_config.rx_timestamps,
+                dpdk_config.burst_size,
+                capture,
+            );
 
-                self.workers.push(worker);
-            }
+            self.workers.push(worker);
         }
 
+        self.placement = Some(plan);
+
         println!(
             "Started {} worker threads on NUMA node {}",
             self.workers.len(),
@@ -167,17 +248,410 @@ impl NumaNode {
         Ok(())
     }
 
-    /// Запускает рабочий поток
-    fn start_worker_thread(
+    /// Запускает конвейер RX -> декодирование -> стратегия
+    ///
+    /// RX worker каждой очереди передает пакеты вместе с mbuf ядрам
+    /// декодирования, те - события ядрам стратегии. Каждая пара стадий
+    /// связана собственным SPSC кольцом; поток пакетов (адрес и порт
+    /// назначения) закреплен за одним ядром декодирования и одним ядром
+    /// стратегии, поэтому порядок внутри потока сохраняется. Все стадии
+    /// узла размещаются одной группой, по возможности в одном L3 домене.
+    pub fn start_pipeline<D, S>(
+        &mut self,
+        decoder: D,
+        strategy: S,
+        pipeline: &PipelineConfig,
+        dpdk_config: &DpdkConfig,
+        planner: &PlacementPlanner<'_>,
+    ) -> Result<(), String>
+    where
+        D: Decoder + Clone,
+        S: Strategy<Event = D::Event> + Clone,
+    {
+        if self.running.load(Ordering::SeqCst) {
+            return Err("Workers already running".to_string());
+        }
+
+        if self.local_cpus.is_empty() {
+            return Err(format!("No cores available for NUMA node {}", self.node_id));
+        }
+
+        let nb_decode = pipeline.decode_workers.max(1);
+        let nb_strategy = pipeline.strategy_workers.max(1);
+
+        let rx_queues: Vec<(u16, u16)> = self
+            .local_ports
+            .iter()
+            .flat_map(|port| (0..port.num_rx_queues).map(move |q| (port.port_id, q)))
+            .collect();
+
+        let mut requests: Vec<PlacementRequest> = rx_queues
+            .iter()
+            .map(|&(port_id, queue_id)| PlacementRequest::rx_queue(port_id, queue_id).in_group(0))
+            .collect();
+        requests.extend((0..nb_decode).map(|i| PlacementRequest::stage("decode", i as u16, 0)));
+        requests.extend((0..nb_strategy).map(|i| PlacementRequest::stage("strategy", i as u16, 0)));
+
+        let plan = planner.plan(self.node_id, &self.local_cpus, &requests);
+        print!("{}", plan);
+
+        if plan.is_oversubscribed() {
+            eprintln!(
+                "Warning: NUMA node {} has {} cores for {} pipeline stages, some cores are shared; \
+                 blocking backpressure may stall on a shared core",
+                self.node_id,
+                self.local_cpus.len(),
+                requests.len()
+            );
+        }
+
+        let core_for = |port_id: u16, index: u16, role: &str| {
+            plan.core_for(port_id, index, role)
+                .ok_or_else(|| format!("No core planned for {} {}:{}", role, port_id, index))
+        };
+        let rx_cores = rx_queues
+            .iter()
+            .map(|&(port_id, queue_id)| core_for(port_id, queue_id, "rx"))
+            .collect::<Result<Vec<_>, _>>()?;
+        let decode_cores = (0..nb_decode)
+            .map(|i| core_for(STAGE_PORT_ID, i as u16, "decode"))
+            .collect::<Result<Vec<_>, _>>()?;
+        let strategy_cores = (0..nb_strategy)
+            .map(|i| core_for(STAGE_PORT_ID, i as u16, "strategy"))
+            .collect::<Result<Vec<_>, _>>()?;
+
+        // Кольца RX -> декодирование: по одному на пару (очередь, ядро декодирования)
+        let mut rx_outputs: Vec<Vec<Producer<PacketData>>> = Vec::with_capacity(rx_queues.len());
+        let mut decode_inputs: Vec<Vec<Consumer<PacketData>>> =
+            (0..nb_decode).map(|_| Vec::new()).collect();
+
+        for &(port_id, queue_id) in &rx_queues {
+            let mut lanes = Vec::with_capacity(nb_decode);
+            for (d, inputs) in decode_inputs.iter_mut().enumerate() {
+                let (producer, consumer) = SpscRing::new(pipeline.ring_size);
+                self.pipeline_links.push(PipelineLink {
+                    from: format!("rx {}:{}", port_id, queue_id),
+                    to: format!("decode {}", d),
+                    capacity: producer.ring().capacity(),
+                    stats: producer.ring().stats().clone(),
+                });
+                lanes.push(producer);
+                inputs.push(consumer);
+            }
+            rx_outputs.push(lanes);
+        }
+
+        // Кольца декодирование -> стратегия
+        let mut decode_outputs: Vec<Vec<Producer<D::Event>>> = Vec::with_capacity(nb_decode);
+        let mut strategy_inputs: Vec<Vec<Consumer<D::Event>>> =
+            (0..nb_strategy).map(|_| Vec::new()).collect();
+
+        for d in 0..nb_decode {
+            let mut lanes = Vec::with_capacity(nb_strategy);
+            for (s, inputs) in strategy_inputs.iter_mut().enumerate() {
+                let (producer, consumer) = SpscRing::new(pipeline.ring_size);
+                self.pipeline_links.push(PipelineLink {
+                    from: format!("decode {}", d),
+                    to: format!("strategy {}", s),
+                    capacity: producer.ring().capacity(),
+                    stats: producer.ring().stats().clone(),
+                });
+                lanes.push(producer);
+                inputs.push(consumer);
+            }
+            decode_outputs.push(lanes);
+        }
+
+        self.running.store(true, Ordering::SeqCst);
+        self.stages_running.store(true, Ordering::SeqCst);
+
+        // Потребители запускаются раньше производителей
+        for (s, (inputs, core_id)) in strategy_inputs.into_iter().zip(strategy_cores).enumerate() {
+            let strategy = {
+                let _arena = ArenaScope::enter(self.node_id);
+                strategy.clone()
+            };
+            let (handle, control) = reconfig::channel::<S>();
+            let worker = self.start_stage_thread(
+                "strategy",
+                s as u16,
+                core_id,
+                Some(handle),
+                move |running, telemetry| {
+                    run_strategy_stage(strategy, inputs, control, running, telemetry)
+                },
+            );
+            self.workers.push(worker);
+        }
+
+        let decode_policy = pipeline.decode_backpressure;
+        for (d, ((inputs, outputs), core_id)) in decode_inputs
+            .into_iter()
+            .zip(decode_outputs)
+            .zip(decode_cores)
+            .enumerate()
+        {
+            let decoder = {
+                let _arena = ArenaScope::enter(self.node_id);
+                decoder.clone()
+            };
+            let worker = self.start_stage_thread(
+                "decode",
+                d as u16,
+                core_id,
+                None,
+                move |running, telemetry| {
+                    run_decode_stage(decoder, inputs, outputs, decode_policy, running, telemetry)
+                },
+            );
+            self.workers.push(worker);
+        }
+
+        let classifier = HeaderClassifier::new(&dpdk_config.rx_filters);
+
+        for ((&(port_id, queue_id), lanes), core_id) in
+            rx_queues.iter().zip(rx_outputs).zip(rx_cores)
+        {
+            let handler = PipelineRx::new(lanes, pipeline.rx_backpressure, self.running.clone());
+            let capture = self.capture_tap(dpdk_config);
+            let worker = self.start_worker_thread(
+                port_id,
+                queue_id,
+                core_id,
+                handler,
+                classifier.clone(),
+                dpdk_config.idle_strategy_for(port_id, queue_id),
+                dpdk_config.rx_timestamps,
+                dpdk_config.burst_size,
+                capture,
+            );
+            self.workers.push(worker);
+        }
+
+        self.placement = Some(plan);
+
+        println!(
+            "Started pipeline on NUMA node {}: {} RX, {} decode, {} strategy threads, {} rings",
+            self.node_id,
+            rx_queues.len(),
+            nb_decode,
+            nb_strategy,
+            self.pipeline_links.len()
+        );
+        Ok(())
+    }
+
+    /// Запускает арбитраж линий A/B фида
+    ///
+    /// Обе RX очереди опрашиваются одним worker, поэтому первое
+    /// поступление каждого номера определяется без синхронизации между
+    /// ядрами; обработчик получает только недублированные пакеты.
+    /// Возвращает потребителя кольца запросов восстановления для разрывов,
+    /// которые не закрыла ни одна из линий.
+    pub fn start_arbitrated_feed<H, S>(
+        &mut self,
+        arbitration: &ArbitrationConfig,
+        sequence: S,
+        packet_handler: H,
+        dpdk_config: &DpdkConfig,
+        planner: &PlacementPlanner<'_>,
+    ) -> Result<Consumer<GapRequest>, String>
+    where
+        H: BurstHandler,
+        S: FeedSequence,
+    {
+        if self.running.load(Ordering::SeqCst) {
+            return Err("Workers already running".to_string());
+        }
+
+        if self.local_cpus.is_empty() {
+            return Err(format!("No cores available for NUMA node {}", self.node_id));
+        }
+
+        let lines = vec![arbitration.line_a, arbitration.line_b];
+        for &(port_id, queue_id) in &lines {
+            let local = self
+                .local_ports
+                .iter()
+                .any(|port| port.port_id == port_id && queue_id < port.num_rx_queues);
+            if !local {
+                return Err(format!(
+                    "Feed line {}:{} is not an RX queue of NUMA node {}",
+                    port_id, queue_id, self.node_id
+                ));
+            }
+        }
+        if arbitration.line_a == arbitration.line_b {
+            return Err("Feed lines A and B must be different queues".to_string());
+        }
+
+        let (port_id, queue_id) = arbitration.line_a;
+        let requests = [PlacementRequest::rx_queue(port_id, queue_id)];
+        let plan = planner.plan(self.node_id, &self.local_cpus, &requests);
+        print!("{}", plan);
+
+        let core_id = plan
+            .core_for(port_id, queue_id, "rx")
+            .ok_or_else(|| format!("No core planned for feed line {}:{}", port_id, queue_id))?;
+
+        let (arbiter, recovery) = {
+            let _arena = ArenaScope::enter(self.node_id);
+            LineArbiter::new(packet_handler, sequence, arbitration)
+        };
+        self.arbiters.push(FeedArbitration {
+            line_a: arbitration.line_a,
+            line_b: arbitration.line_b,
+            stats: arbiter.stats().clone(),
+        });
+
+        self.running.store(true, Ordering::SeqCst);
+
+        let capture = self.capture_tap(dpdk_config);
+        // Замена обработчика фида меняет только обернутый обработчик
+        let worker = self.start_lines_thread(
+            lines,
+            core_id,
+            arbiter,
+            LineArbiter::inner_mut,
+            HeaderClassifier::new(&dpdk_config.rx_filters),
+            dpdk_config.idle_strategy_for(port_id, queue_id),
+            dpdk_config.rx_timestamps,
+            dpdk_config.burst_size,
+            capture,
+        );
+        self.workers.push(worker);
+        self.placement = Some(plan);
+
+        println!(
+            "Started A/B feed arbitration on NUMA node {}: lines {}:{} and {}:{}",
+            self.node_id,
+            arbitration.line_a.0,
+            arbitration.line_a.1,
+            arbitration.line_b.0,
+            arbitration.line_b.1
+        );
+        Ok(recovery)
+    }
+
+    /// Создает точку захвата для RX worker, если захват включен; кольцо
+    /// остается в `capture_sources` до передачи потоку записи
+    fn capture_tap(&mut self, dpdk_config: &DpdkConfig) -> Option<CaptureTap> {
+        if !dpdk_config.capture.is_enabled() {
+            return None;
+        }
+
+        let (tap, source) = CaptureTap::new(dpdk_config.capture.ring_size);
+        self.capture_sources.push(source);
+        Some(tap)
+    }
+
+    /// Источник воспроизведения для RX очереди, если она читает запись
+    fn replay_source(&self, port_id: u16, queue_id: u16) -> Option<ReplaySource> {
+        let replay = self.replay.as_ref().filter(|r| r.port_id() == port_id)?;
+        let port = self.local_ports.iter().find(|p| p.port_id == port_id)?;
+        Some(replay.source(queue_id, port.mbuf_pool))
+    }
+
+    /// Запускает поток стадии конвейера
+    fn start_stage_thread<F>(
+        &self,
+        role: &'static str,
+        index: u16,
+        core_id: CoreId,
+        control: Option<ControlHandle>,
+        body: F,
+    ) -> Worker
+    where
+        F: FnOnce(&AtomicBool, &WorkerTelemetry) + Send + 'static,
+    {
+        let running = self.stages_running.clone();
+        let node_id = self.node_id;
+        let telemetry = Arc::new(WorkerTelemetry::for_stage(role, index, core_id.id));
+        let stage_telemetry = telemetry.clone();
+
+        let thread = thread::spawn(move || {
+            core_affinity::set_for_current(core_id);
+
+            if NumaAllocator::is_available() {
+                NumaAllocator::bind_thread_to_node(node_id);
+                println!(
+                    "Thread for {} {} bound to NUMA node {} core {}",
+                    role, index, node_id, core_id.id
+                );
+            }
+            let _arena = ArenaScope::enter(node_id);
+
+            body(&running, &stage_telemetry);
+        });
+
+        Worker {
+            thread: Some(thread),
+            core_id,
+            port_id: STAGE_PORT_ID,
+            queue_id: index,
+            telemetry,
+            lines: Vec::new(),
+            control,
+        }
+    }
+
+    /// Запускает рабочий поток для одной RX очереди
+    fn start_worker_thread<H: BurstHandler>(
         &self,
         port_id: u16,
         queue_id: u16,
         core_id: CoreId,
-        packet_handler: PacketHandler,
+        packet_handler: H,
+        classifier: HeaderClassifier,
+        idle_strategy: IdleStrategy,
+        timestamp_mode: RxTimestampMode,
         burst_size: u32,
+        capture: Option<CaptureTap>,
     ) -> Worker {
+        self.start_lines_thread(
+            vec![(port_id, queue_id)],
+            core_id,
+            packet_handler,
+            |handler: &mut H| handler,
+            classifier,
+            idle_strategy,
+            timestamp_mode,
+            burst_size,
+            capture,
+        )
+    }
+
+    /// Запускает рабочий поток, опрашивающий по кругу RX очереди `lines`
+    /// (порт, очередь) и передающий их burst одному обработчику
+    ///
+    /// Телеметрия относится к первой линии; пустым считается круг, в котором
+    /// пусты все линии, и RX прерывание стратегии Interrupt ждется сразу на
+    /// всех линиях.
+    /// `capture` получает каждый burst всех линий до фильтрации. Линии порта
+    /// воспроизведения получают пакеты из записи вместо `rte_eth_rx_burst`.
+    fn start_lines_thread<H: BurstHandler, T: Send + 'static>(
+        &self,
+        lines: Vec<(u16, u16)>,
+        core_id: CoreId,
+        mut packet_handler: H,
+        swap_target: fn(&mut H) -> &mut T,
+        classifier: HeaderClassifier,
+        idle_strategy: IdleStrategy,
+        timestamp_mode: RxTimestampMode,
+        burst_size: u32,
+        mut capture: Option<CaptureTap>,
+    ) -> Worker {
+        let (port_id, queue_id) = lines[0];
         let running = self.running.clone();
         let node_id = self.node_id;
+        let telemetry = Arc::new(WorkerTelemetry::new(port_id, queue_id, core_id.id));
+        let worker_telemetry = telemetry.clone();
+        let mut replays: Vec<Option<ReplaySource>> = lines
+            .iter()
+            .map(|&(port_id, queue_id)| self.replay_source(port_id, queue_id))
+            .collect();
+        let (control_handle, mut control): (_, ControlReceiver<T>) = reconfig::channel();
+        let worker_lines = lines.clone();
 
         let thread = thread::spawn(move || {
             core_affinity::set_for_current(core_id);
@@ -189,92 +663,170 @@ impl NumaNode {
                     port_id, queue_id, node_id, core_id.id
                 );
             }
+            let _arena = ArenaScope::enter(node_id);
+
+            let burst = (burst_size as usize).min(MAX_BURST_SIZE);
+            let mut rx_pkts = vec![std::ptr::null_mut(); burst];
+            let mut dropped_pkts = vec![std::ptr::null_mut(); burst];
+            let mut descs = PacketArena::new(burst, Some(node_id));
+
+            let mut lanes = Box::new(HeaderLanes::new());
+            let mut burst_stats = BurstStats::default();
+
+            let telemetry = &*worker_telemetry;
+            let mut idler = Idler::new(idle_strategy, &lines, &telemetry.polls);
+            let mut rx_clocks: Vec<Option<RxClockSync>> = lines
+                .iter()
+                .map(|&(port_id, _)| RxClockSync::new(port_id, timestamp_mode))
+                .collect();
+
+            // Флаг останова меняется редко, достаточно Relaxed чтения
+            while running.load(Ordering::Relaxed) {
+                let mut any_rx = false;
+
+                // Замена обработчика и приостановка линий между burst
+                control.poll(swap_target(&mut packet_handler));
+                if control.paused_lines() != idler.paused() {
+                    idler.set_paused(control.paused_lines());
+                }
 
-            let packet_pool = PacketDataPool::new(burst_size as usize, Some(node_id));
+                for (line, ((&(port_id, queue_id), rx_clock), replay)) in lines
+                    .iter()
+                    .zip(rx_clocks.iter_mut())
+                    .zip(replays.iter_mut())
+                    .enumerate()
+                {
+                    if control.is_paused(line) {
+                        continue;
+                    }
 
-            const PREFETCH_AHEAD: usize = 4;
+                    let mut nb_rx = match replay {
+                        Some(source) => source.rx_burst(&mut rx_pkts),
+                        None => unsafe {
+                            crate::dpdk::ffi::rte_eth_rx_burst(
+                                port_id,
+                                queue_id,
+                                rx_pkts.as_mut_ptr(),
+                                burst as u16,
+                            )
+                        },
+                    };
 
-            let mut rx_pkts = vec![std::ptr::null_mut(); burst_size as usize];
+                    if nb_rx == 0 {
+                        continue;
+                    }
+                    any_rx = true;
 
-            while running.load(Ordering::SeqCst) {
-                let nb_rx = unsafe {
-                    crate::dpdk::ffi::rte_eth_rx_burst(
-                        port_id,
-                        queue_id,
-                        rx_pkts.as_mut_ptr(),
-                        burst_size as u16,
-                    )
-                };
+                    if let Some(clock) = rx_clock.as_mut() {
+                        clock.begin_burst();
+                    }
 
-                for i in 0..std::cmp::min(PREFETCH_AHEAD, nb_rx as usize) {
-                    unsafe {
-                        let pkt = rx_pkts[i];
-                        rte_prefetch0(pkt as *const libc::c_void);
+                    idler.on_busy();
+                    telemetry.record_rx(nb_rx as usize);
 
-                        let data = crate::dpdk::ffi::rte_pktmbuf_mtod(pkt, std::ptr::null());
-                        rte_prefetch0(data);
+                    if let Some(tap) = capture.as_mut() {
+                        tap.capture(
+                            port_id,
+                            queue_id,
+                            &mut rx_pkts[..nb_rx as usize],
+                            rx_clock.as_ref().map(|clock| clock.clock()),
+                        );
                     }
-                }
 
-                for i in 0..nb_rx as usize {
-                    if i + PREFETCH_AHEAD < nb_rx as usize {
+                    // Отбрасываем нерелевантный трафик до разбора пакетов
+                    if classifier.has_rules() {
                         unsafe {
-                            let pkt = rx_pkts[i + PREFETCH_AHEAD];
-                            rte_prefetch0(pkt as *const libc::c_void);
+                            crate::dpdk::ffi::dpdk_gather_headers(
+                                rx_pkts.as_mut_ptr(),
+                                nb_rx,
+                                &mut *lanes,
+                            )
+                        };
+
+                        let mask = classifier.classify(&lanes, nb_rx as usize);
+                        let (nb_kept, nb_dropped) =
+                            partition_burst(&mut rx_pkts, nb_rx as usize, mask, &mut dropped_pkts);
+
+                        if nb_dropped > 0 {
+                            telemetry.rx.filtered.add(nb_dropped as u64);
+                            unsafe {
+                                crate::dpdk::ffi::rte_pktmbuf_free_bulk(
+                                    dropped_pkts.as_mut_ptr(),
+                                    nb_dropped as u32,
+                                )
+                            };
+                        }
 
-                            let data = crate::dpdk::ffi::rte_pktmbuf_mtod(pkt, std::ptr::null());
-                            rte_prefetch0(data);
+                        if nb_kept == 0 {
+                            continue;
                         }
+
+                        nb_rx = nb_kept as u16;
                     }
 
-                    let pkt = rx_pkts[i];
-
-                    let mut src_ip_ptr = std::ptr::null_mut();
-                    let mut src_ip_len: u32 = 0;
-                    let mut dst_ip_ptr = std::ptr::null_mut();
-                    let mut dst_ip_len: u32 = 0;
-                    let mut src_port: u16 = 0;
-                    let mut dst_port: u16 = 0;
-                    let mut data_ptr = std::ptr::null_mut();
-                    let mut data_len: u32 = 0;
-
-                    let ret = unsafe {
-                        crate::dpdk::ffi::dpdk_extract_packet_data(
-                            pkt,
-                            &mut src_ip_ptr,
-                            &mut src_ip_len,
-                            &mut dst_ip_ptr,
-                            &mut dst_ip_len,
-                            &mut src_port,
-                            &mut dst_port,
-                            &mut data_ptr,
-                            &mut data_len,
+                    burst_stats.clear();
+                    let nb_ok = unsafe {
+                        crate::dpdk::ffi::dpdk_parse_burst(
+                            rx_pkts.as_mut_ptr(),
+                            nb_rx,
+                            queue_id,
+                            descs.as_mut_ptr(),
+                            rx_clock
+                                .as_ref()
+                                .map_or(std::ptr::null(), |clock| clock.clock() as *const _),
+                            &mut burst_stats,
                         )
                     };
+                    telemetry.record_parse(nb_ok as usize, &burst_stats);
+
+                    let mut kept_mask = 0;
+                    if nb_ok > 0 {
+                        let mut packet_burst = PacketBurst::new(descs.as_slice(nb_ok as usize));
+                        packet_handler.on_burst(queue_id, &mut packet_burst);
+                        kept_mask = packet_burst.kept_mask();
+
+                        // Задержка от прихода каждого пакета до конца обработки burst
+                        if rx_clock.is_some() {
+                            let done = tsc();
+                            for packet in descs.as_slice(nb_ok as usize) {
+                                telemetry
+                                    .latency
+                                    .record(done.saturating_sub(packet.rx_timestamp));
+                            }
+                        }
+                    }
 
-                    if ret == 0 && !data_ptr.is_null() && data_len > 0 {
-                        let mut packet = packet_pool.acquire();
-
-                        packet.source_port = src_port;
-                        packet.dest_port = dst_port;
-                        packet.queue_id = queue_id;
-                        packet.source_ip_ptr = src_ip_ptr;
-                        packet.source_ip_len = src_ip_len as usize;
-                        packet.dest_ip_ptr = dst_ip_ptr;
-                        packet.dest_ip_len = dst_ip_len as usize;
-                        packet.data_ptr = data_ptr;
-                        packet.data_len = data_len as usize;
-                        packet.mbuf_ptr = pkt;
-
-                        packet_handler(queue_id, &packet);
-
-                        unsafe { crate::dpdk::ffi::rte_pktmbuf_free(packet.mbuf_ptr) };
-
-                        packet_pool.release(packet);
+                    if kept_mask == 0 {
+                        unsafe {
+                            crate::dpdk::ffi::rte_pktmbuf_free_bulk(
+                                rx_pkts.as_mut_ptr(),
+                                nb_rx as u32,
+                            )
+                        };
                     } else {
-                        unsafe { crate::dpdk::ffi::rte_pktmbuf_free(pkt) };
+                        // pkts[0..nb_ok) соответствуют дескрипторам, остальные не разобраны
+                        let (_, nb_free) = partition_burst(
+                            &mut rx_pkts,
+                            nb_ok as usize,
+                            kept_mask,
+                            &mut dropped_pkts,
+                        );
+                        unsafe {
+                            crate::dpdk::ffi::rte_pktmbuf_free_bulk(
+                                dropped_pkts.as_mut_ptr(),
+                                nb_free as u32,
+                            );
+                            crate::dpdk::ffi::rte_pktmbuf_free_bulk(
+                                rx_pkts.as_mut_ptr().add(nb_ok as usize),
+                                (nb_rx - nb_ok) as u32,
+                            );
+                        }
                     }
                 }
+
+                if !any_rx {
+                    idler.on_idle();
+                }
             }
         });
 
@@ -283,6 +835,9 @@ impl NumaNode {
             core_id,
             port_id,
             queue_id,
+            telemetry,
+            lines: worker_lines,
+            control: Some(control_handle),
         }
     }
 
@@ -300,40 +855,48 @@ impl NumaNode {
 
         self.running.store(false, Ordering::SeqCst);
 
-        while let Some(mut worker) = self.workers.pop() {
+        // Сначала RX worker: после их останова в кольца к декодированию
+        // больше ничего не попадает, и стадии забирают остаток целиком
+        let (stages, rx_workers): (Vec<Worker>, Vec<Worker>) = self
+            .workers
+            .drain(..)
+            .partition(|worker| worker.port_id == STAGE_PORT_ID);
+        Self::join_workers(rx_workers);
+        self.stages_running.store(false, Ordering::SeqCst);
+        Self::join_workers(stages);
+
+        self.pipeline_links.clear();
+        self.arbiters.clear();
+        // Worker остановлены: непереданные кольца освобождают свои mbuf
+        self.capture_sources.clear();
+    }
+
+    fn join_workers(mut workers: Vec<Worker>) {
+        while let Some(mut worker) = workers.pop() {
             if let Some(thread) = worker.thread.take() {
                 let _ = thread.join();
-                println!(
-                    "  Worker thread for port {}, queue {} on core {} stopped",
-                    worker.port_id, worker.queue_id, worker.core_id.id
-                );
+                if worker.port_id == STAGE_PORT_ID {
+                    println!(
+                        "  {} thread {} on core {} stopped",
+                        worker.telemetry.role, worker.queue_id, worker.core_id.id
+                    );
+                } else {
+                    println!(
+                        "  Worker thread for port {}, queue {} on core {} stopped",
+                        worker.port_id, worker.queue_id, worker.core_id.id
+                    );
+                }
             }
         }
     }
 
-    /// Генерирует аргументы для DPDK EAL, относящиеся к этому узлу NUMA
-    pub fn generate_eal_args(&self, dpdk_config: &DpdkConfig) -> Vec<String> {
-        let mut args = Vec::new();
-
-        if dpdk_config.use_huge_pages {
-            let socket_mem = if NumaAllocator::is_available() {
-                let mut mem_per_node = vec!["0".to_string(); NumaAllocator::get_node_count()];
-                mem_per_node[self.node_id] = dpdk_config
-                    .socket_mem
-                    .as_ref()
-                    .map_or_else(|| "1024".to_string(), |v| v[self.node_id].to_string());
-                mem_per_node.join(",")
-            } else {
-                dpdk_config
-                    .socket_mem
-                    .as_ref()
-                    .map_or_else(|| "1024".to_string(), |v| v[0].to_string())
-            };
-
-            args.push(format!("--socket-mem={}", socket_mem));
-        }
-
-        args
+    /// Возвращает объем hugepage памяти (МБ), резервируемой EAL на этом узле
+    pub fn socket_mem_mb(&self, dpdk_config: &DpdkConfig) -> u32 {
+        dpdk_config
+            .socket_mem
+            .as_ref()
+            .and_then(|mem| mem.get(self.node_id).or_else(|| mem.first()).copied())
+            .unwrap_or(1024)
     }
 
     /// Генерирует маску ядер для DPDK EAL, содержащую только ядра этого узла
@@ -355,18 +918,3 @@ impl Drop for NumaNode {
         self.stop_workers();
     }
 }
-
-// Функция для предзагрузки данных в кеш
-#[inline(always)]
-unsafe fn rte_prefetch0(p: *const libc::c_void) {
-    #[cfg(target_arch = "x86_64")]
-    {
-        std::arch::x86_64::_mm_prefetch(p as *const i8, std::arch::x86_64::_MM_HINT_T0);
-    }
-
-    #[cfg(not(target_arch = "x86_64"))]
-    {
-        // На других архитектурах используем линкованный DPDK
-        crate::dpdk::ffi::rte_prefetch0(p);
-    }
-}
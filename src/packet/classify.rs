@@ -0,0 +1,340 @@
+// src/packet/classify.rs
+use std::net::Ipv4Addr;
+
+use crate::dpdk::config::MAX_BURST_SIZE;
+
+const ETHER_TYPE_IPV4: u32 = 0x0800;
+pub const IPPROTO_TCP: u8 = 6;
+pub const IPPROTO_UDP: u8 = 17;
+
+/// Поля заголовков burst в формате "структура массивов"
+///
+/// Раскладка совпадает с `struct dpdk_header_lanes` в src/native/dpdk.c,
+/// заполняется через `dpdk_gather_headers`. `ether_type` и `l2_len`
+/// относятся к L3 заголовку после VLAN тегов (802.1Q/QinQ).
+#[repr(C, align(64))]
+pub struct HeaderLanes {
+    pub ether_type: [u32; MAX_BURST_SIZE],
+    pub l2_len: [u32; MAX_BURST_SIZE],
+    pub ip_proto: [u32; MAX_BURST_SIZE],
+    pub ihl: [u32; MAX_BURST_SIZE],
+    pub dst_ip: [u32; MAX_BURST_SIZE],
+    pub dst_port: [u32; MAX_BURST_SIZE],
+}
+
+impl HeaderLanes {
+    pub fn new() -> Self {
+        Self {
+            ether_type: [0; MAX_BURST_SIZE],
+            l2_len: [0; MAX_BURST_SIZE],
+            ip_proto: [0; MAX_BURST_SIZE],
+            ihl: [0; MAX_BURST_SIZE],
+            dst_ip: [0; MAX_BURST_SIZE],
+            dst_port: [0; MAX_BURST_SIZE],
+        }
+    }
+}
+
+/// Правило отбора пакетов по адресу назначения, порту и протоколу
+///
+/// `None` в поле означает "любое значение".
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct FlowMatch {
+    pub dst_ip: Option<Ipv4Addr>,
+    pub dst_port: Option<u16>,
+    pub proto: Option<u8>,
+}
+
+impl FlowMatch {
+    /// Правило для UDP потока (например, мультикаст-группы биржевого фида)
+    pub fn udp(dst_ip: Ipv4Addr, dst_port: u16) -> Self {
+        Self {
+            dst_ip: Some(dst_ip),
+            dst_port: Some(dst_port),
+            proto: Some(IPPROTO_UDP),
+        }
+    }
+
+    /// Правило для TCP потока (например, сессии order gateway)
+    pub fn tcp(dst_ip: Ipv4Addr, dst_port: u16) -> Self {
+        Self {
+            dst_ip: Some(dst_ip),
+            dst_port: Some(dst_port),
+            proto: Some(IPPROTO_TCP),
+        }
+    }
+
+    /// Правило только по порту назначения
+    pub fn port(dst_port: u16) -> Self {
+        Self {
+            dst_ip: None,
+            dst_port: Some(dst_port),
+            proto: None,
+        }
+    }
+}
+
+/// Правило в виде (маска, значение) для сравнения без ветвлений:
+/// `(field & mask) == value`, для "любого" значения маска и значение равны 0
+#[derive(Debug, Clone, Copy)]
+struct MaskedRule {
+    ip_mask: u32,
+    ip: u32,
+    port_mask: u32,
+    port: u32,
+    proto_mask: u32,
+    proto: u32,
+}
+
+impl From<&FlowMatch> for MaskedRule {
+    fn from(rule: &FlowMatch) -> Self {
+        let (ip_mask, ip) = rule.dst_ip.map_or((0, 0), |ip| (u32::MAX, u32::from(ip)));
+        let (port_mask, port) = rule.dst_port.map_or((0, 0), |p| (u32::MAX, p as u32));
+        let (proto_mask, proto) = rule.proto.map_or((0, 0), |p| (u32::MAX, p as u32));
+
+        Self {
+            ip_mask,
+            ip: ip & ip_mask,
+            port_mask,
+            port: port & port_mask,
+            proto_mask,
+            proto: proto & proto_mask,
+        }
+    }
+}
+
+/// Векторный классификатор заголовков burst
+///
+/// Отбрасывает нерелевантный трафик до разбора пакетов: за один проход
+/// строит битовую маску "интересных" пакетов. Смещение payload здесь не
+/// считается - его все равно определяет `dpdk_parse_burst` для оставшихся
+/// пакетов. Путь выбирается флагами `avx512`/`avx2` из build.rs, иначе
+/// используется скалярная реализация.
+#[derive(Debug, Clone)]
+pub struct HeaderClassifier {
+    rules: Vec<MaskedRule>,
+}
+
+impl HeaderClassifier {
+    /// Создает классификатор; без правил пропускает любой IPv4 TCP/UDP трафик
+    pub fn new(rules: &[FlowMatch]) -> Self {
+        Self {
+            rules: rules.iter().map(MaskedRule::from).collect(),
+        }
+    }
+
+    /// Проверяет, задано ли хотя бы одно правило
+    pub fn has_rules(&self) -> bool {
+        !self.rules.is_empty()
+    }
+
+    /// Классифицирует первые `nb_pkts` пакетов
+    ///
+    /// Возвращает маску, в которой бит `i` установлен для подходящих пакетов.
+    #[inline]
+    pub fn classify(&self, lanes: &HeaderLanes, nb_pkts: usize) -> u64 {
+        let nb_pkts = nb_pkts.min(MAX_BURST_SIZE);
+
+        #[cfg(all(target_arch = "x86_64", feature = "avx512"))]
+        {
+            return unsafe { self.classify_avx512(lanes, nb_pkts) };
+        }
+
+        #[cfg(all(target_arch = "x86_64", feature = "avx2", not(feature = "avx512")))]
+        {
+            return unsafe { self.classify_avx2(lanes, nb_pkts) };
+        }
+
+        #[allow(unreachable_code)]
+        self.classify_scalar(lanes, nb_pkts)
+    }
+
+    /// Скалярная реализация, она же эталон для векторных путей
+    pub fn classify_scalar(&self, lanes: &HeaderLanes, nb_pkts: usize) -> u64 {
+        let mut mask = 0u64;
+
+        for i in 0..nb_pkts {
+            let proto = lanes.ip_proto[i];
+            let valid = lanes.ether_type[i] == ETHER_TYPE_IPV4
+                && lanes.ihl[i] >= 5
+                && (proto == IPPROTO_UDP as u32 || proto == IPPROTO_TCP as u32);
+
+            let matched = self.rules.is_empty()
+                || self.rules.iter().any(|r| {
+                    (lanes.dst_ip[i] & r.ip_mask) == r.ip
+                        && (lanes.dst_port[i] & r.port_mask) == r.port
+                        && (proto & r.proto_mask) == r.proto
+                });
+
+            mask |= ((valid && matched) as u64) << i;
+        }
+
+        mask
+    }
+
+    #[cfg(all(target_arch = "x86_64", feature = "avx2"))]
+    #[target_feature(enable = "avx2")]
+    unsafe fn classify_avx2(&self, lanes: &HeaderLanes, nb_pkts: usize) -> u64 {
+        use std::arch::x86_64::*;
+
+        const LANES: usize = 8;
+
+        let ether_ipv4 = _mm256_set1_epi32(ETHER_TYPE_IPV4 as i32);
+        let proto_udp = _mm256_set1_epi32(IPPROTO_UDP as i32);
+        let proto_tcp = _mm256_set1_epi32(IPPROTO_TCP as i32);
+        let min_ihl = _mm256_set1_epi32(4);
+
+        let mut mask = 0u64;
+        let mut base = 0;
+
+        // Массивы выровнены и имеют длину MAX_BURST_SIZE, поэтому хвост burst
+        // можно обрабатывать полным вектором и обрезать маску в конце
+        while base < nb_pkts {
+            let ld = |arr: &[u32; MAX_BURST_SIZE]| {
+                _mm256_load_si256(arr.as_ptr().add(base) as *const __m256i)
+            };
+
+            let ether_type = ld(&lanes.ether_type);
+            let proto = ld(&lanes.ip_proto);
+            let ihl = ld(&lanes.ihl);
+            let dst_ip = ld(&lanes.dst_ip);
+            let dst_port = ld(&lanes.dst_port);
+
+            let l4_ok = _mm256_or_si256(
+                _mm256_cmpeq_epi32(proto, proto_udp),
+                _mm256_cmpeq_epi32(proto, proto_tcp),
+            );
+            let mut valid = _mm256_and_si256(
+                _mm256_cmpeq_epi32(ether_type, ether_ipv4),
+                _mm256_and_si256(_mm256_cmpgt_epi32(ihl, min_ihl), l4_ok),
+            );
+
+            if !self.rules.is_empty() {
+                let mut matched = _mm256_setzero_si256();
+
+                for r in &self.rules {
+                    let ip_eq = _mm256_cmpeq_epi32(
+                        _mm256_and_si256(dst_ip, _mm256_set1_epi32(r.ip_mask as i32)),
+                        _mm256_set1_epi32(r.ip as i32),
+                    );
+                    let port_eq = _mm256_cmpeq_epi32(
+                        _mm256_and_si256(dst_port, _mm256_set1_epi32(r.port_mask as i32)),
+                        _mm256_set1_epi32(r.port as i32),
+                    );
+                    let proto_eq = _mm256_cmpeq_epi32(
+                        _mm256_and_si256(proto, _mm256_set1_epi32(r.proto_mask as i32)),
+                        _mm256_set1_epi32(r.proto as i32),
+                    );
+
+                    matched = _mm256_or_si256(
+                        matched,
+                        _mm256_and_si256(ip_eq, _mm256_and_si256(port_eq, proto_eq)),
+                    );
+                }
+
+                valid = _mm256_and_si256(valid, matched);
+            }
+
+            let bits = _mm256_movemask_ps(_mm256_castsi256_ps(valid)) as u32 as u64;
+            mask |= bits << base;
+            base += LANES;
+        }
+
+        mask & burst_mask(nb_pkts)
+    }
+
+    #[cfg(all(target_arch = "x86_64", feature = "avx512"))]
+    #[target_feature(enable = "avx512f")]
+    unsafe fn classify_avx512(&self, lanes: &HeaderLanes, nb_pkts: usize) -> u64 {
+        use std::arch::x86_64::*;
+
+        const LANES: usize = 16;
+
+        let ether_ipv4 = _mm512_set1_epi32(ETHER_TYPE_IPV4 as i32);
+        let proto_udp = _mm512_set1_epi32(IPPROTO_UDP as i32);
+        let proto_tcp = _mm512_set1_epi32(IPPROTO_TCP as i32);
+        let min_ihl = _mm512_set1_epi32(4);
+
+        let mut mask = 0u64;
+        let mut base = 0;
+
+        while base < nb_pkts {
+            let ld = |arr: &[u32; MAX_BURST_SIZE]| {
+                _mm512_load_si512(arr.as_ptr().add(base) as *const __m512i)
+            };
+
+            let proto = ld(&lanes.ip_proto);
+            let ihl = ld(&lanes.ihl);
+            let dst_ip = ld(&lanes.dst_ip);
+            let dst_port = ld(&lanes.dst_port);
+
+            let mut valid: __mmask16 = _mm512_cmpeq_epi32_mask(ld(&lanes.ether_type), ether_ipv4)
+                & _mm512_cmpgt_epi32_mask(ihl, min_ihl)
+                & (_mm512_cmpeq_epi32_mask(proto, proto_udp)
+                    | _mm512_cmpeq_epi32_mask(proto, proto_tcp));
+
+            if !self.rules.is_empty() {
+                let mut matched: __mmask16 = 0;
+
+                for r in &self.rules {
+                    matched |= _mm512_cmpeq_epi32_mask(
+                        _mm512_and_si512(dst_ip, _mm512_set1_epi32(r.ip_mask as i32)),
+                        _mm512_set1_epi32(r.ip as i32),
+                    ) & _mm512_cmpeq_epi32_mask(
+                        _mm512_and_si512(dst_port, _mm512_set1_epi32(r.port_mask as i32)),
+                        _mm512_set1_epi32(r.port as i32),
+                    ) & _mm512_cmpeq_epi32_mask(
+                        _mm512_and_si512(proto, _mm512_set1_epi32(r.proto_mask as i32)),
+                        _mm512_set1_epi32(r.proto as i32),
+                    );
+                }
+
+                valid &= matched;
+            }
+
+            mask |= (valid as u64) << base;
+            base += LANES;
+        }
+
+        mask & burst_mask(nb_pkts)
+    }
+}
+
+/// Маска из `nb_pkts` младших бит
+#[inline(always)]
+fn burst_mask(nb_pkts: usize) -> u64 {
+    if nb_pkts >= 64 {
+        u64::MAX
+    } else {
+        (1u64 << nb_pkts) - 1
+    }
+}
+
+/// Разделяет burst по маске классификатора
+///
+/// Подходящие пакеты сохраняют порядок и сдвигаются в начало `pkts`,
+/// отброшенные складываются в `dropped`. Возвращает количество оставшихся
+/// и количество отброшенных пакетов.
+#[inline]
+pub fn partition_burst<T: Copy>(
+    pkts: &mut [T],
+    nb_pkts: usize,
+    mask: u64,
+    dropped: &mut [T],
+) -> (usize, usize) {
+    let mut kept = 0;
+    let mut nb_dropped = 0;
+
+    for i in 0..nb_pkts {
+        let pkt = pkts[i];
+        if mask & (1u64 << i) != 0 {
+            pkts[kept] = pkt;
+            kept += 1;
+        } else {
+            dropped[nb_dropped] = pkt;
+            nb_dropped += 1;
+        }
+    }
+
+    (kept, nb_dropped)
+}
@@ -1,7 +1,14 @@
 // src/packet/data.rs
-use crate::dpdk::ffi::RteMbuf;
+use crate::dpdk::ffi::{self, RteMbuf};
+
+/// Код разбора многосегментного пакета (scatter): payload продолжается
+/// в следующих сегментах mbuf, совпадает с DPDK_PARSE_SEGMENTED в src/native/dpdk.c
+pub const STATUS_SEGMENTED: i16 = 1;
 
 /// Структура для хранения данных пакета
+///
+/// Раскладка совпадает с `struct dpdk_packet_desc` в src/native/dpdk.c:
+/// массив `PacketData` заполняется напрямую из `dpdk_parse_burst`.
 #[repr(C, align(64))]
 pub struct PacketData {
     // High
@@ -11,12 +18,16 @@ pub struct PacketData {
     pub source_port: u16,
     pub dest_port: u16,
     pub queue_id: u16,
-    pub _padding: u16,
+    /// Код разбора пакета: 0 - успех, `STATUS_SEGMENTED` - успех, payload
+    /// в нескольких сегментах, отрицательное значение - ошибка
+    pub status: i16,
     // Low
     pub source_ip_ptr: *const u8,
-    pub source_ip_len: usize,
     pub dest_ip_ptr: *const u8,
-    pub dest_ip_len: usize,
+    pub source_ip_len: u32,
+    pub dest_ip_len: u32,
+    /// Время прихода пакета в тактах TSC, 0 - метки отключены
+    pub rx_timestamp: u64,
     pub mbuf_ptr: *mut RteMbuf,
 }
 
@@ -29,12 +40,13 @@ impl PacketData {
             source_port: 0,
             dest_port: 0,
             queue_id: 0,
-            _padding: 0,
+            status: 0,
 
             source_ip_ptr: std::ptr::null(),
-            source_ip_len: 0,
             dest_ip_ptr: std::ptr::null(),
+            source_ip_len: 0,
             dest_ip_len: 0,
+            rx_timestamp: 0,
             mbuf_ptr: std::ptr::null_mut(),
         }
     }
@@ -49,31 +61,130 @@ impl PacketData {
         self.source_port = 0;
         self.dest_port = 0;
         self.queue_id = 0;
+        self.status = 0;
 
         self.source_ip_ptr = std::ptr::null();
-        self.source_ip_len = 0;
         self.dest_ip_ptr = std::ptr::null();
+        self.source_ip_len = 0;
         self.dest_ip_len = 0;
+        self.rx_timestamp = 0;
         self.mbuf_ptr = std::ptr::null_mut();
     }
 
+    /// Проверяет, успешно ли разобран пакет
+    #[inline(always)]
+    pub fn is_valid(&self) -> bool {
+        self.status >= 0
+    }
+
+    /// Проверяет, продолжается ли payload в следующих сегментах mbuf
+    #[inline(always)]
+    pub fn is_segmented(&self) -> bool {
+        self.status == STATUS_SEGMENTED
+    }
+
     /// Получает исходный IP-адрес в виде среза
     #[inline(always)]
     pub fn get_source_ip(&self) -> &[u8] {
-        unsafe { std::slice::from_raw_parts(self.source_ip_ptr, self.source_ip_len) }
+        unsafe { std::slice::from_raw_parts(self.source_ip_ptr, self.source_ip_len as usize) }
     }
 
     /// Получает IP-адрес назначения в виде среза
     #[inline(always)]
     pub fn get_dest_ip(&self) -> &[u8] {
-        unsafe { std::slice::from_raw_parts(self.dest_ip_ptr, self.dest_ip_len) }
+        unsafe { std::slice::from_raw_parts(self.dest_ip_ptr, self.dest_ip_len as usize) }
+    }
+
+    /// Время прихода пакета в тактах TSC (аппаратная метка NIC или
+    /// время возврата rte_eth_rx_burst), 0 если метки отключены
+    #[inline(always)]
+    pub fn rx_timestamp(&self) -> u64 {
+        self.rx_timestamp
     }
 
     /// Получает данные пакета в виде среза
+    ///
+    /// Для многосегментного пакета - только часть payload из первого
+    /// сегмента; полный payload доступен через `segments` или `linearize`.
     #[inline(always)]
     pub fn get_data(&self) -> &[u8] {
         unsafe { std::slice::from_raw_parts(self.data_ptr, self.data_len) }
     }
+
+    /// Полная длина payload с учетом всех сегментов
+    #[inline(always)]
+    pub fn payload_len(&self) -> usize {
+        if !self.is_segmented() {
+            return self.data_len;
+        }
+        unsafe { ffi::dpdk_packet_payload_len(self) as usize }
+    }
+
+    /// Итератор по частям payload в сегментах mbuf, без копирования
+    #[inline(always)]
+    pub fn segments(&self) -> PayloadSegments<'_> {
+        PayloadSegments {
+            seg: self.mbuf_ptr,
+            first: Some(self.get_data()),
+            remaining: self.payload_len(),
+            _packet: std::marker::PhantomData,
+        }
+    }
+
+    /// Непрерывный payload: срез в mbuf, если payload в одном сегменте,
+    /// иначе копия в `buf`; None - `buf` меньше payload
+    #[inline(always)]
+    pub fn linearize<'b>(&'b self, buf: &'b mut [u8]) -> Option<&'b [u8]> {
+        if !self.is_segmented() {
+            return Some(self.get_data());
+        }
+
+        let len = self.payload_len();
+        let ptr = unsafe { ffi::dpdk_packet_linearize(self, buf.as_mut_ptr(), buf.len() as u32) };
+        if ptr.is_null() {
+            return None;
+        }
+        Some(unsafe { std::slice::from_raw_parts(ptr, len) })
+    }
+}
+
+/// Части payload многосегментного пакета в порядке следования
+pub struct PayloadSegments<'a> {
+    seg: *const RteMbuf,
+    first: Option<&'a [u8]>,
+    remaining: usize,
+    _packet: std::marker::PhantomData<&'a PacketData>,
 }
 
+impl<'a> Iterator for PayloadSegments<'a> {
+    type Item = &'a [u8];
+
+    #[inline(always)]
+    fn next(&mut self) -> Option<&'a [u8]> {
+        if let Some(first) = self.first.take() {
+            self.remaining -= first.len();
+            return Some(first);
+        }
+
+        if self.remaining == 0 || self.seg.is_null() {
+            return None;
+        }
+
+        let mut data = std::ptr::null();
+        let mut len = 0u32;
+        self.seg = unsafe { ffi::dpdk_packet_next_segment(self.seg, &mut data, &mut len) };
+        if self.seg.is_null() {
+            return None;
+        }
+
+        // Последний сегмент может содержать хвост кадра за пределами IP пакета
+        let len = (len as usize).min(self.remaining);
+        self.remaining -= len;
+        Some(unsafe { std::slice::from_raw_parts(data, len) })
+    }
+}
+
+// Дескриптор должен занимать ровно одну кеш-линию, как и его C-аналог
+const _: () = assert!(std::mem::size_of::<PacketData>() == 64);
+
 unsafe impl Send for PacketData {}
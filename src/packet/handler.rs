@@ -0,0 +1,88 @@
+// src/packet/handler.rs
+use crate::dpdk::ffi::RteMbuf;
+use crate::packet::data::PacketData;
+
+/// Разобранные пакеты одного burst, передаваемые обработчику
+///
+/// После возврата из обработчика worker освобождает mbuf всех пакетов,
+/// кроме помеченных через `keep`. Данные пакета (`get_data` и т.п.)
+/// указывают в mbuf и действительны только до этого момента.
+pub struct PacketBurst<'a> {
+    packets: &'a [PacketData],
+    keep_mask: u64,
+}
+
+impl<'a> PacketBurst<'a> {
+    #[inline(always)]
+    pub(crate) fn new(packets: &'a [PacketData]) -> Self {
+        Self {
+            packets,
+            keep_mask: 0,
+        }
+    }
+
+    /// Возвращает пакеты burst
+    #[inline(always)]
+    pub fn packets(&self) -> &'a [PacketData] {
+        self.packets
+    }
+
+    /// Количество пакетов в burst
+    #[inline(always)]
+    pub fn len(&self) -> usize {
+        self.packets.len()
+    }
+
+    /// Проверяет, пуст ли burst
+    #[inline(always)]
+    pub fn is_empty(&self) -> bool {
+        self.packets.is_empty()
+    }
+
+    /// Оставляет mbuf пакета `index` за обработчиком: worker не освободит его,
+    /// обработчик обязан сам вызвать `release_mbuf`, когда данные не нужны
+    #[inline(always)]
+    pub fn keep(&mut self, index: usize) -> *mut RteMbuf {
+        debug_assert!(index < self.packets.len());
+        self.keep_mask |= 1u64 << index;
+        self.packets[index].mbuf_ptr
+    }
+
+    /// Маска пакетов, mbuf которых оставлены обработчику
+    #[inline(always)]
+    pub fn kept_mask(&self) -> u64 {
+        self.keep_mask
+    }
+}
+
+/// Обработчик пакетов, вызываемый один раз на burst
+///
+/// Каждый worker получает собственную копию обработчика (через `Clone`),
+/// поэтому состояние не разделяется между потоками. Тип обработчика
+/// известен на этапе компиляции, и его код встраивается в RX цикл.
+pub trait BurstHandler: Send + 'static {
+    /// Обрабатывает разобранные пакеты burst, полученного из очереди `queue_id`
+    fn on_burst(&mut self, queue_id: u16, burst: &mut PacketBurst<'_>);
+}
+
+/// Адаптер для обработчиков, работающих с одним пакетом за вызов
+#[derive(Clone)]
+pub struct PerPacket<F>(pub F);
+
+impl<F> BurstHandler for PerPacket<F>
+where
+    F: FnMut(u16, &PacketData) + Send + 'static,
+{
+    #[inline(always)]
+    fn on_burst(&mut self, queue_id: u16, burst: &mut PacketBurst<'_>) {
+        for packet in burst.packets() {
+            (self.0)(queue_id, packet);
+        }
+    }
+}
+
+/// Освобождает mbuf, ранее оставленный обработчику через `PacketBurst::keep`
+#[inline(always)]
+pub unsafe fn release_mbuf(mbuf: *mut RteMbuf) {
+    crate::dpdk::ffi::rte_pktmbuf_free(mbuf);
+}
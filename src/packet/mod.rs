@@ -1,2 +1,5 @@
+pub mod classify;
 pub mod data;
+pub mod handler;
 pub mod pool;
+pub mod timestamp;
@@ -1,98 +1,109 @@
-use crossbeam::queue::ArrayQueue;
+// src/packet/pool.rs
+use std::alloc::{self, Layout};
+use std::marker::PhantomData;
 use std::os::raw::c_void;
-use std::sync::Arc;
+use std::ptr::NonNull;
 
+use crate::numa::arena::NodeArena;
 use crate::numa::ffi::NumaAllocator;
 use crate::packet::data::PacketData;
 
-/// Пул пакетов данных с поддержкой NUMA
-pub struct PacketDataPool {
-    /// Очередь с пакетами
-    queue: Arc<ArrayQueue<PacketData>>,
-    /// NUMA-узел, на котором выделена память
+/// Арена дескрипторов пакетов одного worker
+///
+/// Хранит `capacity` дескрипторов (обычно размер burst) подряд в памяти
+/// NUMA-узла worker, слоты адресуются индексом. Арена принадлежит одному
+/// потоку: нет атомарных операций и очередей, выделение происходит один раз
+/// при создании, поэтому в RX цикле арена не может "закончиться".
+pub struct PacketArena {
+    /// Начало массива дескрипторов
+    slots: NonNull<PacketData>,
+    /// Количество слотов
+    capacity: usize,
+    /// NUMA-узел, на котором выделена память (None - обычная куча)
     numa_node: Option<usize>,
-    /// Информация о выделенной памяти для корректного освобождения
-    allocated_memory: Option<(*mut c_void, usize)>,
+    /// Арена не должна разделяться между потоками
+    _not_sync: PhantomData<*mut PacketData>,
 }
 
-impl PacketDataPool {
-    /// Создает новый пул пакетов, оптимально в памяти конкретного узла NUMA
+impl PacketArena {
+    /// Создает арену, по возможности в памяти указанного узла NUMA
     pub fn new(capacity: usize, numa_node: Option<usize>) -> Self {
-        let queue = Arc::new(ArrayQueue::new(capacity));
-        let mut allocated_memory = None;
-
-        if let Some(node) = numa_node {
-            if NumaAllocator::is_available() {
-                println!(
-                    "Creating packet pool with NUMA-optimized memory on node {}",
-                    node
-                );
-
-                let packet_size = std::mem::size_of::<PacketData>();
-                let aligned_size = (packet_size + 63) & !63;
-                let total_size = aligned_size * capacity;
-
-                let memory = NumaAllocator::alloc_on_node(total_size, node);
-
-                if !memory.is_null() {
-                    allocated_memory = Some((memory, total_size));
-
-                    let memory_slice =
-                        unsafe { std::slice::from_raw_parts_mut(memory as *mut u8, total_size) };
-
-                    for i in 0..capacity {
-                        let offset = i * packet_size;
-                        let packet_ptr = memory_slice[offset..].as_mut_ptr() as *mut PacketData;
-
-                        unsafe {
-                            std::ptr::write(packet_ptr, PacketData::new());
-
-                            if queue.push(std::ptr::read(packet_ptr)).is_err() {
-                                break;
-                            }
-                        }
-                    }
-
-                    println!("Successfully allocated NUMA-optimized memory for packet pool");
-                } else {
-                    println!("Warning: Failed to allocate NUMA memory, falling back to regular allocation");
-                }
-            }
-        }
-
-        if allocated_memory.is_none() {
-            println!("Creating packet pool with regular memory allocation");
-            for _ in 0..capacity {
-                let data = PacketData::new();
-                let _ = queue.push(data);
-            }
+        let capacity = capacity.max(1);
+        let layout = Self::layout(capacity);
+
+        // Арена узла, затем numa_alloc_onnode, затем обычная куча
+        let numa_memory = numa_node
+            .and_then(NodeArena::get)
+            .map(|arena| (arena.alloc(layout) as *mut c_void, arena.node()))
+            .filter(|(memory, _)| !memory.is_null())
+            .or_else(|| {
+                numa_node
+                    .filter(|_| NumaAllocator::is_available())
+                    .map(|node| (NumaAllocator::alloc_on_node(layout.size(), node), node))
+                    .filter(|(memory, _)| !memory.is_null())
+            });
+
+        // Арена выравнивает блок по классу размера, numa_alloc_onnode - по
+        // странице, что покрывает align(64)
+        let (memory, numa_node) = match numa_memory {
+            Some((memory, node)) => (memory as *mut PacketData, Some(node)),
+            None => (unsafe { alloc::alloc(layout) } as *mut PacketData, None),
+        };
+
+        let slots = match NonNull::new(memory) {
+            Some(slots) => slots,
+            None => alloc::handle_alloc_error(layout),
+        };
+
+        // Заполнение выполняется потоком-владельцем, что также закрепляет
+        // страницы кучи за его узлом (first touch)
+        for i in 0..capacity {
+            unsafe { slots.as_ptr().add(i).write(PacketData::new()) };
         }
 
         Self {
-            queue,
+            slots,
+            capacity,
             numa_node,
-            allocated_memory,
+            _not_sync: PhantomData,
         }
     }
 
-    /// Получает пакет из пула
-    pub fn acquire(&self) -> PacketData {
-        match self.queue.pop() {
-            Some(packet) => packet,
-            None => {
-                println!("Warning: Packet pool is empty, creating new packet");
-                PacketData::new()
-            }
-        }
+    fn layout(capacity: usize) -> Layout {
+        Layout::array::<PacketData>(capacity).expect("packet arena size overflow")
+    }
+
+    /// Количество слотов в арене
+    #[inline(always)]
+    pub fn capacity(&self) -> usize {
+        self.capacity
     }
 
-    /// Возвращает пакет в пул
-    pub fn release(&self, mut packet: PacketData) {
-        packet.reset();
+    /// Возвращает дескриптор в слоте `index`
+    #[inline(always)]
+    pub fn slot(&self, index: usize) -> &PacketData {
+        assert!(index < self.capacity);
+        unsafe { &*self.slots.as_ptr().add(index) }
+    }
 
-        if self.queue.push(packet).is_err() {
-            println!("Warning: Failed to return packet to pool (pool is full)");
-        }
+    /// Возвращает изменяемый дескриптор в слоте `index`
+    #[inline(always)]
+    pub fn slot_mut(&mut self, index: usize) -> &mut PacketData {
+        assert!(index < self.capacity);
+        unsafe { &mut *self.slots.as_ptr().add(index) }
+    }
+
+    /// Возвращает первые `len` дескрипторов
+    #[inline(always)]
+    pub fn as_slice(&self, len: usize) -> &[PacketData] {
+        let len = len.min(self.capacity);
+        unsafe { std::slice::from_raw_parts(self.slots.as_ptr(), len) }
+    }
+
+    /// Указатель на начало массива для заполнения из нативного кода
+    #[inline(always)]
+    pub fn as_mut_ptr(&mut self) -> *mut PacketData {
+        self.slots.as_ptr()
     }
 
     /// Возвращает NUMA-узел, на котором выделена память
@@ -101,15 +112,22 @@ impl PacketDataPool {
     }
 }
 
-impl Drop for PacketDataPool {
+impl Drop for PacketArena {
     fn drop(&mut self) {
-        if let Some((ptr, size)) = self.allocated_memory {
-            println!("Freeing NUMA-allocated memory for packet pool");
-            NumaAllocator::free(ptr, size);
+        let layout = Self::layout(self.capacity);
+
+        // PacketData не владеет ресурсами, поэтому деструкторы слотов не нужны
+        let memory = self.slots.as_ptr() as *mut u8;
+        if let Some(arena) = NodeArena::owner_of(memory) {
+            unsafe { arena.dealloc(memory, layout) };
+            return;
+        }
+
+        match self.numa_node {
+            Some(_) => NumaAllocator::free(self.slots.as_ptr() as *mut c_void, layout.size()),
+            None => unsafe { alloc::dealloc(self.slots.as_ptr() as *mut u8, layout) },
         }
     }
 }
 
-unsafe impl Send for PacketDataPool {}
-
-unsafe impl Sync for PacketDataPool {}
+unsafe impl Send for PacketArena {}
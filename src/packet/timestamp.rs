@@ -0,0 +1,188 @@
+// src/packet/timestamp.rs
+use crate::dpdk::ffi;
+
+/// Источник времени прихода пакетов
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum RxTimestampMode {
+    /// Время прихода не проставляется, задержки не измеряются
+    Off,
+    /// Время возврата `rte_eth_rx_burst` по TSC, одно чтение на burst
+    Tsc,
+    /// Аппаратная метка NIC (RX offload timestamp), переведенная в такты TSC;
+    /// если драйвер не поддерживает offload, используется `Tsc`
+    Hardware,
+}
+
+impl Default for RxTimestampMode {
+    fn default() -> Self {
+        RxTimestampMode::Off
+    }
+}
+
+/// Читает счетчик тактов процессора
+#[inline(always)]
+pub fn tsc() -> u64 {
+    #[cfg(target_arch = "x86_64")]
+    {
+        unsafe { std::arch::x86_64::_rdtsc() }
+    }
+
+    #[cfg(not(target_arch = "x86_64"))]
+    {
+        unsafe { ffi::dpdk_tsc_cycles() }
+    }
+}
+
+/// Частота TSC в герцах по калибровке EAL
+pub fn tsc_hz() -> u64 {
+    unsafe { ffi::rte_get_tsc_hz() }
+}
+
+/// Переводит такты TSC в наносекунды
+#[inline]
+pub fn cycles_to_ns(cycles: u64, hz: u64) -> u64 {
+    if hz == 0 {
+        return 0;
+    }
+    ((cycles as u128 * 1_000_000_000) / hz as u128) as u64
+}
+
+/// Параметры перевода времени в домен TSC, передаются в dpdk_parse_burst
+///
+/// Раскладка совпадает с `struct dpdk_rx_clock` в src/native/dpdk.c.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct RxClock {
+    /// TSC в момент возврата rte_eth_rx_burst, метка пакетов без HW timestamp
+    pub burst_tsc: u64,
+    /// Показание часов NIC в последней точке синхронизации
+    pub nic_ref: u64,
+    /// TSC в последней точке синхронизации
+    pub tsc_ref: u64,
+    /// Тактов TSC на такт часов NIC
+    pub tsc_per_tick: f64,
+    /// Ненулевое значение - аппаратные метки включены
+    pub hw: i32,
+    pub _reserved: i32,
+}
+
+/// Часы RX одного worker
+///
+/// Для аппаратных меток периодически сопоставляет часы NIC с TSC:
+/// наклон оценивается по двум соседним точкам синхронизации, поэтому
+/// дрейф частоты NIC учитывается без отдельного потока.
+pub struct RxClockSync {
+    port_id: u16,
+    clock: RxClock,
+    sync_interval: u64,
+    next_sync: u64,
+}
+
+impl RxClockSync {
+    /// Интервал синхронизации часов NIC и TSC
+    const SYNC_INTERVAL_MS: u64 = 100;
+
+    /// Создает часы для очереди порта; `None`, если метки отключены
+    pub fn new(port_id: u16, mode: RxTimestampMode) -> Option<Self> {
+        if mode == RxTimestampMode::Off {
+            return None;
+        }
+
+        let hz = tsc_hz();
+        let mut sync = Self {
+            port_id,
+            clock: RxClock {
+                burst_tsc: 0,
+                nic_ref: 0,
+                tsc_ref: 0,
+                tsc_per_tick: 0.0,
+                hw: 0,
+                _reserved: 0,
+            },
+            sync_interval: hz / 1000 * Self::SYNC_INTERVAL_MS,
+            next_sync: 0,
+        };
+
+        let hw_active = unsafe { ffi::dpdk_rx_timestamp_active(port_id) } != 0;
+        if mode == RxTimestampMode::Hardware && hw_active {
+            if let Err(e) = sync.calibrate(hz) {
+                eprintln!("{}, falling back to TSC timestamps", e);
+            }
+        }
+
+        Some(sync)
+    }
+
+    /// Начальная оценка наклона по двум точкам с интервалом ~1 мс
+    fn calibrate(&mut self, hz: u64) -> Result<(), String> {
+        let (nic_start, tsc_start) = self.read_pair()?;
+
+        let deadline = tsc_start + hz / 1000;
+        while tsc() < deadline {
+            std::hint::spin_loop();
+        }
+
+        let (nic_end, tsc_end) = self.read_pair()?;
+        if nic_end <= nic_start {
+            return Err(format!("NIC clock of port {} does not advance", self.port_id));
+        }
+
+        self.clock.tsc_per_tick = (tsc_end - tsc_start) as f64 / (nic_end - nic_start) as f64;
+        self.clock.nic_ref = nic_end;
+        self.clock.tsc_ref = tsc_end;
+        self.clock.hw = 1;
+        self.next_sync = tsc_end + self.sync_interval;
+
+        Ok(())
+    }
+
+    /// Читает часы NIC и TSC как можно ближе друг к другу
+    #[inline]
+    fn read_pair(&self) -> Result<(u64, u64), String> {
+        let mut nic = 0u64;
+        let ret = unsafe { ffi::rte_eth_read_clock(self.port_id, &mut nic) };
+        if ret != 0 {
+            return Err(format!(
+                "Failed to read NIC clock of port {}: {}",
+                self.port_id, ret
+            ));
+        }
+        Ok((nic, tsc()))
+    }
+
+    /// Фиксирует время очередного burst; вызывается сразу после rte_eth_rx_burst
+    #[inline(always)]
+    pub fn begin_burst(&mut self) {
+        let now = tsc();
+        self.clock.burst_tsc = now;
+
+        if self.clock.hw != 0 && now >= self.next_sync {
+            self.resync(now);
+        }
+    }
+
+    #[cold]
+    fn resync(&mut self, now: u64) {
+        self.next_sync = now + self.sync_interval;
+
+        if let Ok((nic, tsc_now)) = self.read_pair() {
+            if nic > self.clock.nic_ref {
+                self.clock.tsc_per_tick =
+                    (tsc_now - self.clock.tsc_ref) as f64 / (nic - self.clock.nic_ref) as f64;
+                self.clock.nic_ref = nic;
+                self.clock.tsc_ref = tsc_now;
+            }
+        }
+    }
+
+    /// Используются ли аппаратные метки
+    pub fn is_hardware(&self) -> bool {
+        self.clock.hw != 0
+    }
+
+    /// Параметры для dpdk_parse_burst
+    #[inline(always)]
+    pub fn clock(&self) -> &RxClock {
+        &self.clock
+    }
+}
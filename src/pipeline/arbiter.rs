@@ -0,0 +1,407 @@
+// src/pipeline/arbiter.rs
+use std::sync::Arc;
+
+use crate::dpdk::config::MAX_BURST_SIZE;
+use crate::packet::handler::{BurstHandler, PacketBurst};
+use crate::packet::pool::PacketArena;
+use crate::packet::timestamp::{tsc, tsc_hz};
+use crate::pipeline::ring::{Consumer, Producer, SpscRing};
+use crate::protocols::mdp3;
+use crate::protocols::moldudp64::{self, MoldPacket};
+use crate::protocols::wire::WireField;
+use crate::telemetry::worker::Counter;
+
+/// Максимальное число одновременно ожидающих разрывов
+const MAX_PENDING_GAPS: usize = 16;
+
+/// Диапазон порядковых номеров пакета фида
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SequenceRange {
+    /// Номер первого сообщения (или пакета)
+    pub first: u64,
+    /// Количество номеров в пакете; 0 - heartbeat
+    pub count: u64,
+}
+
+/// Извлекает порядковые номера из полезной нагрузки пакета фида
+pub trait FeedSequence: Send + 'static {
+    fn sequence(&self, payload: &[u8]) -> Option<SequenceRange>;
+}
+
+/// Номера сообщений MoldUDP64
+#[derive(Debug, Clone, Copy, Default)]
+pub struct MoldUdp64Sequence;
+
+impl FeedSequence for MoldUdp64Sequence {
+    #[inline(always)]
+    fn sequence(&self, payload: &[u8]) -> Option<SequenceRange> {
+        let packet = MoldPacket::parse(payload).ok()?;
+        let count = match packet.message_count() {
+            moldudp64::END_OF_SESSION => 0,
+            count => count as u64,
+        };
+
+        Some(SequenceRange {
+            first: packet.sequence(),
+            count,
+        })
+    }
+}
+
+/// Номера пакетов CME MDP 3.0 (MsgSeqNum заголовка пакета)
+#[derive(Debug, Clone, Copy, Default)]
+pub struct Mdp3Sequence;
+
+impl FeedSequence for Mdp3Sequence {
+    #[inline(always)]
+    fn sequence(&self, payload: &[u8]) -> Option<SequenceRange> {
+        if payload.len() < mdp3::PACKET_HEADER_LEN {
+            return None;
+        }
+
+        Some(SequenceRange {
+            first: unsafe { u32::read_le(payload, 0) } as u64,
+            count: 1,
+        })
+    }
+}
+
+/// Разрыв, не закрытый ни одной из линий за отведенное время
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct GapRequest {
+    /// Первый пропущенный номер
+    pub from: u64,
+    /// Номер, следующий за последним пропущенным
+    pub to: u64,
+    /// TSC обнаружения разрыва
+    pub detected_tsc: u64,
+}
+
+/// Линии фида A/B: (порт, очередь) каждой линии
+#[derive(Debug, Clone)]
+pub struct ArbitrationConfig {
+    pub line_a: (u16, u16),
+    pub line_b: (u16, u16),
+    /// Сколько ждать пакет из разрыва от второй линии, прежде чем
+    /// передать разрыв на восстановление
+    pub gap_timeout_us: u64,
+    /// Емкость кольца запросов восстановления
+    pub recovery_ring_size: usize,
+}
+
+impl ArbitrationConfig {
+    pub fn new(line_a: (u16, u16), line_b: (u16, u16)) -> Self {
+        Self {
+            line_a,
+            line_b,
+            gap_timeout_us: 500,
+            recovery_ring_size: 1024,
+        }
+    }
+
+    pub fn with_gap_timeout_us(mut self, gap_timeout_us: u64) -> Self {
+        self.gap_timeout_us = gap_timeout_us;
+        self
+    }
+}
+
+/// Счетчики арбитража, пишет RX worker арбитра
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct ArbiterStats {
+    /// Пакеты, переданные дальше (первое поступление)
+    pub forwarded: Counter,
+    /// Дубликаты, отброшенные арбитром
+    pub duplicates: Counter,
+    /// Пакеты второй линии, закрывшие часть ожидающего разрыва
+    pub gap_fills: Counter,
+    /// Пакеты, лишь частично перекрывающие уже переданные номера: пакет
+    /// нельзя урезать, не переписав payload, поэтому он не передается, а
+    /// новые номера остаются разрывом до другой линии или восстановления
+    pub partial_overlaps: Counter,
+    /// Пакеты без распознаваемого номера (переданы без арбитража)
+    pub unsequenced: Counter,
+    /// Heartbeat пакеты (не передаются)
+    pub heartbeats: Counter,
+    /// Разрывы, переданные на восстановление
+    pub gaps_escalated: Counter,
+    /// Номеров в разрывах, переданных на восстановление
+    pub gap_sequences: Counter,
+    /// Запросы восстановления, не поместившиеся в кольцо
+    pub recovery_dropped: Counter,
+}
+
+/// Арбитраж пары линий, запущенный на узле
+#[derive(Debug, Clone)]
+pub struct FeedArbitration {
+    pub line_a: (u16, u16),
+    pub line_b: (u16, u16),
+    pub stats: Arc<ArbiterStats>,
+}
+
+#[derive(Debug, Clone, Copy)]
+struct PendingGap {
+    from: u64,
+    to: u64,
+    detected_tsc: u64,
+}
+
+/// Арбитр линий A/B
+///
+/// Оборачивает обработчик и пропускает к нему только первое поступление
+/// каждого диапазона номеров с любой из линий; обе линии опрашиваются
+/// одним RX worker (`NumaNode::start_arbitrated_feed`), поэтому состояние
+/// арбитра принадлежит одному потоку и не требует синхронизации.
+///
+/// При скачке номера разрыв запоминается, а живой поток продолжает
+/// передаваться без ожидания. Пакет второй линии, целиком попадающий в
+/// разрыв, передается и сужает его; пакет, частично перекрывающий уже
+/// переданные номера, не передается вовсе, чтобы обработчик не получил
+/// сообщения повторно. Разрыв, не закрытый за `gap_timeout`,
+/// отправляется в кольцо восстановления (без блокировки: при переполнении
+/// запрос отбрасывается и учитывается). Истечение проверяется при каждом
+/// burst; heartbeat пакеты фида гарантируют проверку и при тишине рынка.
+pub struct LineArbiter<H, S> {
+    inner: H,
+    sequence: S,
+    /// Следующий ожидаемый номер, 0 - еще не известен
+    next: u64,
+    pending: [PendingGap; MAX_PENDING_GAPS],
+    nb_pending: usize,
+    gap_timeout_cycles: u64,
+    recovery: Producer<GapRequest>,
+    forwarded: PacketArena,
+    origin: [u8; MAX_BURST_SIZE],
+    stats: Arc<ArbiterStats>,
+}
+
+impl<H: BurstHandler, S: FeedSequence> LineArbiter<H, S> {
+    /// Создает арбитр; возвращает его и сторону потребителя кольца восстановления
+    pub fn new(inner: H, sequence: S, config: &ArbitrationConfig) -> (Self, Consumer<GapRequest>) {
+        let (recovery, consumer) = SpscRing::new(config.recovery_ring_size);
+
+        let arbiter = Self {
+            inner,
+            sequence,
+            next: 0,
+            pending: [PendingGap {
+                from: 0,
+                to: 0,
+                detected_tsc: 0,
+            }; MAX_PENDING_GAPS],
+            nb_pending: 0,
+            gap_timeout_cycles: config.gap_timeout_us * tsc_hz() / 1_000_000,
+            recovery,
+            forwarded: PacketArena::new(MAX_BURST_SIZE, None),
+            origin: [0; MAX_BURST_SIZE],
+            stats: Arc::new(ArbiterStats::default()),
+        };
+
+        (arbiter, consumer)
+    }
+
+    pub fn stats(&self) -> &Arc<ArbiterStats> {
+        &self.stats
+    }
+
+    /// Обернутый обработчик
+    pub fn inner(&self) -> &H {
+        &self.inner
+    }
+
+    /// Обернутый обработчик для замены на ходу: номера, разрывы и кольцо
+    /// восстановления арбитра при этом сохраняются
+    pub fn inner_mut(&mut self) -> &mut H {
+        &mut self.inner
+    }
+
+    /// Решает судьбу пакета: true - передать обработчику
+    #[inline(always)]
+    fn admit(&mut self, range: SequenceRange, now: u64) -> bool {
+        let end = range.first + range.count;
+
+        if self.next == 0 {
+            self.next = end.max(range.first);
+            if range.count == 0 {
+                self.stats.heartbeats.inc();
+                return false;
+            }
+            return true;
+        }
+
+        if range.first > self.next {
+            // Скачок вперед: запоминаем разрыв, живой поток не ждет
+            self.open_gap(self.next, range.first, now);
+            self.next = end.max(range.first);
+        } else if end > self.next {
+            if range.first < self.next {
+                // Начало пакета уже передано: next не двигаем, и номера
+                // [next, end) придут следующим пакетом или станут разрывом
+                self.stats.partial_overlaps.inc();
+                return false;
+            }
+            // Продолжение потока
+            self.next = end;
+        } else if range.count > 0 && self.fill_gap(range.first, end) {
+            self.stats.gap_fills.inc();
+            return true;
+        } else {
+            if range.count == 0 {
+                self.stats.heartbeats.inc();
+            } else if self.overlaps_gap(range.first, end) {
+                // Разрывы не пересекаются, поэтому пересечение без вхождения
+                // означает, что часть номеров пакета уже передана
+                self.stats.partial_overlaps.inc();
+            } else {
+                self.stats.duplicates.inc();
+            }
+            return false;
+        }
+
+        if range.count == 0 {
+            self.stats.heartbeats.inc();
+            return false;
+        }
+        true
+    }
+
+    #[inline(always)]
+    fn open_gap(&mut self, from: u64, to: u64, now: u64) {
+        if self.nb_pending == MAX_PENDING_GAPS {
+            // Нет места: самый старый разрыв сразу уходит на восстановление
+            let oldest = self.pending[0];
+            self.escalate(oldest);
+            self.pending.copy_within(1.., 0);
+            self.nb_pending -= 1;
+        }
+
+        self.pending[self.nb_pending] = PendingGap {
+            from,
+            to,
+            detected_tsc: now,
+        };
+        self.nb_pending += 1;
+    }
+
+    /// Сужает разрыв, целиком содержащий [first, end); false - такого
+    /// разрыва нет (диапазон уже передан полностью или частично)
+    #[inline(always)]
+    fn fill_gap(&mut self, first: u64, end: u64) -> bool {
+        let i = match self.pending[..self.nb_pending]
+            .iter()
+            .position(|gap| gap.from <= first && end <= gap.to)
+        {
+            Some(i) => i,
+            None => return false,
+        };
+
+        let gap = self.pending[i];
+        let left = (gap.from < first).then(|| PendingGap { to: first, ..gap });
+        let right = (end < gap.to).then(|| PendingGap { from: end, ..gap });
+
+        match (left, right) {
+            (Some(left), Some(right)) => {
+                self.pending[i] = left;
+                if self.nb_pending < MAX_PENDING_GAPS {
+                    self.pending[self.nb_pending] = right;
+                    self.nb_pending += 1;
+                } else {
+                    self.escalate(right);
+                }
+            }
+            (Some(part), None) | (None, Some(part)) => self.pending[i] = part,
+            (None, None) => {
+                self.pending[i] = self.pending[self.nb_pending - 1];
+                self.nb_pending -= 1;
+            }
+        }
+
+        true
+    }
+
+    /// Пересекает ли [first, end) хотя бы один ожидающий разрыв
+    #[inline(always)]
+    fn overlaps_gap(&self, first: u64, end: u64) -> bool {
+        self.pending[..self.nb_pending]
+            .iter()
+            .any(|gap| first < gap.to && gap.from < end)
+    }
+
+    /// Отправляет истекшие разрывы на восстановление
+    #[inline(always)]
+    fn expire_gaps(&mut self, now: u64) {
+        let mut i = 0;
+        while i < self.nb_pending {
+            let gap = self.pending[i];
+            if now.wrapping_sub(gap.detected_tsc) >= self.gap_timeout_cycles {
+                self.escalate(gap);
+                self.pending[i] = self.pending[self.nb_pending - 1];
+                self.nb_pending -= 1;
+            } else {
+                i += 1;
+            }
+        }
+    }
+
+    #[inline(always)]
+    fn escalate(&mut self, gap: PendingGap) {
+        self.stats.gaps_escalated.inc();
+        self.stats.gap_sequences.add(gap.to - gap.from);
+
+        let request = GapRequest {
+            from: gap.from,
+            to: gap.to,
+            detected_tsc: gap.detected_tsc,
+        };
+        if self.recovery.push(request).is_err() {
+            self.stats.recovery_dropped.inc();
+            self.recovery.ring().stats().dropped.inc();
+        }
+    }
+}
+
+impl<H: BurstHandler, S: FeedSequence> BurstHandler for LineArbiter<H, S> {
+    #[inline(always)]
+    fn on_burst(&mut self, queue_id: u16, burst: &mut PacketBurst<'_>) {
+        let now = tsc();
+        let mut nb_fwd = 0;
+
+        for (index, packet) in burst.packets().iter().enumerate() {
+            let admit = match self.sequence.sequence(packet.get_data()) {
+                Some(range) => self.admit(range, now),
+                None => {
+                    self.stats.unsequenced.inc();
+                    true
+                }
+            };
+
+            if admit {
+                // Дескриптор - POD, mbuf остается за RX worker
+                *self.forwarded.slot_mut(nb_fwd) = unsafe { std::ptr::read(packet) };
+                self.origin[nb_fwd] = index as u8;
+                nb_fwd += 1;
+            }
+        }
+
+        if self.nb_pending > 0 {
+            self.expire_gaps(now);
+        }
+        self.recovery.publish();
+
+        if nb_fwd == 0 {
+            return;
+        }
+        self.stats.forwarded.add(nb_fwd as u64);
+
+        let mut inner_burst = PacketBurst::new(self.forwarded.as_slice(nb_fwd));
+        self.inner.on_burst(queue_id, &mut inner_burst);
+
+        // Переносим mbuf, оставленные обработчику, на исходные индексы burst
+        let mut kept = inner_burst.kept_mask();
+        while kept != 0 {
+            let i = kept.trailing_zeros() as usize;
+            burst.keep(self.origin[i] as usize);
+            kept &= kept - 1;
+        }
+    }
+}
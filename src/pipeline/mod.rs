@@ -0,0 +1,4 @@
+pub mod arbiter;
+pub mod ring;
+pub mod shm;
+pub mod stage;
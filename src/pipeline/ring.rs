@@ -0,0 +1,215 @@
+// src/pipeline/ring.rs
+use std::cell::UnsafeCell;
+use std::mem::MaybeUninit;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Arc;
+
+use crate::telemetry::worker::Counter;
+
+/// Значение в собственной кеш-линии, чтобы индексы производителя и
+/// потребителя не делили линию (false sharing)
+#[repr(C, align(64))]
+struct CachePadded<T>(T);
+
+/// Кольцо с одним производителем и одним потребителем
+///
+/// Емкость - степень двойки. Стороны хранят копию индекса
+/// противоположной стороны и перечитывают его только когда кольцо
+/// выглядит полным (пустым), а свой индекс публикуют один раз на
+/// пачку элементов (`publish` / `release`). Гарантия SPSC обеспечивается
+/// типами: `Producer` и `Consumer` существуют в единственном экземпляре.
+pub struct SpscRing<T> {
+    /// Индекс следующего элемента для чтения, пишет потребитель
+    head: CachePadded<AtomicUsize>,
+    /// Индекс следующего свободного слота, пишет производитель
+    tail: CachePadded<AtomicUsize>,
+    /// Счетчики производителя, доступны для отчетов после запуска стадий
+    stats: Arc<RingStats>,
+    slots: Box<[UnsafeCell<MaybeUninit<T>>]>,
+    mask: usize,
+}
+
+/// Счетчики кольца, пишет производитель
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct RingStats {
+    /// Элементы, помещенные в кольцо
+    pub enqueued: Counter,
+    /// Элементы, отброшенные из-за переполнения
+    pub dropped: Counter,
+    /// Ожидания освобождения места (политика Block)
+    pub stalls: Counter,
+}
+
+unsafe impl<T: Send> Send for SpscRing<T> {}
+unsafe impl<T: Send> Sync for SpscRing<T> {}
+
+impl<T> SpscRing<T> {
+    /// Создает кольцо и возвращает его стороны; емкость округляется до степени двойки
+    pub fn new(capacity: usize) -> (Producer<T>, Consumer<T>) {
+        let capacity = capacity.max(2).next_power_of_two();
+        let slots = (0..capacity)
+            .map(|_| UnsafeCell::new(MaybeUninit::uninit()))
+            .collect();
+
+        let ring = Arc::new(SpscRing {
+            head: CachePadded(AtomicUsize::new(0)),
+            tail: CachePadded(AtomicUsize::new(0)),
+            stats: Arc::new(RingStats::default()),
+            slots,
+            mask: capacity - 1,
+        });
+
+        (
+            Producer {
+                ring: ring.clone(),
+                tail: 0,
+                published_tail: 0,
+                cached_head: 0,
+            },
+            Consumer {
+                ring,
+                head: 0,
+                released_head: 0,
+                cached_tail: 0,
+            },
+        )
+    }
+
+    /// Емкость кольца
+    pub fn capacity(&self) -> usize {
+        self.mask + 1
+    }
+
+    /// Количество элементов в кольце (приблизительно, для отчетов)
+    pub fn len(&self) -> usize {
+        let tail = self.tail.0.load(Ordering::Relaxed);
+        let head = self.head.0.load(Ordering::Relaxed);
+        tail.wrapping_sub(head)
+    }
+
+    /// Счетчики кольца
+    pub fn stats(&self) -> &Arc<RingStats> {
+        &self.stats
+    }
+
+    #[inline(always)]
+    unsafe fn slot(&self, index: usize) -> *mut MaybeUninit<T> {
+        self.slots.get_unchecked(index & self.mask).get()
+    }
+}
+
+impl<T> Drop for SpscRing<T> {
+    fn drop(&mut self) {
+        let head = *self.head.0.get_mut();
+        let tail = *self.tail.0.get_mut();
+
+        for index in head..tail {
+            unsafe { (*self.slot(index)).assume_init_drop() };
+        }
+    }
+}
+
+/// Сторона производителя
+pub struct Producer<T> {
+    ring: Arc<SpscRing<T>>,
+    tail: usize,
+    published_tail: usize,
+    cached_head: usize,
+}
+
+unsafe impl<T: Send> Send for Producer<T> {}
+
+impl<T> Producer<T> {
+    /// Помещает элемент без публикации; при переполнении возвращает его обратно
+    #[inline(always)]
+    pub fn push(&mut self, item: T) -> Result<(), T> {
+        if self.tail.wrapping_sub(self.cached_head) > self.ring.mask {
+            self.cached_head = self.ring.head.0.load(Ordering::Acquire);
+            if self.tail.wrapping_sub(self.cached_head) > self.ring.mask {
+                return Err(item);
+            }
+        }
+
+        unsafe { (*self.ring.slot(self.tail)).write(item) };
+        self.tail = self.tail.wrapping_add(1);
+        Ok(())
+    }
+
+    /// Делает помещенные элементы видимыми потребителю
+    #[inline(always)]
+    pub fn publish(&mut self) {
+        if self.tail != self.published_tail {
+            let n = self.tail.wrapping_sub(self.published_tail);
+            self.ring.stats.enqueued.add(n as u64);
+            self.ring.tail.0.store(self.tail, Ordering::Release);
+            self.published_tail = self.tail;
+        }
+    }
+
+    /// Свободное место с точки зрения производителя
+    #[inline(always)]
+    pub fn free_space(&mut self) -> usize {
+        self.cached_head = self.ring.head.0.load(Ordering::Acquire);
+        self.ring.capacity() - self.tail.wrapping_sub(self.cached_head)
+    }
+
+    /// Кольцо, общее с потребителем
+    pub fn ring(&self) -> &Arc<SpscRing<T>> {
+        &self.ring
+    }
+}
+
+impl<T> Drop for Producer<T> {
+    fn drop(&mut self) {
+        self.publish();
+    }
+}
+
+/// Сторона потребителя
+pub struct Consumer<T> {
+    ring: Arc<SpscRing<T>>,
+    head: usize,
+    released_head: usize,
+    cached_tail: usize,
+}
+
+unsafe impl<T: Send> Send for Consumer<T> {}
+
+impl<T> Consumer<T> {
+    /// Извлекает элемент; освобожденный слот становится доступен
+    /// производителю после `release`
+    #[inline(always)]
+    pub fn pop(&mut self) -> Option<T> {
+        if self.head == self.cached_tail {
+            self.cached_tail = self.ring.tail.0.load(Ordering::Acquire);
+            if self.head == self.cached_tail {
+                return None;
+            }
+        }
+
+        let item = unsafe { (*self.ring.slot(self.head)).assume_init_read() };
+        self.head = self.head.wrapping_add(1);
+        Some(item)
+    }
+
+    /// Возвращает прочитанные слоты производителю
+    #[inline(always)]
+    pub fn release(&mut self) {
+        if self.head != self.released_head {
+            self.ring.head.0.store(self.head, Ordering::Release);
+            self.released_head = self.head;
+        }
+    }
+
+    /// Кольцо, общее с производителем
+    pub fn ring(&self) -> &Arc<SpscRing<T>> {
+        &self.ring
+    }
+}
+
+impl<T> Drop for Consumer<T> {
+    fn drop(&mut self) {
+        self.release();
+    }
+}
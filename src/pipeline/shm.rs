@@ -0,0 +1,436 @@
+// src/pipeline/shm.rs
+use std::cell::UnsafeCell;
+use std::fs::{self, File, OpenOptions};
+use std::marker::PhantomData;
+use std::mem::{align_of, size_of, MaybeUninit};
+use std::os::unix::io::AsRawFd;
+use std::sync::atomic::{fence, AtomicU32, AtomicU64, Ordering};
+use std::sync::Arc;
+
+use crate::dpdk::hugepages::{find_hugetlbfs_mount, mount_hugetlbfs};
+use crate::pipeline::stage::Strategy;
+
+/// Признак инициализированного заголовка кольца
+const SHM_MAGIC: u64 = 0x4846_4545_4353_484D;
+const SHM_VERSION: u32 = 1;
+
+/// Каталог для колец, если hugetlbfs не найдена (обычные 4 КБ страницы)
+const FALLBACK_DIR: &str = "/dev/shm";
+
+/// Событие, которое можно передавать между процессами побайтовой копией
+///
+/// # Safety
+/// Тип не должен содержать указателей, ссылок и владеющих полей (`Vec`,
+/// `String`, `Box`): читатель в другом процессе получает копию байтов.
+/// Раскладка должна быть фиксированной (`#[repr(C)]`).
+pub unsafe trait ShmEvent: Copy + Send + 'static {
+    /// Идентификатор раскладки: читатель с другим значением не откроет
+    /// кольцо. Менять при любом изменении полей
+    const LAYOUT_ID: u64;
+}
+
+/// Параметры кольца в разделяемой памяти
+#[derive(Debug, Clone)]
+pub struct ShmRingConfig {
+    /// Имя файла кольца в каталоге hugetlbfs
+    pub name: String,
+    /// Количество слотов, округляется до степени двойки
+    pub capacity: usize,
+    /// Размер hugepage, на которой размещается кольцо (КБ)
+    pub page_size_kb: u64,
+    /// Каталог файла; None - найти точку монтирования hugetlbfs
+    pub dir: Option<String>,
+    /// Куда смонтировать hugetlbfs, если точка монтирования не найдена
+    pub mount_path: Option<String>,
+}
+
+impl ShmRingConfig {
+    pub fn new(name: &str, capacity: usize) -> Self {
+        Self {
+            name: name.to_string(),
+            capacity,
+            page_size_kb: 2048,
+            dir: None,
+            mount_path: None,
+        }
+    }
+
+    /// Путь к файлу кольца
+    ///
+    /// Каталог ищется так же, как hugepage память EAL; без hugetlbfs кольцо
+    /// создается в /dev/shm.
+    pub fn path(&self) -> String {
+        let dir = self.dir.clone().or_else(|| {
+            find_hugetlbfs_mount(self.page_size_kb).or_else(|| {
+                let mount = self.mount_path.as_deref()?;
+                let page_size = format!("{}K", self.page_size_kb);
+                match mount_hugetlbfs(mount, &page_size) {
+                    Ok(()) => Some(mount.to_string()),
+                    Err(e) => {
+                        eprintln!("Failed to mount hugetlbfs at {}: {}", mount, e);
+                        None
+                    }
+                }
+            })
+        });
+
+        match dir {
+            Some(dir) => format!("{}/hfeec-{}", dir.trim_end_matches('/'), self.name),
+            None => {
+                eprintln!(
+                    "Warning: no hugetlbfs mount with {} KB pages, ring {} uses {}",
+                    self.page_size_kb, self.name, FALLBACK_DIR
+                );
+                format!("{}/hfeec-{}", FALLBACK_DIR, self.name)
+            }
+        }
+    }
+}
+
+#[repr(C, align(64))]
+struct CachePadded<T>(T);
+
+/// Заголовок кольца: неизменяемые параметры и индекс записи
+#[repr(C)]
+struct ShmHeader {
+    /// Записывается последним; читатель открывает только готовое кольцо
+    magic: AtomicU64,
+    layout_id: u64,
+    capacity: u64,
+    version: u32,
+    event_size: u32,
+    event_align: u32,
+    slot_size: u32,
+    /// Ненулевое значение - издатель закрыл кольцо
+    closed: AtomicU32,
+    /// Номер следующего события, увеличивают издатели
+    tail: CachePadded<AtomicU64>,
+}
+
+/// Слот кольца под seqlock
+///
+/// `seq` = 2n+1, пока пишется событие n, и 2n+2 после записи. Читатель
+/// события n ждет 2n+2; большее значение означает, что слот уже занят
+/// событием следующего круга и читатель отстал.
+#[repr(C, align(64))]
+struct Slot<E> {
+    seq: AtomicU64,
+    event: UnsafeCell<MaybeUninit<E>>,
+}
+
+/// Отображение файла кольца
+struct ShmMapping {
+    base: *mut u8,
+    len: usize,
+    capacity: u64,
+    slots_offset: usize,
+}
+
+unsafe impl Send for ShmMapping {}
+unsafe impl Sync for ShmMapping {}
+
+impl ShmMapping {
+    #[inline(always)]
+    fn header(&self) -> &ShmHeader {
+        unsafe { &*(self.base as *const ShmHeader) }
+    }
+
+    #[inline(always)]
+    fn slot<E>(&self, seq: u64) -> &Slot<E> {
+        let index = (seq & (self.capacity - 1)) as usize;
+        unsafe {
+            &*(self
+                .base
+                .add(self.slots_offset + index * size_of::<Slot<E>>())
+                as *const Slot<E>)
+        }
+    }
+
+    fn map(file: &File, len: usize, writable: bool) -> Result<*mut u8, String> {
+        let prot = if writable {
+            libc::PROT_READ | libc::PROT_WRITE
+        } else {
+            libc::PROT_READ
+        };
+        // Страницы отображаются сразу, а не по первому обращению на горячем пути
+        let flags = libc::MAP_SHARED | libc::MAP_POPULATE;
+
+        let base =
+            unsafe { libc::mmap(std::ptr::null_mut(), len, prot, flags, file.as_raw_fd(), 0) };
+        if base == libc::MAP_FAILED {
+            return Err(format!(
+                "Failed to map shared ring: {}",
+                std::io::Error::last_os_error()
+            ));
+        }
+        Ok(base as *mut u8)
+    }
+}
+
+impl Drop for ShmMapping {
+    fn drop(&mut self) {
+        unsafe { libc::munmap(self.base as *mut libc::c_void, self.len) };
+    }
+}
+
+fn slots_offset() -> usize {
+    (size_of::<ShmHeader>() + 63) & !63
+}
+
+/// Владелец кольца у издателей: при уничтожении последнего помечает
+/// кольцо закрытым
+struct ShmRegion {
+    mapping: ShmMapping,
+    path: String,
+}
+
+impl Drop for ShmRegion {
+    fn drop(&mut self) {
+        self.mapping.header().closed.store(1, Ordering::Release);
+    }
+}
+
+/// Издатель событий в кольцо в разделяемой памяти (hugetlbfs)
+///
+/// Кольцо широковещательное: каждый читатель в своем процессе видит все
+/// события и ведет собственную позицию, издатель читателей не ждет и о
+/// них не знает. Клоны издателя пишут в то же кольцо (по одному на ядро
+/// стратегии конвейера): номер события выдается `fetch_add` индекса
+/// записи, слот защищен seqlock. Издатель ждет только другого издателя,
+/// если тот не дописал слот за полный круг кольца.
+pub struct ShmPublisher<E: ShmEvent> {
+    region: Arc<ShmRegion>,
+    _event: PhantomData<E>,
+}
+
+impl<E: ShmEvent> Clone for ShmPublisher<E> {
+    fn clone(&self) -> Self {
+        Self {
+            region: self.region.clone(),
+            _event: PhantomData,
+        }
+    }
+}
+
+impl<E: ShmEvent> ShmPublisher<E> {
+    /// Создает кольцо; существующий файл с тем же именем заменяется
+    ///
+    /// Читатели, открывшие прежний файл, видят его закрытым только если
+    /// прежний издатель завершился штатно; после перезапуска издателя
+    /// читатели должны открыть кольцо заново.
+    pub fn create(config: &ShmRingConfig) -> Result<Self, String> {
+        let capacity = config.capacity.max(2).next_power_of_two() as u64;
+        let slots_len = capacity as usize * size_of::<Slot<E>>();
+        let page = (config.page_size_kb as usize * 1024).max(4096);
+        let len = (slots_offset() + slots_len + page - 1) / page * page;
+
+        let path = config.path();
+        let _ = fs::remove_file(&path);
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create_new(true)
+            .open(&path)
+            .map_err(|e| format!("Failed to create shared ring {}: {}", path, e))?;
+        file.set_len(len as u64)
+            .map_err(|e| format!("Failed to size shared ring {}: {}", path, e))?;
+
+        let base = ShmMapping::map(&file, len, true)?;
+        let mapping = ShmMapping {
+            base,
+            len,
+            capacity,
+            slots_offset: slots_offset(),
+        };
+
+        // Файл только что создан и заполнен нулями: seq всех слотов = 0
+        unsafe {
+            let header = base as *mut ShmHeader;
+            (*header).layout_id = E::LAYOUT_ID;
+            (*header).capacity = capacity;
+            (*header).version = SHM_VERSION;
+            (*header).event_size = size_of::<E>() as u32;
+            (*header).event_align = align_of::<E>() as u32;
+            (*header).slot_size = size_of::<Slot<E>>() as u32;
+        }
+        mapping.header().magic.store(SHM_MAGIC, Ordering::Release);
+
+        println!(
+            "Shared ring {}: {} slots x {} bytes ({} KB)",
+            path,
+            capacity,
+            size_of::<Slot<E>>(),
+            len >> 10
+        );
+
+        Ok(Self {
+            region: Arc::new(ShmRegion { mapping, path }),
+            _event: PhantomData,
+        })
+    }
+
+    /// Путь к файлу кольца
+    pub fn path(&self) -> &str {
+        &self.region.path
+    }
+
+    /// Количество опубликованных событий (включая пишущиеся)
+    pub fn published(&self) -> u64 {
+        self.region.mapping.header().tail.0.load(Ordering::Relaxed)
+    }
+
+    /// Публикует событие
+    #[inline]
+    pub fn publish(&mut self, event: &E) {
+        let mapping = &self.region.mapping;
+        let seq = mapping.header().tail.0.fetch_add(1, Ordering::Relaxed);
+        let slot = mapping.slot::<E>(seq);
+
+        // Предыдущий круг этого слота должен быть дописан
+        let previous = if seq >= mapping.capacity {
+            2 * (seq - mapping.capacity) + 2
+        } else {
+            0
+        };
+        while slot.seq.load(Ordering::Acquire) < previous {
+            std::hint::spin_loop();
+        }
+
+        slot.seq.store(2 * seq + 1, Ordering::Relaxed);
+        fence(Ordering::Release);
+        unsafe { (*slot.event.get()).write(*event) };
+        slot.seq.store(2 * seq + 2, Ordering::Release);
+    }
+}
+
+impl<E: ShmEvent> Strategy for ShmPublisher<E> {
+    type Event = E;
+
+    /// Стадия стратегии конвейера, транслирующая события в другие процессы
+    #[inline]
+    fn on_event(&mut self, event: E) {
+        self.publish(&event);
+    }
+}
+
+/// Читатель отстал: события до текущей позиции записи пропущены
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Lagged {
+    /// Сколько событий пропущено
+    pub missed: u64,
+}
+
+/// Читатель кольца в другом процессе
+///
+/// Чтение не выполняет системных вызовов и ничего не пишет в
+/// разделяемую память: отображение открыто только на чтение.
+pub struct ShmSubscriber<E: ShmEvent> {
+    mapping: ShmMapping,
+    next: u64,
+    _event: PhantomData<E>,
+}
+
+impl<E: ShmEvent> ShmSubscriber<E> {
+    /// Открывает кольцо; чтение начинается с текущей позиции записи
+    pub fn open(config: &ShmRingConfig) -> Result<Self, String> {
+        let path = config.path();
+        let file =
+            File::open(&path).map_err(|e| format!("Failed to open shared ring {}: {}", path, e))?;
+        let len = file
+            .metadata()
+            .map_err(|e| format!("Failed to stat shared ring {}: {}", path, e))?
+            .len() as usize;
+        if len < slots_offset() {
+            return Err(format!("Shared ring {} is too small", path));
+        }
+
+        let base = ShmMapping::map(&file, len, false)?;
+        let header = unsafe { &*(base as *const ShmHeader) };
+        let mut mapping = ShmMapping {
+            base,
+            len,
+            capacity: 0,
+            slots_offset: slots_offset(),
+        };
+
+        if header.magic.load(Ordering::Acquire) != SHM_MAGIC || header.version != SHM_VERSION {
+            return Err(format!("Shared ring {} is not initialized", path));
+        }
+        if header.layout_id != E::LAYOUT_ID
+            || header.event_size as usize != size_of::<E>()
+            || header.event_align as usize != align_of::<E>()
+            || header.slot_size as usize != size_of::<Slot<E>>()
+        {
+            return Err(format!(
+                "Shared ring {} holds events of another layout (id 0x{:x}, {} bytes)",
+                path, header.layout_id, header.event_size
+            ));
+        }
+        let capacity = header.capacity;
+        if !capacity.is_power_of_two()
+            || slots_offset() + capacity as usize * size_of::<Slot<E>>() > len
+        {
+            return Err(format!("Shared ring {} has a corrupted header", path));
+        }
+        mapping.capacity = capacity;
+
+        let next = header.tail.0.load(Ordering::Acquire);
+        Ok(Self {
+            mapping,
+            next,
+            _event: PhantomData,
+        })
+    }
+
+    /// Номер следующего события
+    pub fn position(&self) -> u64 {
+        self.next
+    }
+
+    /// Сколько событий опубликовано, но еще не прочитано
+    pub fn backlog(&self) -> u64 {
+        self.mapping
+            .header()
+            .tail
+            .0
+            .load(Ordering::Relaxed)
+            .saturating_sub(self.next)
+    }
+
+    /// Издатель закрыл кольцо
+    pub fn is_closed(&self) -> bool {
+        self.mapping.header().closed.load(Ordering::Acquire) != 0
+    }
+
+    /// Читает следующее событие
+    ///
+    /// `Ok(None)` - новых событий нет. При отставании больше чем на круг
+    /// кольца возвращает `Err(Lagged)` и переходит к текущей позиции
+    /// записи: пропущенные события уже перезаписаны.
+    #[inline]
+    pub fn poll(&mut self) -> Result<Option<E>, Lagged> {
+        let slot = self.mapping.slot::<E>(self.next);
+        let ready = 2 * self.next + 2;
+
+        let before = slot.seq.load(Ordering::Acquire);
+        if before < ready {
+            return Ok(None);
+        }
+
+        if before == ready {
+            // Копия может оказаться порванной записью следующего круга;
+            // это видно по seq после копирования, и копия отбрасывается
+            let event = unsafe { std::ptr::read_volatile(slot.event.get()) };
+            fence(Ordering::Acquire);
+            if slot.seq.load(Ordering::Relaxed) == ready {
+                self.next += 1;
+                return Ok(Some(unsafe { event.assume_init() }));
+            }
+        }
+
+        let tail = self.mapping.header().tail.0.load(Ordering::Acquire);
+        let missed = tail.saturating_sub(self.next);
+        self.next = tail;
+        Err(Lagged { missed })
+    }
+}
@@ -0,0 +1,364 @@
+// src/pipeline/stage.rs
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+
+use crate::control::reconfig::ControlReceiver;
+use crate::dpdk::config::MAX_BURST_SIZE;
+use crate::dpdk::ffi::RteMbuf;
+use crate::packet::data::PacketData;
+use crate::packet::handler::{BurstHandler, PacketBurst};
+use crate::packet::timestamp::tsc;
+use crate::pipeline::ring::{Consumer, Producer, RingStats};
+use crate::telemetry::worker::WorkerTelemetry;
+
+/// Поведение производителя при заполненном кольце следующей стадии
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum BackpressurePolicy {
+    /// Ждать освобождения места: задержка передается назад вплоть до
+    /// RX очереди NIC, где избыток учитывается как imissed
+    Block,
+    /// Отбросить новый элемент и учесть его в `RingStats::dropped`;
+    /// mbuf отброшенного пакета освобождает RX worker
+    DropNewest,
+}
+
+/// Конфигурация конвейерного режима: RX -> декодирование -> стратегия
+#[derive(Debug, Clone)]
+pub struct PipelineConfig {
+    /// Количество ядер декодирования на узел NUMA
+    pub decode_workers: usize,
+    /// Количество ядер стратегии на узел NUMA
+    pub strategy_workers: usize,
+    /// Емкость каждого кольца между стадиями (округляется до степени двойки)
+    pub ring_size: usize,
+    /// Политика для колец RX -> декодирование
+    pub rx_backpressure: BackpressurePolicy,
+    /// Политика для колец декодирование -> стратегия
+    pub decode_backpressure: BackpressurePolicy,
+}
+
+impl Default for PipelineConfig {
+    fn default() -> Self {
+        Self {
+            decode_workers: 1,
+            strategy_workers: 1,
+            ring_size: 1024,
+            rx_backpressure: BackpressurePolicy::DropNewest,
+            decode_backpressure: BackpressurePolicy::Block,
+        }
+    }
+}
+
+impl PipelineConfig {
+    /// Задает количество ядер декодирования и стратегии
+    pub fn with_workers(mut self, decode_workers: usize, strategy_workers: usize) -> Self {
+        self.decode_workers = decode_workers.max(1);
+        self.strategy_workers = strategy_workers.max(1);
+        self
+    }
+
+    /// Задает емкость колец между стадиями
+    pub fn with_ring_size(mut self, ring_size: usize) -> Self {
+        self.ring_size = ring_size;
+        self
+    }
+
+    /// Задает политики переполнения колец обеих стадий
+    pub fn with_backpressure(mut self, rx: BackpressurePolicy, decode: BackpressurePolicy) -> Self {
+        self.rx_backpressure = rx;
+        self.decode_backpressure = decode;
+        self
+    }
+}
+
+/// Приемник событий декодера
+pub trait EventSink<E> {
+    /// Передает событие следующей стадии
+    fn emit(&mut self, event: E);
+}
+
+/// Стадия декодирования: превращает пакеты в события
+///
+/// Каждое ядро декодирования получает свою копию (через `Clone`).
+/// Пакеты одного потока всегда попадают на одно и то же ядро
+/// в порядке приема, а его события - на одно и то же ядро стратегии.
+pub trait Decoder: Send + 'static {
+    type Event: Send + 'static;
+
+    /// Декодирует пакет; данные пакета действительны только во время вызова
+    fn decode<S: EventSink<Self::Event>>(&mut self, packet: &PacketData, sink: &mut S);
+}
+
+/// Стадия стратегии: потребляет события декодеров
+pub trait Strategy: Send + 'static {
+    type Event: Send + 'static;
+
+    /// Обрабатывает событие
+    fn on_event(&mut self, event: Self::Event);
+
+    /// Вызывается, когда входные кольца пусты
+    #[inline(always)]
+    fn on_idle(&mut self) {}
+}
+
+/// Номер полосы (ядра следующей стадии) для потока пакета
+///
+/// Поток определяется адресом и портом назначения, как и в правилах
+/// RSS / rte_flow, поэтому порядок внутри потока сохраняется при любом
+/// числе ядер декодирования.
+#[inline(always)]
+pub fn flow_lane(packet: &PacketData, lanes: usize) -> usize {
+    if lanes <= 1 {
+        return 0;
+    }
+
+    let ip = packet.get_dest_ip();
+    let addr = if ip.len() >= 4 {
+        u32::from_be_bytes([ip[0], ip[1], ip[2], ip[3]])
+    } else {
+        0
+    };
+
+    let key = ((addr as u64) << 16) | packet.dest_port as u64;
+    let hash = key.wrapping_mul(0x9E37_79B9_7F4A_7C15) >> 32;
+    (hash as usize) % lanes
+}
+
+/// Обработчик RX worker в конвейерном режиме: передает дескрипторы
+/// пакетов вместе с mbuf в кольца стадии декодирования
+pub struct PipelineRx {
+    lanes: Vec<Producer<PacketData>>,
+    policy: BackpressurePolicy,
+    running: Arc<AtomicBool>,
+}
+
+impl PipelineRx {
+    pub fn new(
+        lanes: Vec<Producer<PacketData>>,
+        policy: BackpressurePolicy,
+        running: Arc<AtomicBool>,
+    ) -> Self {
+        Self {
+            lanes,
+            policy,
+            running,
+        }
+    }
+}
+
+impl BurstHandler for PipelineRx {
+    #[inline(always)]
+    fn on_burst(&mut self, _queue_id: u16, burst: &mut PacketBurst<'_>) {
+        let nb_lanes = self.lanes.len();
+
+        for index in 0..burst.len() {
+            let packet = &burst.packets()[index];
+            let lane = flow_lane(packet, nb_lanes);
+            // Дескриптор - POD без Drop; владение mbuf переходит к стадии
+            // декодирования только если дескриптор попал в кольцо
+            let desc = unsafe { std::ptr::read(packet) };
+
+            if push_with_policy(&mut self.lanes[lane], desc, self.policy, &self.running) {
+                burst.keep(index);
+            }
+        }
+
+        for producer in &mut self.lanes {
+            producer.publish();
+        }
+    }
+}
+
+/// Помещает элемент в кольцо согласно политике; `false` - элемент отброшен
+#[inline(always)]
+fn push_with_policy<T>(
+    producer: &mut Producer<T>,
+    item: T,
+    policy: BackpressurePolicy,
+    running: &AtomicBool,
+) -> bool {
+    let mut item = match producer.push(item) {
+        Ok(()) => return true,
+        Err(item) => item,
+    };
+
+    match policy {
+        BackpressurePolicy::DropNewest => {}
+        BackpressurePolicy::Block => {
+            // Публикуем уже помещенное, иначе потребитель не освободит место
+            producer.publish();
+            producer.ring().stats().stalls.inc();
+
+            while running.load(Ordering::Relaxed) {
+                match producer.push(item) {
+                    Ok(()) => return true,
+                    Err(back) => item = back,
+                }
+                std::hint::spin_loop();
+            }
+        }
+    }
+
+    producer.ring().stats().dropped.inc();
+    false
+}
+
+/// Приемник событий ядра декодирования: кольца ко всем ядрам стратегии
+struct LaneSink<'a, E> {
+    lanes: &'a mut [Producer<E>],
+    lane: usize,
+    policy: BackpressurePolicy,
+    running: &'a AtomicBool,
+    emitted: u64,
+    dropped: u64,
+}
+
+impl<E> EventSink<E> for LaneSink<'_, E> {
+    #[inline(always)]
+    fn emit(&mut self, event: E) {
+        if push_with_policy(&mut self.lanes[self.lane], event, self.policy, self.running) {
+            self.emitted += 1;
+        } else {
+            self.dropped += 1;
+        }
+    }
+}
+
+/// Цикл ядра декодирования
+///
+/// Опрашивает входные кольца от всех RX worker по очереди, пачками до
+/// MAX_BURST_SIZE пакетов, и освобождает mbuf пачкой после декодирования.
+/// Первое кольцо круга сдвигается каждый круг, чтобы под нагрузкой
+/// одно кольцо не занимало всю пачку.
+/// Телеметрия стадии: rx.packets - полученные пакеты, rx.delivered -
+/// переданные события, rx.filtered - события, отброшенные из-за переполнения.
+pub fn run_decode_stage<D: Decoder>(
+    mut decoder: D,
+    mut inputs: Vec<Consumer<PacketData>>,
+    mut outputs: Vec<Producer<D::Event>>,
+    policy: BackpressurePolicy,
+    running: &AtomicBool,
+    telemetry: &WorkerTelemetry,
+) {
+    let mut mbufs: [*mut RteMbuf; MAX_BURST_SIZE] = [std::ptr::null_mut(); MAX_BURST_SIZE];
+    let nb_lanes = outputs.len();
+    let nb_inputs = inputs.len().max(1);
+    let mut first_input = 0;
+
+    while running.load(Ordering::Relaxed) {
+        let mut nb_pkts = 0;
+        let mut sink = LaneSink {
+            lanes: &mut outputs,
+            lane: 0,
+            policy,
+            running,
+            emitted: 0,
+            dropped: 0,
+        };
+
+        for k in 0..inputs.len() {
+            let input = &mut inputs[(first_input + k) % nb_inputs];
+            while nb_pkts < MAX_BURST_SIZE {
+                let packet = match input.pop() {
+                    Some(packet) => packet,
+                    None => break,
+                };
+
+                sink.lane = flow_lane(&packet, nb_lanes);
+                decoder.decode(&packet, &mut sink);
+
+                if packet.rx_timestamp != 0 {
+                    telemetry
+                        .latency
+                        .record(tsc().saturating_sub(packet.rx_timestamp));
+                }
+
+                mbufs[nb_pkts] = packet.mbuf_ptr;
+                nb_pkts += 1;
+            }
+            input.release();
+        }
+        first_input = (first_input + 1) % nb_inputs;
+
+        let (emitted, dropped) = (sink.emitted, sink.dropped);
+        for output in &mut outputs {
+            output.publish();
+        }
+
+        if nb_pkts == 0 {
+            telemetry.polls.empty_polls.inc();
+            std::hint::spin_loop();
+            continue;
+        }
+
+        telemetry.polls.busy_polls.inc();
+        telemetry.record_rx(nb_pkts);
+        telemetry.rx.delivered.add(emitted);
+        telemetry.rx.filtered.add(dropped);
+
+        unsafe { crate::dpdk::ffi::rte_pktmbuf_free_bulk(mbufs.as_mut_ptr(), nb_pkts as u32) };
+    }
+
+    // Возвращаем в пул mbuf, оставшиеся в кольцах после останова
+    for input in &mut inputs {
+        while let Some(packet) = input.pop() {
+            unsafe { crate::dpdk::ffi::rte_pktmbuf_free(packet.mbuf_ptr) };
+        }
+        input.release();
+    }
+}
+
+/// Цикл ядра стратегии
+///
+/// Телеметрия стадии: rx.packets и rx.delivered - обработанные события.
+/// Стратегию можно заменить на ходу через `control` (см. `NumaManager::swap_strategy`).
+pub fn run_strategy_stage<S: Strategy>(
+    mut strategy: S,
+    mut inputs: Vec<Consumer<S::Event>>,
+    mut control: ControlReceiver<S>,
+    running: &AtomicBool,
+    telemetry: &WorkerTelemetry,
+) {
+    // Как в стадии декодирования: первое кольцо круга сдвигается
+    let nb_inputs = inputs.len().max(1);
+    let mut first_input = 0;
+
+    while running.load(Ordering::Relaxed) {
+        let mut nb_events = 0;
+
+        // Новая стратегия принимает события со следующего круга
+        control.poll(&mut strategy);
+
+        for k in 0..inputs.len() {
+            let input = &mut inputs[(first_input + k) % nb_inputs];
+            while nb_events < MAX_BURST_SIZE {
+                match input.pop() {
+                    Some(event) => strategy.on_event(event),
+                    None => break,
+                }
+                nb_events += 1;
+            }
+            input.release();
+        }
+        first_input = (first_input + 1) % nb_inputs;
+
+        if nb_events == 0 {
+            telemetry.polls.empty_polls.inc();
+            strategy.on_idle();
+            continue;
+        }
+
+        telemetry.polls.busy_polls.inc();
+        telemetry.record_rx(nb_events);
+        telemetry.rx.delivered.add(nb_events as u64);
+    }
+}
+
+/// Кольцо между двумя стадиями в отчете о конвейере
+#[derive(Debug, Clone)]
+pub struct PipelineLink {
+    pub from: String,
+    pub to: String,
+    pub capacity: usize,
+    pub stats: Arc<RingStats>,
+}
@@ -0,0 +1,454 @@
+// src/plan.rs
+//! Сохраненный план запуска
+//!
+//! Обход sysfs (топология CPU и NUMA, привязка NIC к узлам, точки
+//! монтирования hugetlbfs) выполняется один раз командой `hfeec plan`,
+//! после полного запуска EAL и портов. Последующие запуски загружают план,
+//! сверяют его с быстрым отпечатком системы и параметрами конфигурации и
+//! пропускают обнаружение. Формат - текстовые строки `ключ значения...`,
+//! чтобы план можно было прочитать и сравнить глазами.
+use std::collections::{HashMap, HashSet};
+use std::fmt::Write as _;
+use std::fs;
+use std::path::Path;
+
+use crate::cpu::topology::CpuTopology;
+use crate::dpdk::config::DpdkConfig;
+use crate::dpdk::mempool::{MbufPoolPlan, PoolRole};
+use crate::numa::topology::NumaTopology;
+
+/// Путь плана по умолчанию
+pub const DEFAULT_PLAN_PATH: &str = "hfeec.plan";
+
+/// Версия формата; план другой версии отвергается
+const PLAN_VERSION: u32 = 1;
+
+/// Разрешенная при обнаружении конфигурация запуска
+#[derive(Debug, Clone)]
+pub struct StartupPlan {
+    /// Отпечаток системы на момент построения (см. `system_fingerprint`)
+    pub fingerprint: u64,
+    /// Хеш параметров конфигурации, влияющих на план (см. `config_hash`)
+    pub config_hash: u64,
+    pub cpu_topology: CpuTopology,
+    pub numa_topology: NumaTopology,
+    /// Ядра worker каждого узла NUMA, как их выбрал `NumaNode::new`
+    pub node_cores: Vec<(usize, Vec<usize>)>,
+    /// Аргументы `rte_eal_init`
+    pub eal_args: Vec<String>,
+    /// Пулы mbuf портов, созданные при построении плана
+    pub pools: Vec<(u16, MbufPoolPlan)>,
+}
+
+impl StartupPlan {
+    /// Количество узлов NUMA в плане
+    pub fn node_count(&self) -> usize {
+        self.node_cores.len()
+    }
+
+    /// Проверяет, что план построен на этой системе и для этой конфигурации
+    pub fn validate(&self, dpdk_config: &DpdkConfig) -> Result<(), String> {
+        let fingerprint = system_fingerprint();
+        if fingerprint != self.fingerprint {
+            return Err(format!(
+                "system fingerprint changed ({:016x}, plan {:016x})",
+                fingerprint, self.fingerprint
+            ));
+        }
+
+        let config = config_hash(dpdk_config);
+        if config != self.config_hash {
+            return Err(format!(
+                "DPDK config changed ({:016x}, plan {:016x})",
+                config, self.config_hash
+            ));
+        }
+        Ok(())
+    }
+
+    /// Записывает план в файл (через временный файл и rename)
+    pub fn save(&self, path: &str) -> Result<(), String> {
+        let tmp = format!("{}.tmp", path);
+        fs::write(&tmp, self.to_text())
+            .and_then(|_| fs::rename(&tmp, path))
+            .map_err(|e| format!("Failed to write startup plan {}: {}", path, e))
+    }
+
+    /// Загружает план из файла
+    pub fn load(path: &str) -> Result<Self, String> {
+        let text = fs::read_to_string(path)
+            .map_err(|e| format!("Failed to read startup plan {}: {}", path, e))?;
+        Self::from_text(&text).map_err(|e| format!("Invalid startup plan {}: {}", path, e))
+    }
+
+    fn to_text(&self) -> String {
+        let cpu = &self.cpu_topology;
+        let numa = &self.numa_topology;
+        let mut out = String::new();
+
+        let _ = writeln!(out, "hfeec-plan {}", PLAN_VERSION);
+        let _ = writeln!(out, "fingerprint {:016x}", self.fingerprint);
+        let _ = writeln!(out, "config {:016x}", self.config_hash);
+
+        let _ = writeln!(
+            out,
+            "cpu {} {} {}",
+            cpu.total_cores, cpu.physical_cores, cpu.sockets
+        );
+        let mut cpus: Vec<usize> = cpu
+            .core_mapping
+            .keys()
+            .chain(cpu.socket_mapping.keys())
+            .chain(cpu.l3_mapping.keys())
+            .copied()
+            .collect();
+        cpus.sort_unstable();
+        cpus.dedup();
+        for id in cpus {
+            let _ = writeln!(
+                out,
+                "core {} {} {} {}",
+                id,
+                opt(cpu.core_mapping.get(&id)),
+                opt(cpu.socket_mapping.get(&id)),
+                opt(cpu.l3_mapping.get(&id))
+            );
+        }
+        write_lists(&mut out, "siblings", &cpu.sibling_cores);
+        write_lists(&mut out, "socket_cores", &cpu.socket_cores);
+        write_lists(&mut out, "l3_domain", &cpu.l3_domains);
+        let mut isolated: Vec<usize> = cpu.isolated_cores.iter().copied().collect();
+        isolated.sort_unstable();
+        let _ = writeln!(out, "isolated {}", list(&isolated));
+
+        let _ = writeln!(out, "numa {}", numa.num_nodes);
+        write_lists(&mut out, "node_cores", &numa.node_cores);
+        let mut memory: Vec<_> = numa.node_memory.iter().collect();
+        memory.sort();
+        for (node, lines) in memory {
+            for line in lines {
+                let _ = writeln!(out, "node_memory {} {}", node, line);
+            }
+        }
+        for (key, map) in [("device", &numa.device_node), ("nic", &numa.nic_node)] {
+            let mut entries: Vec<_> = map.iter().collect();
+            entries.sort();
+            for (name, node) in entries {
+                let _ = writeln!(out, "{} {} {}", key, name, node);
+            }
+        }
+
+        for (node, cores) in &self.node_cores {
+            let _ = writeln!(out, "worker_cores {} {}", node, list(cores));
+        }
+        for arg in &self.eal_args {
+            let _ = writeln!(out, "eal {}", arg);
+        }
+        for (port, pool) in &self.pools {
+            let role = match pool.role {
+                PoolRole::Shared => "shared".to_string(),
+                PoolRole::Rx(q) => format!("rx{}", q),
+                PoolRole::Tx => "tx".to_string(),
+            };
+            let _ = writeln!(
+                out,
+                "pool {} {} {} {} {} {} {}",
+                port,
+                role,
+                pool.socket_id,
+                pool.num_mbufs,
+                pool.cache_size,
+                pool.data_room_size,
+                pool.name
+            );
+        }
+        out
+    }
+
+    fn from_text(text: &str) -> Result<Self, String> {
+        let mut lines = text.lines();
+        let header = lines.next().unwrap_or("");
+        if header != format!("hfeec-plan {}", PLAN_VERSION) {
+            return Err(format!("unsupported header '{}'", header));
+        }
+
+        let mut plan = StartupPlan {
+            fingerprint: 0,
+            config_hash: 0,
+            cpu_topology: CpuTopology {
+                total_cores: 0,
+                physical_cores: 0,
+                sockets: 0,
+                core_mapping: HashMap::new(),
+                socket_mapping: HashMap::new(),
+                sibling_cores: HashMap::new(),
+                socket_cores: HashMap::new(),
+                l3_mapping: HashMap::new(),
+                l3_domains: HashMap::new(),
+                isolated_cores: HashSet::new(),
+            },
+            numa_topology: NumaTopology {
+                num_nodes: 0,
+                node_cores: HashMap::new(),
+                node_memory: HashMap::new(),
+                device_node: HashMap::new(),
+                nic_node: HashMap::new(),
+            },
+            node_cores: Vec::new(),
+            eal_args: Vec::new(),
+            pools: Vec::new(),
+        };
+
+        for (n, line) in lines.enumerate() {
+            let line_no = n + 2;
+            let (key, rest) = line.split_once(' ').unwrap_or((line, ""));
+            let fields: Vec<&str> = rest.split_whitespace().collect();
+            let bad = || format!("line {}: malformed '{}'", line_no, line);
+            let num = |i: usize| -> Result<usize, String> {
+                fields.get(i).and_then(|f| f.parse().ok()).ok_or_else(bad)
+            };
+
+            let cpu = &mut plan.cpu_topology;
+            let numa = &mut plan.numa_topology;
+            match key {
+                "" => {}
+                "fingerprint" | "config" => {
+                    let value = fields
+                        .first()
+                        .and_then(|f| u64::from_str_radix(f, 16).ok())
+                        .ok_or_else(bad)?;
+                    if key == "fingerprint" {
+                        plan.fingerprint = value;
+                    } else {
+                        plan.config_hash = value;
+                    }
+                }
+                "cpu" => {
+                    cpu.total_cores = num(0)?;
+                    cpu.physical_cores = num(1)?;
+                    cpu.sockets = num(2)?;
+                }
+                "core" => {
+                    let id = num(0)?;
+                    for (i, map) in [
+                        &mut cpu.core_mapping,
+                        &mut cpu.socket_mapping,
+                        &mut cpu.l3_mapping,
+                    ]
+                    .into_iter()
+                    .enumerate()
+                    {
+                        if fields.get(i + 1) != Some(&"-") {
+                            map.insert(id, num(i + 1)?);
+                        }
+                    }
+                }
+                "siblings" => {
+                    cpu.sibling_cores
+                        .insert(num(0)?, parse_list(fields.get(1)).ok_or_else(bad)?);
+                }
+                "socket_cores" => {
+                    cpu.socket_cores
+                        .insert(num(0)?, parse_list(fields.get(1)).ok_or_else(bad)?);
+                }
+                "l3_domain" => {
+                    cpu.l3_domains
+                        .insert(num(0)?, parse_list(fields.get(1)).ok_or_else(bad)?);
+                }
+                "isolated" => {
+                    cpu.isolated_cores = parse_list(fields.first())
+                        .ok_or_else(bad)?
+                        .into_iter()
+                        .collect();
+                }
+                "numa" => numa.num_nodes = num(0)?,
+                "node_cores" => {
+                    numa.node_cores
+                        .insert(num(0)?, parse_list(fields.get(1)).ok_or_else(bad)?);
+                }
+                "node_memory" => {
+                    let (_, memory) = rest.split_once(' ').ok_or_else(bad)?;
+                    numa.node_memory
+                        .entry(num(0)?)
+                        .or_default()
+                        .push(memory.to_string());
+                }
+                "device" | "nic" => {
+                    let name = fields.first().ok_or_else(bad)?.to_string();
+                    let map = if key == "device" {
+                        &mut numa.device_node
+                    } else {
+                        &mut numa.nic_node
+                    };
+                    map.insert(name, num(1)?);
+                }
+                "worker_cores" => {
+                    let cores = parse_list(fields.get(1)).ok_or_else(bad)?;
+                    plan.node_cores.push((num(0)?, cores));
+                }
+                "eal" => plan.eal_args.push(rest.to_string()),
+                "pool" => {
+                    let role = match *fields.get(1).ok_or_else(bad)? {
+                        "shared" => PoolRole::Shared,
+                        "tx" => PoolRole::Tx,
+                        rx => PoolRole::Rx(
+                            rx.strip_prefix("rx")
+                                .and_then(|q| q.parse().ok())
+                                .ok_or_else(bad)?,
+                        ),
+                    };
+                    let pool = MbufPoolPlan {
+                        name: fields.get(6).ok_or_else(bad)?.to_string(),
+                        role,
+                        socket_id: fields.get(2).and_then(|f| f.parse().ok()).ok_or_else(bad)?,
+                        num_mbufs: num(3)? as u32,
+                        cache_size: num(4)? as u32,
+                        data_room_size: num(5)? as u16,
+                    };
+                    plan.pools.push((num(0)? as u16, pool));
+                }
+                _ => return Err(format!("line {}: unknown key '{}'", line_no, key)),
+            }
+        }
+
+        if plan.node_cores.is_empty() || plan.eal_args.is_empty() {
+            return Err("no NUMA nodes or EAL arguments".to_string());
+        }
+        Ok(plan)
+    }
+}
+
+fn opt(value: Option<&usize>) -> String {
+    value.map_or("-".to_string(), |v| v.to_string())
+}
+
+fn list(values: &[usize]) -> String {
+    if values.is_empty() {
+        return "-".to_string();
+    }
+    values
+        .iter()
+        .map(|v| v.to_string())
+        .collect::<Vec<_>>()
+        .join(",")
+}
+
+fn parse_list(field: Option<&&str>) -> Option<Vec<usize>> {
+    match *field? {
+        "-" => Some(Vec::new()),
+        values => values.split(',').map(|v| v.parse().ok()).collect(),
+    }
+}
+
+fn write_lists(out: &mut String, key: &str, map: &HashMap<usize, Vec<usize>>) {
+    let mut entries: Vec<_> = map.iter().collect();
+    entries.sort();
+    for (id, values) in entries {
+        let _ = writeln!(out, "{} {} {}", key, id, list(values));
+    }
+}
+
+/// FNV-1a: стабилен между сборками, в отличие от `DefaultHasher`
+fn fnv1a(hash: u64, bytes: &[u8]) -> u64 {
+    bytes
+        .iter()
+        .fold(hash, |h, &b| (h ^ b as u64).wrapping_mul(0x100_0000_01b3))
+}
+
+const FNV_OFFSET: u64 = 0xcbf2_9ce4_8422_2325;
+
+/// Быстрый отпечаток системы: несколько коротких файлов sysfs/procfs
+/// вместо обхода каталогов всех CPU и PCI устройств
+///
+/// Меняется при смене ядра, набора онлайн CPU и изолированных ядер, узлов
+/// NUMA и их CPU, числа hugepages, точек монтирования hugetlbfs и набора
+/// сетевых интерфейсов с их узлами.
+pub fn system_fingerprint() -> u64 {
+    let mut hash = FNV_OFFSET;
+    let mut add = |name: &str, value: &str| {
+        hash = fnv1a(hash, name.as_bytes());
+        hash = fnv1a(hash, &[0]);
+        hash = fnv1a(hash, value.trim().as_bytes());
+        hash = fnv1a(hash, &[0]);
+    };
+    let read = |path: &str| fs::read_to_string(path).unwrap_or_default();
+
+    for path in [
+        "/proc/sys/kernel/osrelease",
+        "/sys/devices/system/cpu/online",
+        "/sys/devices/system/cpu/isolated",
+        "/sys/devices/system/node/online",
+        "/sys/kernel/mm/hugepages/hugepages-2048kB/nr_hugepages",
+        "/sys/kernel/mm/hugepages/hugepages-1048576kB/nr_hugepages",
+    ] {
+        add(path, &read(path));
+    }
+
+    let nodes = read("/sys/devices/system/node/online");
+    for part in nodes.trim().split(',').filter(|p| !p.is_empty()) {
+        let (start, end) = part.split_once('-').unwrap_or((part, part));
+        let (Ok(start), Ok(end)) = (start.parse::<usize>(), end.parse::<usize>()) else {
+            continue;
+        };
+        for node in start..=end {
+            let base = format!("/sys/devices/system/node/node{}", node);
+            for file in [
+                "cpulist",
+                "hugepages/hugepages-2048kB/nr_hugepages",
+                "hugepages/hugepages-1048576kB/nr_hugepages",
+            ] {
+                let path = format!("{}/{}", base, file);
+                add(&path, &read(&path));
+            }
+        }
+    }
+
+    let mounts = read("/proc/mounts");
+    for line in mounts.lines().filter(|l| l.contains(" hugetlbfs ")) {
+        add("hugetlbfs", line);
+    }
+
+    if let Ok(entries) = fs::read_dir("/sys/class/net") {
+        let mut nics: Vec<String> = entries
+            .flatten()
+            .map(|e| e.file_name().to_string_lossy().to_string())
+            .collect();
+        nics.sort();
+        for nic in nics {
+            let node = Path::new("/sys/class/net")
+                .join(&nic)
+                .join("device/numa_node");
+            add(&nic, &fs::read_to_string(node).unwrap_or_default());
+        }
+    }
+
+    hash
+}
+
+/// Хеш параметров `DpdkConfig`, от которых зависят ядра, EAL и пулы
+pub fn config_hash(dpdk_config: &DpdkConfig) -> u64 {
+    let c = dpdk_config;
+    let text = format!(
+        "{} {} {} {} {} {} {} {} {:?} {:?} {} {} {} {:?} {} {} {} {} {:?}",
+        c.num_rx_queues,
+        c.num_tx_queues,
+        c.rx_ring_size,
+        c.tx_ring_size,
+        c.num_mbufs,
+        c.mbuf_cache_size,
+        c.burst_size,
+        c.use_huge_pages,
+        c.socket_mem,
+        c.huge_dir,
+        c.use_1g_hugepages,
+        c.data_room_size,
+        c.use_numa_on_socket,
+        c.mbuf_pool_layout,
+        c.mbuf_in_flight_bursts,
+        c.control_queues(),
+        c.capture.is_enabled(),
+        c.capture.ring_size,
+        c.eal_args
+    );
+    fnv1a(FNV_OFFSET, text.as_bytes())
+}
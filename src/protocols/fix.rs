@@ -0,0 +1,417 @@
+// src/protocols/fix.rs
+use crate::book::orders::Side;
+use crate::protocols::wire::put_decimal;
+
+/// Разделитель полей FIX
+pub const SOH: u8 = 0x01;
+/// Максимальная длина сообщения, собираемого по шаблону
+pub const MAX_MESSAGE_LEN: usize = 512;
+/// Длина UTCTimestamp с миллисекундами: YYYYMMDD-HH:MM:SS.sss
+pub const TIMESTAMP_LEN: usize = 21;
+
+/// Идентификаторы сессии, известные после logon
+#[derive(Debug, Clone)]
+pub struct FixSessionIds {
+    pub begin_string: String,
+    pub sender_comp_id: String,
+    pub target_comp_id: String,
+}
+
+/// Ширина изменяемых полей шаблона
+///
+/// Числа записываются с ведущими нулями на всю ширину (FIX допускает
+/// ведущие нули в int и float), поэтому длина сообщения и BodyLength
+/// постоянны, а запись поля не зависит от значения.
+#[derive(Debug, Clone, Copy)]
+pub struct FixFieldWidths {
+    pub seq_num: usize,
+    pub cl_ord_id: usize,
+    pub qty: usize,
+    /// Цифр целой части цены (без знака)
+    pub price_int: usize,
+    /// Цифр дробной части цены; цена в `FixOrder` - целое в этих единицах
+    pub price_decimals: usize,
+}
+
+impl Default for FixFieldWidths {
+    fn default() -> Self {
+        Self {
+            seq_num: 9,
+            cl_ord_id: 16,
+            qty: 9,
+            price_int: 8,
+            price_decimals: 4,
+        }
+    }
+}
+
+/// Изменяемые поля ордера
+#[derive(Debug, Clone, Copy)]
+pub struct FixOrder {
+    pub cl_ord_id: u64,
+    /// OrigClOrdID (41) для отмены; в NewOrderSingle не используется
+    pub orig_cl_ord_id: u64,
+    pub side: Side,
+    pub qty: u64,
+    /// Цена в единицах 10^-price_decimals
+    pub price: i64,
+}
+
+/// UTCTimestamp для SendingTime (52) и TransactTime (60)
+///
+/// Строится один раз на миллисекунду и подставляется во все сообщения
+/// копированием вместе с заранее посчитанной суммой байт.
+#[derive(Debug, Clone, Copy)]
+pub struct FixTimestamp {
+    bytes: [u8; TIMESTAMP_LEN],
+    sum: u32,
+}
+
+impl FixTimestamp {
+    /// Время из миллисекунд Unix epoch
+    pub fn from_unix_millis(ms: u64) -> Self {
+        let days = (ms / 86_400_000) as i64;
+        let ms_of_day = ms % 86_400_000;
+        let (year, month, day) = civil_from_days(days);
+
+        let mut bytes = *b"00000000-00:00:00.000";
+        let mut sum = 0;
+        sum += put_decimal(&mut bytes[0..4], year as u64).unwrap_or(0);
+        sum += put_decimal(&mut bytes[4..6], month as u64).unwrap_or(0);
+        sum += put_decimal(&mut bytes[6..8], day as u64).unwrap_or(0);
+        sum += put_decimal(&mut bytes[9..11], ms_of_day / 3_600_000).unwrap_or(0);
+        sum += put_decimal(&mut bytes[12..14], ms_of_day / 60_000 % 60).unwrap_or(0);
+        sum += put_decimal(&mut bytes[15..17], ms_of_day / 1000 % 60).unwrap_or(0);
+        sum += put_decimal(&mut bytes[18..21], ms_of_day % 1000).unwrap_or(0);
+        sum += b'-' as u32 + 2 * b':' as u32 + b'.' as u32;
+
+        Self { bytes, sum }
+    }
+
+    pub fn as_bytes(&self) -> &[u8; TIMESTAMP_LEN] {
+        &self.bytes
+    }
+}
+
+/// Дата по номеру дня от 1970-01-01 (H. Hinnant, civil_from_days)
+fn civil_from_days(days: i64) -> (i64, u32, u32) {
+    let z = days + 719_468;
+    let era = z.div_euclid(146_097);
+    let doe = z.rem_euclid(146_097);
+    let yoe = (doe - doe / 1460 + doe / 36_524 - doe / 146_096) / 365;
+    let doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    let mp = (5 * doy + 2) / 153;
+    let day = (doy - (153 * mp + 2) / 5 + 1) as u32;
+    let month = if mp < 10 { mp + 3 } else { mp - 9 } as u32;
+    let year = yoe + era * 400 + (month <= 2) as i64;
+    (year, month, day)
+}
+
+/// Позиция изменяемого поля в шаблоне; len = 0 - поля нет в сообщении
+#[derive(Debug, Clone, Copy, Default)]
+struct Slot {
+    off: u16,
+    len: u16,
+}
+
+impl Slot {
+    #[inline(always)]
+    fn range(self) -> std::ops::Range<usize> {
+        self.off as usize..self.off as usize + self.len as usize
+    }
+
+    #[inline(always)]
+    fn is_present(self) -> bool {
+        self.len != 0
+    }
+}
+
+/// Сборщик тела сообщения: статические поля и места под изменяемые
+struct BodyBuilder {
+    body: Vec<u8>,
+}
+
+impl BodyBuilder {
+    fn field(&mut self, tag: u32, value: &[u8]) -> Result<(), String> {
+        if value.contains(&SOH) || value.contains(&b'=') || value.is_empty() {
+            return Err(format!("Invalid value for FIX tag {}", tag));
+        }
+        self.body.extend_from_slice(format!("{}=", tag).as_bytes());
+        self.body.extend_from_slice(value);
+        self.body.push(SOH);
+        Ok(())
+    }
+
+    /// Резервирует поле ширины `width`, заполненное нулями
+    fn slot(&mut self, tag: u32, width: usize) -> Slot {
+        self.body.extend_from_slice(format!("{}=", tag).as_bytes());
+        let off = self.body.len();
+        self.body.resize(off + width, b'0');
+        self.body.push(SOH);
+        Slot {
+            off: off as u16,
+            len: width as u16,
+        }
+    }
+}
+
+/// Места изменяемых полей в сообщении
+#[derive(Debug, Clone, Copy, Default)]
+struct Slots {
+    seq_num: Slot,
+    sending_time: Slot,
+    cl_ord_id: Slot,
+    orig_cl_ord_id: Slot,
+    side: Slot,
+    transact_time: Slot,
+    qty: Slot,
+    price: Slot,
+}
+
+/// Готовое сообщение FIX с заранее сериализованными заголовком и
+/// статическими полями
+///
+/// Шаблон строится при logon. При отправке байты шаблона записываются
+/// прямо в буфер назначения (data room mbuf или буфер TCP сессии) и в них
+/// исправляются только MsgSeqNum, время, ClOrdID, сторона, количество и
+/// цена; контрольная сумма (10) считается как сумма статических байт,
+/// посчитанная при построении, плюс сумма записанных цифр.
+#[derive(Clone)]
+pub struct FixTemplate {
+    buf: [u8; MAX_MESSAGE_LEN],
+    len: usize,
+    /// Сумма байт до поля 10 без изменяемых полей
+    static_sum: u32,
+    checksum_off: usize,
+    slots: Slots,
+    widths: FixFieldWidths,
+    /// MsgType (35)
+    msg_type: u8,
+}
+
+impl FixTemplate {
+    /// NewOrderSingle (35=D), лимитный ордер
+    pub fn new_order_single(
+        ids: &FixSessionIds,
+        symbol: &str,
+        account: Option<&str>,
+        time_in_force: u8,
+        widths: FixFieldWidths,
+    ) -> Result<Self, String> {
+        let mut b = BodyBuilder { body: Vec::new() };
+        let mut slots = Self::header(&mut b, ids, b"D", widths)?;
+
+        slots.cl_ord_id = b.slot(11, widths.cl_ord_id);
+        if let Some(account) = account {
+            b.field(1, account.as_bytes())?;
+        }
+        b.field(55, symbol.as_bytes())?;
+        slots.side = b.slot(54, 1);
+        slots.transact_time = b.slot(60, TIMESTAMP_LEN);
+        slots.qty = b.slot(38, widths.qty);
+        b.field(40, b"2")?;
+        slots.price = b.slot(44, widths.price_int + widths.price_decimals + 2);
+        b.field(59, &[time_in_force])?;
+
+        Self::finish(ids, b, slots, widths, b'D')
+    }
+
+    /// OrderCancelRequest (35=F)
+    pub fn order_cancel_request(
+        ids: &FixSessionIds,
+        symbol: &str,
+        widths: FixFieldWidths,
+    ) -> Result<Self, String> {
+        let mut b = BodyBuilder { body: Vec::new() };
+        let mut slots = Self::header(&mut b, ids, b"F", widths)?;
+
+        slots.orig_cl_ord_id = b.slot(41, widths.cl_ord_id);
+        slots.cl_ord_id = b.slot(11, widths.cl_ord_id);
+        b.field(55, symbol.as_bytes())?;
+        slots.side = b.slot(54, 1);
+        slots.transact_time = b.slot(60, TIMESTAMP_LEN);
+        slots.qty = b.slot(38, widths.qty);
+
+        Self::finish(ids, b, slots, widths, b'F')
+    }
+
+    /// Поля стандартного заголовка после BodyLength
+    fn header(
+        b: &mut BodyBuilder,
+        ids: &FixSessionIds,
+        msg_type: &[u8],
+        widths: FixFieldWidths,
+    ) -> Result<Slots, String> {
+        if widths.seq_num == 0 || widths.cl_ord_id == 0 || widths.qty == 0 || widths.price_int == 0
+        {
+            return Err("FIX field widths must be non-zero".to_string());
+        }
+
+        let mut slots = Slots::default();
+        b.field(35, msg_type)?;
+        b.field(49, ids.sender_comp_id.as_bytes())?;
+        b.field(56, ids.target_comp_id.as_bytes())?;
+        slots.seq_num = b.slot(34, widths.seq_num);
+        slots.sending_time = b.slot(52, TIMESTAMP_LEN);
+        Ok(slots)
+    }
+
+    /// Добавляет BeginString, BodyLength и место под CheckSum
+    fn finish(
+        ids: &FixSessionIds,
+        b: BodyBuilder,
+        mut slots: Slots,
+        widths: FixFieldWidths,
+        msg_type: u8,
+    ) -> Result<Self, String> {
+        let prefix = format!("8={}\x019={}\x01", ids.begin_string, b.body.len());
+        let checksum_off = prefix.len() + b.body.len() + 3;
+        let len = checksum_off + 4;
+        if len > MAX_MESSAGE_LEN {
+            return Err(format!(
+                "FIX message template is {} bytes, limit {}",
+                len, MAX_MESSAGE_LEN
+            ));
+        }
+
+        let mut buf = [0u8; MAX_MESSAGE_LEN];
+        buf[..prefix.len()].copy_from_slice(prefix.as_bytes());
+        buf[prefix.len()..prefix.len() + b.body.len()].copy_from_slice(&b.body);
+        buf[checksum_off - 3..len].copy_from_slice(b"10=000\x01");
+
+        let shift = prefix.len() as u16;
+        for slot in [
+            &mut slots.seq_num,
+            &mut slots.sending_time,
+            &mut slots.cl_ord_id,
+            &mut slots.orig_cl_ord_id,
+            &mut slots.side,
+            &mut slots.transact_time,
+            &mut slots.qty,
+            &mut slots.price,
+        ] {
+            if slot.is_present() {
+                slot.off += shift;
+            }
+        }
+
+        // Сумма статических байт: изменяемые поля заполняются при отправке
+        let mut static_sum: u32 = buf[..checksum_off - 3].iter().map(|&b| b as u32).sum();
+        for slot in [
+            slots.seq_num,
+            slots.sending_time,
+            slots.cl_ord_id,
+            slots.orig_cl_ord_id,
+            slots.side,
+            slots.transact_time,
+            slots.qty,
+            slots.price,
+        ] {
+            if slot.is_present() {
+                static_sum -= buf[slot.range()].iter().map(|&b| b as u32).sum::<u32>();
+            }
+        }
+
+        Ok(Self {
+            buf,
+            len,
+            static_sum,
+            checksum_off,
+            slots,
+            widths,
+            msg_type,
+        })
+    }
+
+    /// MsgType (35) шаблона
+    #[inline(always)]
+    pub fn msg_type(&self) -> u8 {
+        self.msg_type
+    }
+
+    /// Открывает ли сообщение новый ордер (NewOrderSingle); только такие
+    /// сообщения добавляют экспозицию и проходят проверки риска
+    #[inline(always)]
+    pub fn is_new_order(&self) -> bool {
+        self.msg_type == b'D'
+    }
+
+    /// Ширина изменяемых полей, в том числе число знаков цены
+    #[inline(always)]
+    pub fn widths(&self) -> &FixFieldWidths {
+        &self.widths
+    }
+
+    /// Длина сообщения; одинакова для всех ордеров шаблона
+    #[inline(always)]
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Байты шаблона с нулями в изменяемых полях
+    pub fn as_bytes(&self) -> &[u8] {
+        &self.buf[..self.len]
+    }
+
+    /// Записывает сообщение в `out`, возвращает длину
+    ///
+    /// None - буфер короче сообщения или значение не помещается в ширину
+    /// поля; в этом случае содержимое `out` не определено.
+    #[inline]
+    pub fn encode(
+        &self,
+        out: &mut [u8],
+        seq_num: u64,
+        time: &FixTimestamp,
+        order: &FixOrder,
+    ) -> Option<usize> {
+        let out = out.get_mut(..self.len)?;
+        out.copy_from_slice(&self.buf[..self.len]);
+
+        let s = &self.slots;
+        let mut sum = self.static_sum;
+        sum += put_decimal(&mut out[s.seq_num.range()], seq_num)?;
+        sum += put_decimal(&mut out[s.cl_ord_id.range()], order.cl_ord_id)?;
+        sum += put_decimal(&mut out[s.qty.range()], order.qty)?;
+
+        out[s.sending_time.range()].copy_from_slice(&time.bytes);
+        out[s.transact_time.range()].copy_from_slice(&time.bytes);
+        sum += 2 * time.sum;
+
+        let side = match order.side {
+            Side::Bid => b'1',
+            Side::Ask => b'2',
+        };
+        out[s.side.off as usize] = side;
+        sum += side as u32;
+
+        if s.orig_cl_ord_id.is_present() {
+            sum += put_decimal(&mut out[s.orig_cl_ord_id.range()], order.orig_cl_ord_id)?;
+        }
+        if s.price.is_present() {
+            sum += self.put_price(&mut out[s.price.range()], order.price)?;
+        }
+
+        put_decimal(
+            &mut out[self.checksum_off..self.checksum_off + 3],
+            (sum % 256) as u64,
+        );
+        Some(self.len)
+    }
+
+    /// Цена фиксированной ширины: знак ('0' или '-'), целая часть, точка,
+    /// дробная часть
+    #[inline(always)]
+    fn put_price(&self, dst: &mut [u8], price: i64) -> Option<u32> {
+        let scale = 10u64.pow(self.widths.price_decimals as u32);
+        let abs = price.unsigned_abs();
+        let int_end = 1 + self.widths.price_int;
+
+        dst[0] = if price < 0 { b'-' } else { b'0' };
+        dst[int_end] = b'.';
+        let mut sum = dst[0] as u32 + b'.' as u32;
+        sum += put_decimal(&mut dst[1..int_end], abs / scale)?;
+        sum += put_decimal(&mut dst[int_end + 1..], abs % scale)?;
+        Some(sum)
+    }
+}
@@ -0,0 +1,294 @@
+// src/protocols/igmp.rs
+use std::net::Ipv4Addr;
+
+use crate::protocols::wire::{ensure_len, wire_view, DecodeError, WireField};
+
+/// IP протокол IGMP
+pub const IPPROTO_IGMP: u8 = 2;
+
+/// Membership Query (v1/v2/v3)
+pub const TYPE_QUERY: u8 = 0x11;
+/// IGMPv2 Membership Report
+pub const TYPE_V2_REPORT: u8 = 0x16;
+/// IGMPv2 Leave Group
+pub const TYPE_V2_LEAVE: u8 = 0x17;
+/// IGMPv3 Membership Report
+pub const TYPE_V3_REPORT: u8 = 0x22;
+
+/// Все хосты сегмента: адрес общих запросов
+pub const ALL_HOSTS: Ipv4Addr = Ipv4Addr::new(224, 0, 0, 1);
+/// Все маршрутизаторы: адрес IGMPv2 Leave
+pub const ALL_ROUTERS: Ipv4Addr = Ipv4Addr::new(224, 0, 0, 2);
+/// Маршрутизаторы IGMPv3: адрес IGMPv3 Report
+pub const ALL_IGMPV3_ROUTERS: Ipv4Addr = Ipv4Addr::new(224, 0, 0, 22);
+
+const ETHER_HDR_LEN: usize = 14;
+const ETHER_TYPE_IPV4: u16 = 0x0800;
+const ETHER_TYPE_VLAN: u16 = 0x8100;
+/// IPv4 заголовок с опцией Router Alert (RFC 2113), обязательной для IGMP
+const IP_HDR_LEN: usize = 24;
+const IP_OPT_ROUTER_ALERT: [u8; 4] = [0x94, 0x04, 0x00, 0x00];
+/// DSCP CS6 (Internet Control), как у IGMP сообщений ядра
+const IP_TOS_CONTROL: u8 = 0xc0;
+
+/// Максимальный размер IGMP кадра, который строит `build_frame`
+pub const MAX_FRAME_LEN: usize = 128;
+/// Минимальный размер Ethernet кадра без FCS
+const MIN_FRAME_LEN: usize = 60;
+
+/// Версия протокола, которой отвечает хост
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum IgmpVersion {
+    V2,
+    V3,
+}
+
+/// Тип записи IGMPv3 Group Record (RFC 3376, 4.2.12)
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(u8)]
+pub enum RecordType {
+    ModeIsInclude = 1,
+    ModeIsExclude = 2,
+    ChangeToInclude = 3,
+    ChangeToExclude = 4,
+    AllowNewSources = 5,
+    BlockOldSources = 6,
+}
+
+wire_view! {
+    /// Заголовок IGMP сообщения (общий для всех версий)
+    pub struct IgmpHeader, read_be, len = 8;
+    msg_type: u8 = 0;
+    /// Max Resp Code: в v2 - десятые доли секунды, в v3 - код с плавающей точкой
+    max_resp_code: u8 = 1;
+    checksum: u16 = 2;
+    group: u32 = 4;
+}
+
+wire_view! {
+    /// Расширение IGMPv3 Membership Query после общего заголовка
+    pub struct V3QueryTail, read_be, len = 4;
+    /// S-флаг и QRV
+    flags: u8 = 0;
+    qqic: u8 = 1;
+    num_sources: u16 = 2;
+}
+
+/// Разобранный Membership Query
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct MembershipQuery {
+    /// None - общий запрос по всем группам
+    pub group: Option<Ipv4Addr>,
+    /// Максимальная задержка ответа, мс
+    pub max_resp_ms: u32,
+    /// Запрос от маршрутизатора IGMPv3
+    pub v3: bool,
+}
+
+/// Время ответа из Max Resp Code IGMPv3 (RFC 3376, 4.1.1), в десятых
+/// долях секунды
+#[inline]
+fn v3_max_resp_tenths(code: u8) -> u32 {
+    if code < 128 {
+        code as u32
+    } else {
+        let mant = (code & 0x0f) as u32;
+        let exp = ((code >> 4) & 0x07) as u32;
+        (mant | 0x10) << (exp + 3)
+    }
+}
+
+/// Разбирает Ethernet кадр и возвращает Membership Query, если это он
+///
+/// Кадры, не являющиеся IGMP запросом, дают Ok(None); кадры с неверной
+/// контрольной суммой IGMP отбрасываются как UnknownMessage.
+pub fn parse_query(frame: &[u8]) -> Result<Option<MembershipQuery>, DecodeError> {
+    ensure_len(frame, ETHER_HDR_LEN)?;
+
+    let mut l2_len = ETHER_HDR_LEN;
+    let mut ether_type = unsafe { u16::read_be(frame, 12) };
+    if ether_type == ETHER_TYPE_VLAN {
+        ensure_len(frame, ETHER_HDR_LEN + 4)?;
+        ether_type = unsafe { u16::read_be(frame, 16) };
+        l2_len += 4;
+    }
+    if ether_type != ETHER_TYPE_IPV4 {
+        return Ok(None);
+    }
+
+    let ip = &frame[l2_len..];
+    ensure_len(ip, 20)?;
+    let ihl = ((ip[0] & 0x0f) as usize) * 4;
+    if ip[9] != IPPROTO_IGMP || ihl < 20 {
+        return Ok(None);
+    }
+
+    let total_len = unsafe { u16::read_be(ip, 2) } as usize;
+    ensure_len(ip, total_len.max(ihl))?;
+    let igmp = &ip[ihl..total_len.max(ihl)];
+
+    let header = IgmpHeader::new(igmp)?;
+    if header.msg_type() != TYPE_QUERY {
+        return Ok(None);
+    }
+    if checksum(igmp) != 0 {
+        return Err(DecodeError::UnknownMessage(TYPE_QUERY as u16));
+    }
+
+    // IGMPv3 запрос длиннее 8 байт (RFC 3376, 7.1)
+    let v3 = igmp.len() >= IgmpHeader::LEN + V3QueryTail::LEN;
+    let tenths = if v3 {
+        v3_max_resp_tenths(header.max_resp_code())
+    } else if header.max_resp_code() == 0 {
+        // IGMPv1 запрос: 10 секунд
+        100
+    } else {
+        header.max_resp_code() as u32
+    };
+
+    let group = match header.group() {
+        0 => None,
+        group => Some(Ipv4Addr::from(group)),
+    };
+
+    Ok(Some(MembershipQuery {
+        group,
+        max_resp_ms: tenths * 100,
+        v3,
+    }))
+}
+
+/// Интернет-контрольная сумма (RFC 1071)
+pub fn checksum(data: &[u8]) -> u16 {
+    let mut sum = 0u32;
+    let mut chunks = data.chunks_exact(2);
+    for chunk in &mut chunks {
+        sum += u16::from_be_bytes([chunk[0], chunk[1]]) as u32;
+    }
+    if let [last] = chunks.remainder() {
+        sum += (*last as u32) << 8;
+    }
+    while sum > 0xffff {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    !(sum as u16)
+}
+
+/// MAC адрес Ethernet для IPv4 мультикаст-группы: 01:00:5e + младшие 23 бита
+pub fn multicast_mac(group: Ipv4Addr) -> [u8; 6] {
+    let o = group.octets();
+    [0x01, 0x00, 0x5e, o[1] & 0x7f, o[2], o[3]]
+}
+
+/// Запись о группе для IGMP сообщения
+#[derive(Debug, Clone, Copy)]
+pub struct GroupRecord<'a> {
+    pub record_type: RecordType,
+    pub group: Ipv4Addr,
+    /// Источники SSM; пустой список - любой источник
+    pub sources: &'a [Ipv4Addr],
+}
+
+/// Адресация хоста, от имени которого отправляются сообщения
+#[derive(Debug, Clone, Copy)]
+pub struct IgmpHost {
+    pub src_mac: [u8; 6],
+    pub src_ip: Ipv4Addr,
+}
+
+/// Строит Ethernet/IPv4/IGMP кадр
+///
+/// Для IGMPv2 используется только первая запись: ChangeToInclude без
+/// источников превращается в Leave Group, остальные типы - в Membership
+/// Report. IGMPv3 Report содержит все записи. Возвращает длину кадра или
+/// None, если записи не помещаются в `MAX_FRAME_LEN`.
+pub fn build_frame(
+    buf: &mut [u8; MAX_FRAME_LEN],
+    host: &IgmpHost,
+    version: IgmpVersion,
+    records: &[GroupRecord<'_>],
+) -> Option<usize> {
+    let first = records.first()?;
+    let igmp_start = ETHER_HDR_LEN + IP_HDR_LEN;
+
+    let (dst_ip, igmp_len) = match version {
+        IgmpVersion::V2 => {
+            let leave =
+                first.record_type == RecordType::ChangeToInclude && first.sources.is_empty();
+            let (msg_type, dst) = if leave {
+                (TYPE_V2_LEAVE, ALL_ROUTERS)
+            } else {
+                (TYPE_V2_REPORT, first.group)
+            };
+
+            let igmp = &mut buf[igmp_start..igmp_start + 8];
+            igmp[0] = msg_type;
+            igmp[1] = 0;
+            igmp[2..4].fill(0);
+            igmp[4..8].copy_from_slice(&first.group.octets());
+            (dst, 8)
+        }
+        IgmpVersion::V3 => {
+            let len = 8 + records
+                .iter()
+                .map(|r| 8 + 4 * r.sources.len())
+                .sum::<usize>();
+            if igmp_start + len > MAX_FRAME_LEN || records.len() > u16::MAX as usize {
+                return None;
+            }
+
+            let igmp = &mut buf[igmp_start..igmp_start + len];
+            igmp[0] = TYPE_V3_REPORT;
+            igmp[1] = 0;
+            igmp[2..6].fill(0);
+            igmp[6..8].copy_from_slice(&(records.len() as u16).to_be_bytes());
+
+            let mut pos = 8;
+            for record in records {
+                igmp[pos] = record.record_type as u8;
+                igmp[pos + 1] = 0;
+                igmp[pos + 2..pos + 4]
+                    .copy_from_slice(&(record.sources.len() as u16).to_be_bytes());
+                igmp[pos + 4..pos + 8].copy_from_slice(&record.group.octets());
+                pos += 8;
+                for source in record.sources {
+                    igmp[pos..pos + 4].copy_from_slice(&source.octets());
+                    pos += 4;
+                }
+            }
+            (ALL_IGMPV3_ROUTERS, len)
+        }
+    };
+
+    let igmp_sum = checksum(&buf[igmp_start..igmp_start + igmp_len]);
+    buf[igmp_start + 2..igmp_start + 4].copy_from_slice(&igmp_sum.to_be_bytes());
+
+    // Ethernet
+    buf[0..6].copy_from_slice(&multicast_mac(dst_ip));
+    buf[6..12].copy_from_slice(&host.src_mac);
+    buf[12..14].copy_from_slice(&ETHER_TYPE_IPV4.to_be_bytes());
+
+    // IPv4 с Router Alert, TTL 1
+    let ip = &mut buf[ETHER_HDR_LEN..igmp_start];
+    let total_len = (IP_HDR_LEN + igmp_len) as u16;
+    ip[0] = 0x40 | (IP_HDR_LEN / 4) as u8;
+    ip[1] = IP_TOS_CONTROL;
+    ip[2..4].copy_from_slice(&total_len.to_be_bytes());
+    ip[4..6].fill(0);
+    ip[6..8].copy_from_slice(&0x4000u16.to_be_bytes()); // DF
+    ip[8] = 1;
+    ip[9] = IPPROTO_IGMP;
+    ip[10..12].fill(0);
+    ip[12..16].copy_from_slice(&host.src_ip.octets());
+    ip[16..20].copy_from_slice(&dst_ip.octets());
+    ip[20..24].copy_from_slice(&IP_OPT_ROUTER_ALERT);
+    let ip_sum = checksum(ip);
+    ip[10..12].copy_from_slice(&ip_sum.to_be_bytes());
+
+    // Короткий IGMPv2 кадр дополняется до минимального размера Ethernet
+    let frame_len = igmp_start + igmp_len;
+    if frame_len < MIN_FRAME_LEN {
+        buf[frame_len..MIN_FRAME_LEN].fill(0);
+    }
+    Some(frame_len.max(MIN_FRAME_LEN))
+}
@@ -0,0 +1,318 @@
+// src/protocols/itch.rs
+use crate::protocols::wire::{read_u48_be, wire_view, DecodeError, WireView};
+
+/// Цена ITCH: целое с 4 знаками после запятой
+pub const PRICE_SCALE: u32 = 10_000;
+
+/// Длины сообщений NASDAQ TotalView-ITCH 5.0 (включая байт типа)
+const MESSAGE_TYPES: [(u8, u8); 23] = [
+    (b'S', 12),
+    (b'R', 39),
+    (b'H', 25),
+    (b'Y', 20),
+    (b'L', 26),
+    (b'V', 35),
+    (b'W', 12),
+    (b'K', 28),
+    (b'J', 35),
+    (b'h', 21),
+    (b'A', 36),
+    (b'F', 40),
+    (b'E', 31),
+    (b'C', 36),
+    (b'X', 23),
+    (b'D', 19),
+    (b'U', 35),
+    (b'P', 44),
+    (b'Q', 40),
+    (b'B', 19),
+    (b'I', 50),
+    (b'N', 20),
+    (b'O', 48),
+];
+
+const fn build_lengths() -> [u8; 256] {
+    let mut table = [0u8; 256];
+    let mut i = 0;
+    while i < MESSAGE_TYPES.len() {
+        table[MESSAGE_TYPES[i].0 as usize] = MESSAGE_TYPES[i].1;
+        i += 1;
+    }
+    table
+}
+
+/// Таблица длин по байту типа, 0 - неизвестный тип
+pub const MESSAGE_LENGTHS: [u8; 256] = build_lengths();
+
+/// Возвращает фиксированную длину сообщения типа `msg_type`
+#[inline(always)]
+pub const fn message_len(msg_type: u8) -> Option<usize> {
+    match MESSAGE_LENGTHS[msg_type as usize] {
+        0 => None,
+        len => Some(len as usize),
+    }
+}
+
+/// Объявляет сообщение ITCH: общий заголовок (тип, stock locate,
+/// tracking number, 48-битная метка времени) и поля тела
+macro_rules! itch_message {
+    (
+        $(#[$meta:meta])*
+        $name:ident = $type:expr, len = $len:expr;
+        $( $(#[$fmeta:meta])* $field:ident: $ty:ty = $offset:expr; )*
+    ) => {
+        wire_view! {
+            $(#[$meta])*
+            pub struct $name, read_be, len = $len;
+            stock_locate: u16 = 1;
+            tracking_number: u16 = 3;
+            $( $(#[$fmeta])* $field: $ty = $offset; )*
+        }
+
+        impl<'a> $name<'a> {
+            /// Байт типа сообщения
+            pub const TYPE: u8 = $type;
+
+            /// Наносекунды от полуночи
+            #[inline(always)]
+            pub fn timestamp(&self) -> u64 {
+                unsafe { read_u48_be(self.buf, 5) }
+            }
+        }
+
+        const _: () = assert!(MESSAGE_LENGTHS[$type as usize] as usize == $len);
+    };
+}
+
+itch_message! {
+    /// System Event (S)
+    SystemEvent = b'S', len = 12;
+    event_code: u8 = 11;
+}
+
+itch_message! {
+    /// Stock Directory (R)
+    StockDirectory = b'R', len = 39;
+    stock: [u8; 8] = 11;
+    market_category: u8 = 19;
+    financial_status: u8 = 20;
+    round_lot_size: u32 = 21;
+    round_lots_only: u8 = 25;
+}
+
+itch_message! {
+    /// Stock Trading Action (H)
+    StockTradingAction = b'H', len = 25;
+    stock: [u8; 8] = 11;
+    trading_state: u8 = 19;
+    reason: [u8; 4] = 21;
+}
+
+itch_message! {
+    /// Add Order без атрибуции (A)
+    AddOrder = b'A', len = 36;
+    order_ref: u64 = 11;
+    /// b'B' - покупка, b'S' - продажа
+    side: u8 = 19;
+    shares: u32 = 20;
+    stock: [u8; 8] = 24;
+    price: u32 = 32;
+}
+
+itch_message! {
+    /// Add Order с атрибуцией участника (F)
+    AddOrderMpid = b'F', len = 40;
+    order_ref: u64 = 11;
+    side: u8 = 19;
+    shares: u32 = 20;
+    stock: [u8; 8] = 24;
+    price: u32 = 32;
+    attribution: [u8; 4] = 36;
+}
+
+itch_message! {
+    /// Order Executed (E)
+    OrderExecuted = b'E', len = 31;
+    order_ref: u64 = 11;
+    executed_shares: u32 = 19;
+    match_number: u64 = 23;
+}
+
+itch_message! {
+    /// Order Executed With Price (C)
+    OrderExecutedWithPrice = b'C', len = 36;
+    order_ref: u64 = 11;
+    executed_shares: u32 = 19;
+    match_number: u64 = 23;
+    printable: u8 = 31;
+    execution_price: u32 = 32;
+}
+
+itch_message! {
+    /// Order Cancel, частичная отмена (X)
+    OrderCancel = b'X', len = 23;
+    order_ref: u64 = 11;
+    cancelled_shares: u32 = 19;
+}
+
+itch_message! {
+    /// Order Delete (D)
+    OrderDelete = b'D', len = 19;
+    order_ref: u64 = 11;
+}
+
+itch_message! {
+    /// Order Replace (U)
+    OrderReplace = b'U', len = 35;
+    original_order_ref: u64 = 11;
+    new_order_ref: u64 = 19;
+    shares: u32 = 27;
+    price: u32 = 31;
+}
+
+itch_message! {
+    /// Trade по скрытой заявке (P)
+    Trade = b'P', len = 44;
+    order_ref: u64 = 11;
+    side: u8 = 19;
+    shares: u32 = 20;
+    stock: [u8; 8] = 24;
+    price: u32 = 32;
+    match_number: u64 = 36;
+}
+
+itch_message! {
+    /// Cross Trade (Q)
+    CrossTrade = b'Q', len = 40;
+    shares: u64 = 11;
+    stock: [u8; 8] = 19;
+    cross_price: u32 = 27;
+    match_number: u64 = 31;
+    cross_type: u8 = 39;
+}
+
+itch_message! {
+    /// Broken Trade (B)
+    BrokenTrade = b'B', len = 19;
+    match_number: u64 = 11;
+}
+
+/// Обработчик сообщений ITCH
+///
+/// Методы по умолчанию ничего не делают; обработчик переопределяет только
+/// нужные типы. Тип обработчика известен на этапе компиляции, поэтому
+/// `decode` разворачивается в прямые вызовы без виртуальной диспетчеризации.
+/// Представления ссылаются на буфер сообщения и действительны только
+/// во время вызова.
+pub trait ItchHandler {
+    #[inline(always)]
+    fn on_system_event(&mut self, _msg: SystemEvent<'_>) {}
+    #[inline(always)]
+    fn on_stock_directory(&mut self, _msg: StockDirectory<'_>) {}
+    #[inline(always)]
+    fn on_trading_action(&mut self, _msg: StockTradingAction<'_>) {}
+    #[inline(always)]
+    fn on_add_order(&mut self, _msg: AddOrder<'_>) {}
+    #[inline(always)]
+    fn on_add_order_mpid(&mut self, _msg: AddOrderMpid<'_>) {}
+    #[inline(always)]
+    fn on_order_executed(&mut self, _msg: OrderExecuted<'_>) {}
+    #[inline(always)]
+    fn on_order_executed_with_price(&mut self, _msg: OrderExecutedWithPrice<'_>) {}
+    #[inline(always)]
+    fn on_order_cancel(&mut self, _msg: OrderCancel<'_>) {}
+    #[inline(always)]
+    fn on_order_delete(&mut self, _msg: OrderDelete<'_>) {}
+    #[inline(always)]
+    fn on_order_replace(&mut self, _msg: OrderReplace<'_>) {}
+    #[inline(always)]
+    fn on_trade(&mut self, _msg: Trade<'_>) {}
+    #[inline(always)]
+    fn on_cross_trade(&mut self, _msg: CrossTrade<'_>) {}
+    #[inline(always)]
+    fn on_broken_trade(&mut self, _msg: BrokenTrade<'_>) {}
+    /// Сообщения известной длины без отдельного представления (NOII, LULD и т.п.)
+    #[inline(always)]
+    fn on_other(&mut self, _msg_type: u8, _msg: &[u8]) {}
+}
+
+/// Декодирует одно сообщение ITCH и передает его обработчику
+///
+/// Длина проверяется по таблице `MESSAGE_LENGTHS` один раз; сообщение
+/// длиннее фиксированной длины допускается (лишние байты игнорируются).
+#[inline(always)]
+pub fn decode<H: ItchHandler>(msg: &[u8], handler: &mut H) -> Result<(), DecodeError> {
+    let msg_type = match msg.first() {
+        Some(&msg_type) => msg_type,
+        None => {
+            return Err(DecodeError::Truncated {
+                needed: 1,
+                available: 0,
+            })
+        }
+    };
+
+    let expected = match message_len(msg_type) {
+        Some(len) => len,
+        None => return Err(DecodeError::UnknownMessage(msg_type as u16)),
+    };
+
+    if msg.len() < expected {
+        return Err(DecodeError::LengthMismatch {
+            msg_type: msg_type as u16,
+            expected,
+            actual: msg.len(),
+        });
+    }
+
+    // Длина уже проверена, представления создаются без повторной проверки
+    match msg_type {
+        SystemEvent::TYPE => handler.on_system_event(unsafe { SystemEvent::new_unchecked(msg) }),
+        StockDirectory::TYPE => {
+            handler.on_stock_directory(unsafe { StockDirectory::new_unchecked(msg) })
+        }
+        StockTradingAction::TYPE => {
+            handler.on_trading_action(unsafe { StockTradingAction::new_unchecked(msg) })
+        }
+        AddOrder::TYPE => handler.on_add_order(unsafe { AddOrder::new_unchecked(msg) }),
+        AddOrderMpid::TYPE => {
+            handler.on_add_order_mpid(unsafe { AddOrderMpid::new_unchecked(msg) })
+        }
+        OrderExecuted::TYPE => {
+            handler.on_order_executed(unsafe { OrderExecuted::new_unchecked(msg) })
+        }
+        OrderExecutedWithPrice::TYPE => handler
+            .on_order_executed_with_price(unsafe { OrderExecutedWithPrice::new_unchecked(msg) }),
+        OrderCancel::TYPE => handler.on_order_cancel(unsafe { OrderCancel::new_unchecked(msg) }),
+        OrderDelete::TYPE => handler.on_order_delete(unsafe { OrderDelete::new_unchecked(msg) }),
+        OrderReplace::TYPE => handler.on_order_replace(unsafe { OrderReplace::new_unchecked(msg) }),
+        Trade::TYPE => handler.on_trade(unsafe { Trade::new_unchecked(msg) }),
+        CrossTrade::TYPE => handler.on_cross_trade(unsafe { CrossTrade::new_unchecked(msg) }),
+        BrokenTrade::TYPE => handler.on_broken_trade(unsafe { BrokenTrade::new_unchecked(msg) }),
+        _ => handler.on_other(msg_type, msg),
+    }
+
+    Ok(())
+}
+
+/// Декодирует все сообщения ITCH пакета MoldUDP64
+///
+/// `on_sequence` вызывается перед каждым сообщением с его порядковым
+/// номером (для контроля пропусков). Возвращает номер, ожидаемый в
+/// следующем пакете.
+#[inline(always)]
+pub fn decode_mold_packet<H: ItchHandler>(
+    payload: &[u8],
+    handler: &mut H,
+    mut on_sequence: impl FnMut(u64),
+) -> Result<u64, DecodeError> {
+    let packet = crate::protocols::moldudp64::MoldPacket::parse(payload)?;
+
+    for message in packet.messages() {
+        let (sequence, msg) = message?;
+        on_sequence(sequence);
+        decode(msg, handler)?;
+    }
+
+    Ok(packet.next_sequence())
+}
@@ -0,0 +1,285 @@
+// src/protocols/mdp3.rs
+use crate::protocols::sbe::{split_message, Group, GroupHeader, MessageHeader};
+use crate::protocols::wire::{ensure_len, wire_view, DecodeError, WireField, WireView};
+
+/// Идентификатор схемы CME MDP 3.0
+pub const SCHEMA_ID: u16 = 1;
+
+/// Минимальная поддерживаемая версия схемы
+pub const MIN_SCHEMA_VERSION: u16 = 9;
+
+/// Длина заголовка пакета: MsgSeqNum u32 + SendingTime u64
+pub const PACKET_HEADER_LEN: usize = 12;
+
+/// Экспонента цен PRICE9 / PRICENULL9
+pub const PRICE_EXPONENT: i32 = -9;
+
+/// Значение NULL для PRICENULL9
+pub const PRICE_NULL: i64 = i64::MAX;
+
+/// Пакет MDP 3.0: заголовок и последовательность сообщений SBE,
+/// каждое с префиксом MsgSize (u16 LE, включая сам префикс)
+#[derive(Debug, Clone, Copy)]
+pub struct Mdp3Packet<'a> {
+    buf: &'a [u8],
+}
+
+impl<'a> Mdp3Packet<'a> {
+    /// Проверяет заголовок пакета
+    #[inline(always)]
+    pub fn parse(buf: &'a [u8]) -> Result<Self, DecodeError> {
+        ensure_len(buf, PACKET_HEADER_LEN)?;
+        Ok(Self { buf })
+    }
+
+    /// Порядковый номер пакета в канале
+    #[inline(always)]
+    pub fn sequence(&self) -> u32 {
+        unsafe { u32::read_le(self.buf, 0) }
+    }
+
+    /// Время отправки, наносекунды от эпохи UNIX
+    #[inline(always)]
+    pub fn sending_time(&self) -> u64 {
+        unsafe { u64::read_le(self.buf, 4) }
+    }
+
+    /// Итератор по сообщениям SBE пакета
+    #[inline(always)]
+    pub fn messages(&self) -> Mdp3Messages<'a> {
+        Mdp3Messages {
+            rest: &self.buf[PACKET_HEADER_LEN..],
+        }
+    }
+}
+
+/// Итератор по сообщениям пакета MDP 3.0
+#[derive(Debug, Clone)]
+pub struct Mdp3Messages<'a> {
+    rest: &'a [u8],
+}
+
+impl<'a> Iterator for Mdp3Messages<'a> {
+    type Item = Result<&'a [u8], DecodeError>;
+
+    #[inline(always)]
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.rest.is_empty() {
+            return None;
+        }
+
+        let rest = self.rest;
+        if rest.len() < 2 {
+            self.rest = &[];
+            return Some(Err(DecodeError::Truncated {
+                needed: 2,
+                available: rest.len(),
+            }));
+        }
+
+        let size = unsafe { u16::read_le(rest, 0) } as usize;
+        if size < 2 + MessageHeader::LEN || rest.len() < size {
+            self.rest = &[];
+            return Some(Err(DecodeError::Truncated {
+                needed: size.max(2 + MessageHeader::LEN),
+                available: rest.len(),
+            }));
+        }
+
+        self.rest = &rest[size..];
+        Some(Ok(&rest[2..size]))
+    }
+}
+
+wire_view! {
+    /// Корневой блок инкрементальных сообщений (шаблоны 46, 47, 48)
+    pub struct IncrementalRoot, read_le, len = 11;
+    /// Время события, наносекунды от эпохи UNIX
+    transact_time: u64 = 0;
+    match_event_indicator: u8 = 8;
+}
+
+wire_view! {
+    /// Запись NoMDEntries шаблона 46 (MDIncrementalRefreshBook)
+    pub struct BookEntry, read_le, len = 32;
+    /// Цена уровня, PRICENULL9
+    price: i64 = 0;
+    size: i32 = 8;
+    security_id: i32 = 12;
+    rpt_seq: u32 = 16;
+    number_of_orders: i32 = 20;
+    price_level: u8 = 24;
+    /// 0 - New, 1 - Change, 2 - Delete, 3 - DeleteThru, 4 - DeleteFrom, 5 - Overlay
+    update_action: u8 = 25;
+    /// b'0' - Bid, b'1' - Offer, b'E'/b'F' - implied
+    entry_type: u8 = 26;
+}
+
+wire_view! {
+    /// Запись NoOrderIDEntries шаблона 46
+    pub struct BookOrderEntry, read_le, len = 24;
+    order_id: u64 = 0;
+    order_priority: u64 = 8;
+    display_qty: i32 = 16;
+    reference_id: u8 = 20;
+    order_update_action: u8 = 21;
+}
+
+wire_view! {
+    /// Запись NoMDEntries шаблона 47 (MDIncrementalRefreshOrderBook)
+    pub struct OrderBookEntry, read_le, len = 40;
+    order_id: u64 = 0;
+    order_priority: u64 = 8;
+    price: i64 = 16;
+    display_qty: i32 = 24;
+    security_id: i32 = 28;
+    update_action: u8 = 32;
+    entry_type: u8 = 33;
+}
+
+wire_view! {
+    /// Запись NoMDEntries шаблона 48 (MDIncrementalRefreshTradeSummary)
+    pub struct TradeEntry, read_le, len = 32;
+    price: i64 = 0;
+    size: i32 = 8;
+    security_id: i32 = 12;
+    rpt_seq: u32 = 16;
+    number_of_orders: i32 = 20;
+    /// 0 - нет агрессора, 1 - покупка, 2 - продажа
+    aggressor_side: u8 = 24;
+    update_action: u8 = 25;
+    trade_entry_id: u32 = 26;
+}
+
+wire_view! {
+    /// Запись NoOrderIDEntries шаблона 48
+    pub struct TradeOrderEntry, read_le, len = 16;
+    order_id: u64 = 0;
+    last_qty: i32 = 8;
+}
+
+/// MDIncrementalRefreshBook (шаблон 46)
+#[derive(Debug, Clone, Copy)]
+pub struct IncrementalRefreshBook<'a> {
+    pub root: IncrementalRoot<'a>,
+    pub entries: Group<'a, BookEntry<'a>>,
+    pub orders: Group<'a, BookOrderEntry<'a>>,
+}
+
+/// MDIncrementalRefreshOrderBook (шаблон 47)
+#[derive(Debug, Clone, Copy)]
+pub struct IncrementalRefreshOrderBook<'a> {
+    pub root: IncrementalRoot<'a>,
+    pub entries: Group<'a, OrderBookEntry<'a>>,
+}
+
+/// MDIncrementalRefreshTradeSummary (шаблон 48)
+#[derive(Debug, Clone, Copy)]
+pub struct IncrementalRefreshTradeSummary<'a> {
+    pub root: IncrementalRoot<'a>,
+    pub entries: Group<'a, TradeEntry<'a>>,
+    pub orders: Group<'a, TradeOrderEntry<'a>>,
+}
+
+pub const TEMPLATE_BOOK: u16 = 46;
+pub const TEMPLATE_ORDER_BOOK: u16 = 47;
+pub const TEMPLATE_TRADE_SUMMARY: u16 = 48;
+
+/// Обработчик сообщений MDP 3.0
+///
+/// Как и в `itch::ItchHandler`, методы по умолчанию пустые, а тип
+/// обработчика известен на этапе компиляции.
+pub trait Mdp3Handler {
+    #[inline(always)]
+    fn on_book(&mut self, _msg: &IncrementalRefreshBook<'_>) {}
+    #[inline(always)]
+    fn on_order_book(&mut self, _msg: &IncrementalRefreshOrderBook<'_>) {}
+    #[inline(always)]
+    fn on_trade_summary(&mut self, _msg: &IncrementalRefreshTradeSummary<'_>) {}
+    /// Остальные шаблоны: заголовок и тело после него
+    #[inline(always)]
+    fn on_other(&mut self, _header: MessageHeader<'_>, _body: &[u8]) {}
+}
+
+/// Декодирует одно сообщение SBE (без префикса MsgSize) и передает его обработчику
+#[inline(always)]
+pub fn decode<H: Mdp3Handler>(msg: &[u8], handler: &mut H) -> Result<(), DecodeError> {
+    let (header, root, groups) = split_message(msg)?;
+
+    if header.schema_id() != SCHEMA_ID || header.version() < MIN_SCHEMA_VERSION {
+        return Err(DecodeError::UnsupportedSchema {
+            schema_id: header.schema_id(),
+            version: header.version(),
+        });
+    }
+
+    match header.template_id() {
+        TEMPLATE_BOOK => {
+            let root = root_block(root, header)?;
+            let (entries, rest) = Group::parse(groups, GroupHeader::Compact)?;
+            let (orders, _) = Group::parse(rest, GroupHeader::Padded8)?;
+            handler.on_book(&IncrementalRefreshBook {
+                root,
+                entries,
+                orders,
+            });
+        }
+        TEMPLATE_ORDER_BOOK => {
+            let root = root_block(root, header)?;
+            let (entries, _) = Group::parse(groups, GroupHeader::Padded8)?;
+            handler.on_order_book(&IncrementalRefreshOrderBook { root, entries });
+        }
+        TEMPLATE_TRADE_SUMMARY => {
+            let root = root_block(root, header)?;
+            let (entries, rest) = Group::parse(groups, GroupHeader::Compact)?;
+            let (orders, _) = Group::parse(rest, GroupHeader::Padded8)?;
+            handler.on_trade_summary(&IncrementalRefreshTradeSummary {
+                root,
+                entries,
+                orders,
+            });
+        }
+        _ => handler.on_other(header, &msg[MessageHeader::LEN..]),
+    }
+
+    Ok(())
+}
+
+/// Декодирует все сообщения пакета MDP 3.0; возвращает порядковый номер пакета
+#[inline(always)]
+pub fn decode_packet<H: Mdp3Handler>(payload: &[u8], handler: &mut H) -> Result<u32, DecodeError> {
+    let packet = Mdp3Packet::parse(payload)?;
+
+    for msg in packet.messages() {
+        decode(msg?, handler)?;
+    }
+
+    Ok(packet.sequence())
+}
+
+/// Проверяет длину корневого блока инкрементального сообщения
+#[inline(always)]
+fn root_block<'a>(
+    root: &'a [u8],
+    header: MessageHeader<'_>,
+) -> Result<IncrementalRoot<'a>, DecodeError> {
+    if root.len() < IncrementalRoot::LEN {
+        return Err(DecodeError::LengthMismatch {
+            msg_type: header.template_id(),
+            expected: IncrementalRoot::LEN,
+            actual: root.len(),
+        });
+    }
+    Ok(unsafe { IncrementalRoot::new_unchecked(root) })
+}
+
+/// Переводит цену PRICE9 в значение с плавающей точкой (для отчетов);
+/// `None` для PRICENULL9
+#[inline(always)]
+pub fn price_to_f64(price: i64) -> Option<f64> {
+    if price == PRICE_NULL {
+        None
+    } else {
+        Some(price as f64 * 1e-9)
+    }
+}
@@ -1 +1,8 @@
-
+pub mod fix;
+pub mod igmp;
+pub mod itch;
+pub mod mdp3;
+pub mod moldudp64;
+pub mod ouch;
+pub mod sbe;
+pub mod wire;
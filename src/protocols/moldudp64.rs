@@ -0,0 +1,137 @@
+// src/protocols/moldudp64.rs
+use crate::protocols::wire::{ensure_len, DecodeError, WireField};
+
+/// Длина заголовка пакета MoldUDP64
+pub const HEADER_LEN: usize = 20;
+
+/// Значение message_count, означающее конец сессии
+pub const END_OF_SESSION: u16 = 0xFFFF;
+
+/// Пакет MoldUDP64 поверх полезной нагрузки UDP
+///
+/// Заголовок: session (10 байт), первый порядковый номер (u64 BE),
+/// количество сообщений (u16 BE). Далее блоки сообщений: длина (u16 BE)
+/// и данные. Сообщения выдаются срезами исходного буфера без копирования.
+#[derive(Debug, Clone, Copy)]
+pub struct MoldPacket<'a> {
+    buf: &'a [u8],
+}
+
+impl<'a> MoldPacket<'a> {
+    /// Проверяет заголовок пакета
+    #[inline(always)]
+    pub fn parse(buf: &'a [u8]) -> Result<Self, DecodeError> {
+        ensure_len(buf, HEADER_LEN)?;
+        Ok(Self { buf })
+    }
+
+    /// Идентификатор сессии
+    #[inline(always)]
+    pub fn session(&self) -> [u8; 10] {
+        unsafe { <[u8; 10]>::read_be(self.buf, 0) }
+    }
+
+    /// Порядковый номер первого сообщения пакета
+    #[inline(always)]
+    pub fn sequence(&self) -> u64 {
+        unsafe { u64::read_be(self.buf, 10) }
+    }
+
+    /// Количество сообщений в пакете
+    #[inline(always)]
+    pub fn message_count(&self) -> u16 {
+        unsafe { u16::read_be(self.buf, 18) }
+    }
+
+    /// Heartbeat: пакет без сообщений, sequence - следующий ожидаемый номер
+    #[inline(always)]
+    pub fn is_heartbeat(&self) -> bool {
+        self.message_count() == 0
+    }
+
+    /// Последний пакет сессии
+    #[inline(always)]
+    pub fn is_end_of_session(&self) -> bool {
+        self.message_count() == END_OF_SESSION
+    }
+
+    /// Порядковый номер, ожидаемый в следующем пакете
+    #[inline(always)]
+    pub fn next_sequence(&self) -> u64 {
+        if self.is_end_of_session() {
+            self.sequence()
+        } else {
+            self.sequence() + self.message_count() as u64
+        }
+    }
+
+    /// Итератор по сообщениям пакета
+    #[inline(always)]
+    pub fn messages(&self) -> MoldMessages<'a> {
+        let count = if self.is_end_of_session() {
+            0
+        } else {
+            self.message_count()
+        };
+
+        MoldMessages {
+            buf: self.buf,
+            offset: HEADER_LEN,
+            remaining: count,
+            sequence: self.sequence(),
+        }
+    }
+}
+
+/// Итератор по блокам сообщений MoldUDP64
+///
+/// Выдает пары (порядковый номер, данные сообщения). Обрезанный блок
+/// завершает итерацию ошибкой `Truncated`.
+#[derive(Debug, Clone)]
+pub struct MoldMessages<'a> {
+    buf: &'a [u8],
+    offset: usize,
+    remaining: u16,
+    sequence: u64,
+}
+
+impl<'a> Iterator for MoldMessages<'a> {
+    type Item = Result<(u64, &'a [u8]), DecodeError>;
+
+    #[inline(always)]
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.remaining == 0 {
+            return None;
+        }
+
+        let rest = &self.buf[self.offset..];
+        if rest.len() < 2 {
+            self.remaining = 0;
+            return Some(Err(DecodeError::Truncated {
+                needed: 2,
+                available: rest.len(),
+            }));
+        }
+
+        let len = unsafe { u16::read_be(rest, 0) } as usize;
+        if rest.len() < 2 + len {
+            self.remaining = 0;
+            return Some(Err(DecodeError::Truncated {
+                needed: 2 + len,
+                available: rest.len(),
+            }));
+        }
+
+        let sequence = self.sequence;
+        self.sequence += 1;
+        self.remaining -= 1;
+        self.offset += 2 + len;
+
+        Some(Ok((sequence, &rest[2..2 + len])))
+    }
+
+    #[inline(always)]
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (0, Some(self.remaining as usize))
+    }
+}
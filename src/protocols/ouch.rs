@@ -0,0 +1,154 @@
+// src/protocols/ouch.rs
+use crate::book::orders::Side;
+use crate::protocols::wire::{put_alpha, put_decimal};
+
+/// Тип пакета SoupBinTCP: неупорядоченные данные клиента
+const SOUP_UNSEQUENCED: u8 = b'U';
+/// Заголовок SoupBinTCP: длина (u16 BE, без самого поля) и тип пакета
+const SOUP_HDR_LEN: usize = 3;
+
+/// OUCH 4.2 Enter Order
+pub const ENTER_ORDER_LEN: usize = 49;
+/// OUCH 4.2 Cancel Order
+pub const CANCEL_ORDER_LEN: usize = 19;
+/// Длина Order Token
+pub const TOKEN_LEN: usize = 14;
+/// Максимальная длина пакета, собираемого по шаблону
+pub const MAX_PACKET_LEN: usize = SOUP_HDR_LEN + ENTER_ORDER_LEN;
+
+/// Time in Force: до конца торгового дня
+pub const TIF_MARKET_HOURS: u32 = 99_998;
+/// Time in Force: немедленно или отменить
+pub const TIF_IOC: u32 = 0;
+
+/// Статические поля Enter Order, известные при logon
+#[derive(Debug, Clone)]
+pub struct OuchOrderParams {
+    pub stock: String,
+    pub firm: String,
+    pub time_in_force: u32,
+    /// Display: b'Y' - видимый, b'N' - скрытый
+    pub display: u8,
+    /// Capacity: b'A' - агент, b'P' - принципал
+    pub capacity: u8,
+    /// Статический префикс Order Token; остаток токена - номер ордера
+    pub token_prefix: String,
+}
+
+/// Изменяемые поля ордера
+#[derive(Debug, Clone, Copy)]
+pub struct OuchOrder {
+    pub token: u64,
+    pub side: Side,
+    pub shares: u32,
+    /// Цена с 4 знаками после запятой (как в ITCH)
+    pub price: u32,
+}
+
+/// Пакет SoupBinTCP с сообщением OUCH 4.2, собранный при logon
+///
+/// OUCH бинарный, поэтому при отправке после копирования шаблона
+/// исправляются только цифры токена, сторона, количество и цена; длины,
+/// символ, firm и прочие поля уже на месте.
+#[derive(Clone)]
+pub struct OuchTemplate {
+    buf: [u8; MAX_PACKET_LEN],
+    len: usize,
+    token_digits: std::ops::Range<usize>,
+    /// Смещения полей от начала пакета; 0 - поля нет в сообщении
+    side_off: usize,
+    shares_off: usize,
+    price_off: usize,
+}
+
+impl OuchTemplate {
+    /// Enter Order ('O')
+    pub fn enter_order(params: &OuchOrderParams) -> Result<Self, String> {
+        let mut t = Self::packet(b'O', ENTER_ORDER_LEN, &params.token_prefix)?;
+        let m = SOUP_HDR_LEN;
+
+        put_alpha(&mut t.buf[m + 20..m + 28], params.stock.as_bytes())
+            .ok_or_else(|| format!("OUCH stock '{}' is longer than 8", params.stock))?;
+        t.buf[m + 32..m + 36].copy_from_slice(&params.time_in_force.to_be_bytes());
+        put_alpha(&mut t.buf[m + 36..m + 40], params.firm.as_bytes())
+            .ok_or_else(|| format!("OUCH firm '{}' is longer than 4", params.firm))?;
+        t.buf[m + 40] = params.display;
+        t.buf[m + 41] = params.capacity;
+        // Intermarket Sweep, Minimum Quantity, Cross Type, Customer Type
+        t.buf[m + 42] = b'N';
+        t.buf[m + 43..m + 47].fill(0);
+        t.buf[m + 47] = b'N';
+        t.buf[m + 48] = b'R';
+
+        t.side_off = m + 15;
+        t.shares_off = m + 16;
+        t.price_off = m + 28;
+        Ok(t)
+    }
+
+    /// Cancel Order ('X'); shares - количество, остающееся у ордера
+    pub fn cancel_order(token_prefix: &str) -> Result<Self, String> {
+        let mut t = Self::packet(b'X', CANCEL_ORDER_LEN, token_prefix)?;
+        t.shares_off = SOUP_HDR_LEN + 15;
+        Ok(t)
+    }
+
+    fn packet(msg_type: u8, msg_len: usize, token_prefix: &str) -> Result<Self, String> {
+        if token_prefix.len() >= TOKEN_LEN {
+            return Err(format!(
+                "OUCH token prefix '{}' leaves no room for the order number",
+                token_prefix
+            ));
+        }
+
+        let mut buf = [b' '; MAX_PACKET_LEN];
+        buf[0..2].copy_from_slice(&((msg_len + 1) as u16).to_be_bytes());
+        buf[2] = SOUP_UNSEQUENCED;
+        buf[SOUP_HDR_LEN] = msg_type;
+
+        let token = SOUP_HDR_LEN + 1;
+        buf[token..token + token_prefix.len()].copy_from_slice(token_prefix.as_bytes());
+
+        Ok(Self {
+            buf,
+            len: SOUP_HDR_LEN + msg_len,
+            token_digits: token + token_prefix.len()..token + TOKEN_LEN,
+            side_off: 0,
+            shares_off: 0,
+            price_off: 0,
+        })
+    }
+
+    /// Длина пакета вместе с заголовком SoupBinTCP
+    #[inline(always)]
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn as_bytes(&self) -> &[u8] {
+        &self.buf[..self.len]
+    }
+
+    /// Записывает пакет в `out`, возвращает длину; None - буфер короче
+    /// пакета или номер ордера не помещается в токен
+    #[inline]
+    pub fn encode(&self, out: &mut [u8], order: &OuchOrder) -> Option<usize> {
+        let out = out.get_mut(..self.len)?;
+        out.copy_from_slice(&self.buf[..self.len]);
+
+        put_decimal(&mut out[self.token_digits.clone()], order.token)?;
+        out[self.shares_off..self.shares_off + 4].copy_from_slice(&order.shares.to_be_bytes());
+
+        if self.side_off != 0 {
+            out[self.side_off] = match order.side {
+                Side::Bid => b'B',
+                Side::Ask => b'S',
+            };
+        }
+        if self.price_off != 0 {
+            out[self.price_off..self.price_off + 4].copy_from_slice(&order.price.to_be_bytes());
+        }
+
+        Some(self.len)
+    }
+}
@@ -0,0 +1,169 @@
+// src/protocols/sbe.rs
+use std::marker::PhantomData;
+
+use crate::protocols::wire::{ensure_len, wire_view, DecodeError, WireView};
+
+wire_view! {
+    /// Заголовок сообщения SBE (little-endian)
+    pub struct MessageHeader, read_le, len = 8;
+    /// Длина корневого блока; может превышать известную декодеру
+    /// при более новой версии схемы
+    block_length: u16 = 0;
+    template_id: u16 = 2;
+    schema_id: u16 = 4;
+    version: u16 = 6;
+}
+
+wire_view! {
+    /// Размерность повторяющейся группы: blockLength u16, numInGroup u8
+    pub struct GroupSize, read_le, len = 3;
+    block_length: u16 = 0;
+    num_in_group: u8 = 2;
+}
+
+wire_view! {
+    /// Размерность группы с 8-байтовым заголовком (groupSize8Byte)
+    pub struct GroupSize8Byte, read_le, len = 8;
+    block_length: u16 = 0;
+    num_in_group: u8 = 7;
+}
+
+/// Формат заголовка повторяющейся группы
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum GroupHeader {
+    /// 3 байта: blockLength u16, numInGroup u8
+    Compact,
+    /// 8 байт: blockLength u16, 5 байт выравнивания, numInGroup u8
+    Padded8,
+}
+
+/// Повторяющаяся группа записей одного типа
+///
+/// Записи читаются с шагом `blockLength` из заголовка группы, поэтому
+/// поля, добавленные в новых версиях схемы, пропускаются. Длина записи
+/// проверяется один раз при разборе группы.
+#[derive(Debug, Clone, Copy)]
+pub struct Group<'a, V> {
+    buf: &'a [u8],
+    block_len: usize,
+    count: usize,
+    _entry: PhantomData<V>,
+}
+
+impl<'a, V: WireView<'a>> Group<'a, V> {
+    /// Разбирает группу в начале `buf`; возвращает группу и остаток буфера
+    #[inline(always)]
+    pub fn parse(buf: &'a [u8], header: GroupHeader) -> Result<(Self, &'a [u8]), DecodeError> {
+        let (block_len, count, header_len) = match header {
+            GroupHeader::Compact => {
+                let size = GroupSize::new(buf)?;
+                (
+                    size.block_length() as usize,
+                    size.num_in_group() as usize,
+                    GroupSize::LEN,
+                )
+            }
+            GroupHeader::Padded8 => {
+                let size = GroupSize8Byte::new(buf)?;
+                (
+                    size.block_length() as usize,
+                    size.num_in_group() as usize,
+                    GroupSize8Byte::LEN,
+                )
+            }
+        };
+
+        if count > 0 && block_len < V::LEN {
+            return Err(DecodeError::LengthMismatch {
+                msg_type: 0,
+                expected: V::LEN,
+                actual: block_len,
+            });
+        }
+
+        let total = header_len + block_len * count;
+        ensure_len(buf, total)?;
+
+        let group = Self {
+            buf: &buf[header_len..total],
+            block_len,
+            count,
+            _entry: PhantomData,
+        };
+
+        Ok((group, &buf[total..]))
+    }
+
+    /// Количество записей
+    #[inline(always)]
+    pub fn len(&self) -> usize {
+        self.count
+    }
+
+    #[inline(always)]
+    pub fn is_empty(&self) -> bool {
+        self.count == 0
+    }
+
+    /// Запись с индексом `index`
+    #[inline(always)]
+    pub fn get(&self, index: usize) -> Option<V> {
+        if index >= self.count {
+            return None;
+        }
+
+        let start = index * self.block_len;
+        Some(unsafe { V::new_unchecked(&self.buf[start..start + self.block_len]) })
+    }
+
+    /// Итератор по записям
+    #[inline(always)]
+    pub fn iter(&self) -> GroupIter<'a, V> {
+        GroupIter {
+            chunks: self.buf.chunks_exact(self.block_len.max(1)),
+            remaining: self.count,
+            _entry: PhantomData,
+        }
+    }
+}
+
+/// Итератор по записям повторяющейся группы
+pub struct GroupIter<'a, V> {
+    chunks: std::slice::ChunksExact<'a, u8>,
+    remaining: usize,
+    _entry: PhantomData<V>,
+}
+
+impl<'a, V: WireView<'a>> Iterator for GroupIter<'a, V> {
+    type Item = V;
+
+    #[inline(always)]
+    fn next(&mut self) -> Option<V> {
+        if self.remaining == 0 {
+            return None;
+        }
+        self.remaining -= 1;
+        // Длина записи проверена в Group::parse
+        self.chunks
+            .next()
+            .map(|chunk| unsafe { V::new_unchecked(chunk) })
+    }
+
+    #[inline(always)]
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (self.remaining, Some(self.remaining))
+    }
+}
+
+/// Разбирает заголовок SBE и корневой блок сообщения
+///
+/// Возвращает заголовок, корневой блок длиной `blockLength` и остаток
+/// сообщения с повторяющимися группами.
+#[inline(always)]
+pub fn split_message(msg: &[u8]) -> Result<(MessageHeader<'_>, &[u8], &[u8]), DecodeError> {
+    let header = MessageHeader::new(msg)?;
+    let root_end = MessageHeader::LEN + header.block_length() as usize;
+    ensure_len(msg, root_end)?;
+
+    Ok((header, &msg[MessageHeader::LEN..root_end], &msg[root_end..]))
+}
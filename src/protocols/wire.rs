@@ -0,0 +1,243 @@
+// src/protocols/wire.rs
+use std::fmt;
+
+/// Ошибка декодирования сообщения биржевого протокола
+///
+/// Тип не выделяет память и копируется, чтобы ошибки на горячем пути
+/// можно было считать, не создавая строк.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum DecodeError {
+    /// Буфер короче, чем требует заголовок или объявленная длина
+    Truncated { needed: usize, available: usize },
+    /// Тип сообщения неизвестен декодеру
+    UnknownMessage(u16),
+    /// Длина сообщения меньше фиксированной длины его типа
+    LengthMismatch {
+        msg_type: u16,
+        expected: usize,
+        actual: usize,
+    },
+    /// Схема SBE не поддерживается
+    UnsupportedSchema { schema_id: u16, version: u16 },
+}
+
+impl fmt::Display for DecodeError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match *self {
+            DecodeError::Truncated { needed, available } => {
+                write!(
+                    f,
+                    "truncated message: need {} bytes, have {}",
+                    needed, available
+                )
+            }
+            DecodeError::UnknownMessage(msg_type) => write!(f, "unknown message type {}", msg_type),
+            DecodeError::LengthMismatch {
+                msg_type,
+                expected,
+                actual,
+            } => write!(
+                f,
+                "message type {}: expected {} bytes, got {}",
+                msg_type, expected, actual
+            ),
+            DecodeError::UnsupportedSchema { schema_id, version } => {
+                write!(
+                    f,
+                    "unsupported SBE schema {} version {}",
+                    schema_id, version
+                )
+            }
+        }
+    }
+}
+
+/// Проверяет, что буфер содержит не меньше `needed` байт
+#[inline(always)]
+pub fn ensure_len(buf: &[u8], needed: usize) -> Result<(), DecodeError> {
+    if buf.len() < needed {
+        Err(DecodeError::Truncated {
+            needed,
+            available: buf.len(),
+        })
+    } else {
+        Ok(())
+    }
+}
+
+/// Поле фиксированного размера, читаемое напрямую из буфера сообщения
+pub trait WireField: Sized + Copy {
+    const SIZE: usize;
+
+    /// Читает поле в сетевом порядке байт (ITCH, MoldUDP64)
+    ///
+    /// # Safety
+    /// `buf` должен содержать не меньше `offset + SIZE` байт.
+    unsafe fn read_be(buf: &[u8], offset: usize) -> Self;
+
+    /// Читает поле в порядке little-endian (SBE)
+    ///
+    /// # Safety
+    /// `buf` должен содержать не меньше `offset + SIZE` байт.
+    unsafe fn read_le(buf: &[u8], offset: usize) -> Self;
+}
+
+macro_rules! impl_wire_int {
+    ($($ty:ty),*) => {$(
+        impl WireField for $ty {
+            const SIZE: usize = std::mem::size_of::<$ty>();
+
+            #[inline(always)]
+            unsafe fn read_be(buf: &[u8], offset: usize) -> Self {
+                debug_assert!(offset + Self::SIZE <= buf.len());
+                <$ty>::from_be(std::ptr::read_unaligned(buf.as_ptr().add(offset) as *const $ty))
+            }
+
+            #[inline(always)]
+            unsafe fn read_le(buf: &[u8], offset: usize) -> Self {
+                debug_assert!(offset + Self::SIZE <= buf.len());
+                <$ty>::from_le(std::ptr::read_unaligned(buf.as_ptr().add(offset) as *const $ty))
+            }
+        }
+    )*};
+}
+
+impl_wire_int!(u8, i8, u16, i16, u32, i32, u64, i64);
+
+impl<const N: usize> WireField for [u8; N] {
+    const SIZE: usize = N;
+
+    #[inline(always)]
+    unsafe fn read_be(buf: &[u8], offset: usize) -> Self {
+        debug_assert!(offset + N <= buf.len());
+        std::ptr::read_unaligned(buf.as_ptr().add(offset) as *const [u8; N])
+    }
+
+    #[inline(always)]
+    unsafe fn read_le(buf: &[u8], offset: usize) -> Self {
+        Self::read_be(buf, offset)
+    }
+}
+
+/// Читает 48-битное беззнаковое целое в сетевом порядке байт
+///
+/// # Safety
+/// `buf` должен содержать не меньше `offset + 6` байт.
+#[inline(always)]
+pub unsafe fn read_u48_be(buf: &[u8], offset: usize) -> u64 {
+    let hi = u16::read_be(buf, offset) as u64;
+    let lo = u32::read_be(buf, offset + 2) as u64;
+    (hi << 32) | lo
+}
+
+/// Отбрасывает пробелы справа в алфавитно-цифровом поле (символ, MPID)
+#[inline(always)]
+pub fn trim_alpha(field: &[u8]) -> &[u8] {
+    let end = field
+        .iter()
+        .rposition(|&b| b != b' ' && b != 0)
+        .map_or(0, |i| i + 1);
+    &field[..end]
+}
+
+/// Записывает `value` десятичными цифрами на всю ширину `dst` с ведущими нулями
+///
+/// Время записи зависит только от ширины поля, а не от значения. Возвращает
+/// сумму записанных байт (для контрольной суммы FIX) или None, если
+/// значение не помещается в поле.
+#[inline(always)]
+pub fn put_decimal(dst: &mut [u8], mut value: u64) -> Option<u32> {
+    let mut sum = 0u32;
+    for digit in dst.iter_mut().rev() {
+        *digit = b'0' + (value % 10) as u8;
+        sum += *digit as u32;
+        value /= 10;
+    }
+    (value == 0).then_some(sum)
+}
+
+/// Записывает алфавитно-цифровое поле с выравниванием влево и пробелами
+/// справа (символ, токен); None - строка длиннее поля
+#[inline]
+pub fn put_alpha(dst: &mut [u8], src: &[u8]) -> Option<()> {
+    if src.len() > dst.len() {
+        return None;
+    }
+    dst[..src.len()].copy_from_slice(src);
+    dst[src.len()..].fill(b' ');
+    Some(())
+}
+
+/// Представление блока фиксированной длины поверх буфера сообщения
+pub trait WireView<'a>: Sized + Copy {
+    /// Минимальная длина блока в байтах
+    const LEN: usize;
+
+    /// Создает представление без проверки длины
+    ///
+    /// # Safety
+    /// `buf` должен содержать не меньше `LEN` байт.
+    unsafe fn new_unchecked(buf: &'a [u8]) -> Self;
+}
+
+/// Объявляет представление сообщения фиксированной длины поверх буфера
+///
+/// Для каждого поля генерируется метод, читающий значение по смещению,
+/// известному на этапе компиляции. Длина буфера проверяется один раз
+/// в `new`, поэтому методы полей не выполняют проверок границ, а
+/// `const`-проверка гарантирует, что все поля помещаются в `LEN`.
+macro_rules! wire_view {
+    (
+        $(#[$meta:meta])*
+        pub struct $name:ident, $read:ident, len = $len:expr;
+        $( $(#[$fmeta:meta])* $field:ident: $ty:ty = $offset:expr; )*
+    ) => {
+        $(#[$meta])*
+        #[derive(Debug, Clone, Copy)]
+        pub struct $name<'a> {
+            buf: &'a [u8],
+        }
+
+        impl<'a> $name<'a> {
+            /// Фиксированная длина сообщения в байтах
+            pub const LEN: usize = $len;
+
+            /// Создает представление, проверяя длину буфера
+            #[inline(always)]
+            pub fn new(buf: &'a [u8]) -> Result<Self, $crate::protocols::wire::DecodeError> {
+                $crate::protocols::wire::ensure_len(buf, Self::LEN)?;
+                Ok(Self { buf })
+            }
+
+            /// Исходные байты сообщения
+            #[inline(always)]
+            pub fn as_bytes(&self) -> &'a [u8] {
+                self.buf
+            }
+
+            $(
+                $(#[$fmeta])*
+                #[inline(always)]
+                pub fn $field(&self) -> $ty {
+                    unsafe { <$ty as $crate::protocols::wire::WireField>::$read(self.buf, $offset) }
+                }
+            )*
+        }
+
+        impl<'a> $crate::protocols::wire::WireView<'a> for $name<'a> {
+            const LEN: usize = $len;
+
+            #[inline(always)]
+            unsafe fn new_unchecked(buf: &'a [u8]) -> Self {
+                debug_assert!(buf.len() >= $len);
+                Self { buf }
+            }
+        }
+
+        const _: () = {
+            $( assert!($offset + <$ty as $crate::protocols::wire::WireField>::SIZE <= $len); )*
+        };
+    };
+}
+
+pub(crate) use wire_view;
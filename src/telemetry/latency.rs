@@ -0,0 +1,146 @@
+// src/telemetry/latency.rs
+use crate::packet::timestamp::cycles_to_ns;
+use crate::telemetry::worker::Counter;
+
+/// Число бит мантиссы: 16 подкорзин на каждую степень двойки (~6% точности)
+const SUB_BUCKET_BITS: u32 = 4;
+const SUB_BUCKETS: usize = 1 << SUB_BUCKET_BITS;
+/// Старший учитываемый бит значения; большие значения попадают в последнюю корзину
+const MAX_MAGNITUDE: u32 = 40;
+/// Количество корзин гистограммы
+pub const LATENCY_BUCKETS: usize = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) as usize * SUB_BUCKETS;
+
+/// Гистограмма задержек в тактах TSC с логарифмически-линейными корзинами
+///
+/// Как и в HdrHistogram, каждая степень двойки делится на равные
+/// подкорзины, поэтому относительная погрешность постоянна во всем
+/// диапазоне. Запись - одна операция над счетчиком без RMW-инструкций,
+/// писатель у гистограммы один; читать можно из любого потока.
+#[repr(C, align(64))]
+#[derive(Debug)]
+pub struct LatencyHistogram {
+    count: Counter,
+    sum: Counter,
+    max: Counter,
+    buckets: [Counter; LATENCY_BUCKETS],
+}
+
+impl LatencyHistogram {
+    pub fn new() -> Self {
+        Self {
+            count: Counter::default(),
+            sum: Counter::default(),
+            max: Counter::default(),
+            buckets: std::array::from_fn(|_| Counter::default()),
+        }
+    }
+
+    /// Индекс корзины для значения
+    #[inline(always)]
+    fn bucket_index(value: u64) -> usize {
+        if value < SUB_BUCKETS as u64 {
+            return value as usize;
+        }
+
+        let magnitude = (63 - value.leading_zeros()).min(MAX_MAGNITUDE);
+        let shift = magnitude - SUB_BUCKET_BITS;
+        let sub = ((value >> shift) as usize).min(2 * SUB_BUCKETS - 1) & (SUB_BUCKETS - 1);
+
+        (shift as usize + 1) * SUB_BUCKETS + sub
+    }
+
+    /// Верхняя граница значений корзины
+    fn bucket_upper_bound(index: usize) -> u64 {
+        if index < SUB_BUCKETS {
+            return index as u64;
+        }
+
+        let shift = (index / SUB_BUCKETS - 1) as u32;
+        let sub = (index % SUB_BUCKETS) as u64;
+
+        ((SUB_BUCKETS as u64 + sub + 1) << shift) - 1
+    }
+
+    /// Учитывает одно измерение; вызывать только из потока-владельца
+    #[inline(always)]
+    pub fn record(&self, cycles: u64) {
+        self.count.inc();
+        self.sum.add(cycles);
+        self.max.raise(cycles);
+        self.buckets[Self::bucket_index(cycles)].inc();
+    }
+
+    /// Снимает копию гистограммы и вычисляет перцентили
+    pub fn snapshot(&self) -> LatencySnapshot {
+        let buckets: [u64; LATENCY_BUCKETS] = std::array::from_fn(|i| self.buckets[i].get());
+        // Счетчики читаются не атомарно как группа, поэтому сумма корзин
+        // может немного отличаться от count; перцентили считаются по корзинам
+        let total: u64 = buckets.iter().sum();
+
+        let percentile = |q: f64| -> u64 {
+            if total == 0 {
+                return 0;
+            }
+            let rank = ((total as f64 * q).ceil() as u64).max(1);
+            let mut seen = 0;
+            for (index, &n) in buckets.iter().enumerate() {
+                seen += n;
+                if seen >= rank {
+                    return Self::bucket_upper_bound(index);
+                }
+            }
+            Self::bucket_upper_bound(LATENCY_BUCKETS - 1)
+        };
+
+        let max = self.max.get();
+
+        LatencySnapshot {
+            count: self.count.get(),
+            sum: self.sum.get(),
+            p50: percentile(0.50).min(max),
+            p99: percentile(0.99).min(max),
+            p999: percentile(0.999).min(max),
+            max,
+        }
+    }
+}
+
+impl Default for LatencyHistogram {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Перцентили задержки в тактах TSC
+#[derive(Debug, Clone, Copy, Default)]
+pub struct LatencySnapshot {
+    pub count: u64,
+    pub sum: u64,
+    pub p50: u64,
+    pub p99: u64,
+    pub p999: u64,
+    pub max: u64,
+}
+
+impl LatencySnapshot {
+    /// Среднее значение в тактах
+    pub fn mean(&self) -> f64 {
+        if self.count == 0 {
+            0.0
+        } else {
+            self.sum as f64 / self.count as f64
+        }
+    }
+
+    /// Переводит значения в наносекунды по частоте TSC
+    pub fn to_ns(&self, tsc_hz: u64) -> LatencySnapshot {
+        LatencySnapshot {
+            count: self.count,
+            sum: cycles_to_ns(self.sum, tsc_hz),
+            p50: cycles_to_ns(self.p50, tsc_hz),
+            p99: cycles_to_ns(self.p99, tsc_hz),
+            p999: cycles_to_ns(self.p999, tsc_hz),
+            max: cycles_to_ns(self.max, tsc_hz),
+        }
+    }
+}
@@ -0,0 +1,3 @@
+pub mod latency;
+pub mod port;
+pub mod worker;
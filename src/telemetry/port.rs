@@ -0,0 +1,96 @@
+// src/telemetry/port.rs
+use std::ffi::CStr;
+
+use crate::dpdk::ffi;
+
+/// Статистика порта, прочитанная из драйвера
+///
+/// В отличие от счетчиков worker, эти значения ведет NIC: `imissed` -
+/// пакеты, не попавшие в RX кольцо, `rx_nombuf` - пакеты, для которых
+/// не нашлось mbuf в пуле.
+#[derive(Debug, Clone, Copy)]
+pub struct PortStats {
+    pub port_id: u16,
+    pub ipackets: u64,
+    pub ibytes: u64,
+    pub opackets: u64,
+    pub obytes: u64,
+    pub imissed: u64,
+    pub ierrors: u64,
+    pub oerrors: u64,
+    pub rx_nombuf: u64,
+}
+
+impl PortStats {
+    /// Читает базовую статистику порта
+    ///
+    /// Вызов обращается к регистрам NIC и не должен выполняться из RX цикла.
+    pub fn read(port_id: u16) -> Result<Self, String> {
+        let mut stats: ffi::RteEthStats = unsafe { std::mem::zeroed() };
+        let ret = unsafe { ffi::rte_eth_stats_get(port_id, &mut stats) };
+
+        if ret != 0 {
+            return Err(format!(
+                "Failed to read stats for port {}: {}",
+                port_id, ret
+            ));
+        }
+
+        Ok(Self {
+            port_id,
+            ipackets: stats.ipackets,
+            ibytes: stats.ibytes,
+            opackets: stats.opackets,
+            obytes: stats.obytes,
+            imissed: stats.imissed,
+            ierrors: stats.ierrors,
+            oerrors: stats.oerrors,
+            rx_nombuf: stats.rx_nombuf,
+        })
+    }
+}
+
+/// Читает расширенные счетчики драйвера (xstats) порта
+///
+/// Возвращает пары (имя, значение) в порядке, заданном драйвером.
+pub fn read_port_xstats(port_id: u16) -> Result<Vec<(String, u64)>, String> {
+    let count = unsafe { ffi::rte_eth_xstats_get_names(port_id, std::ptr::null_mut(), 0) };
+    if count < 0 {
+        return Err(format!(
+            "Failed to query xstats count for port {}: {}",
+            port_id, count
+        ));
+    }
+
+    let count = count as usize;
+    let mut names = vec![
+        ffi::RteEthXstatName {
+            name: [0; ffi::RTE_ETH_XSTATS_NAME_SIZE],
+        };
+        count
+    ];
+    let mut values = vec![ffi::RteEthXstat::default(); count];
+
+    let nb_names =
+        unsafe { ffi::rte_eth_xstats_get_names(port_id, names.as_mut_ptr(), count as u32) };
+    let nb_values = unsafe { ffi::rte_eth_xstats_get(port_id, values.as_mut_ptr(), count as u32) };
+
+    if nb_names < 0 || nb_values < 0 || nb_names as usize != nb_values as usize {
+        return Err(format!(
+            "Failed to read xstats for port {}: names {}, values {}",
+            port_id, nb_names, nb_values
+        ));
+    }
+
+    let xstats = values
+        .iter()
+        .take(nb_values as usize)
+        .filter_map(|xstat| {
+            let name = names.get(xstat.id as usize)?;
+            let name = unsafe { CStr::from_ptr(name.name.as_ptr()) };
+            Some((name.to_string_lossy().into_owned(), xstat.value))
+        })
+        .collect();
+
+    Ok(xstats)
+}
@@ -0,0 +1,262 @@
+// src/telemetry/worker.rs
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use crate::dpdk::config::MAX_BURST_SIZE;
+use crate::telemetry::latency::{LatencyHistogram, LatencySnapshot};
+
+/// Количество слотов кодов ошибок разбора, должно совпадать с DPDK_PARSE_ERR_SLOTS
+pub const PARSE_ERR_SLOTS: usize = 8;
+
+/// Значение port_id в телеметрии стадий конвейера, не привязанных к порту
+pub const STAGE_PORT_ID: u16 = u16::MAX;
+
+/// Счетчик с единственным писателем
+///
+/// Писатель обновляет значение обычными load/store без RMW-инструкций
+/// и `lock`-префикса; читатели из других потоков видят монотонно
+/// растущее значение.
+#[repr(transparent)]
+#[derive(Debug, Default)]
+pub struct Counter(AtomicU64);
+
+impl Counter {
+    /// Увеличивает счетчик; вызывать только из потока-владельца
+    #[inline(always)]
+    pub fn add(&self, n: u64) {
+        self.0.store(self.0.load(Ordering::Relaxed) + n, Ordering::Relaxed);
+    }
+
+    #[inline(always)]
+    pub fn inc(&self) {
+        self.add(1);
+    }
+
+    /// Записывает значение; вызывать только из потока-владельца
+    #[inline(always)]
+    pub fn set(&self, value: u64) {
+        self.0.store(value, Ordering::Relaxed);
+    }
+
+    /// Поднимает значение до `value`, если оно больше текущего
+    #[inline(always)]
+    pub fn raise(&self, value: u64) {
+        if value > self.0.load(Ordering::Relaxed) {
+            self.0.store(value, Ordering::Relaxed);
+        }
+    }
+
+    /// Текущее значение
+    #[inline(always)]
+    pub fn get(&self) -> u64 {
+        self.0.load(Ordering::Relaxed)
+    }
+}
+
+/// Счетчики опросов очереди
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct PollCounters {
+    pub empty_polls: Counter,
+    pub busy_polls: Counter,
+}
+
+/// Счетчики принятого трафика
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct RxCounters {
+    /// Пакеты, полученные из RX очереди
+    pub packets: Counter,
+    /// Байты пакетов, переданных в разбор (после классификатора)
+    pub bytes: Counter,
+    /// Пакеты, переданные обработчику
+    pub delivered: Counter,
+    /// Пакеты, отброшенные классификатором заголовков
+    pub filtered: Counter,
+}
+
+/// Счетчики ошибок разбора, индекс - модуль кода возврата dpdk_parse_packet
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct ParseErrorCounters {
+    pub by_code: [Counter; PARSE_ERR_SLOTS],
+}
+
+/// Счетчики TX сессии
+///
+/// Пишет поток-владелец сессии, читать можно из любого потока через
+/// `TxSession::counters`.
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct TxCounters {
+    pub sent: Counter,
+    pub dropped: Counter,
+    pub alloc_failures: Counter,
+    pub oversized: Counter,
+    /// Вызовы rte_eth_tx_burst: отношение `sent / doorbells` показывает,
+    /// насколько bulk трафик объединяется
+    pub doorbells: Counter,
+    /// mbuf, возвращенные в пул `rte_eth_tx_done_cleanup`
+    pub reclaimed: Counter,
+    /// TSC последней успешной передачи пакетов в TX очередь
+    pub last_tx_tsc: Counter,
+    /// Задержка от прихода пакета-триггера до передачи ответа в TX очередь
+    pub tick_to_trade: LatencyHistogram,
+}
+
+/// Телеметрия одного worker
+///
+/// Каждая группа счетчиков лежит в своей кеш-линии. Worker - единственный
+/// писатель, читатель (поток отчетов или экспорт) только загружает
+/// значения и не инвалидирует линии worker записью.
+#[repr(C, align(64))]
+#[derive(Debug)]
+pub struct WorkerTelemetry {
+    /// Роль потока: "rx" для RX worker, иначе стадия конвейера
+    pub role: &'static str,
+    pub port_id: u16,
+    pub queue_id: u16,
+    pub core_id: usize,
+    pub polls: PollCounters,
+    pub rx: RxCounters,
+    pub parse_errors: ParseErrorCounters,
+    /// Гистограмма размеров burst: индекс - количество пакетов
+    pub burst_sizes: [Counter; MAX_BURST_SIZE + 1],
+    /// Задержка от прихода пакета до завершения обработчика burst
+    pub latency: LatencyHistogram,
+}
+
+impl WorkerTelemetry {
+    pub fn new(port_id: u16, queue_id: u16, core_id: usize) -> Self {
+        Self::with_role("rx", port_id, queue_id, core_id)
+    }
+
+    /// Телеметрия стадии конвейера `index`; порт не привязан
+    pub fn for_stage(role: &'static str, index: u16, core_id: usize) -> Self {
+        Self::with_role(role, STAGE_PORT_ID, index, core_id)
+    }
+
+    fn with_role(role: &'static str, port_id: u16, queue_id: u16, core_id: usize) -> Self {
+        Self {
+            role,
+            port_id,
+            queue_id,
+            core_id,
+            polls: PollCounters::default(),
+            rx: RxCounters::default(),
+            parse_errors: ParseErrorCounters::default(),
+            burst_sizes: std::array::from_fn(|_| Counter::default()),
+            latency: LatencyHistogram::new(),
+        }
+    }
+
+    /// Учитывает непустой опрос очереди
+    #[inline(always)]
+    pub fn record_rx(&self, nb_rx: usize) {
+        self.rx.packets.add(nb_rx as u64);
+        self.burst_sizes[nb_rx.min(MAX_BURST_SIZE)].inc();
+    }
+
+    /// Учитывает итоги разбора burst
+    #[inline(always)]
+    pub fn record_parse(&self, nb_ok: usize, stats: &BurstStats) {
+        self.rx.bytes.add(stats.bytes);
+        self.rx.delivered.add(nb_ok as u64);
+
+        if stats.nb_errors != 0 {
+            for (counter, &n) in self.parse_errors.by_code.iter().zip(stats.errors.iter()) {
+                if n != 0 {
+                    counter.add(n as u64);
+                }
+            }
+        }
+    }
+
+    /// Снимает копию всех счетчиков
+    pub fn snapshot(&self) -> WorkerSnapshot {
+        WorkerSnapshot {
+            role: self.role,
+            port_id: self.port_id,
+            queue_id: self.queue_id,
+            core_id: self.core_id,
+            empty_polls: self.polls.empty_polls.get(),
+            busy_polls: self.polls.busy_polls.get(),
+            rx_packets: self.rx.packets.get(),
+            rx_bytes: self.rx.bytes.get(),
+            rx_delivered: self.rx.delivered.get(),
+            rx_filtered: self.rx.filtered.get(),
+            parse_errors: std::array::from_fn(|i| self.parse_errors.by_code[i].get()),
+            burst_sizes: std::array::from_fn(|i| self.burst_sizes[i].get()),
+            latency: self.latency.snapshot(),
+        }
+    }
+}
+
+/// Итоги разбора одного burst, заполняются в dpdk_parse_burst
+///
+/// Раскладка совпадает с `struct dpdk_burst_stats` в src/native/dpdk.c.
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct BurstStats {
+    pub bytes: u64,
+    pub nb_errors: u16,
+    pub errors: [u16; PARSE_ERR_SLOTS],
+}
+
+impl BurstStats {
+    #[inline(always)]
+    pub fn clear(&mut self) {
+        *self = Self::default();
+    }
+}
+
+/// Копия счетчиков worker в момент чтения
+#[derive(Debug, Clone)]
+pub struct WorkerSnapshot {
+    pub role: &'static str,
+    pub port_id: u16,
+    pub queue_id: u16,
+    pub core_id: usize,
+    pub empty_polls: u64,
+    pub busy_polls: u64,
+    pub rx_packets: u64,
+    pub rx_bytes: u64,
+    pub rx_delivered: u64,
+    pub rx_filtered: u64,
+    pub parse_errors: [u64; PARSE_ERR_SLOTS],
+    pub burst_sizes: [u64; MAX_BURST_SIZE + 1],
+    /// Задержка обработки в тактах TSC
+    pub latency: LatencySnapshot,
+}
+
+impl WorkerSnapshot {
+    /// Средний размер непустого burst
+    pub fn mean_burst_size(&self) -> f64 {
+        let (sum, count) = self
+            .burst_sizes
+            .iter()
+            .enumerate()
+            .skip(1)
+            .fold((0u64, 0u64), |(s, c), (size, &n)| (s + size as u64 * n, c + n));
+
+        if count == 0 {
+            0.0
+        } else {
+            sum as f64 / count as f64
+        }
+    }
+
+    /// Доля пустых опросов
+    pub fn idle_ratio(&self) -> f64 {
+        let total = self.empty_polls + self.busy_polls;
+        if total == 0 {
+            0.0
+        } else {
+            self.empty_polls as f64 / total as f64
+        }
+    }
+
+    /// Всего ошибок разбора
+    pub fn total_parse_errors(&self) -> u64 {
+        self.parse_errors.iter().sum()
+    }
+}
@@ -0,0 +1,530 @@
+// src/training.rs
+//! Обучающая нагрузка для PGO/BOLT (`hfeec train ...`)
+//!
+//! Прогоняет через настоящие RX worker тот же путь, что и в production:
+//! классификатор, `dpdk_parse_burst`, декодирование ITCH поверх MoldUDP64
+//! в стаканы и отправку ордеров через TX сессию с кодированием на месте.
+//! Источник трафика - синтетический фид в `net_ring` (TX очередь замкнута
+//! на RX очередь) или запись фида, воспроизводимая `net_pcap` по кругу.
+//!
+//! Профиль инструментированной сборки записывается при нормальном
+//! завершении процесса, поэтому прогон ограничен по времени и завершается
+//! сам; см. scripts/pgo.sh.
+use std::net::Ipv4Addr;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::thread;
+use std::time::Duration;
+
+use crate::book::feed::{BookListener, BookSet, ItchBookHandler};
+use crate::book::order_book::BookConfig;
+use crate::book::orders::Side;
+use crate::dpdk::config::DpdkConfig;
+use crate::dpdk::hugepages::check_hugepages_available;
+use crate::numa::manager::NumaManager;
+use crate::packet::classify::FlowMatch;
+use crate::packet::timestamp::{tsc, tsc_hz, RxTimestampMode};
+use crate::protocols::itch::{AddOrder, OrderCancel, OrderDelete, OrderExecuted, OrderReplace};
+use crate::protocols::ouch::{OuchOrder, OuchOrderParams, OuchTemplate, TIF_IOC};
+use crate::protocols::wire::put_decimal;
+use crate::tx::risk::{self, RiskConfig, RiskCounters, RiskEngine, RiskLimits};
+use crate::tx::session::{TxProtocol, TxSession, TxSessionConfig};
+
+/// Адрес и порт синтетического фида
+const FEED_IP: Ipv4Addr = Ipv4Addr::new(233, 54, 12, 1);
+const FEED_PORT: u16 = 26400;
+/// Порт ордеров; на RX отфильтровывается классификатором
+const ORDER_PORT: u16 = 15000;
+
+/// Пакетов фида в одной отправке генератора
+const TX_BATCH: usize = 16;
+/// Сообщений ITCH в пакете MoldUDP64
+const MESSAGES_PER_PACKET: usize = 8;
+/// Один ордер на столько пакетов фида
+const PACKETS_PER_ORDER: u64 = 64;
+/// Максимальный размер пакета MoldUDP64 синтетического фида
+pub const MAX_PACKET_LEN: usize = 20 + MESSAGES_PER_PACKET * (2 + AddOrder::LEN);
+
+/// Средняя цена инструментов (4 знака после запятой, как в ITCH)
+const MID_PRICE: u32 = 1_000_000;
+const TICK: u32 = 100;
+/// Живых заявок, к которым стремится генератор
+const LIVE_ORDERS: usize = 4096;
+/// Stock locate инструмента ордеров генератора
+const ORDER_INSTRUMENT: u16 = 1;
+
+/// Параметры обучающего прогона
+#[derive(Debug, Clone)]
+pub struct TrainingConfig {
+    /// Запись фида для `net_pcap`; None - синтетический фид через `net_ring`
+    pub pcap: Option<String>,
+    pub seconds: u64,
+    /// Суммарная частота пакетов фида, 0 - без ограничения
+    pub rate_pps: u64,
+    pub queues: u16,
+    /// Инструменты со stock locate 1..=instruments
+    pub instruments: u16,
+}
+
+impl Default for TrainingConfig {
+    fn default() -> Self {
+        Self {
+            pcap: None,
+            seconds: 30,
+            rate_pps: 1_000_000,
+            queues: 1,
+            instruments: 64,
+        }
+    }
+}
+
+impl TrainingConfig {
+    /// Разбирает аргументы после `train`:
+    /// `[--pcap FILE] [--seconds N] [--rate PPS] [--queues N] [--instruments N]`
+    pub fn from_args(args: &[String]) -> Result<Self, String> {
+        fn value<'a, T: std::str::FromStr>(
+            it: &mut impl Iterator<Item = &'a String>,
+            name: &str,
+        ) -> Result<T, String> {
+            it.next()
+                .ok_or_else(|| format!("Missing value for {}", name))?
+                .parse()
+                .map_err(|_| format!("Invalid value for {}", name))
+        }
+
+        let mut config = Self::default();
+        let mut it = args.iter();
+        while let Some(arg) = it.next() {
+            match arg.as_str() {
+                "--pcap" => config.pcap = Some(value(&mut it, arg)?),
+                "--seconds" => config.seconds = value(&mut it, arg)?,
+                "--rate" => config.rate_pps = value(&mut it, arg)?,
+                "--queues" => config.queues = value(&mut it, arg)?,
+                "--instruments" => config.instruments = value(&mut it, arg)?,
+                other => return Err(format!("Unknown training argument: {}", other)),
+            }
+        }
+
+        config.queues = config.queues.max(1);
+        config.instruments = config.instruments.max(1);
+        Ok(config)
+    }
+
+    fn dpdk_config(&self) -> DpdkConfig {
+        let vdev = match self.pcap {
+            Some(ref file) => format!("net_pcap0,rx_pcap={},tx_pcap=/dev/null,infinite_rx=1", file),
+            None => "net_ring0".to_string(),
+        };
+
+        let mut dpdk_config = DpdkConfig::default()
+            .without_numa()
+            .with_vdev(&vdev)
+            .with_eal_arg("--no-pci")
+            .with_rx_timestamps(RxTimestampMode::Tsc);
+
+        // Синтетические ордера возвращаются из кольца на RX и отбрасываются
+        // классификатором, как чужой трафик в production
+        if self.pcap.is_none() {
+            dpdk_config = dpdk_config.with_rx_filter(FlowMatch::udp(FEED_IP, FEED_PORT));
+        }
+
+        dpdk_config.num_rx_queues = self.queues;
+        dpdk_config.num_tx_queues = self.queues;
+        // У виртуальных устройств нет RSS и offload контрольных сумм
+        dpdk_config.use_rss = false;
+        dpdk_config.use_hw_checksum = false;
+        if !check_hugepages_available() {
+            dpdk_config.use_huge_pages = false;
+            dpdk_config = dpdk_config.with_eal_arg("--no-huge");
+        }
+        dpdk_config
+    }
+
+    fn books(&self) -> BookSet {
+        (1..=self.instruments).fold(BookSet::new(None), |books, locate| {
+            books.with_instrument(
+                locate,
+                BookConfig::centered(MID_PRICE as i64, TICK as i64, 512, LIVE_ORDERS * 2),
+            )
+        })
+    }
+}
+
+/// Детерминированный синтетический поток ITCH 5.0 поверх MoldUDP64
+///
+/// Смесь сообщений похожа на фид акций: в основном добавления и удаления
+/// заявок вокруг середины окна, реже частичные отмены, исполнения и
+/// замены. Удаляются и исполняются только живые заявки, поэтому стаканы
+/// проходят рабочие, а не ошибочные ветки.
+pub struct SyntheticItchFeed {
+    rng: u64,
+    sequence: u64,
+    next_order_ref: u64,
+    next_match: u64,
+    /// Живые заявки: (order ref, stock locate, количество, покупка)
+    live: Vec<(u64, u16, u32, bool)>,
+    instruments: u16,
+}
+
+impl SyntheticItchFeed {
+    pub fn new(instruments: u16, seed: u64) -> Self {
+        Self {
+            rng: seed | 1,
+            sequence: 1,
+            next_order_ref: 1,
+            next_match: 1,
+            live: Vec::with_capacity(LIVE_ORDERS * 2),
+            instruments: instruments.max(1),
+        }
+    }
+
+    /// xorshift64*
+    #[inline]
+    fn next_u64(&mut self) -> u64 {
+        self.rng ^= self.rng >> 12;
+        self.rng ^= self.rng << 25;
+        self.rng ^= self.rng >> 27;
+        self.rng.wrapping_mul(0x2545_f491_4f6c_dd1d)
+    }
+
+    /// Записывает следующий пакет в `buf`, возвращает его длину
+    pub fn next_packet(&mut self, buf: &mut [u8; MAX_PACKET_LEN]) -> usize {
+        buf[0..10].copy_from_slice(b"HFEECTRAIN");
+        buf[10..18].copy_from_slice(&self.sequence.to_be_bytes());
+        buf[18..20].copy_from_slice(&(MESSAGES_PER_PACKET as u16).to_be_bytes());
+        self.sequence += MESSAGES_PER_PACKET as u64;
+
+        let timestamp = tsc() & 0xffff_ffff_ffff;
+        let mut pos = 20;
+        for _ in 0..MESSAGES_PER_PACKET {
+            let msg = &mut buf[pos + 2..];
+            let len = self.next_message(msg, timestamp);
+            buf[pos..pos + 2].copy_from_slice(&(len as u16).to_be_bytes());
+            pos += 2 + len;
+        }
+        pos
+    }
+
+    fn next_message(&mut self, msg: &mut [u8], timestamp: u64) -> usize {
+        let r = self.next_u64();
+        // Число живых заявок держится между LIVE_ORDERS / 2 и LIVE_ORDERS
+        let kind = if self.live.len() < LIVE_ORDERS / 2 {
+            0
+        } else if self.live.len() >= LIVE_ORDERS {
+            5 + r % 5
+        } else {
+            r % 10
+        };
+
+        if kind < 5 || self.live.is_empty() {
+            return self.add_order(msg, r, timestamp);
+        }
+
+        let index = (r >> 8) as usize % self.live.len();
+        let (order_ref, locate, shares, bid) = self.live[index];
+
+        let (msg_type, len) = match kind {
+            5 | 6 => {
+                self.live.swap_remove(index);
+                (OrderDelete::TYPE, OrderDelete::LEN)
+            }
+            7 => {
+                let cancelled = (shares / 2).max(1);
+                msg[19..23].copy_from_slice(&cancelled.to_be_bytes());
+                self.reduce(index, cancelled);
+                (OrderCancel::TYPE, OrderCancel::LEN)
+            }
+            8 => {
+                let executed = shares.min(100);
+                msg[19..23].copy_from_slice(&executed.to_be_bytes());
+                msg[23..31].copy_from_slice(&self.next_match.to_be_bytes());
+                self.next_match += 1;
+                self.reduce(index, executed);
+                (OrderExecuted::TYPE, OrderExecuted::LEN)
+            }
+            _ => {
+                let new_ref = self.next_order_ref;
+                self.next_order_ref += 1;
+                let new_shares = 100 * (1 + (r >> 20) as u32 % 10);
+                let price = self.price(bid, r >> 40);
+                msg[19..27].copy_from_slice(&new_ref.to_be_bytes());
+                msg[27..31].copy_from_slice(&new_shares.to_be_bytes());
+                msg[31..35].copy_from_slice(&price.to_be_bytes());
+                self.live[index] = (new_ref, locate, new_shares, bid);
+                (OrderReplace::TYPE, OrderReplace::LEN)
+            }
+        };
+
+        Self::header(msg, msg_type, locate, timestamp);
+        msg[11..19].copy_from_slice(&order_ref.to_be_bytes());
+        len
+    }
+
+    fn add_order(&mut self, msg: &mut [u8], r: u64, timestamp: u64) -> usize {
+        let locate = 1 + (r >> 16) as u16 % self.instruments;
+        let order_ref = self.next_order_ref;
+        self.next_order_ref += 1;
+
+        let bid = (r >> 32) % 2 == 0;
+        let shares = 100 * (1 + (r >> 24) as u32 % 10);
+
+        Self::header(msg, AddOrder::TYPE, locate, timestamp);
+        msg[11..19].copy_from_slice(&order_ref.to_be_bytes());
+        msg[19] = if bid { b'B' } else { b'S' };
+        msg[20..24].copy_from_slice(&shares.to_be_bytes());
+        msg[24..27].copy_from_slice(b"SYM");
+        put_decimal(&mut msg[27..32], locate as u64);
+        msg[32..36].copy_from_slice(&self.price(bid, r >> 40).to_be_bytes());
+
+        self.live.push((order_ref, locate, shares, bid));
+        AddOrder::LEN
+    }
+
+    /// Цена в пределах 32 шагов от середины на своей стороне книги
+    #[inline]
+    fn price(&self, bid: bool, r: u64) -> u32 {
+        let offset = TICK * (r % 32) as u32;
+        if bid {
+            MID_PRICE - TICK - offset
+        } else {
+            MID_PRICE + offset
+        }
+    }
+
+    fn reduce(&mut self, index: usize, shares: u32) {
+        let order = &mut self.live[index];
+        if order.2 <= shares {
+            self.live.swap_remove(index);
+        } else {
+            order.2 -= shares;
+        }
+    }
+
+    fn header(msg: &mut [u8], msg_type: u8, locate: u16, timestamp: u64) {
+        msg[0] = msg_type;
+        msg[1..3].copy_from_slice(&locate.to_be_bytes());
+        msg[3..5].copy_from_slice(&0u16.to_be_bytes());
+        msg[5..11].copy_from_slice(&timestamp.to_be_bytes()[2..]);
+    }
+}
+
+/// Получатель обновлений стаканов: читает вершину книги, как стратегия
+#[derive(Clone, Default)]
+struct TrainingListener {
+    updates: u64,
+    spread_sum: i64,
+}
+
+impl BookListener for TrainingListener {
+    fn on_books_updated(&mut self, books: &BookSet, changed: &[u16]) {
+        for &key in changed {
+            if let Some(book) = books.book(key) {
+                if let (Some((bid, _)), Some((ask, _))) = (book.best_bid(), book.best_ask()) {
+                    self.spread_sum += ask - bid;
+                }
+                self.updates += 1;
+            }
+        }
+    }
+}
+
+/// Генератор одной очереди: пакеты фида с постоянным темпом и ордера
+/// через кодирование на месте
+fn run_generator(
+    mut feed_tx: Option<TxSession>,
+    mut order_tx: TxSession,
+    mut risk: RiskEngine,
+    mut feed: SyntheticItchFeed,
+    rate_pps: u64,
+    running: Arc<AtomicBool>,
+) {
+    let ouch = match OuchTemplate::enter_order(&OuchOrderParams {
+        stock: "SYM00001".to_string(),
+        firm: "HFEC".to_string(),
+        time_in_force: TIF_IOC,
+        display: b'Y',
+        capacity: b'P',
+        token_prefix: "T".to_string(),
+    }) {
+        Ok(template) => template,
+        Err(e) => {
+            eprintln!("Training order template: {}", e);
+            return;
+        }
+    };
+
+    let interval = if rate_pps == 0 {
+        0
+    } else {
+        tsc_hz() * TX_BATCH as u64 / rate_pps.max(1)
+    };
+
+    let mut packets = vec![[0u8; MAX_PACKET_LEN]; TX_BATCH];
+    let mut lens = [0usize; TX_BATCH];
+    let mut sent_packets = 0u64;
+    let mut token = 1u64;
+    let mut deadline = tsc();
+
+    while running.load(Ordering::Relaxed) {
+        // Doorbell накопленного фида и освобождение TX колец, в том числе
+        // во время ожидания следующей пачки
+        let now = tsc();
+        if let Some(session) = feed_tx.as_mut() {
+            session.poll(now);
+        }
+        order_tx.poll(now);
+
+        if interval != 0 {
+            if now < deadline {
+                std::hint::spin_loop();
+                continue;
+            }
+            deadline += interval;
+        }
+
+        if let Some(session) = feed_tx.as_mut() {
+            for (packet, len) in packets.iter_mut().zip(lens.iter_mut()) {
+                *len = feed.next_packet(packet);
+            }
+            let payloads: [&[u8]; TX_BATCH] = std::array::from_fn(|i| &packets[i][..lens[i]]);
+            // Фид не срочен: пакеты уходят общим doorbell сессии
+            session.send_bulk(&payloads);
+        }
+
+        sent_packets += TX_BATCH as u64;
+        if sent_packets % PACKETS_PER_ORDER < TX_BATCH as u64 {
+            let order = OuchOrder {
+                token,
+                side: if token % 2 == 0 { Side::Bid } else { Side::Ask },
+                shares: 100,
+                price: MID_PRICE,
+            };
+            token += 1;
+            // Ответов биржи нет: IOC остаток снимается сразу после отправки
+            if let Ok(true) = risk.send_in_place(&mut order_tx, ORDER_INSTRUMENT, &order, |buf| {
+                ouch.encode(buf, &order)
+            }) {
+                risk.on_done(ORDER_INSTRUMENT, order.side, order.shares);
+            }
+        }
+    }
+
+    if let Some(session) = feed_tx.as_mut() {
+        session.flush();
+    }
+    order_tx.flush();
+}
+
+/// Выводит счетчики и время проверок риска генераторов
+fn print_risk(counters: &[Arc<RiskCounters>]) {
+    let hz = tsc_hz();
+    for (queue_id, risk) in counters.iter().enumerate() {
+        let latency = risk.check_latency.snapshot().to_ns(hz);
+        println!(
+            "  Risk queue {}: accepted {}, rejected {}, check ns: p50 {}, p99 {}, p99.9 {}, max {}",
+            queue_id,
+            risk.accepted.get(),
+            risk.rejected.get(),
+            latency.p50,
+            latency.p99,
+            latency.p999,
+            latency.max
+        );
+    }
+}
+
+/// Выполняет обучающий прогон и выводит телеметрию
+pub fn run(config: &TrainingConfig) -> Result<(), String> {
+    println!(
+        "Training workload: {}, {} s, {} pps, {} queues, {} instruments",
+        config.pcap.as_deref().unwrap_or("synthetic ITCH feed"),
+        config.seconds,
+        config.rate_pps,
+        config.queues,
+        config.instruments
+    );
+
+    let dpdk_config = config.dpdk_config();
+
+    let mut manager = NumaManager::new()?;
+    manager.init_nodes()?;
+    manager.init_eal(&dpdk_config)?;
+    manager.distribute_interfaces(&dpdk_config)?;
+    manager.init_dpdk(&dpdk_config)?;
+
+    let handler = ItchBookHandler::new(config.books(), TrainingListener::default());
+    manager.start_packet_processing(handler, &dpdk_config)?;
+
+    let running = Arc::new(AtomicBool::new(true));
+    let mut generators = Vec::new();
+    let mut risk_counters = Vec::new();
+    let per_queue_rate = config.rate_pps / config.queues as u64;
+
+    for queue_id in 0..config.queues {
+        let session = |dst_port| TxSessionConfig {
+            port_id: 0,
+            queue_id,
+            dst_mac: [0xff; 6],
+            src_ip: Ipv4Addr::new(10, 0, 0, 1),
+            dst_ip: if dst_port == FEED_PORT {
+                FEED_IP
+            } else {
+                Ipv4Addr::new(10, 0, 0, 2)
+            },
+            src_port: 31000 + queue_id,
+            dst_port,
+            protocol: TxProtocol::Udp,
+        };
+
+        // При воспроизведении записи фид приходит из pcap, генерируются только
+        // ордера; фид идет через ту же TX очередь генератора
+        let order_tx = manager.create_tx_session(&session(ORDER_PORT), &dpdk_config)?;
+        let feed_tx = match config.pcap {
+            Some(_) => None,
+            None => Some(order_tx.sibling(&session(FEED_PORT), &dpdk_config)?),
+        };
+        let feed = SyntheticItchFeed::new(config.instruments, 0x9e37_79b9 + queue_id as u64);
+
+        let (mut risk_control, risk) = risk::channel(&RiskConfig {
+            instruments: config.instruments as usize + 1,
+            max_orders_per_sec: 0,
+            burst: 0,
+        });
+        risk_control.set_limits(
+            ORDER_INSTRUMENT,
+            &RiskLimits {
+                max_order_qty: 1_000,
+                min_price: MID_PRICE / 2,
+                max_price: MID_PRICE * 2,
+                max_notional: MID_PRICE as u64 * 1_000,
+                max_position: 10_000,
+                max_orders_per_sec: u32::MAX,
+                burst: 1_000,
+            },
+        )?;
+        risk_counters.push(risk.counters());
+
+        let running = running.clone();
+        generators.push(thread::spawn(move || {
+            run_generator(feed_tx, order_tx, risk, feed, per_queue_rate, running)
+        }));
+    }
+
+    for _ in 0..config.seconds {
+        thread::sleep(Duration::from_secs(1));
+    }
+
+    running.store(false, Ordering::Relaxed);
+    for generator in generators {
+        let _ = generator.join();
+    }
+
+    // Даем worker дочитать кольца до остановки
+    thread::sleep(Duration::from_millis(100));
+    manager.print_telemetry();
+    print_risk(&risk_counters);
+    manager.stop_packet_processing();
+
+    println!("Training workload finished");
+    Ok(())
+}
@@ -0,0 +1,4 @@
+pub mod queue;
+pub mod risk;
+pub mod session;
+pub mod tcp;
@@ -0,0 +1,97 @@
+// src/tx/queue.rs
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+
+/// Номер очереди в `TxSessionConfig`, при котором менеджер сам выбирает
+/// первую свободную TX очередь порта
+pub const TX_QUEUE_AUTO: u16 = u16::MAX;
+
+/// Владельцы рабочих TX очередей порта
+///
+/// `rte_eth_tx_burst` не потокобезопасен для одной очереди, а блокировка
+/// вокруг общей очереди съедает выигрыш от обхода ядра. Поэтому каждая
+/// очередь принадлежит ровно одной сессии (и одному ядру); служебная
+/// очередь IGMP в таблицу не входит.
+#[derive(Debug)]
+pub struct TxQueueTable {
+    port_id: u16,
+    claimed: Box<[AtomicBool]>,
+}
+
+impl TxQueueTable {
+    pub fn new(port_id: u16, num_tx_queues: u16) -> Arc<Self> {
+        Arc::new(Self {
+            port_id,
+            claimed: (0..num_tx_queues).map(|_| AtomicBool::new(false)).collect(),
+        })
+    }
+
+    /// Закрепляет очередь `queue_id`; ошибка, если она уже занята
+    pub fn claim(self: &Arc<Self>, queue_id: u16) -> Result<TxQueueClaim, String> {
+        let flag = self.claimed.get(queue_id as usize).ok_or_else(|| {
+            format!(
+                "TX queue {} out of range for port {} ({} queues)",
+                queue_id,
+                self.port_id,
+                self.claimed.len()
+            )
+        })?;
+
+        if flag.swap(true, Ordering::AcqRel) {
+            return Err(format!(
+                "TX queue {} of port {} is already owned by another session",
+                queue_id, self.port_id
+            ));
+        }
+
+        Ok(TxQueueClaim {
+            table: self.clone(),
+            queue_id,
+        })
+    }
+
+    /// Закрепляет первую свободную очередь
+    pub fn claim_free(self: &Arc<Self>) -> Result<TxQueueClaim, String> {
+        for queue_id in 0..self.claimed.len() as u16 {
+            if let Ok(claim) = self.claim(queue_id) {
+                return Ok(claim);
+            }
+        }
+        Err(format!(
+            "No free TX queue on port {} ({} queues, all owned)",
+            self.port_id,
+            self.claimed.len()
+        ))
+    }
+
+    /// Количество свободных очередей
+    pub fn free_queues(&self) -> usize {
+        self.claimed
+            .iter()
+            .filter(|flag| !flag.load(Ordering::Acquire))
+            .count()
+    }
+}
+
+/// Право единственного владельца на TX очередь, освобождается при уничтожении
+#[derive(Debug)]
+pub struct TxQueueClaim {
+    table: Arc<TxQueueTable>,
+    queue_id: u16,
+}
+
+impl TxQueueClaim {
+    pub fn port_id(&self) -> u16 {
+        self.table.port_id
+    }
+
+    pub fn queue_id(&self) -> u16 {
+        self.queue_id
+    }
+}
+
+impl Drop for TxQueueClaim {
+    fn drop(&mut self) {
+        self.table.claimed[self.queue_id as usize].store(false, Ordering::Release);
+    }
+}
@@ -0,0 +1,580 @@
+// src/tx/risk.rs
+use std::cell::UnsafeCell;
+use std::sync::atomic::{fence, AtomicBool, AtomicU64, Ordering};
+use std::sync::Arc;
+
+use crate::book::orders::Side;
+use crate::packet::timestamp::{tsc, tsc_hz};
+use crate::protocols::fix::{FixOrder, FixTemplate, FixTimestamp};
+use crate::protocols::ouch::OuchOrder;
+use crate::telemetry::latency::LatencyHistogram;
+use crate::telemetry::worker::Counter;
+use crate::tx::session::TxSession;
+use crate::tx::tcp::TcpSession;
+
+/// Сколько раз проверка перечитывает лимиты, которые пишет управляющая
+/// сторона, прежде чем отклонить ордер
+const READ_ATTEMPTS: usize = 2;
+
+/// Количество причин отказа (бит `RiskReject`)
+pub const RISK_REASONS: usize = 9;
+
+/// Знаков после запятой в ценах лимитов и `RiskOrder` (как в OUCH/ITCH)
+pub const RISK_PRICE_DECIMALS: usize = 4;
+
+/// Лимиты инструмента
+///
+/// Цены и notional в единицах цены OUCH/ITCH (4 знака после запятой).
+/// Нулевые лимиты (`Default`) запрещают торговлю инструментом.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct RiskLimits {
+    /// Максимальное количество в одном ордере (fat finger)
+    pub max_order_qty: u32,
+    /// Допустимый диапазон цены ордера (fat finger)
+    pub min_price: u32,
+    pub max_price: u32,
+    /// Максимальный notional одного ордера: цена * количество
+    pub max_notional: u64,
+    /// Максимальная абсолютная позиция с учетом рабочих ордеров
+    pub max_position: i64,
+    /// Частота ордеров по инструменту и допустимая пачка сверх нее;
+    /// 0 запрещает инструмент, как и нулевой `max_order_qty`
+    pub max_orders_per_sec: u32,
+    pub burst: u32,
+}
+
+/// Лимиты в виде, удобном для проверки: частоты переведены в такты
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+struct SlotLimits {
+    max_order_qty: u64,
+    min_price: u64,
+    max_price: u64,
+    max_notional: u64,
+    max_position: i64,
+    /// Интервал GCRA между ордерами и допуск пачки, такты TSC
+    interval_cycles: u64,
+    burst_cycles: u64,
+}
+
+/// Лимиты одного инструмента под seqlock
+///
+/// `seq` нечетный, пока управляющая сторона пишет лимиты. Писатель один
+/// (`RiskControl`), читатель - ядро отправки ордеров; читатель никогда не
+/// ждет писателя дольше `READ_ATTEMPTS` чтений.
+#[repr(C, align(64))]
+struct LimitSlot {
+    seq: AtomicU64,
+    limits: UnsafeCell<SlotLimits>,
+}
+
+const _: () = assert!(std::mem::size_of::<LimitSlot>() == 64);
+
+impl LimitSlot {
+    #[inline(always)]
+    fn read(&self) -> Option<SlotLimits> {
+        for _ in 0..READ_ATTEMPTS {
+            let seq = self.seq.load(Ordering::Acquire);
+            let limits = unsafe { std::ptr::read_volatile(self.limits.get()) };
+            fence(Ordering::Acquire);
+            if seq & 1 == 0 && self.seq.load(Ordering::Relaxed) == seq {
+                return Some(limits);
+            }
+        }
+        None
+    }
+
+    fn write(&self, limits: SlotLimits) {
+        let seq = self.seq.load(Ordering::Relaxed);
+        self.seq.store(seq + 1, Ordering::Relaxed);
+        fence(Ordering::Release);
+        unsafe { std::ptr::write_volatile(self.limits.get(), limits) };
+        self.seq.store(seq + 2, Ordering::Release);
+    }
+}
+
+/// Лимиты всех инструментов одного ядра отправки
+struct LimitTable {
+    slots: Box<[LimitSlot]>,
+    /// Запрет всех новых ордеров (kill switch)
+    halted: AtomicBool,
+}
+
+unsafe impl Sync for LimitTable {}
+unsafe impl Send for LimitTable {}
+
+/// Параметры проверок ядра отправки
+#[derive(Debug, Clone, Copy)]
+pub struct RiskConfig {
+    /// Размер массивов лимитов и позиций; индекс - номер инструмента
+    /// (как stock locate в `BookSet`)
+    pub instruments: usize,
+    /// Частота ордеров ядра по всем инструментам и допустимая пачка;
+    /// 0 - без ограничения
+    pub max_orders_per_sec: u32,
+    pub burst: u32,
+}
+
+impl Default for RiskConfig {
+    fn default() -> Self {
+        Self {
+            instruments: 1024,
+            max_orders_per_sec: 10_000,
+            burst: 100,
+        }
+    }
+}
+
+/// Ордер в виде, не зависящем от протокола биржи: все проверки идут по
+/// нему, поэтому ни один протокол не обходит их
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct RiskOrder {
+    pub instrument: u16,
+    pub side: Side,
+    pub qty: u64,
+    /// Цена в единицах лимитов (`RISK_PRICE_DECIMALS` знаков); цена, которую
+    /// нельзя выразить точно (отрицательная, лишние знаки), - `u64::MAX`,
+    /// и ордер не проходит ценовой коридор
+    pub price: u64,
+}
+
+impl RiskOrder {
+    /// Ордер OUCH: цена уже в единицах лимитов
+    #[inline(always)]
+    pub fn from_ouch(instrument: u16, order: &OuchOrder) -> Self {
+        Self {
+            instrument,
+            side: order.side,
+            qty: order.shares as u64,
+            price: order.price as u64,
+        }
+    }
+
+    /// Ордер FIX с ценой в единицах 10^-`price_decimals`
+    #[inline(always)]
+    pub fn from_fix(instrument: u16, order: &FixOrder, price_decimals: usize) -> Self {
+        let price = match u64::try_from(order.price) {
+            Ok(price) if price_decimals >= RISK_PRICE_DECIMALS => {
+                match 10u64.checked_pow((price_decimals - RISK_PRICE_DECIMALS) as u32) {
+                    Some(scale) if price % scale == 0 => price / scale,
+                    _ => u64::MAX,
+                }
+            }
+            Ok(price) => 10u64
+                .checked_pow((RISK_PRICE_DECIMALS - price_decimals) as u32)
+                .and_then(|scale| price.checked_mul(scale))
+                .unwrap_or(u64::MAX),
+            Err(_) => u64::MAX,
+        };
+
+        Self {
+            instrument,
+            side: order.side,
+            qty: order.qty,
+            price,
+        }
+    }
+}
+
+/// Причины отказа; у отклоненного ордера может быть несколько
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct RiskReject(pub u32);
+
+impl RiskReject {
+    pub const ORDER_QTY: u32 = 1 << 0;
+    pub const PRICE_BAND: u32 = 1 << 1;
+    pub const NOTIONAL: u32 = 1 << 2;
+    pub const POSITION: u32 = 1 << 3;
+    pub const INSTRUMENT_RATE: u32 = 1 << 4;
+    pub const SESSION_RATE: u32 = 1 << 5;
+    pub const HALTED: u32 = 1 << 6;
+    /// Номер инструмента вне массива лимитов
+    pub const UNKNOWN_INSTRUMENT: u32 = 1 << 7;
+    /// Лимиты инструмента переписывались во время всех попыток чтения
+    pub const LIMITS_BUSY: u32 = 1 << 8;
+
+    pub fn has(&self, reason: u32) -> bool {
+        self.0 & reason != 0
+    }
+}
+
+/// Создает таблицу лимитов ядра отправки: управляющая сторона и проверки
+pub fn channel(config: &RiskConfig) -> (RiskControl, RiskEngine) {
+    let table = Arc::new(LimitTable {
+        slots: (0..config.instruments)
+            .map(|_| LimitSlot {
+                seq: AtomicU64::new(0),
+                limits: UnsafeCell::new(SlotLimits::default()),
+            })
+            .collect(),
+        halted: AtomicBool::new(false),
+    });
+
+    let hz = tsc_hz();
+    let (interval_cycles, burst_cycles) = gcra(hz, config.max_orders_per_sec, config.burst);
+    let counters = Arc::new(RiskCounters::default());
+
+    let control = RiskControl {
+        table: table.clone(),
+        hz,
+    };
+    let engine = RiskEngine {
+        table,
+        state: vec![InstrumentState::default(); config.instruments].into_boxed_slice(),
+        session_tat: 0,
+        session_interval: interval_cycles,
+        session_burst: burst_cycles,
+        counters,
+    };
+    (control, engine)
+}
+
+/// Интервал и допуск пачки GCRA в тактах для частоты `per_sec`;
+/// нулевая частота не ограничивает
+fn gcra(hz: u64, per_sec: u32, burst: u32) -> (u64, u64) {
+    if per_sec == 0 {
+        return (0, u64::MAX);
+    }
+    let interval = (hz / per_sec as u64).max(1);
+    (interval, interval.saturating_mul(burst as u64))
+}
+
+/// Управляющая сторона: единственный писатель лимитов ядра
+pub struct RiskControl {
+    table: Arc<LimitTable>,
+    hz: u64,
+}
+
+impl RiskControl {
+    /// Публикует лимиты инструмента; ядро отправки применяет их со
+    /// следующего ордера
+    pub fn set_limits(&mut self, instrument: u16, limits: &RiskLimits) -> Result<(), String> {
+        let slot = self
+            .table
+            .slots
+            .get(instrument as usize)
+            .ok_or_else(|| format!("Instrument {} out of risk table range", instrument))?;
+        if limits.min_price > limits.max_price {
+            return Err(format!(
+                "Instrument {}: min price {} above max price {}",
+                instrument, limits.min_price, limits.max_price
+            ));
+        }
+        if limits.max_position < 0 {
+            return Err(format!(
+                "Instrument {}: negative position limit",
+                instrument
+            ));
+        }
+
+        let (interval_cycles, burst_cycles) =
+            gcra(self.hz, limits.max_orders_per_sec, limits.burst);
+        let max_order_qty = match limits.max_orders_per_sec {
+            0 => 0,
+            _ => limits.max_order_qty as u64,
+        };
+        slot.write(SlotLimits {
+            max_order_qty,
+            min_price: limits.min_price as u64,
+            max_price: limits.max_price as u64,
+            max_notional: limits.max_notional,
+            max_position: limits.max_position,
+            interval_cycles,
+            burst_cycles,
+        });
+        Ok(())
+    }
+
+    /// Запрещает инструмент: следующие ордера по нему отклоняются
+    pub fn block(&mut self, instrument: u16) -> Result<(), String> {
+        self.set_limits(instrument, &RiskLimits::default())
+    }
+
+    /// Запрещает все новые ордера ядра
+    pub fn halt(&mut self) {
+        self.table.halted.store(true, Ordering::Release);
+    }
+
+    pub fn resume(&mut self) {
+        self.table.halted.store(false, Ordering::Release);
+    }
+
+    pub fn is_halted(&self) -> bool {
+        self.table.halted.load(Ordering::Acquire)
+    }
+}
+
+/// Позиция и экспозиция инструмента, которые ведет ядро отправки
+#[derive(Debug, Clone, Copy, Default)]
+struct InstrumentState {
+    /// Исполненная позиция (покупка +, продажа -)
+    position: i64,
+    /// Неисполненный остаток отправленных ордеров по сторонам
+    open_buy: i64,
+    open_sell: i64,
+    /// Теоретическое время прихода следующего ордера (GCRA), TSC
+    tat: u64,
+}
+
+/// Счетчики проверок для чтения из других потоков
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct RiskCounters {
+    pub accepted: Counter,
+    pub rejected: Counter,
+    /// Отказы по причинам, индекс - номер бита `RiskReject`
+    pub reasons: [Counter; RISK_REASONS],
+    /// Время проверки ордера, такты TSC
+    pub check_latency: LatencyHistogram,
+}
+
+/// Проверки ордеров перед отправкой, принадлежат ядру отправки
+///
+/// Все проверки ордера вычисляются без досрочного выхода и собираются в
+/// маску причин, поэтому время проверки не зависит от того, какой лимит
+/// нарушен: одно чтение лимитов под seqlock, несколько сравнений и одна
+/// ветка по маске. Массивы позиций плоские по номеру инструмента; их
+/// стоит создавать в потоке ядра (или под `ArenaScope` его узла).
+pub struct RiskEngine {
+    table: Arc<LimitTable>,
+    state: Box<[InstrumentState]>,
+    session_tat: u64,
+    session_interval: u64,
+    session_burst: u64,
+    counters: Arc<RiskCounters>,
+}
+
+impl RiskEngine {
+    /// Проверяет ордер и при одобрении учитывает его в экспозиции и лимитах
+    /// частоты
+    #[inline]
+    pub fn check(&mut self, order: &RiskOrder) -> Result<(), RiskReject> {
+        let start = tsc();
+        let result = self.evaluate(order, start);
+        self.counters
+            .check_latency
+            .record(tsc().wrapping_sub(start));
+
+        match result {
+            0 => {
+                self.counters.accepted.inc();
+                Ok(())
+            }
+            mask => {
+                self.reject(mask);
+                Err(RiskReject(mask))
+            }
+        }
+    }
+
+    /// Проверяет ордер и при одобрении кодирует его прямо в mbuf сессии
+    ///
+    /// Ok(false) - ордер одобрен, но не отправлен (нет mbuf или `encode`
+    /// отменил отправку); его экспозиция снимается сразу.
+    #[inline]
+    pub fn send_in_place<F>(
+        &mut self,
+        tx: &mut TxSession,
+        instrument: u16,
+        order: &OuchOrder,
+        encode: F,
+    ) -> Result<bool, RiskReject>
+    where
+        F: FnOnce(&mut [u8]) -> Option<usize>,
+    {
+        let order = RiskOrder::from_ouch(instrument, order);
+        self.send_checked(&order, || tx.send_in_place(encode))
+    }
+
+    /// Проверяет ордер и при одобрении кодирует его прямо в буфер отправки
+    /// TCP сессии (`TcpSession::send_with`)
+    ///
+    /// Ok(false) - ордер одобрен, но не принят сессией (нет соединения,
+    /// места в буфере или `encode` отменил отправку).
+    #[inline]
+    pub fn send_tcp_with<F>(
+        &mut self,
+        tcp: &mut TcpSession,
+        instrument: u16,
+        order: &OuchOrder,
+        max_len: usize,
+        encode: F,
+        now: u64,
+    ) -> Result<bool, RiskReject>
+    where
+        F: FnOnce(&mut [u8]) -> Option<usize>,
+    {
+        let order = RiskOrder::from_ouch(instrument, order);
+        self.send_checked(&order, || tcp.send_with(max_len, encode, now) > 0)
+    }
+
+    /// Проверяет ордер FIX и при одобрении собирает сообщение `template`
+    /// прямо в mbuf сессии
+    ///
+    /// Сообщения, не открывающие ордер (OrderCancelRequest), не добавляют
+    /// экспозиции и отправляются без проверок.
+    #[inline]
+    pub fn send_fix_in_place(
+        &mut self,
+        tx: &mut TxSession,
+        instrument: u16,
+        template: &FixTemplate,
+        seq_num: u64,
+        time: &FixTimestamp,
+        order: &FixOrder,
+    ) -> Result<bool, RiskReject> {
+        let encode = |buf: &mut [u8]| template.encode(buf, seq_num, time, order);
+        if !template.is_new_order() {
+            return Ok(tx.send_in_place(encode));
+        }
+
+        let order = RiskOrder::from_fix(instrument, order, template.widths().price_decimals);
+        self.send_checked(&order, || tx.send_in_place(encode))
+    }
+
+    /// Проверяет ордер FIX и при одобрении собирает сообщение `template`
+    /// прямо в буфер отправки TCP сессии, как `send_fix_in_place`
+    #[inline]
+    pub fn send_fix_tcp(
+        &mut self,
+        tcp: &mut TcpSession,
+        instrument: u16,
+        template: &FixTemplate,
+        seq_num: u64,
+        time: &FixTimestamp,
+        order: &FixOrder,
+        now: u64,
+    ) -> Result<bool, RiskReject> {
+        let max_len = template.len();
+        let encode = |buf: &mut [u8]| template.encode(buf, seq_num, time, order);
+        if !template.is_new_order() {
+            return Ok(tcp.send_with(max_len, encode, now) > 0);
+        }
+
+        let order = RiskOrder::from_fix(instrument, order, template.widths().price_decimals);
+        self.send_checked(&order, || tcp.send_with(max_len, encode, now) > 0)
+    }
+
+    /// Проверяет ордер и при одобрении отправляет его через `send`
+    ///
+    /// `send` возвращает, ушел ли ордер; экспозиция неотправленного ордера
+    /// снимается сразу. Все пути отправки ордеров должны идти через эту
+    /// проверку.
+    #[inline]
+    pub fn send_checked<S>(&mut self, order: &RiskOrder, send: S) -> Result<bool, RiskReject>
+    where
+        S: FnOnce() -> bool,
+    {
+        self.check(order)?;
+
+        let sent = send();
+        if !sent {
+            // Одобренное количество не больше `max_order_qty` (u32)
+            self.on_done(order.instrument, order.side, order.qty as u32);
+        }
+        Ok(sent)
+    }
+
+    #[inline(always)]
+    fn evaluate(&mut self, order: &RiskOrder, now: u64) -> u32 {
+        let index = order.instrument as usize;
+        let (Some(slot), Some(state)) = (self.table.slots.get(index), self.state.get(index)) else {
+            return RiskReject::UNKNOWN_INSTRUMENT;
+        };
+        let Some(limits) = slot.read() else {
+            return RiskReject::LIMITS_BUSY;
+        };
+
+        let qty = order.qty;
+        let price = order.price;
+        let buy = order.side == Side::Bid;
+
+        // Худшая позиция, если исполнятся все ордера этой стороны и новый
+        // Количество больше u32 отклоняется по ORDER_QTY; ограничение только
+        // защищает сумму от переполнения
+        let exposure = qty.min(1 << 32) as i64;
+        let projected = if buy {
+            state.position + state.open_buy + exposure
+        } else {
+            state.position - state.open_sell - exposure
+        };
+
+        let session_tat = self.session_tat.max(now);
+        let tat = state.tat.max(now);
+
+        let mut mask = 0;
+        mask |= (qty > limits.max_order_qty || qty == 0) as u32 * RiskReject::ORDER_QTY;
+        mask |=
+            (price < limits.min_price || price > limits.max_price) as u32 * RiskReject::PRICE_BAND;
+        mask |= (price.saturating_mul(qty) > limits.max_notional) as u32 * RiskReject::NOTIONAL;
+        mask |=
+            (projected.unsigned_abs() > limits.max_position as u64) as u32 * RiskReject::POSITION;
+        mask |= (tat - now > limits.burst_cycles) as u32 * RiskReject::INSTRUMENT_RATE;
+        mask |= (session_tat - now > self.session_burst) as u32 * RiskReject::SESSION_RATE;
+        mask |= self.table.halted.load(Ordering::Relaxed) as u32 * RiskReject::HALTED;
+
+        if mask == 0 {
+            let state = &mut self.state[index];
+            state.tat = tat.saturating_add(limits.interval_cycles);
+            if buy {
+                state.open_buy += exposure;
+            } else {
+                state.open_sell += exposure;
+            }
+            self.session_tat = session_tat.saturating_add(self.session_interval);
+        }
+        mask
+    }
+
+    #[cold]
+    fn reject(&mut self, mask: u32) {
+        self.counters.rejected.inc();
+        for (bit, counter) in self.counters.reasons.iter().enumerate() {
+            if mask & (1 << bit) != 0 {
+                counter.inc();
+            }
+        }
+    }
+
+    /// Учитывает исполнение `shares` ордера стороны `side`
+    #[inline]
+    pub fn on_fill(&mut self, instrument: u16, side: Side, shares: u32) {
+        if let Some(state) = self.state.get_mut(instrument as usize) {
+            let qty = shares as i64;
+            match side {
+                Side::Bid => {
+                    state.open_buy = (state.open_buy - qty).max(0);
+                    state.position += qty;
+                }
+                Side::Ask => {
+                    state.open_sell = (state.open_sell - qty).max(0);
+                    state.position -= qty;
+                }
+            }
+        }
+    }
+
+    /// Снимает неисполненный остаток `shares` (отмена, IOC, отказ биржи)
+    #[inline]
+    pub fn on_done(&mut self, instrument: u16, side: Side, shares: u32) {
+        if let Some(state) = self.state.get_mut(instrument as usize) {
+            let open = match side {
+                Side::Bid => &mut state.open_buy,
+                Side::Ask => &mut state.open_sell,
+            };
+            *open = (*open - shares as i64).max(0);
+        }
+    }
+
+    /// Исполненная позиция по инструменту
+    pub fn position(&self, instrument: u16) -> i64 {
+        self.state
+            .get(instrument as usize)
+            .map_or(0, |state| state.position)
+    }
+
+    /// Счетчики проверок для чтения из других потоков
+    pub fn counters(&self) -> Arc<RiskCounters> {
+        self.counters.clone()
+    }
+}
@@ -0,0 +1,748 @@
+// src/tx/session.rs
+use std::net::Ipv4Addr;
+use std::os::raw::c_int;
+use std::sync::Arc;
+
+use crate::dpdk::config::{DpdkConfig, MAX_BURST_SIZE};
+use crate::dpdk::ffi::{self, RteEtherAddr, RteMbuf, RteMempool};
+use crate::packet::timestamp::{tsc, tsc_hz};
+use crate::telemetry::worker::TxCounters;
+use crate::tx::queue::TxQueueClaim;
+use crate::tx::tcp::TcpSegment;
+
+/// Максимальный размер заголовков в шаблоне, должен совпадать с DPDK_TX_HDR_MAX
+pub const TX_HDR_MAX: usize = 96;
+
+/// Размер headroom mbuf (RTE_PKTMBUF_HEADROOM в сборке DPDK по умолчанию)
+const MBUF_HEADROOM: usize = 128;
+
+/// Заранее сериализованные заголовки Ethernet/IPv4/L4 сессии
+///
+/// Раскладка совпадает с `struct dpdk_tx_template` в src/native/dpdk.c,
+/// шаблон строится один раз через `dpdk_tx_template_init`.
+#[repr(C, align(64))]
+pub struct HeaderTemplate {
+    pub hdr: [u8; TX_HDR_MAX],
+    pub hdr_len: u16,
+    pub l2_len: u8,
+    pub l3_len: u8,
+    pub l4_len: u8,
+    pub ip_proto: u8,
+    pub hw_cksum: u8,
+    pub _reserved: u8,
+    pub phdr_sum: u32,
+    pub ol_flags: u64,
+}
+
+impl HeaderTemplate {
+    fn zeroed() -> Self {
+        Self {
+            hdr: [0; TX_HDR_MAX],
+            hdr_len: 0,
+            l2_len: 0,
+            l3_len: 0,
+            l4_len: 0,
+            ip_proto: 0,
+            hw_cksum: 0,
+            _reserved: 0,
+            phdr_sum: 0,
+            ol_flags: 0,
+        }
+    }
+
+    /// Возвращает сериализованные заголовки
+    pub fn header_bytes(&self) -> &[u8] {
+        &self.hdr[..self.hdr_len as usize]
+    }
+}
+
+// Раскладка должна совпадать с C-структурой: 96 байт заголовков + метаданные
+const _: () = assert!(std::mem::size_of::<HeaderTemplate>() == 128);
+
+/// Транспортный протокол TX сессии
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum TxProtocol {
+    Udp,
+    Tcp,
+}
+
+/// Что делать с пакетами, которые TX очередь не приняла после всех попыток
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum TxDrainPolicy {
+    /// Освободить сразу: устаревший ордер хуже потерянного
+    Drop,
+    /// Сохранить в backlog сессии и отправить первыми при следующем вызове
+    Backlog,
+}
+
+/// Политика повторной отправки
+#[derive(Debug, Clone, Copy)]
+pub struct TxPolicy {
+    /// Количество повторов rte_eth_tx_burst при заполненной очереди
+    pub max_retries: u32,
+    pub drain: TxDrainPolicy,
+}
+
+impl Default for TxPolicy {
+    fn default() -> Self {
+        Self {
+            max_retries: 8,
+            drain: TxDrainPolicy::Backlog,
+        }
+    }
+}
+
+/// Объединение bulk трафика в общие doorbell и освобождение TX кольца
+///
+/// Каждый вызов `rte_eth_tx_burst` - это запись в doorbell регистр NIC
+/// через PCIe. Срочные ордера платят за нее сразу, а heartbeat и
+/// служебные сообщения (`TxSession::send_bulk`) копятся и уходят пачкой.
+#[derive(Debug, Clone, Copy)]
+pub struct TxBatching {
+    /// Сколько bulk пакетов накапливается до doorbell (1..=MAX_BURST_SIZE)
+    pub doorbell_batch: usize,
+    /// Сколько bulk пакет может ждать doorbell, мкс (проверяет `poll`)
+    pub max_delay_us: u64,
+    /// Период `rte_eth_tx_done_cleanup` на очереди сессии, мкс; 0 - не вызывать
+    pub reclaim_interval_us: u64,
+}
+
+impl Default for TxBatching {
+    fn default() -> Self {
+        Self {
+            doorbell_batch: 16,
+            max_delay_us: 50,
+            reclaim_interval_us: 100,
+        }
+    }
+}
+
+/// Адресация TX сессии; MAC получателя должен быть уже разрешен
+///
+/// `queue_id` - рабочая TX очередь порта, которой сессия владеет
+/// единолично; `TX_QUEUE_AUTO` поручает выбор свободной очереди менеджеру.
+#[derive(Debug, Clone)]
+pub struct TxSessionConfig {
+    pub port_id: u16,
+    pub queue_id: u16,
+    pub dst_mac: [u8; 6],
+    pub src_ip: Ipv4Addr,
+    pub dst_ip: Ipv4Addr,
+    pub src_port: u16,
+    pub dst_port: u16,
+    pub protocol: TxProtocol,
+}
+
+/// Снимок счетчиков TX сессии
+#[derive(Debug, Default, Clone, Copy)]
+pub struct TxStats {
+    pub sent: u64,
+    pub dropped: u64,
+    pub alloc_failures: u64,
+    pub oversized: u64,
+    pub doorbells: u64,
+    pub reclaimed: u64,
+}
+
+/// Исходящая сессия: шаблон заголовков, пул и собственная TX очередь
+///
+/// Сессия принадлежит одному потоку и не выполняет выделений памяти
+/// при отправке: заголовки копируются из шаблона, mbuf берутся из пула
+/// порта одним вызовом `rte_pktmbuf_alloc_bulk`.
+///
+/// `send*` передают пакеты в очередь немедленно; `send_bulk` копит их до
+/// общего doorbell. Ядро-владелец должно регулярно вызывать `poll`.
+pub struct TxSession {
+    template: Box<HeaderTemplate>,
+    mbuf_pool: *mut RteMempool,
+    port_id: u16,
+    queue_id: u16,
+    /// Право на очередь; общее у сессий, созданных через `sibling`
+    claim: Option<Arc<TxQueueClaim>>,
+    policy: TxPolicy,
+    max_payload: usize,
+    backlog: [*mut RteMbuf; MAX_BURST_SIZE],
+    backlog_len: usize,
+    /// Bulk пакеты, ожидающие doorbell
+    staged: [*mut RteMbuf; MAX_BURST_SIZE],
+    staged_len: usize,
+    /// TSC постановки старейшего пакета в `staged`
+    staged_tsc: u64,
+    doorbell_batch: usize,
+    max_delay_cycles: u64,
+    /// Период освобождения TX кольца в тактах, 0 - отключено
+    reclaim_cycles: u64,
+    next_reclaim: u64,
+    counters: Arc<TxCounters>,
+}
+
+impl TxSession {
+    /// Создает сессию и строит шаблон заголовков
+    pub fn new(
+        config: &TxSessionConfig,
+        mbuf_pool: *mut RteMempool,
+        dpdk_config: &DpdkConfig,
+    ) -> Result<Self, String> {
+        if mbuf_pool.is_null() {
+            return Err(format!("Port {} has no mbuf pool", config.port_id));
+        }
+
+        let mut src_mac = RteEtherAddr { addr_bytes: [0; 6] };
+        let ret = unsafe { ffi::rte_eth_macaddr_get(config.port_id, &mut src_mac) };
+        if ret < 0 {
+            return Err(format!(
+                "Failed to get MAC address of port {}: error code {}",
+                config.port_id, ret
+            ));
+        }
+
+        let mut template = Box::new(HeaderTemplate::zeroed());
+        let ret = unsafe {
+            ffi::dpdk_tx_template_init(
+                &mut *template,
+                src_mac.addr_bytes.as_ptr(),
+                config.dst_mac.as_ptr(),
+                u32::from(config.src_ip).to_be(),
+                u32::from(config.dst_ip).to_be(),
+                config.src_port,
+                config.dst_port,
+                (config.protocol == TxProtocol::Tcp) as c_int,
+                dpdk_config.use_hw_checksum as c_int,
+            )
+        };
+        if ret != 0 {
+            return Err(format!("Failed to build TX header template: error code {}", ret));
+        }
+
+        let max_payload = (dpdk_config.data_room_size as usize)
+            .saturating_sub(MBUF_HEADROOM + template.hdr_len as usize);
+
+        let batching = &dpdk_config.tx_batching;
+        let hz = tsc_hz();
+
+        Ok(Self {
+            template,
+            mbuf_pool,
+            port_id: config.port_id,
+            queue_id: config.queue_id,
+            claim: None,
+            policy: dpdk_config.tx_policy,
+            max_payload,
+            backlog: [std::ptr::null_mut(); MAX_BURST_SIZE],
+            backlog_len: 0,
+            staged: [std::ptr::null_mut(); MAX_BURST_SIZE],
+            staged_len: 0,
+            staged_tsc: 0,
+            doorbell_batch: batching.doorbell_batch.clamp(1, MAX_BURST_SIZE),
+            max_delay_cycles: batching.max_delay_us * hz / 1_000_000,
+            reclaim_cycles: batching.reclaim_interval_us * hz / 1_000_000,
+            next_reclaim: 0,
+            counters: Arc::new(TxCounters::default()),
+        })
+    }
+
+    /// Закрепляет за сессией TX очередь, выданную `TxQueueTable`
+    pub(crate) fn bind_queue(&mut self, claim: TxQueueClaim) {
+        debug_assert_eq!(
+            (claim.port_id(), claim.queue_id()),
+            (self.port_id, self.queue_id)
+        );
+        self.claim = Some(Arc::new(claim));
+    }
+
+    /// Создает сессию с другой адресацией на той же TX очереди
+    ///
+    /// Очередь остается единственной на ядро: обе сессии должны
+    /// использоваться из одного потока.
+    pub fn sibling(
+        &self,
+        config: &TxSessionConfig,
+        dpdk_config: &DpdkConfig,
+    ) -> Result<Self, String> {
+        let config = TxSessionConfig {
+            port_id: self.port_id,
+            queue_id: self.queue_id,
+            ..config.clone()
+        };
+        let mut session = Self::new(&config, self.mbuf_pool, dpdk_config)?;
+        session.claim = self.claim.clone();
+        Ok(session)
+    }
+
+    /// Отправляет пакеты с указанными payload, возвращает число отправленных
+    ///
+    /// Пакеты из backlog отправляются первыми, чтобы сохранить порядок.
+    pub fn send(&mut self, payloads: &[&[u8]]) -> usize {
+        let mut sent = self.flush_backlog();
+
+        let mut data_ptrs = [std::ptr::null::<u8>(); MAX_BURST_SIZE];
+        let mut data_lens = [0u16; MAX_BURST_SIZE];
+        let mut mbufs = [std::ptr::null_mut::<RteMbuf>(); MAX_BURST_SIZE];
+
+        for chunk in payloads.chunks(MAX_BURST_SIZE) {
+            let mut nb = 0;
+            for payload in chunk {
+                if payload.len() > self.max_payload {
+                    self.counters.oversized.inc();
+                    continue;
+                }
+                data_ptrs[nb] = payload.as_ptr();
+                data_lens[nb] = payload.len() as u16;
+                nb += 1;
+            }
+
+            if nb == 0 {
+                continue;
+            }
+
+            let nb_built = unsafe {
+                ffi::dpdk_tx_build_burst(
+                    self.mbuf_pool,
+                    &*self.template,
+                    data_ptrs.as_ptr(),
+                    data_lens.as_ptr(),
+                    nb as u16,
+                    mbufs.as_mut_ptr(),
+                )
+            } as usize;
+
+            if nb_built == 0 {
+                self.counters.alloc_failures.add(nb as u64);
+                self.counters.dropped.add(nb as u64);
+                continue;
+            }
+
+            sent += self.transmit(&mut mbufs[..nb_built]);
+        }
+
+        sent
+    }
+
+    /// Отправляет пакет, payload которого `encode` пишет прямо в data room
+    /// mbuf, без промежуточного буфера
+    ///
+    /// `encode` получает область длиной `max_payload` и возвращает длину
+    /// записанного сообщения; None отменяет отправку.
+    #[inline]
+    pub fn send_in_place<F>(&mut self, encode: F) -> bool
+    where
+        F: FnOnce(&mut [u8]) -> Option<usize>,
+    {
+        self.flush_backlog();
+
+        let mut mbuf = std::ptr::null_mut::<RteMbuf>();
+        let payload = unsafe { ffi::dpdk_tx_prepare(self.mbuf_pool, &*self.template, &mut mbuf) };
+        if payload.is_null() {
+            self.counters.alloc_failures.inc();
+            self.counters.dropped.inc();
+            return false;
+        }
+
+        let room = unsafe { std::slice::from_raw_parts_mut(payload, self.max_payload) };
+        let len = match encode(room) {
+            Some(len) if len <= self.max_payload => len,
+            _ => {
+                unsafe { ffi::rte_pktmbuf_free(mbuf) };
+                self.counters.oversized.inc();
+                return false;
+            }
+        };
+
+        unsafe { ffi::dpdk_tx_commit(&*self.template, mbuf, len as u16) };
+
+        let mut pkts = [mbuf];
+        self.transmit(&mut pkts) == 1
+    }
+
+    /// Отправляет TCP сегменты, возвращает число переданных в очередь
+    ///
+    /// Номера последовательности и флаги задает вызывающая сторона
+    /// (`TcpSession`); сегменты длиннее `max_payload` пропускаются.
+    pub fn send_tcp(&mut self, segs: &[TcpSegment]) -> usize {
+        let mut sent = self.flush_backlog();
+        let mut mbufs = [std::ptr::null_mut::<RteMbuf>(); MAX_BURST_SIZE];
+
+        for chunk in segs.chunks(MAX_BURST_SIZE) {
+            if chunk
+                .iter()
+                .any(|seg| seg.payload_len as usize > self.max_payload)
+            {
+                self.counters.oversized.add(chunk.len() as u64);
+                continue;
+            }
+
+            let nb_built = unsafe {
+                ffi::dpdk_tx_build_tcp_burst(
+                    self.mbuf_pool,
+                    &*self.template,
+                    chunk.as_ptr(),
+                    chunk.len() as u16,
+                    mbufs.as_mut_ptr(),
+                )
+            } as usize;
+
+            if nb_built == 0 {
+                self.counters.alloc_failures.add(chunk.len() as u64);
+                self.counters.dropped.add(chunk.len() as u64);
+                continue;
+            }
+
+            sent += self.transmit(&mut mbufs[..nb_built]);
+        }
+
+        sent
+    }
+
+    /// Отправляет один пакет
+    #[inline]
+    pub fn send_one(&mut self, payload: &[u8]) -> bool {
+        self.send(&[payload]) == 1
+    }
+
+    /// Ставит bulk пакеты (heartbeat, служебные сообщения) в очередь общего
+    /// doorbell, возвращает число принятых пакетов
+    ///
+    /// Пакеты уходят одним `rte_eth_tx_burst`, когда их накопится
+    /// `doorbell_batch`, когда старейший прождет `max_delay_us` (`poll`),
+    /// или вместе со следующей срочной отправкой - следом за ней.
+    pub fn send_bulk(&mut self, payloads: &[&[u8]]) -> usize {
+        let mut staged = 0;
+        let mut data_ptrs = [std::ptr::null::<u8>(); MAX_BURST_SIZE];
+        let mut data_lens = [0u16; MAX_BURST_SIZE];
+        let pool = self.mbuf_pool;
+        let template: *const HeaderTemplate = &*self.template;
+
+        for chunk in payloads.chunks(MAX_BURST_SIZE) {
+            let mut nb = 0;
+            for payload in chunk {
+                if payload.len() > self.max_payload {
+                    self.counters.oversized.inc();
+                    continue;
+                }
+                data_ptrs[nb] = payload.as_ptr();
+                data_lens[nb] = payload.len() as u16;
+                nb += 1;
+            }
+
+            staged += self.stage(nb, |first, count, out| unsafe {
+                ffi::dpdk_tx_build_burst(
+                    pool,
+                    template,
+                    data_ptrs[first..].as_ptr(),
+                    data_lens[first..].as_ptr(),
+                    count as u16,
+                    out,
+                ) as usize
+            });
+        }
+
+        if self.staged_len >= self.doorbell_batch {
+            self.ring_doorbell();
+        }
+
+        staged
+    }
+
+    /// Ставит TCP сегменты без срочности (чистые ACK) в очередь общего
+    /// doorbell, как `send_bulk`
+    pub fn send_tcp_bulk(&mut self, segs: &[TcpSegment]) -> usize {
+        let mut staged = 0;
+        let pool = self.mbuf_pool;
+        let template: *const HeaderTemplate = &*self.template;
+
+        for chunk in segs.chunks(MAX_BURST_SIZE) {
+            if chunk
+                .iter()
+                .any(|seg| seg.payload_len as usize > self.max_payload)
+            {
+                self.counters.oversized.add(chunk.len() as u64);
+                continue;
+            }
+
+            staged += self.stage(chunk.len(), |first, count, out| unsafe {
+                ffi::dpdk_tx_build_tcp_burst(
+                    pool,
+                    template,
+                    chunk[first..].as_ptr(),
+                    count as u16,
+                    out,
+                ) as usize
+            });
+        }
+
+        if self.staged_len >= self.doorbell_batch {
+            self.ring_doorbell();
+        }
+
+        staged
+    }
+
+    /// Собирает `nb` пакетов в `staged`, освобождая место doorbell
+    ///
+    /// `build(first, count, out)` собирает пакеты `first..first + count`
+    /// в `out` и возвращает число собранных.
+    fn stage<F>(&mut self, nb: usize, mut build: F) -> usize
+    where
+        F: FnMut(usize, usize, *mut *mut RteMbuf) -> usize,
+    {
+        let mut staged = 0;
+        let mut done = 0;
+        while done < nb {
+            if self.staged_len == MAX_BURST_SIZE && self.ring_doorbell() == 0 {
+                // Очередь не принимает даже накопленное: остаток теряется
+                self.counters.dropped.add((nb - done) as u64);
+                break;
+            }
+
+            let room = (MAX_BURST_SIZE - self.staged_len).min(nb - done);
+            let nb_built = build(done, room, self.staged[self.staged_len..].as_mut_ptr());
+
+            if nb_built < room {
+                self.counters.alloc_failures.add((room - nb_built) as u64);
+                self.counters.dropped.add((room - nb_built) as u64);
+            }
+            if nb_built > 0 && self.staged_len == 0 {
+                self.staged_tsc = tsc();
+            }
+            self.staged_len += nb_built;
+            staged += nb_built;
+            done += room;
+        }
+        staged
+    }
+
+    /// Отправляет накопленные bulk пакеты одним doorbell
+    pub fn ring_doorbell(&mut self) -> usize {
+        self.flush_backlog();
+        if self.staged_len == 0 || self.backlog_len > 0 {
+            return 0;
+        }
+
+        let pkts = self.staged.as_mut_ptr();
+        let nb_tx = self.tx_burst(pkts, self.staged_len);
+        self.staged.copy_within(nb_tx..self.staged_len, 0);
+        self.staged_len -= nb_tx;
+        self.record_sent(nb_tx);
+
+        nb_tx
+    }
+
+    /// Обслуживает сессию между отправками: doorbell по истечении
+    /// `max_delay_us`, повтор backlog и освобождение TX кольца
+    ///
+    /// Вызывается ядром-владельцем в рабочем цикле с текущим TSC.
+    #[inline]
+    pub fn poll(&mut self, now: u64) {
+        if self.staged_len > 0 && now.wrapping_sub(self.staged_tsc) >= self.max_delay_cycles {
+            self.ring_doorbell();
+        } else if self.backlog_len > 0 {
+            self.flush_backlog();
+        }
+
+        if self.reclaim_cycles != 0 && now >= self.next_reclaim {
+            self.reclaim();
+            self.next_reclaim = now + self.reclaim_cycles;
+        }
+    }
+
+    /// Возвращает в пул mbuf, которые NIC уже отправил из кольца очереди
+    ///
+    /// С RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE драйвер освобождает их пачкой без
+    /// проверки refcnt и пула. Драйверы без `tx_done_cleanup` чистят кольцо
+    /// сами внутри `rte_eth_tx_burst`; для них периодический вызов
+    /// отключается после первой ошибки.
+    pub fn reclaim(&mut self) -> usize {
+        let ret = unsafe { ffi::rte_eth_tx_done_cleanup(self.port_id, self.queue_id, 0) };
+        if ret < 0 {
+            self.reclaim_cycles = 0;
+            return 0;
+        }
+
+        self.counters.reclaimed.add(ret as u64);
+        ret as usize
+    }
+
+    /// Отправляет backlog и накопленные bulk пакеты, возвращает число
+    /// отправленных пакетов
+    pub fn flush(&mut self) -> usize {
+        self.flush_backlog() + self.ring_doorbell()
+    }
+
+    /// Отправляет накопленный backlog, возвращает число отправленных пакетов
+    fn flush_backlog(&mut self) -> usize {
+        if self.backlog_len == 0 {
+            return 0;
+        }
+
+        let pkts = self.backlog.as_mut_ptr();
+        let nb_tx = self.tx_burst(pkts, self.backlog_len);
+        self.backlog.copy_within(nb_tx..self.backlog_len, 0);
+        self.backlog_len -= nb_tx;
+        self.record_sent(nb_tx);
+
+        nb_tx
+    }
+
+    /// Отправляет ответ на пакет, пришедший в момент `origin_tsc`
+    /// (`PacketData::rx_timestamp`), и учитывает задержку tick-to-trade
+    pub fn send_stamped(&mut self, payloads: &[&[u8]], origin_tsc: u64) -> usize {
+        let sent = self.send(payloads);
+
+        if sent > 0 && origin_tsc != 0 {
+            let tx_tsc = self.counters.last_tx_tsc.get();
+            self.counters
+                .tick_to_trade
+                .record(tx_tsc.saturating_sub(origin_tsc));
+        }
+
+        sent
+    }
+
+    /// Учитывает переданные в TX очередь пакеты и время передачи
+    #[inline(always)]
+    fn record_sent(&mut self, nb_tx: usize) {
+        if nb_tx > 0 {
+            self.counters.sent.add(nb_tx as u64);
+            self.counters.last_tx_tsc.set(tsc());
+        }
+    }
+
+    /// Один doorbell: передает пакеты в TX очередь с повторами политики
+    #[inline(always)]
+    fn tx_burst(&self, pkts: *mut *mut RteMbuf, nb_pkts: usize) -> usize {
+        self.counters.doorbells.inc();
+        unsafe {
+            ffi::dpdk_tx_send_burst(
+                self.port_id,
+                self.queue_id,
+                pkts,
+                nb_pkts as u16,
+                self.policy.max_retries,
+            ) as usize
+        }
+    }
+
+    /// Передает готовые пакеты в очередь и применяет политику к остатку
+    fn transmit(&mut self, pkts: &mut [*mut RteMbuf]) -> usize {
+        debug_assert!(pkts.len() <= MAX_BURST_SIZE);
+
+        // Пока backlog не пуст, новые пакеты встают в очередь за ним
+        if self.backlog_len > 0 {
+            self.retain_unsent(pkts);
+            return 0;
+        }
+
+        if self.staged_len == 0 {
+            let nb_tx = self.tx_burst(pkts.as_mut_ptr(), pkts.len());
+            self.record_sent(nb_tx);
+            self.retain_unsent(&mut pkts[nb_tx..]);
+            return nb_tx;
+        }
+
+        // Накопленные bulk пакеты уходят тем же doorbell сразу за срочными
+        let nb_urgent = pkts.len();
+        let nb_pkts = nb_urgent + self.staged_len;
+        let mut burst = [std::ptr::null_mut::<RteMbuf>(); 2 * MAX_BURST_SIZE];
+        burst[..nb_urgent].copy_from_slice(pkts);
+        burst[nb_urgent..nb_pkts].copy_from_slice(&self.staged[..self.staged_len]);
+
+        let nb_tx = self.tx_burst(burst.as_mut_ptr(), nb_pkts);
+        self.record_sent(nb_tx);
+
+        let urgent_tx = nb_tx.min(nb_urgent);
+        let staged_tx = nb_tx - urgent_tx;
+        self.staged.copy_within(staged_tx..self.staged_len, 0);
+        self.staged_len -= staged_tx;
+
+        self.retain_unsent(&mut pkts[urgent_tx..]);
+        urgent_tx
+    }
+
+    /// Применяет политику к пакетам, которые очередь не приняла
+    fn retain_unsent(&mut self, unsent: &mut [*mut RteMbuf]) {
+        if unsent.is_empty() {
+            return;
+        }
+
+        let mut nb_free = unsent.len();
+        if self.policy.drain == TxDrainPolicy::Backlog {
+            let room = (MAX_BURST_SIZE - self.backlog_len).min(unsent.len());
+            self.backlog[self.backlog_len..self.backlog_len + room]
+                .copy_from_slice(&unsent[..room]);
+            self.backlog_len += room;
+            nb_free -= room;
+        }
+
+        if nb_free > 0 {
+            let nb_unsent = unsent.len();
+            let tail = &mut unsent[nb_unsent - nb_free..];
+            unsafe { ffi::rte_pktmbuf_free_bulk(tail.as_mut_ptr(), nb_free as u32) };
+            self.counters.dropped.add(nb_free as u64);
+        }
+    }
+
+    /// Количество пакетов, ожидающих отправки в backlog
+    pub fn pending(&self) -> usize {
+        self.backlog_len
+    }
+
+    /// Количество bulk пакетов, ожидающих doorbell
+    pub fn staged(&self) -> usize {
+        self.staged_len
+    }
+
+    /// Максимальный payload, помещающийся в один mbuf после заголовков
+    pub fn max_payload(&self) -> usize {
+        self.max_payload
+    }
+
+    /// Возвращает шаблон заголовков сессии
+    pub fn template(&self) -> &HeaderTemplate {
+        &self.template
+    }
+
+    /// Возвращает снимок счетчиков сессии
+    pub fn stats(&self) -> TxStats {
+        TxStats {
+            sent: self.counters.sent.get(),
+            dropped: self.counters.dropped.get(),
+            alloc_failures: self.counters.alloc_failures.get(),
+            oversized: self.counters.oversized.get(),
+            doorbells: self.counters.doorbells.get(),
+            reclaimed: self.counters.reclaimed.get(),
+        }
+    }
+
+    /// TSC последней передачи пакетов в TX очередь
+    pub fn last_tx_tsc(&self) -> u64 {
+        self.counters.last_tx_tsc.get()
+    }
+
+    /// Счетчики сессии для чтения из других потоков
+    pub fn counters(&self) -> Arc<TxCounters> {
+        self.counters.clone()
+    }
+
+    pub fn port_id(&self) -> u16 {
+        self.port_id
+    }
+
+    pub fn queue_id(&self) -> u16 {
+        self.queue_id
+    }
+}
+
+impl Drop for TxSession {
+    fn drop(&mut self) {
+        if self.backlog_len > 0 {
+            unsafe {
+                ffi::rte_pktmbuf_free_bulk(self.backlog.as_mut_ptr(), self.backlog_len as u32)
+            };
+        }
+        if self.staged_len > 0 {
+            unsafe { ffi::rte_pktmbuf_free_bulk(self.staged.as_mut_ptr(), self.staged_len as u32) };
+        }
+    }
+}
+
+unsafe impl Send for TxSession {}
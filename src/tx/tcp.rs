@@ -0,0 +1,999 @@
+// src/tx/tcp.rs
+use std::net::Ipv4Addr;
+use std::sync::Arc;
+
+use crate::dpdk::config::{DpdkConfig, MAX_BURST_SIZE};
+use crate::dpdk::ffi::{self, RteMempool};
+use crate::packet::classify::IPPROTO_TCP;
+use crate::packet::data::PacketData;
+use crate::packet::timestamp::{tsc, tsc_hz};
+use crate::protocols::wire::{ensure_len, wire_view, DecodeError, WireField};
+use crate::telemetry::worker::Counter;
+use crate::tx::queue::TxQueueClaim;
+use crate::tx::session::{TxProtocol, TxSession, TxSessionConfig};
+
+pub const TCP_FIN: u8 = 0x01;
+pub const TCP_SYN: u8 = 0x02;
+pub const TCP_RST: u8 = 0x04;
+pub const TCP_PSH: u8 = 0x08;
+pub const TCP_ACK: u8 = 0x10;
+
+/// Длина опции MSS, должна совпадать с DPDK_TCP_OPT_MSS_LEN в src/native/dpdk.c
+const OPT_MSS_LEN: usize = 4;
+/// MSS по умолчанию, если SYN-ACK пришел без опции (RFC 9293, 3.7.1)
+const DEFAULT_PEER_MSS: u16 = 536;
+/// Максимальное окно без опции Window Scale
+const MAX_WINDOW: usize = u16::MAX as usize;
+/// Количество повторных ACK для быстрой повторной отправки
+const DUP_ACK_THRESHOLD: u32 = 3;
+/// Максимальная длина сообщения для `send_with`
+pub const MAX_ENCODED_LEN: usize = 512;
+
+const ETHER_HDR_LEN: usize = 14;
+const ETHER_TYPE_IPV4: u16 = 0x0800;
+const ETHER_TYPE_VLAN: u16 = 0x8100;
+const ETHER_TYPE_QINQ: u16 = 0x88a8;
+
+/// Параметры одного TCP сегмента для `dpdk_tx_build_tcp_burst`
+///
+/// Раскладка совпадает с `struct dpdk_tcp_segment` в src/native/dpdk.c.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct TcpSegment {
+    pub payload: *const u8,
+    pub seq: u32,
+    pub ack: u32,
+    pub payload_len: u16,
+    pub window: u16,
+    pub flags: u8,
+    pub _reserved: u8,
+    /// Значение опции MSS, 0 - без опций
+    pub mss: u16,
+}
+
+const _: () = assert!(std::mem::size_of::<TcpSegment>() == 24);
+
+impl TcpSegment {
+    const EMPTY: TcpSegment = TcpSegment {
+        payload: std::ptr::null(),
+        seq: 0,
+        ack: 0,
+        payload_len: 0,
+        window: 0,
+        flags: 0,
+        _reserved: 0,
+        mss: 0,
+    };
+}
+
+wire_view! {
+    /// Заголовок TCP без опций
+    pub struct TcpHeader, read_be, len = 20;
+    src_port: u16 = 0;
+    dst_port: u16 = 2;
+    seq: u32 = 4;
+    ack: u32 = 8;
+    /// Длина заголовка в 32-битных словах в старших 4 битах
+    data_off: u8 = 12;
+    flags: u8 = 13;
+    window: u16 = 14;
+}
+
+/// Состояние соединения (RFC 9293, 3.3.2); только активное открытие
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum TcpState {
+    Closed,
+    SynSent,
+    Established,
+    FinWait1,
+    FinWait2,
+    Closing,
+    TimeWait,
+    CloseWait,
+    LastAck,
+}
+
+/// Конфигурация TCP сессии
+#[derive(Debug, Clone)]
+pub struct TcpConfig {
+    /// Адресация и TX очередь; протокол должен быть `TxProtocol::Tcp`
+    pub session: TxSessionConfig,
+    /// Буфер неподтвержденных и еще не отправленных данных, степень двойки
+    pub send_buffer: usize,
+    /// Буфер принятых данных; его свободное место объявляется окном
+    pub recv_buffer: usize,
+    /// Собственный MSS; ограничивается размером mbuf
+    pub mss: u16,
+    /// Начальный и минимальный таймаут повторной отправки
+    pub rto_min_us: u64,
+    pub rto_max_us: u64,
+    /// Повторов одного сегмента до разрыва соединения
+    pub max_retransmits: u32,
+}
+
+impl TcpConfig {
+    pub fn new(session: TxSessionConfig) -> Self {
+        Self {
+            session,
+            send_buffer: 64 * 1024,
+            recv_buffer: 64 * 1024,
+            mss: 1460,
+            // Внутри колокации RTT - единицы микросекунд
+            rto_min_us: 5_000,
+            rto_max_us: 1_000_000,
+            max_retransmits: 8,
+        }
+    }
+}
+
+/// Счетчики TCP сессии
+#[repr(C, align(64))]
+#[derive(Debug, Default)]
+pub struct TcpCounters {
+    pub rx_segments: Counter,
+    pub rx_bytes: Counter,
+    pub tx_segments: Counter,
+    pub tx_bytes: Counter,
+    pub retransmits: Counter,
+    pub fast_retransmits: Counter,
+    pub dup_acks: Counter,
+    pub out_of_order: Counter,
+    pub rx_overflow: Counter,
+    pub resets: Counter,
+    pub malformed: Counter,
+}
+
+/// Минимальный TCP в обход ядра для сессий ввода ордеров
+///
+/// Сессия однопоточная и принадлежит ядру, которое ее опрашивает: RX
+/// worker передает ей свои пакеты через `on_packet`, отправка идет через
+/// собственную TX очередь (`TxSession`). Буферы отправки и приема
+/// выделяются при создании; повторная отправка строит сегменты заново из
+/// буфера отправки, поэтому mbuf не удерживаются до подтверждения.
+///
+/// Поддерживаются трехстороннее рукопожатие, окно получателя, повторная
+/// отправка по таймеру (go-back-N) и по трем повторным ACK, FIN и RST.
+/// Контроль перегрузки, Window Scale, SACK и timestamps не реализованы:
+/// сессия рассчитана на короткий путь до шлюза биржи с малым объемом
+/// данных. Сегменты не по порядку отбрасываются и вызывают повторный ACK.
+pub struct TcpSession {
+    tx: TxSession,
+    local_ip: Ipv4Addr,
+    remote_ip: Ipv4Addr,
+    local_port: u16,
+    remote_port: u16,
+    state: TcpState,
+
+    send_buf: Box<[u8]>,
+    /// Начало неподтвержденных данных
+    snd_una: u32,
+    /// Следующий номер для отправки
+    snd_nxt: u32,
+    /// Конец записанных в буфер данных
+    snd_end: u32,
+    /// Окно получателя
+    snd_wnd: u32,
+    iss: u32,
+    fin_queued: bool,
+    fin_sent: bool,
+
+    recv_buf: Box<[u8]>,
+    rcv_nxt: u32,
+    /// Позиции чтения и записи буфера приема (растут монотонно)
+    rx_head: usize,
+    rx_tail: usize,
+    peer_fin: bool,
+    ack_pending: bool,
+
+    mss: u16,
+    peer_mss: u16,
+    dup_acks: u32,
+    retransmits: u32,
+    rto_cycles: u64,
+    rto_min_cycles: u64,
+    rto_max_cycles: u64,
+    max_retransmits: u32,
+    /// Момент срабатывания таймера повторной отправки, 0 - не взведен
+    rto_deadline: u64,
+
+    segs: [TcpSegment; MAX_BURST_SIZE],
+    /// Для сообщения `send_with`, которое пересекает конец кольца отправки
+    scratch: Box<[u8; MAX_ENCODED_LEN]>,
+    counters: Arc<TcpCounters>,
+}
+
+impl TcpSession {
+    /// Создает сессию в состоянии Closed
+    pub fn new(
+        config: &TcpConfig,
+        mbuf_pool: *mut RteMempool,
+        dpdk_config: &DpdkConfig,
+    ) -> Result<Self, String> {
+        if config.session.protocol != TxProtocol::Tcp {
+            return Err("TCP session requires TxProtocol::Tcp".to_string());
+        }
+        if !config.send_buffer.is_power_of_two() {
+            return Err(format!(
+                "TCP send buffer must be a power of two, got {}",
+                config.send_buffer
+            ));
+        }
+        if config.recv_buffer == 0 {
+            return Err("TCP receive buffer must not be empty".to_string());
+        }
+
+        let tx = TxSession::new(&config.session, mbuf_pool, dpdk_config)?;
+
+        // Пришедший сегмент должен помещаться в один mbuf, а свой - в
+        // max_payload вместе с опцией MSS
+        let mss = (config.mss as usize)
+            .min(tx.max_payload().saturating_sub(OPT_MSS_LEN))
+            .min(u16::MAX as usize) as u16;
+        if mss == 0 {
+            return Err(format!(
+                "mbuf data room {} is too small for TCP segments",
+                dpdk_config.data_room_size
+            ));
+        }
+
+        let hz = tsc_hz();
+        let rto_min_cycles = (config.rto_min_us * hz / 1_000_000).max(1);
+
+        Ok(Self {
+            tx,
+            local_ip: config.session.src_ip,
+            remote_ip: config.session.dst_ip,
+            local_port: config.session.src_port,
+            remote_port: config.session.dst_port,
+            state: TcpState::Closed,
+
+            send_buf: vec![0u8; config.send_buffer].into_boxed_slice(),
+            snd_una: 0,
+            snd_nxt: 0,
+            snd_end: 0,
+            snd_wnd: 0,
+            iss: 0,
+            fin_queued: false,
+            fin_sent: false,
+
+            recv_buf: vec![0u8; config.recv_buffer].into_boxed_slice(),
+            rcv_nxt: 0,
+            rx_head: 0,
+            rx_tail: 0,
+            peer_fin: false,
+            ack_pending: false,
+
+            mss,
+            peer_mss: DEFAULT_PEER_MSS,
+            dup_acks: 0,
+            retransmits: 0,
+            rto_cycles: rto_min_cycles,
+            rto_min_cycles,
+            rto_max_cycles: (config.rto_max_us * hz / 1_000_000).max(rto_min_cycles),
+            max_retransmits: config.max_retransmits,
+            rto_deadline: 0,
+
+            segs: [TcpSegment::EMPTY; MAX_BURST_SIZE],
+            scratch: Box::new([0u8; MAX_ENCODED_LEN]),
+            counters: Arc::new(TcpCounters::default()),
+        })
+    }
+
+    /// Начинает активное открытие: отправляет SYN
+    pub fn connect(&mut self, now: u64) -> Result<(), String> {
+        if self.state != TcpState::Closed {
+            return Err(format!("TCP session is already {:?}", self.state));
+        }
+
+        // ISN из TSC: разные для последовательных подключений (RFC 9293, 3.4.1)
+        self.iss = (tsc() >> 4) as u32;
+        self.snd_una = self.iss;
+        self.snd_nxt = self.iss.wrapping_add(1);
+        self.snd_end = self.snd_nxt;
+        self.snd_wnd = 0;
+        self.fin_queued = false;
+        self.fin_sent = false;
+        self.rx_head = 0;
+        self.rx_tail = 0;
+        self.peer_fin = false;
+        self.ack_pending = false;
+        self.peer_mss = DEFAULT_PEER_MSS;
+        self.dup_acks = 0;
+        self.retransmits = 0;
+        self.rto_cycles = self.rto_min_cycles;
+
+        self.state = TcpState::SynSent;
+        self.send_syn();
+        self.rto_deadline = now + self.rto_cycles;
+        Ok(())
+    }
+
+    /// Записывает данные в буфер отправки и отправляет, сколько позволяет
+    /// окно получателя; возвращает количество принятых байт
+    ///
+    /// Ордера так не отправляются: они проходят проверки риска в
+    /// `RiskEngine::send_tcp_with`.
+    pub fn send(&mut self, data: &[u8], now: u64) -> usize {
+        if !matches!(self.state, TcpState::Established | TcpState::CloseWait) || self.fin_queued {
+            return 0;
+        }
+
+        let cap = self.send_buf.len();
+        let used = self.snd_end.wrapping_sub(self.snd_una) as usize;
+        let len = data.len().min(cap - used);
+        if len == 0 {
+            return 0;
+        }
+
+        let mask = cap - 1;
+        let start = self.snd_end as usize & mask;
+        let first = len.min(cap - start);
+        self.send_buf[start..start + first].copy_from_slice(&data[..first]);
+        self.send_buf[..len - first].copy_from_slice(&data[first..len]);
+        self.snd_end = self.snd_end.wrapping_add(len as u32);
+
+        self.push(now, false);
+        len
+    }
+
+    /// Отправляет сообщение, которое `encode` пишет прямо в буфер отправки
+    /// (он же буфер повторной отправки), без промежуточной копии
+    ///
+    /// `encode` получает область не короче `max_len` и возвращает длину
+    /// сообщения; None отменяет отправку. Сообщение отправляется целиком
+    /// или не отправляется: при нехватке места в буфере возвращается 0.
+    /// Ордера отправляются через `RiskEngine::send_tcp_with`.
+    #[inline]
+    pub fn send_with<F>(&mut self, max_len: usize, encode: F, now: u64) -> usize
+    where
+        F: FnOnce(&mut [u8]) -> Option<usize>,
+    {
+        if !matches!(self.state, TcpState::Established | TcpState::CloseWait)
+            || self.fin_queued
+            || max_len > MAX_ENCODED_LEN
+        {
+            return 0;
+        }
+
+        let cap = self.send_buf.len();
+        let used = self.snd_end.wrapping_sub(self.snd_una) as usize;
+        if cap - used < max_len {
+            return 0;
+        }
+
+        let start = self.snd_end as usize & (cap - 1);
+        let len = if cap - start >= max_len {
+            match encode(&mut self.send_buf[start..start + max_len]) {
+                Some(len) if len <= max_len => len,
+                _ => return 0,
+            }
+        } else {
+            // Редкий случай: сообщение пересекает конец кольца
+            let len = match encode(&mut self.scratch[..max_len]) {
+                Some(len) if len <= max_len => len,
+                _ => return 0,
+            };
+            let first = len.min(cap - start);
+            self.send_buf[start..start + first].copy_from_slice(&self.scratch[..first]);
+            self.send_buf[..len - first].copy_from_slice(&self.scratch[first..len]);
+            len
+        };
+
+        self.snd_end = self.snd_end.wrapping_add(len as u32);
+        self.push(now, false);
+        len
+    }
+
+    /// Копирует принятые по порядку данные в `buf`
+    pub fn read(&mut self, buf: &mut [u8]) -> usize {
+        let cap = self.recv_buf.len();
+        let len = buf.len().min(self.rx_tail - self.rx_head);
+        if len == 0 {
+            return 0;
+        }
+
+        let was_closed = self.window() == 0;
+
+        let start = self.rx_head % cap;
+        let first = len.min(cap - start);
+        buf[..first].copy_from_slice(&self.recv_buf[start..start + first]);
+        buf[first..len].copy_from_slice(&self.recv_buf[..len - first]);
+        self.rx_head += len;
+
+        // Окно открылось: сообщаем получателю, иначе он ждет persist таймера
+        if was_closed {
+            self.ack_pending = true;
+        }
+        len
+    }
+
+    /// Количество принятых и еще не прочитанных байт
+    pub fn readable(&self) -> usize {
+        self.rx_tail - self.rx_head
+    }
+
+    /// Закрывает передачу: FIN отправляется после всех данных буфера
+    pub fn close(&mut self, now: u64) {
+        match self.state {
+            TcpState::SynSent => self.reset_state(),
+            TcpState::Established => {
+                self.fin_queued = true;
+                self.state = TcpState::FinWait1;
+                self.push(now, false);
+            }
+            TcpState::CloseWait => {
+                self.fin_queued = true;
+                self.state = TcpState::LastAck;
+                self.push(now, false);
+            }
+            _ => {}
+        }
+    }
+
+    /// Разрывает соединение сегментом RST
+    pub fn abort(&mut self) {
+        if !matches!(
+            self.state,
+            TcpState::Closed | TcpState::SynSent | TcpState::TimeWait
+        ) {
+            self.send_control(self.snd_nxt, TCP_RST | TCP_ACK);
+        }
+        self.reset_state();
+    }
+
+    /// Обрабатывает пакет RX worker; возвращает true, если пакет
+    /// принадлежит сессии
+    #[inline]
+    pub fn on_packet(&mut self, pkt: &PacketData, now: u64) -> bool {
+        if pkt.mbuf_ptr.is_null() {
+            return false;
+        }
+        let frame = unsafe {
+            let data = ffi::rte_pktmbuf_mtod(pkt.mbuf_ptr, std::ptr::null()) as *const u8;
+            std::slice::from_raw_parts(data, ffi::rte_pktmbuf_data_len(pkt.mbuf_ptr) as usize)
+        };
+        self.on_frame(frame, now)
+    }
+
+    /// Обрабатывает Ethernet кадр; возвращает true, если кадр принадлежит
+    /// сессии
+    pub fn on_frame(&mut self, frame: &[u8], now: u64) -> bool {
+        match self.parse(frame) {
+            Ok(Some((header, options, payload))) => {
+                self.counters.rx_segments.inc();
+                self.on_segment(&header, options, payload, now);
+                true
+            }
+            Ok(None) => false,
+            Err(_) => {
+                self.counters.malformed.inc();
+                false
+            }
+        }
+    }
+
+    /// Таймеры, отложенный ACK и обслуживание TX сессии (doorbell bulk
+    /// пакетов, освобождение кольца); вызывается в каждой итерации цикла ядра
+    #[inline]
+    pub fn poll(&mut self, now: u64) {
+        if self.rto_deadline != 0 && now >= self.rto_deadline {
+            self.on_timeout(now);
+        }
+
+        if self.ack_pending {
+            self.stage_ack();
+        }
+
+        self.tx.poll(now);
+    }
+
+    pub fn state(&self) -> TcpState {
+        self.state
+    }
+
+    pub fn is_established(&self) -> bool {
+        self.state == TcpState::Established
+    }
+
+    /// Байты в буфере отправки, еще не подтвержденные получателем
+    pub fn unacked(&self) -> usize {
+        // После подтверждения FIN snd_una на единицу больше snd_end
+        if seq_lt(self.snd_una, self.snd_end) {
+            self.snd_end.wrapping_sub(self.snd_una) as usize
+        } else {
+            0
+        }
+    }
+
+    /// Счетчики сессии для чтения из других потоков
+    pub fn counters(&self) -> Arc<TcpCounters> {
+        self.counters.clone()
+    }
+
+    /// TX сессия соединения (счетчики очереди и tick-to-trade)
+    pub fn tx(&self) -> &TxSession {
+        &self.tx
+    }
+
+    /// Закрепляет за сессией TX очередь, выданную `TxQueueTable`
+    pub(crate) fn bind_queue(&mut self, claim: TxQueueClaim) {
+        self.tx.bind_queue(claim);
+    }
+
+    /// Разбирает кадр; Ok(None) - кадр другого потока
+    fn parse<'a>(
+        &self,
+        frame: &'a [u8],
+    ) -> Result<Option<(TcpHeader<'a>, &'a [u8], &'a [u8])>, DecodeError> {
+        ensure_len(frame, ETHER_HDR_LEN)?;
+
+        let mut l2_len = ETHER_HDR_LEN;
+        let mut ether_type = unsafe { u16::read_be(frame, 12) };
+        while ether_type == ETHER_TYPE_VLAN || ether_type == ETHER_TYPE_QINQ {
+            ensure_len(frame, l2_len + 4)?;
+            ether_type = unsafe { u16::read_be(frame, l2_len + 2) };
+            l2_len += 4;
+        }
+        if ether_type != ETHER_TYPE_IPV4 {
+            return Ok(None);
+        }
+
+        let ip = &frame[l2_len..];
+        ensure_len(ip, 20)?;
+        let ihl = ((ip[0] & 0x0f) as usize) * 4;
+        if ip[9] != IPPROTO_TCP
+            || ihl < 20
+            || ip[12..16] != self.remote_ip.octets()
+            || ip[16..20] != self.local_ip.octets()
+        {
+            return Ok(None);
+        }
+
+        let total_len = unsafe { u16::read_be(ip, 2) } as usize;
+        ensure_len(ip, total_len.max(ihl))?;
+        let tcp = &ip[ihl..total_len.max(ihl)];
+
+        let header = TcpHeader::new(tcp)?;
+        if header.src_port() != self.remote_port || header.dst_port() != self.local_port {
+            return Ok(None);
+        }
+
+        let data_off = ((header.data_off() >> 4) as usize) * 4;
+        if data_off < TcpHeader::LEN || data_off > tcp.len() {
+            return Err(DecodeError::LengthMismatch {
+                msg_type: IPPROTO_TCP as u16,
+                expected: data_off,
+                actual: tcp.len(),
+            });
+        }
+
+        Ok(Some((
+            header,
+            &tcp[TcpHeader::LEN..data_off],
+            &tcp[data_off..],
+        )))
+    }
+
+    fn on_segment(&mut self, header: &TcpHeader<'_>, options: &[u8], payload: &[u8], now: u64) {
+        let flags = header.flags();
+        let seq = header.seq();
+        let ack = header.ack();
+
+        if flags & TCP_RST != 0 {
+            // RST принимается только внутри окна (RFC 5961, 3.2 упрощенно)
+            let acceptable = match self.state {
+                TcpState::SynSent => flags & TCP_ACK != 0 && ack == self.snd_nxt,
+                TcpState::Closed => false,
+                _ => seq == self.rcv_nxt || self.in_recv_window(seq),
+            };
+            if acceptable {
+                self.counters.resets.inc();
+                self.reset_state();
+            }
+            return;
+        }
+
+        match self.state {
+            TcpState::Closed => return,
+            TcpState::SynSent => {
+                if flags & (TCP_SYN | TCP_ACK) != TCP_SYN | TCP_ACK || ack != self.snd_nxt {
+                    return;
+                }
+                self.rcv_nxt = seq.wrapping_add(1);
+                self.snd_una = ack;
+                self.snd_wnd = header.window() as u32;
+                self.peer_mss = parse_mss(options).unwrap_or(DEFAULT_PEER_MSS);
+                self.state = TcpState::Established;
+                self.retransmits = 0;
+                self.rto_cycles = self.rto_min_cycles;
+                self.rto_deadline = 0;
+                self.send_ack();
+                self.push(now, false);
+                return;
+            }
+            _ => {}
+        }
+
+        // Повторный SYN-ACK: наш ACK потерян
+        if flags & TCP_SYN != 0 {
+            self.ack_pending = true;
+            return;
+        }
+
+        if flags & TCP_ACK != 0 {
+            self.on_ack(ack, header.window() as u32, payload.is_empty(), now);
+        }
+
+        if !payload.is_empty() || flags & TCP_FIN != 0 {
+            self.on_data(seq, payload, flags & TCP_FIN != 0, now);
+        }
+    }
+
+    fn on_ack(&mut self, ack: u32, window: u32, pure_ack: bool, now: u64) {
+        let fin_seq = self.snd_end.wrapping_add(1);
+        let limit = if self.fin_queued {
+            fin_seq
+        } else {
+            self.snd_end
+        };
+
+        if seq_lt(self.snd_una, ack) && seq_le(ack, limit) {
+            self.snd_una = ack;
+            self.snd_wnd = window;
+            self.dup_acks = 0;
+            self.retransmits = 0;
+            self.rto_cycles = self.rto_min_cycles;
+            if seq_lt(self.snd_nxt, ack) {
+                self.snd_nxt = ack;
+            }
+
+            let fin_acked = self.fin_queued && ack == fin_seq;
+            self.rto_deadline = if ack == limit {
+                0
+            } else {
+                now + self.rto_cycles
+            };
+
+            if fin_acked {
+                match self.state {
+                    TcpState::FinWait1 => self.state = TcpState::FinWait2,
+                    TcpState::Closing => self.enter_time_wait(now),
+                    TcpState::LastAck => {
+                        self.reset_state();
+                        return;
+                    }
+                    _ => {}
+                }
+            }
+
+            self.push(now, false);
+            return;
+        }
+
+        if ack == self.snd_una && pure_ack && self.unacked() > 0 && window == self.snd_wnd {
+            self.counters.dup_acks.inc();
+            self.dup_acks += 1;
+            if self.dup_acks == DUP_ACK_THRESHOLD {
+                self.counters.fast_retransmits.inc();
+                self.retransmit_first();
+            }
+            return;
+        }
+
+        // Обновление окна без новых данных
+        if ack == self.snd_una {
+            let opened = self.snd_wnd == 0 && window > 0;
+            self.snd_wnd = window;
+            if opened {
+                self.push(now, false);
+            }
+        }
+    }
+
+    fn on_data(&mut self, seq: u32, payload: &[u8], fin: bool, now: u64) {
+        if !matches!(
+            self.state,
+            TcpState::Established | TcpState::FinWait1 | TcpState::FinWait2
+        ) {
+            // После FIN получателя данные не принимаются, но повторный FIN
+            // подтверждается
+            self.ack_pending = true;
+            return;
+        }
+
+        self.ack_pending = true;
+
+        let offset = self.rcv_nxt.wrapping_sub(seq) as usize;
+        if seq_lt(self.rcv_nxt, seq) {
+            self.counters.out_of_order.inc();
+            return;
+        }
+        if offset > payload.len() || (offset == payload.len() && !fin) {
+            // Дубликат уже принятых данных
+            return;
+        }
+
+        let data = &payload[offset.min(payload.len())..];
+        let cap = self.recv_buf.len();
+        let free = cap - (self.rx_tail - self.rx_head);
+        let len = data.len().min(free);
+
+        let start = self.rx_tail % cap;
+        let first = len.min(cap - start);
+        self.recv_buf[start..start + first].copy_from_slice(&data[..first]);
+        self.recv_buf[..len - first].copy_from_slice(&data[first..len]);
+        self.rx_tail += len;
+        self.rcv_nxt = self.rcv_nxt.wrapping_add(len as u32);
+        self.counters.rx_bytes.add(len as u64);
+
+        if len < data.len() {
+            // Остаток за пределами окна будет отправлен повторно
+            self.counters.rx_overflow.inc();
+            return;
+        }
+
+        if fin && !self.peer_fin {
+            self.peer_fin = true;
+            self.rcv_nxt = self.rcv_nxt.wrapping_add(1);
+            match self.state {
+                TcpState::Established => self.state = TcpState::CloseWait,
+                TcpState::FinWait1 => self.state = TcpState::Closing,
+                TcpState::FinWait2 => self.enter_time_wait(now),
+                _ => {}
+            }
+        }
+    }
+
+    fn on_timeout(&mut self, now: u64) {
+        if self.state == TcpState::TimeWait {
+            self.reset_state();
+            return;
+        }
+
+        self.retransmits += 1;
+        if self.retransmits > self.max_retransmits {
+            self.counters.resets.inc();
+            self.abort();
+            return;
+        }
+
+        self.counters.retransmits.inc();
+        self.rto_cycles = (self.rto_cycles * 2).min(self.rto_max_cycles);
+        self.rto_deadline = now + self.rto_cycles;
+
+        if self.state == TcpState::SynSent {
+            self.send_syn();
+            return;
+        }
+
+        // Go-back-N с начала неподтвержденных данных; при нулевом окне
+        // отправляется проба в один байт
+        self.snd_nxt = self.snd_una;
+        self.fin_sent = false;
+        self.push(now, true);
+    }
+
+    /// Отправляет данные из буфера в пределах окна получателя
+    fn push(&mut self, now: u64, probe: bool) {
+        let window = if probe {
+            self.snd_wnd.max(1)
+        } else {
+            self.snd_wnd
+        };
+        let mss = self.mss.min(self.peer_mss) as u32;
+        let cap = self.send_buf.len();
+        let mask = cap - 1;
+        let ack = self.rcv_nxt;
+        let wnd = self.window();
+
+        let mut nb = 0;
+        while nb < MAX_BURST_SIZE && seq_lt(self.snd_nxt, self.snd_end) {
+            let in_flight = self.snd_nxt.wrapping_sub(self.snd_una);
+            if in_flight >= window {
+                break;
+            }
+
+            let start = self.snd_nxt as usize & mask;
+            let len = self
+                .snd_end
+                .wrapping_sub(self.snd_nxt)
+                .min(mss)
+                .min(window - in_flight)
+                .min((cap - start) as u32);
+
+            self.segs[nb] = TcpSegment {
+                payload: self.send_buf[start..].as_ptr(),
+                seq: self.snd_nxt,
+                ack,
+                payload_len: len as u16,
+                window: wnd,
+                flags: TCP_ACK | TCP_PSH,
+                _reserved: 0,
+                mss: 0,
+            };
+            self.snd_nxt = self.snd_nxt.wrapping_add(len);
+            self.counters.tx_bytes.add(len as u64);
+            nb += 1;
+        }
+
+        if self.fin_queued && !self.fin_sent && self.snd_nxt == self.snd_end && nb < MAX_BURST_SIZE
+        {
+            self.segs[nb] = TcpSegment {
+                seq: self.snd_end,
+                ack,
+                window: wnd,
+                flags: TCP_FIN | TCP_ACK,
+                ..TcpSegment::EMPTY
+            };
+            self.fin_sent = true;
+            nb += 1;
+        }
+
+        if nb == 0 {
+            // Данные есть, окно закрыто: таймер служит persist таймером
+            if self.unacked() > 0 && self.rto_deadline == 0 {
+                self.rto_deadline = now + self.rto_cycles;
+            }
+            return;
+        }
+
+        // Отложенный ACK не должен уйти следом за данными со старым номером
+        // последовательности: получатель ответил бы на него повторным ACK
+        if self.tx.staged() > 0 {
+            self.tx.ring_doorbell();
+        }
+
+        let sent = self.tx.send_tcp(&self.segs[..nb]);
+        self.counters.tx_segments.add(sent as u64);
+        self.ack_pending = false;
+
+        if self.rto_deadline == 0 {
+            self.rto_deadline = now + self.rto_cycles;
+        }
+    }
+
+    /// Повторно отправляет первый неподтвержденный сегмент
+    fn retransmit_first(&mut self) {
+        let cap = self.send_buf.len();
+        let start = self.snd_una as usize & (cap - 1);
+        let len = self
+            .snd_nxt
+            .wrapping_sub(self.snd_una)
+            .min(self.mss.min(self.peer_mss) as u32)
+            .min((cap - start) as u32);
+        if len == 0 {
+            return;
+        }
+
+        let seg = TcpSegment {
+            payload: self.send_buf[start..].as_ptr(),
+            seq: self.snd_una,
+            ack: self.rcv_nxt,
+            payload_len: len as u16,
+            window: self.window(),
+            flags: TCP_ACK | TCP_PSH,
+            _reserved: 0,
+            mss: 0,
+        };
+        self.counters
+            .tx_segments
+            .add(self.tx.send_tcp(&[seg]) as u64);
+        self.ack_pending = false;
+    }
+
+    fn send_syn(&mut self) {
+        let seg = TcpSegment {
+            seq: self.iss,
+            window: self.window(),
+            flags: TCP_SYN,
+            mss: self.mss,
+            ..TcpSegment::EMPTY
+        };
+        self.counters
+            .tx_segments
+            .add(self.tx.send_tcp(&[seg]) as u64);
+    }
+
+    fn send_ack(&mut self) {
+        self.send_control(self.ack_seq(), TCP_ACK);
+        self.ack_pending = false;
+    }
+
+    /// Ставит отложенный чистый ACK в общий doorbell TX сессии
+    /// (`TxSession::send_tcp_bulk`) вместо отдельного `rte_eth_tx_burst`
+    fn stage_ack(&mut self) {
+        let seg = TcpSegment {
+            seq: self.ack_seq(),
+            ack: self.rcv_nxt,
+            window: self.window(),
+            flags: TCP_ACK,
+            ..TcpSegment::EMPTY
+        };
+        self.counters
+            .tx_segments
+            .add(self.tx.send_tcp_bulk(&[seg]) as u64);
+        self.ack_pending = false;
+    }
+
+    /// Номер последовательности чистого ACK
+    fn ack_seq(&self) -> u32 {
+        if self.fin_sent {
+            self.snd_end.wrapping_add(1)
+        } else {
+            self.snd_nxt
+        }
+    }
+
+    fn send_control(&mut self, seq: u32, flags: u8) {
+        let seg = TcpSegment {
+            seq,
+            ack: self.rcv_nxt,
+            window: self.window(),
+            flags,
+            ..TcpSegment::EMPTY
+        };
+        self.counters
+            .tx_segments
+            .add(self.tx.send_tcp(&[seg]) as u64);
+    }
+
+    fn enter_time_wait(&mut self, now: u64) {
+        self.state = TcpState::TimeWait;
+        self.rto_deadline = now + 2 * self.rto_max_cycles;
+    }
+
+    fn reset_state(&mut self) {
+        self.state = TcpState::Closed;
+        self.rto_deadline = 0;
+        self.ack_pending = false;
+        self.fin_queued = false;
+        self.fin_sent = false;
+        self.snd_una = self.snd_end;
+        self.snd_nxt = self.snd_end;
+    }
+
+    /// Окно приема: свободное место в буфере приема
+    #[inline]
+    fn window(&self) -> u16 {
+        let free = self.recv_buf.len() - (self.rx_tail - self.rx_head);
+        free.min(MAX_WINDOW) as u16
+    }
+
+    #[inline]
+    fn in_recv_window(&self, seq: u32) -> bool {
+        let offset = seq.wrapping_sub(self.rcv_nxt);
+        offset < (self.window() as u32).max(1)
+    }
+}
+
+/// Значение опции MSS из SYN-ACK
+fn parse_mss(mut options: &[u8]) -> Option<u16> {
+    while let [kind, rest @ ..] = options {
+        match *kind {
+            0 => return None,
+            1 => options = rest,
+            _ => {
+                let len = *rest.first()? as usize;
+                if len < 2 || len > options.len() {
+                    return None;
+                }
+                if *kind == 2 && len == OPT_MSS_LEN {
+                    return Some(u16::from_be_bytes([options[2], options[3]]));
+                }
+                options = &options[len..];
+            }
+        }
+    }
+    None
+}
+
+/// a < b в пространстве номеров последовательности
+#[inline(always)]
+fn seq_lt(a: u32, b: u32) -> bool {
+    (a.wrapping_sub(b) as i32) < 0
+}
+
+#[inline(always)]
+fn seq_le(a: u32, b: u32) -> bool {
+    (a.wrapping_sub(b) as i32) <= 0
+}